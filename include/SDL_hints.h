@@ -841,6 +841,25 @@ extern "C" {
   */
 #define SDL_HINT_JOYSTICK_THREAD "SDL_JOYSTICK_THREAD"
 
+/**
+ * \brief  A variable controlling whether the KMSDRM backend flips pages on a thread
+ *
+ * Without it SDL_GL_SwapWindow() waits for the previous page flip to complete,
+ * which stalls the caller for up to a refresh whenever it gets ahead of the
+ * display. With it, swapped frames are queued and a thread flips them, each on
+ * the vblank after the previous one. With a swap interval of 1 every frame is
+ * shown and SDL_GL_SwapWindow() only waits when the queue is full, with a swap
+ * interval of 0 it never waits and a newer frame replaces the last queued one.
+ *
+ * This hint must be set before the window is created.
+ *
+ * This variable can be set to the following values:
+ *    "0"       - SDL_GL_SwapWindow() waits for the flips itself (default)
+ *    "1"       - One frame can wait for its flip
+ *    "2"       - Two frames can wait, if the GBM surface has enough buffers
+ */
+#define SDL_HINT_KMSDRM_FLIP_QUEUE "SDL_KMSDRM_FLIP_QUEUE"
+
 /**
  * \brief Determines whether SDL enforces that DRM master is required in order
  *        to initialize the KMSDRM video backend.
@@ -907,6 +926,183 @@ extern "C" {
  */
 #define SDL_HINT_MAC_CTRL_CLICK_EMULATE_RIGHT_CLICK "SDL_MAC_CTRL_CLICK_EMULATE_RIGHT_CLICK"
 
+/**
+ *  \brief  A variable controlling how many pixmap buffers the Mali fbdev driver renders into.
+ *
+ *  This variable can be set to a number between 2 and 8:
+ *    "2"       - Double buffering, lowest latency, rendering stalls until the previous frame is shown
+ *    "3"       - Triple buffering (default)
+ *    "4" or more - Extra slack for applications with uneven frame times
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_SWAPCHAIN_DEPTH "SDL_MALI_SWAPCHAIN_DEPTH"
+
+/**
+ *  \brief  A variable controlling how the Mali fbdev driver hands rendered frames to the display.
+ *
+ *  This variable can be set to the following values:
+ *    "mailbox" - Always show the newest frame, older frames are dropped (default)
+ *    "fifo"    - Show every frame once in order, SDL_GL_SwapWindow() waits when the queue is full
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_PRESENT_MODE "SDL_MALI_PRESENT_MODE"
+
+/**
+ *  \brief  A variable controlling whether the Mali fbdev driver collects detailed frame pacing telemetry.
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - Only cheap CPU timestamps are recorded for SDL_GL_GetFrameTimings() (default)
+ *    "1"       - Also measure the GPU time of the display blit, this adds a fence wait per frame
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_TELEMETRY "SDL_MALI_TELEMETRY"
+
+/**
+ *  \brief  A variable setting how often, in milliseconds, the Mali fbdev driver logs frame pacing statistics.
+ *
+ *  The summary covers render-to-present latency, display blit GPU time, fence
+ *  wait time and missed vsyncs, and is logged in the SDL_LOG_CATEGORY_VIDEO
+ *  category. The default is "0", which disables logging.
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_TELEMETRY_LOG_INTERVAL "SDL_MALI_TELEMETRY_LOG_INTERVAL"
+
+/**
+ *  \brief  A variable controlling whether the Mali fbdev driver renders straight into the framebuffer.
+ *
+ *  When the window matches the panel resolution and isn't rotated, the swap
+ *  chain pages are scanned out as they are, skipping the display blit. See
+ *  SDL_HINT_MALI_SCANOUT_BACKEND for how they get to the display. Otherwise
+ *  the driver silently falls back to the blitter.
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - Always present through the GLES blitter (default)
+ *    "1"       - Use direct scanout when possible
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_DIRECT_SCANOUT "SDL_MALI_DIRECT_SCANOUT"
+
+/**
+ *  \brief  A variable selecting how the Mali fbdev driver presents pages with direct scanout.
+ *
+ *  With DRM the swap chain's pages are added as framebuffers and flipped with
+ *  atomic commits on the primary plane, which needs a kernel with atomic
+ *  modesetting and nobody else driving the display. With fbdev the pages are
+ *  carved out of the exported framebuffer and presented by panning.
+ *
+ *  This variable can be set to the following values:
+ *    "auto"    - DRM if the device takes atomic commits, fbdev otherwise (default)
+ *    "drm"     - Only DRM
+ *    "fbdev"   - Only fbdev
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_SCANOUT_BACKEND "SDL_MALI_SCANOUT_BACKEND"
+
+/**
+ *  \brief  A variable naming the DRM device the Mali fbdev driver scans out through.
+ *
+ *  The default is "/dev/dri/card0". Pointing it at the card of the vkms
+ *  virtual driver exercises the DRM backend without a display.
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_DRM_DEVICE "SDL_MALI_DRM_DEVICE"
+
+/**
+ *  \brief  A variable selecting the filter the Mali fbdev driver scales the window onto the display with.
+ *
+ *  This variable can be set to the following values:
+ *    "nearest"         - Nearest neighbour (default)
+ *    "integer-nearest" - Nearest neighbour at the largest whole multiple that fits
+ *    "sharp-bilinear"  - Nearest neighbour with bilinear smoothing of the texel edges
+ *    "quilez"          - Bilinear with a smoothstep between texels
+ *    "area"            - Weights texels by the area they cover on screen
+ *    "lanczos2"        - 4x4 Lanczos, sharpest but the most expensive
+ *    "crt-lite"        - sharp-bilinear with scanlines
+ *
+ *  When unset, the legacy SDL_MALI_HQ_SCALER environment variable ("1" for
+ *  sharp-bilinear, "2" for quilez) is honored.
+ *
+ *  This hint can be changed at any time, the next presented frame uses the new filter.
+ */
+#define SDL_HINT_MALI_SCALER "SDL_MALI_SCALER"
+
+/**
+ *  \brief  A variable selecting how the Mali fbdev driver sizes the window on the display.
+ *
+ *  This variable can be set to the following values:
+ *    "fit"     - As large as fits with the aspect ratio kept, letterboxed (default)
+ *    "integer" - Whole multiples of the window's lines, the width follows the
+ *                aspect ratio. Falls back to "fit" when the window is larger
+ *                than the display.
+ *    "stretch" - Fills the display, the aspect ratio is ignored
+ *
+ *  Scalers that need whole multiples, such as "integer-nearest", switch "fit"
+ *  to "integer". This hint and SDL_HINT_MALI_PIXEL_ASPECT,
+ *  SDL_HINT_MALI_DISPLAY_ASPECT and SDL_HINT_MALI_OVERSCAN can be changed at
+ *  any time, the next presented frame uses the new layout.
+ */
+#define SDL_HINT_MALI_VIEWPORT "SDL_MALI_VIEWPORT"
+
+/**
+ *  \brief  A variable setting the shape of the window's pixels on the Mali fbdev driver.
+ *
+ *  The width over the height of a pixel, as "8:7", "8/7" or "1.143". Pixels
+ *  are square by default. Consoles that output non-square pixels look right
+ *  with their pixel aspect ratio here, "8:7" for the SNES for example.
+ */
+#define SDL_HINT_MALI_PIXEL_ASPECT "SDL_MALI_PIXEL_ASPECT"
+
+/**
+ *  \brief  A variable setting the aspect ratio of the whole window on the Mali fbdev driver.
+ *
+ *  The width over the height of the picture after SDL_HINT_MALI_OVERSCAN
+ *  cropping, as "4:3" for example. Overrides SDL_HINT_MALI_PIXEL_ASPECT. By
+ *  default the aspect ratio follows from the window size and the pixels.
+ */
+#define SDL_HINT_MALI_DISPLAY_ASPECT "SDL_MALI_DISPLAY_ASPECT"
+
+/**
+ *  \brief  A variable cropping the edges of the window on the Mali fbdev driver.
+ *
+ *  Window pixels cut off, as one value for every edge, "horizontal,vertical"
+ *  or "left,top,right,bottom". Nothing is cropped by default.
+ */
+#define SDL_HINT_MALI_OVERSCAN "SDL_MALI_OVERSCAN"
+
+/**
+ *  \brief  A variable setting the directory the Mali fbdev driver caches linked scaler programs in.
+ *
+ *  By default program binaries are stored in $XDG_CACHE_HOME/sdl2-mali, or
+ *  ~/.cache/sdl2-mali, when the driver supports GL_OES_get_program_binary.
+ *  Set this to an empty string to disable the cache.
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_SHADER_CACHE "SDL_MALI_SHADER_CACHE"
+
+/**
+ *  \brief  A variable controlling whether the Mali fbdev driver draws a performance overlay.
+ *
+ *  The overlay sits in the top left corner of the display and shows the frame
+ *  rate, frame time, system CPU load and the GPU time of the display blit,
+ *  above a graph of recent frame times against the refresh period. Measuring
+ *  the blit adds a fence wait per frame, as SDL_HINT_MALI_TELEMETRY does.
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - No overlay (default)
+ *    "1"       - Draw the overlay, unless the window is scanned out directly
+ *
+ *  This hint must be set before the window is created.
+ */
+#define SDL_HINT_MALI_HUD "SDL_MALI_HUD"
+
 /**
  *  \brief  A variable setting the double click radius, in pixels.
  */
@@ -1135,6 +1331,55 @@ extern "C" {
  */
 #define SDL_HINT_RENDER_BATCHING  "SDL_RENDER_BATCHING"
 
+/**
+ *  \brief  A variable controlling whether the 2D render API packs small textures into shared pages
+ *
+ *  This variable can be set to the following values:
+ *    "0"     - Every texture is a texture of the renderer backend (default)
+ *    "1"     - Small static textures are packed into pages shared with others
+ *
+ *  Copies from different textures can't be batched into one draw, copies from
+ *  textures packed into the same page can. Textures of up to 256x256 pixels
+ *  are packed into pages of their format and scale mode, and drawn from
+ *  there transparently. A copy of their pixels is kept in system memory.
+ *  SDL_GL_BindTexture() gives a texture a backend texture of its own again.
+ *  The software renderer never packs textures.
+ *
+ *  This variable should be set when the renderer is created.
+ */
+#define SDL_HINT_RENDER_ATLAS "SDL_RENDER_ATLAS"
+
+/**
+ *  \brief  A variable naming a directory the OpenGL ES 2.0 renderer keeps its linked shader programs in
+ *
+ *  Shader programs are compiled and linked the first time something is drawn
+ *  with them, which can take long enough to drop frames. With this variable
+ *  set, programs linked once are saved into the directory as binaries of the
+ *  driver, through GL_OES_get_program_binary, and loaded from there by later
+ *  runs. A binary is only used with the driver and shaders it was made from.
+ *  Nothing is saved if the driver doesn't support program binaries.
+ *
+ *  By default programs aren't kept. The directory must exist.
+ *
+ *  This variable should be set when the renderer is created.
+ */
+#define SDL_HINT_RENDER_GLES2_PROGRAM_CACHE "SDL_RENDER_GLES2_PROGRAM_CACHE"
+
+/**
+ *  \brief  A variable controlling whether the OpenGL ES 2.0 renderer links all its shader programs up front
+ *
+ *  This variable can be set to the following values:
+ *    "0"     - Shader programs are linked the first time they are drawn with (default)
+ *    "1"     - Every shader program is linked when the renderer is created
+ *
+ *  Creating the renderer takes longer, drawing never stops to link a program.
+ *  Combined with SDL_HINT_RENDER_GLES2_PROGRAM_CACHE, only the first run
+ *  pays for it.
+ *
+ *  This variable should be set when the renderer is created.
+ */
+#define SDL_HINT_RENDER_GLES2_PRECOMPILE "SDL_RENDER_GLES2_PRECOMPILE"
+
 /**
  *  \brief  A variable controlling how the 2D render API renders lines
  *
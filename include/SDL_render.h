@@ -1897,6 +1897,165 @@ extern DECLSPEC void *SDLCALL SDL_RenderGetMetalCommandEncoder(SDL_Renderer * re
  */
 extern DECLSPEC int SDLCALL SDL_RenderSetVSync(SDL_Renderer* renderer, int vsync);
 
+/**
+ * Statistics of the frame a renderer last presented.
+ *
+ * \sa SDL_RenderGetStats
+ */
+typedef struct SDL_RenderStats
+{
+    Uint32 commands_queued; /**< render commands queued */
+    Uint32 commands_run;    /**< left of them for the backend to run, once merged */
+    Uint32 draw_calls;      /**< draws the backend made, 0 if it doesn't count them */
+    int atlas_pages;        /**< pages textures are packed into, see SDL_HINT_RENDER_ATLAS */
+    int atlas_textures;     /**< textures packed into them */
+} SDL_RenderStats;
+
+/**
+ * Get statistics of the frame a renderer last presented.
+ *
+ * Copies of several textures only go to the GPU as a single draw when they
+ * come from one texture, see SDL_HINT_RENDER_ATLAS. The number of draws tells
+ * how well that works out for an application. The OpenGL and OpenGL ES 2.0
+ * renderers count their draws.
+ *
+ * Before the queued commands go to the backend, state changes nothing is
+ * drawn with are dropped and geometry that can be drawn as one is merged.
+ * The commands queued and left to run tell how much that saves.
+ *
+ * \param renderer the rendering context
+ * \param stats filled in with the statistics of the last frame presented
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_RenderPresent
+ */
+extern DECLSPEC int SDLCALL SDL_RenderGetStats(SDL_Renderer * renderer, SDL_RenderStats * stats);
+
+/**
+ * A list of render commands recorded away from the thread rendering.
+ *
+ * \sa SDL_CreateRenderCommandBuffer
+ */
+struct SDL_RenderCommandBuffer;
+typedef struct SDL_RenderCommandBuffer SDL_RenderCommandBuffer;
+
+/**
+ * Create a buffer to record render commands into on another thread.
+ *
+ * All other rendering functions must be called on the thread the renderer
+ * was created on. The recording functions can be called on any thread, with
+ * each thread recording into a buffer of its own. The thread rendering then
+ * submits the buffers in the order their commands are to be drawn in.
+ *
+ * The commands are recorded the way the renderer queues them, so submitting
+ * them only copies them into its queue. They are recorded for the render
+ * target, scale, logical size and viewport the renderer had when the buffer
+ * was created or last submitted. Submitting fails and drops the commands if
+ * any of these changed since, the clip rectangle is the one the renderer has
+ * when the buffer is submitted. Textures drawn from must not be changed or
+ * destroyed while a buffer holds commands drawing from them.
+ *
+ * Only call this function on the thread the renderer was created on.
+ *
+ * \param renderer the rendering context
+ * \returns the buffer or NULL on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_RecordRenderCopyF
+ * \sa SDL_RecordRenderGeometry
+ * \sa SDL_RenderSubmitCommandBuffer
+ * \sa SDL_DestroyRenderCommandBuffer
+ */
+extern DECLSPEC SDL_RenderCommandBuffer * SDLCALL SDL_CreateRenderCommandBuffer(SDL_Renderer * renderer);
+
+/**
+ * Record a copy of a portion of a texture into a command buffer.
+ *
+ * This is SDL_RenderCopyF() for a command buffer, it can be called on any
+ * thread.
+ *
+ * \param buffer the command buffer
+ * \param texture the source texture
+ * \param srcrect the source SDL_Rect structure or NULL for the entire texture
+ * \param dstrect the destination SDL_FRect structure or NULL for the entire
+ *                the rendering target
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_CreateRenderCommandBuffer
+ * \sa SDL_RenderCopyF
+ */
+extern DECLSPEC int SDLCALL SDL_RecordRenderCopyF(SDL_RenderCommandBuffer * buffer,
+                                                  SDL_Texture * texture,
+                                                  const SDL_Rect * srcrect,
+                                                  const SDL_FRect * dstrect);
+
+/**
+ * Record a list of triangles into a command buffer.
+ *
+ * This is SDL_RenderGeometry() for a command buffer, it can be called on any
+ * thread. The software renderer draws some geometry as rectangles instead,
+ * which it can't record.
+ *
+ * \param buffer the command buffer
+ * \param texture (optional) The SDL texture to use.
+ * \param vertices Vertices.
+ * \param num_vertices Number of vertices.
+ * \param indices (optional) An array of integer indices into the 'vertices'
+ *                array, if NULL all vertices will be rendered in sequential
+ *                order.
+ * \param num_indices Number of indices.
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_CreateRenderCommandBuffer
+ * \sa SDL_RenderGeometry
+ */
+extern DECLSPEC int SDLCALL SDL_RecordRenderGeometry(SDL_RenderCommandBuffer * buffer,
+                                                     SDL_Texture * texture,
+                                                     const SDL_Vertex * vertices, int num_vertices,
+                                                     const int * indices, int num_indices);
+
+/**
+ * Append the commands recorded into a buffer to the renderer's queue.
+ *
+ * The buffer is empty afterwards, ready to record the next frame into. It
+ * must not be recorded into while it is submitted.
+ *
+ * Only call this function on the thread the renderer was created on.
+ *
+ * \param buffer the command buffer
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_CreateRenderCommandBuffer
+ */
+extern DECLSPEC int SDLCALL SDL_RenderSubmitCommandBuffer(SDL_RenderCommandBuffer * buffer);
+
+/**
+ * Destroy a command buffer, dropping the commands it holds.
+ *
+ * Buffers must be destroyed before their renderer is.
+ *
+ * \param buffer the command buffer
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_CreateRenderCommandBuffer
+ */
+extern DECLSPEC void SDLCALL SDL_DestroyRenderCommandBuffer(SDL_RenderCommandBuffer * buffer);
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
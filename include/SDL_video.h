@@ -1279,6 +1279,93 @@ extern DECLSPEC int SDLCALL SDL_UpdateWindowSurfaceRects(SDL_Window * window,
                                                          const SDL_Rect * rects,
                                                          int numrects);
 
+/**
+ * A plane of an SDL_DMABUFFrame.
+ */
+typedef struct SDL_DMABUFPlane
+{
+    int fd;             /**< DMA-BUF file descriptor, planes may share one */
+    Uint32 offset;      /**< Offset of the plane within the buffer, in bytes */
+    Uint32 pitch;       /**< Length of a row of the plane, in bytes */
+} SDL_DMABUFPlane;
+
+struct SDL_DMABUFFrame;
+
+/**
+ * Called once the display is done with a frame passed to SDL_PresentDMABUF().
+ */
+typedef void (SDLCALL * SDL_DMABUFReleaseCallback) (void *userdata, const struct SDL_DMABUFFrame *frame);
+
+/**
+ * A frame living in DMA-BUF memory, such as the output of a hardware video
+ * decoder, see SDL_PresentDMABUF().
+ */
+typedef struct SDL_DMABUFFrame
+{
+    Uint32 format;      /**< SDL_PIXELFORMAT_NV12, SDL_PIXELFORMAT_NV21, SDL_PIXELFORMAT_IYUV,
+                             SDL_PIXELFORMAT_YV12 or a packed 16 or 32 bit RGB format */
+    int w, h;           /**< Size of the frame in pixels */
+    int num_planes;     /**< 1 for packed RGB, 2 for NV12 and NV21, 3 for IYUV and YV12 */
+    SDL_DMABUFPlane planes[3];
+    SDL_YUV_CONVERSION_MODE conversion_mode;    /**< YUV colorspace of the frame */
+    SDL_DMABUFReleaseCallback release;          /**< May be NULL */
+    void *userdata;
+} SDL_DMABUFFrame;
+
+/**
+ * Show a frame that lives in DMA-BUF memory on a window without copying it.
+ *
+ * The frame is scaled to fill the window and replaces whatever the window
+ * showed before. YUV frames are converted while they are displayed, so the
+ * output of a hardware video decoder can be presented as is.
+ *
+ * The buffer must not be written to until the release callback has been
+ * called, which happens on an internal thread once a later frame is on
+ * screen, or right away when a later frame replaced this one before it could
+ * be shown. The frame structure itself is copied and can be reused. On
+ * failure the release callback isn't called and the buffer remains with the
+ * caller.
+ *
+ * This is currently only implemented by the Mali fbdev video driver.
+ *
+ * \param window the window to show the frame on
+ * \param frame the frame to show
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_UpdateWindowSurface
+ */
+extern DECLSPEC int SDLCALL SDL_PresentDMABUF(SDL_Window * window, const SDL_DMABUFFrame * frame);
+
+/**
+ * Predict when the display a window is on refreshes next.
+ *
+ * Lets an application start rendering just in time for a refresh instead of
+ * right after the previous one, which keeps input latency down. The driver
+ * follows the display's actual refresh through the swaps it makes with vsync
+ * enabled, while nothing is presented the prediction is extrapolated from
+ * the last one. The period is exact where the display mode's refresh rate is
+ * rounded to whole hertz, a 59.94 Hz panel reports 60.
+ *
+ * This is currently only implemented by the Mali fbdev video driver.
+ *
+ * \param window the window to query
+ * \param vsync filled in with the SDL_GetPerformanceCounter() value of the
+ *              next refresh
+ * \param period filled in with the refresh period, in performance counter
+ *               ticks
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_GL_GetFrameTimings
+ * \sa SDL_GetPerformanceCounter
+ */
+extern DECLSPEC int SDLCALL SDL_GetWindowNextVsync(SDL_Window * window, Uint64 * vsync, Uint64 * period);
+
 /**
  * Set a window's input grab mode.
  *
@@ -2064,6 +2151,69 @@ extern DECLSPEC int SDLCALL SDL_GL_GetSwapInterval(void);
  */
 extern DECLSPEC void SDLCALL SDL_GL_SwapWindow(SDL_Window * window);
 
+/**
+ * Update a window with OpenGL rendering, telling SDL which parts of the frame
+ * changed since the previous swap.
+ *
+ * The whole frame must still be rendered, the damage only lets the driver
+ * skip copying unchanged regions to the display. Drivers without support for
+ * partial updates treat this as SDL_GL_SwapWindow().
+ *
+ * This is currently only taken advantage of by the Mali fbdev video driver.
+ *
+ * \param window the window to change
+ * \param rects an array of rectangles in window coordinates that changed, or
+ *              NULL if the whole window changed
+ * \param numrects the number of rectangles in `rects`
+ * \returns 0 on success or a negative error code on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_GL_SwapWindow
+ */
+extern DECLSPEC int SDLCALL SDL_GL_SwapWindowWithDamage(SDL_Window * window, const SDL_Rect * rects, int numrects);
+
+/**
+ * Timing information for a single OpenGL frame, see SDL_GL_GetFrameTimings().
+ *
+ * All timestamps are SDL_GetPerformanceCounter() values, a stage the driver
+ * cannot observe is reported as 0.
+ */
+typedef struct SDL_GLFrameTiming
+{
+    Uint32 frame;            /**< Frame number, counting SDL_GL_SwapWindow() calls on the window */
+    Uint32 missed_vsyncs;    /**< Refreshes that kept the previous frame on screen before this one */
+    Uint64 swap_requested;   /**< SDL_GL_SwapWindow() was called and the frame fence was created */
+    Uint64 fence_wait_start; /**< The display side started waiting for the GPU to finish the frame */
+    Uint64 fence_signaled;   /**< The GPU finished rendering the frame */
+    Uint64 blit_done;        /**< The frame was copied to the display surface */
+    Uint64 blit_gpu_done;    /**< The GPU finished copying the frame, only measured when SDL_HINT_MALI_TELEMETRY is enabled */
+    Uint64 swap_returned;    /**< The display swap showing the frame returned */
+} SDL_GLFrameTiming;
+
+/**
+ * Retrieve timing information for frames that have been presented on a
+ * window.
+ *
+ * Records are returned oldest first and removed from the window's queue, so
+ * each frame is reported only once. The driver keeps a limited number of
+ * records, frames that are not read back in time are discarded.
+ *
+ * This is currently only implemented by the Mali fbdev video driver.
+ *
+ * \param window the window to query
+ * \param timings an array to fill with the timing records
+ * \param maxtimings the number of elements in `timings`
+ * \returns the number of records stored in `timings` or a negative error
+ *          code on failure; call SDL_GetError() for more information.
+ *
+ * \since This function is available since SDL 2.0.22.
+ *
+ * \sa SDL_GL_SwapWindow
+ */
+extern DECLSPEC int SDLCALL SDL_GL_GetFrameTimings(SDL_Window * window, SDL_GLFrameTiming * timings, int maxtimings);
+
 /**
  * Delete an OpenGL context.
  *
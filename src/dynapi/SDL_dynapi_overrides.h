@@ -865,3 +865,13 @@
 #define SDL_EncloseFPoints SDL_EncloseFPoints_REAL
 #define SDL_IntersectFRectAndLine SDL_IntersectFRectAndLine_REAL
 #define SDL_RenderGetWindow SDL_RenderGetWindow_REAL
+#define SDL_GL_GetFrameTimings SDL_GL_GetFrameTimings_REAL
+#define SDL_GL_SwapWindowWithDamage SDL_GL_SwapWindowWithDamage_REAL
+#define SDL_PresentDMABUF SDL_PresentDMABUF_REAL
+#define SDL_GetWindowNextVsync SDL_GetWindowNextVsync_REAL
+#define SDL_RenderGetStats SDL_RenderGetStats_REAL
+#define SDL_CreateRenderCommandBuffer SDL_CreateRenderCommandBuffer_REAL
+#define SDL_RecordRenderCopyF SDL_RecordRenderCopyF_REAL
+#define SDL_RecordRenderGeometry SDL_RecordRenderGeometry_REAL
+#define SDL_RenderSubmitCommandBuffer SDL_RenderSubmitCommandBuffer_REAL
+#define SDL_DestroyRenderCommandBuffer SDL_DestroyRenderCommandBuffer_REAL
@@ -936,3 +936,13 @@ SDL_DYNAPI_PROC(void,SDL_UnionFRect,(const SDL_FRect *a, const SDL_FRect *b, SDL
 SDL_DYNAPI_PROC(SDL_bool,SDL_EncloseFPoints,(const SDL_FPoint *a, int b, const SDL_FRect *c, SDL_FRect *d),(a,b,c,d),return)
 SDL_DYNAPI_PROC(SDL_bool,SDL_IntersectFRectAndLine,(const SDL_FRect *a, float *b, float *c, float *d, float *e),(a,b,c,d,e),return)
 SDL_DYNAPI_PROC(SDL_Window*,SDL_RenderGetWindow,(SDL_Renderer *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_GL_GetFrameTimings,(SDL_Window *a, SDL_GLFrameTiming *b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_GL_SwapWindowWithDamage,(SDL_Window *a, const SDL_Rect *b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_PresentDMABUF,(SDL_Window *a, const SDL_DMABUFFrame *b),(a,b),return)
+SDL_DYNAPI_PROC(int,SDL_GetWindowNextVsync,(SDL_Window *a, Uint64 *b, Uint64 *c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_RenderGetStats,(SDL_Renderer *a, SDL_RenderStats *b),(a,b),return)
+SDL_DYNAPI_PROC(SDL_RenderCommandBuffer*,SDL_CreateRenderCommandBuffer,(SDL_Renderer *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_RecordRenderCopyF,(SDL_RenderCommandBuffer *a, SDL_Texture *b, const SDL_Rect *c, const SDL_FRect *d),(a,b,c,d),return)
+SDL_DYNAPI_PROC(int,SDL_RecordRenderGeometry,(SDL_RenderCommandBuffer *a, SDL_Texture *b, const SDL_Vertex *c, int d, const int *e, int f),(a,b,c,d,e,f),return)
+SDL_DYNAPI_PROC(int,SDL_RenderSubmitCommandBuffer,(SDL_RenderCommandBuffer *a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_DestroyRenderCommandBuffer,(SDL_RenderCommandBuffer *a),(a),)
@@ -0,0 +1,351 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* Packing of small static textures into shared pages */
+
+#include "SDL_sysrender.h"
+
+
+static int
+SDL_AtlasPageSize(SDL_Renderer *renderer)
+{
+    int size = SDL_ATLAS_PAGE_SIZE;
+
+    if (renderer->info.max_texture_width) {
+        size = SDL_min(size, renderer->info.max_texture_width);
+    }
+    if (renderer->info.max_texture_height) {
+        size = SDL_min(size, renderer->info.max_texture_height);
+    }
+    return size;
+}
+
+/* Finds room for a w by h rectangle on the shelf it wastes the least height
+   of. A rectangle much lower than that shelf opens a new one while the page
+   has room for it. Space isn't reused before the whole page is empty. */
+static SDL_bool
+SDL_AtlasPack(SDL_TextureAtlas *atlas, int w, int h, SDL_Rect *rect)
+{
+    const int size = atlas->page->w;
+    SDL_AtlasShelf *best = NULL;
+    int i, top = 0;
+
+    for (i = 0; i < atlas->num_shelves; i++) {
+        SDL_AtlasShelf *shelf = &atlas->shelves[i];
+
+        if (shelf->h >= h && shelf->x + w <= size && (!best || shelf->h < best->h)) {
+            best = shelf;
+        }
+        top = shelf->y + shelf->h;
+    }
+
+    if ((!best || best->h - h > h / 2) &&
+        atlas->num_shelves < SDL_ATLAS_MAX_SHELVES && top + h <= size) {
+        best = &atlas->shelves[atlas->num_shelves++];
+        best->y = top;
+        best->h = h;
+        best->x = 0;
+    }
+
+    if (!best) {
+        return SDL_FALSE;
+    }
+
+    rect->x = best->x;
+    rect->y = best->y;
+    rect->w = w;
+    rect->h = h;
+    best->x += w;
+    return SDL_TRUE;
+}
+
+static SDL_TextureAtlas *
+SDL_AtlasCreatePage(SDL_Renderer *renderer, Uint32 format, SDL_ScaleMode scaleMode)
+{
+    const int size = SDL_AtlasPageSize(renderer);
+    SDL_TextureAtlas *atlas;
+    SDL_Texture *page, *last;
+
+    atlas = (SDL_TextureAtlas *) SDL_calloc(1, sizeof(*atlas));
+    if (!atlas) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    /* Too large to go into an atlas itself */
+    page = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_STATIC, size, size);
+    if (!page) {
+        SDL_free(atlas);
+        return NULL;
+    }
+    SDL_SetTextureScaleMode(page, scaleMode);
+
+    /* Pages go last in the list of textures, so SDL_DestroyRenderer() gets to
+       them after the textures they hold */
+    if (page->next) {
+        for (last = page->next; last->next; last = last->next) {
+        }
+        renderer->textures = page->next;
+        renderer->textures->prev = NULL;
+        page->prev = last;
+        page->next = NULL;
+        last->next = page;
+    }
+
+    atlas->page = page;
+    atlas->next = renderer->atlases;
+    renderer->atlases = atlas;
+    return atlas;
+}
+
+/* A page with the texture's format and scale mode that has room for it,
+   a new one if none has */
+static SDL_TextureAtlas *
+SDL_AtlasFindRoom(SDL_Renderer *renderer, SDL_Texture *texture, SDL_Rect *rect)
+{
+    const int w = texture->w + 2;   /* with a border repeating the edges */
+    const int h = texture->h + 2;
+    SDL_TextureAtlas *atlas;
+
+    for (atlas = renderer->atlases; atlas; atlas = atlas->next) {
+        if (atlas->page->format == texture->format &&
+            atlas->page->scaleMode == texture->scaleMode &&
+            SDL_AtlasPack(atlas, w, h, rect)) {
+            break;
+        }
+    }
+
+    if (!atlas) {
+        atlas = SDL_AtlasCreatePage(renderer, texture->format, texture->scaleMode);
+        if (atlas && !SDL_AtlasPack(atlas, w, h, rect)) {
+            return NULL;
+        }
+    }
+
+    /* Where the texture itself is */
+    if (atlas) {
+        rect->x += 1;
+        rect->y += 1;
+        rect->w -= 2;
+        rect->h -= 2;
+    }
+    return atlas;
+}
+
+/* Uploads the texture with its border, filtering at its edges then samples
+   its edge pixels instead of its neighbours in the page */
+static int
+SDL_AtlasUpload(SDL_Texture *texture)
+{
+    const int bpp = SDL_BYTESPERPIXEL(texture->format);
+    const int w = texture->w + 2;
+    const int h = texture->h + 2;
+    const int pitch = ((w * bpp) + 3) & ~3;
+    SDL_Rect rect;
+    Uint8 *pixels;
+    int y, retval;
+
+    pixels = (Uint8 *) SDL_malloc(pitch * h);
+    if (!pixels) {
+        return SDL_OutOfMemory();
+    }
+
+    for (y = 0; y < h; y++) {
+        const Uint8 *src = (const Uint8 *) texture->pixels + SDL_clamp(y - 1, 0, texture->h - 1) * texture->pitch;
+        Uint8 *dst = pixels + y * pitch;
+
+        SDL_memcpy(dst, src, bpp);
+        SDL_memcpy(dst + bpp, src, texture->w * bpp);
+        SDL_memcpy(dst + (w - 1) * bpp, src + (texture->w - 1) * bpp, bpp);
+    }
+
+    rect.x = texture->atlas_rect.x - 1;
+    rect.y = texture->atlas_rect.y - 1;
+    rect.w = w;
+    rect.h = h;
+    retval = SDL_UpdateTexture(texture->atlas->page, &rect, pixels, pitch);
+
+    SDL_free(pixels);
+    return retval;
+}
+
+/* Packs a texture being created into a page instead of giving it a backend
+   texture, if it qualifies */
+SDL_bool
+SDL_AtlasAddTexture(SDL_Renderer *renderer, SDL_Texture *texture)
+{
+    SDL_TextureAtlas *atlas;
+    SDL_Rect rect;
+
+    if (!renderer->atlas_enabled ||
+        texture->access != SDL_TEXTUREACCESS_STATIC ||
+        SDL_ISPIXELFORMAT_FOURCC(texture->format) ||
+        SDL_ISPIXELFORMAT_INDEXED(texture->format) ||
+        texture->w > SDL_ATLAS_MAX_TEXTURE_SIZE ||
+        texture->h > SDL_ATLAS_MAX_TEXTURE_SIZE ||
+        texture->w + 2 > SDL_AtlasPageSize(renderer) ||
+        texture->h + 2 > SDL_AtlasPageSize(renderer)) {
+        return SDL_FALSE;
+    }
+
+    /* Kept to move the texture to another page or out of the atlas */
+    texture->pitch = texture->w * SDL_BYTESPERPIXEL(texture->format);
+    texture->pixels = SDL_calloc(1, texture->pitch * texture->h);
+    if (!texture->pixels) {
+        return SDL_FALSE;
+    }
+
+    atlas = SDL_AtlasFindRoom(renderer, texture, &rect);
+    if (!atlas) {
+        SDL_free(texture->pixels);
+        texture->pixels = NULL;
+        texture->pitch = 0;
+        return SDL_FALSE;
+    }
+
+    texture->atlas = atlas;
+    texture->atlas_rect = rect;
+    atlas->num_textures++;
+    return SDL_TRUE;
+}
+
+void
+SDL_AtlasRemoveTexture(SDL_Texture *texture)
+{
+    SDL_Renderer *renderer = texture->renderer;
+    SDL_TextureAtlas *atlas = texture->atlas;
+    SDL_TextureAtlas **prev;
+
+    texture->atlas = NULL;
+    if (--atlas->num_textures > 0) {
+        return;
+    }
+
+    for (prev = &renderer->atlases; *prev != atlas; prev = &(*prev)->next) {
+    }
+    *prev = atlas->next;
+
+    SDL_DestroyTexture(atlas->page);  /* flushes the commands drawing from it */
+    SDL_free(atlas);
+}
+
+int
+SDL_AtlasUpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch)
+{
+    const int bpp = SDL_BYTESPERPIXEL(texture->format);
+    const Uint8 *src = (const Uint8 *) pixels;
+    Uint8 *dst = (Uint8 *) texture->pixels + rect->y * texture->pitch + rect->x * bpp;
+    int y;
+
+    for (y = 0; y < rect->h; y++) {
+        SDL_memcpy(dst, src, rect->w * bpp);
+        src += pitch;
+        dst += texture->pitch;
+    }
+
+    /* Textures in an atlas are small, the border needs updating as well */
+    return SDL_AtlasUpload(texture);
+}
+
+/* Moves the texture to a page with the new scale mode */
+int
+SDL_AtlasSetTextureScaleMode(SDL_Texture *texture, SDL_ScaleMode scaleMode)
+{
+    SDL_TextureAtlas *atlas;
+    SDL_Rect rect;
+
+    if (texture->atlas->page->scaleMode == scaleMode) {
+        return 0;
+    }
+
+    texture->scaleMode = scaleMode;
+    atlas = SDL_AtlasFindRoom(texture->renderer, texture, &rect);
+    if (!atlas) {
+        return SDL_AtlasUnpackTexture(texture);
+    }
+
+    SDL_AtlasRemoveTexture(texture);
+    texture->atlas = atlas;
+    texture->atlas_rect = rect;
+    atlas->num_textures++;
+    return SDL_AtlasUpload(texture);
+}
+
+/* Gives the texture a backend texture of its own, for what a texture in a
+   page can't do */
+int
+SDL_AtlasUnpackTexture(SDL_Texture *texture)
+{
+    SDL_Renderer *renderer = texture->renderer;
+    SDL_Rect rect;
+    int retval;
+
+    if (renderer->CreateTexture(renderer, texture) < 0) {
+        return -1;
+    }
+    SDL_AtlasRemoveTexture(texture);
+
+    rect.x = 0;
+    rect.y = 0;
+    rect.w = texture->w;
+    rect.h = texture->h;
+    retval = renderer->UpdateTexture(renderer, texture, &rect, texture->pixels, texture->pitch);
+
+    SDL_free(texture->pixels);
+    texture->pixels = NULL;
+    texture->pitch = 0;
+    return retval;
+}
+
+/* The page to draw the texture from, with srcrect moved to where the texture
+   is in it. The page takes on the color and blend mode of the texture, which
+   end up in the render commands drawing from it. */
+SDL_Texture *
+SDL_AtlasGetPage(SDL_Texture *texture, SDL_Rect *srcrect)
+{
+    SDL_Texture *page = texture->atlas->page;
+
+    if (srcrect) {
+        srcrect->x += texture->atlas_rect.x;
+        srcrect->y += texture->atlas_rect.y;
+    }
+    page->modMode = texture->modMode;
+    page->color = texture->color;
+    page->blendMode = texture->blendMode;
+    return page;
+}
+
+int
+SDL_AtlasCountPages(SDL_Renderer *renderer, int *num_textures)
+{
+    SDL_TextureAtlas *atlas;
+    int count = 0;
+
+    *num_textures = 0;
+    for (atlas = renderer->atlases; atlas; atlas = atlas->next) {
+        *num_textures += atlas->num_textures;
+        count++;
+    }
+    return count;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,68 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SDL_atlas_c_h_
+#define SDL_atlas_c_h_
+
+#include "../SDL_internal.h"
+
+#include "SDL_render.h"
+
+/* Small static textures packed into shared pages, see SDL_HINT_RENDER_ATLAS.
+
+   A texture in an atlas has no backend texture of its own, it is drawn from
+   its place in a page, so copies of different textures from the same page
+   can go to the GPU as a single draw. The page is an ordinary texture of the
+   renderer, with the format and scale mode of the textures it holds. */
+
+#define SDL_ATLAS_PAGE_SIZE 1024        /* smaller if the renderer can't make textures this large */
+#define SDL_ATLAS_MAX_TEXTURE_SIZE 256  /* larger textures gain little from sharing a page */
+#define SDL_ATLAS_MAX_SHELVES 64
+
+/* A row of textures as high as the first one placed in it */
+typedef struct SDL_AtlasShelf
+{
+    int y, h;
+    int x;                  /* where the next texture goes */
+} SDL_AtlasShelf;
+
+struct SDL_TextureAtlas
+{
+    SDL_Texture *page;
+    int num_textures;       /* the page is freed once the last one is gone */
+    SDL_AtlasShelf shelves[SDL_ATLAS_MAX_SHELVES];
+    int num_shelves;
+    struct SDL_TextureAtlas *next;
+};
+
+typedef struct SDL_TextureAtlas SDL_TextureAtlas;
+
+extern SDL_bool SDL_AtlasAddTexture(SDL_Renderer *renderer, SDL_Texture *texture);
+extern void SDL_AtlasRemoveTexture(SDL_Texture *texture);
+extern int SDL_AtlasUpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch);
+extern int SDL_AtlasSetTextureScaleMode(SDL_Texture *texture, SDL_ScaleMode scaleMode);
+extern int SDL_AtlasUnpackTexture(SDL_Texture *texture);
+extern SDL_Texture *SDL_AtlasGetPage(SDL_Texture *texture, SDL_Rect *srcrect);
+extern int SDL_AtlasCountPages(SDL_Renderer *renderer, int *num_textures);
+
+#endif /* SDL_atlas_c_h_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
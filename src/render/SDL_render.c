@@ -125,6 +125,7 @@ static const SDL_RenderDriver *render_drivers[] = {
 
 static char renderer_magic;
 static char texture_magic;
+static char command_buffer_magic;
 
 static SDL_INLINE void
 DebugLogRenderCommands(const SDL_RenderCommand *cmd)
@@ -227,9 +228,123 @@ DebugLogRenderCommands(const SDL_RenderCommand *cmd)
 #endif
 }
 
+static SDL_bool
+SameRenderState(const SDL_RenderCommand *a, const SDL_RenderCommand *b)
+{
+    switch (a->command) {
+        case SDL_RENDERCMD_SETVIEWPORT:
+            return (SDL_memcmp(&a->data.viewport.rect, &b->data.viewport.rect, sizeof(SDL_Rect)) == 0);
+
+        case SDL_RENDERCMD_SETCLIPRECT:
+            return (a->data.cliprect.enabled == b->data.cliprect.enabled &&
+                    SDL_memcmp(&a->data.cliprect.rect, &b->data.cliprect.rect, sizeof(SDL_Rect)) == 0);
+
+        case SDL_RENDERCMD_SETDRAWCOLOR:
+            return (a->data.color.r == b->data.color.r && a->data.color.g == b->data.color.g &&
+                    a->data.color.b == b->data.color.b && a->data.color.a == b->data.color.a);
+
+        default:
+            return SDL_FALSE;
+    }
+}
+
+/* Geometry queued right after other geometry, drawn the same way from the
+   vertices that follow, is drawn as part of it. The vertex range of the
+   commands shows whether the backend keeps them as a plain list the draw can
+   be extended over: padding between them or vertices kept elsewhere don't
+   line up. */
+static SDL_bool
+CanMergeGeometry(const SDL_RenderCommand *prev, const SDL_RenderCommand *cmd)
+{
+    return (prev->command == SDL_RENDERCMD_GEOMETRY &&
+            cmd->command == SDL_RENDERCMD_GEOMETRY &&
+            prev->data.draw.texture == cmd->data.draw.texture &&
+            prev->data.draw.blend == cmd->data.draw.blend &&
+            prev->data.draw.r == cmd->data.draw.r && prev->data.draw.g == cmd->data.draw.g &&
+            prev->data.draw.b == cmd->data.draw.b && prev->data.draw.a == cmd->data.draw.a &&
+            prev->data.draw.first < prev->vertex_end &&
+            cmd->data.draw.first == prev->vertex_end &&
+            cmd->data.draw.first < cmd->vertex_end);
+}
+
+/* Drops the state changes nothing gets drawn with, either because another one
+   of the same kind replaces them first or because they set what is set
+   already, and merges geometry, before the queue goes to the backend. Draws
+   stay in the order they were queued in, blending makes that order matter
+   wherever they overlap. Returns the number of commands left. */
+static Uint32
+OptimizeRenderCommands(SDL_Renderer *renderer)
+{
+    SDL_RenderCommand *pending[3] = { NULL, NULL, NULL };   /* not drawn with yet */
+    SDL_RenderCommand *current[3] = { NULL, NULL, NULL };   /* what is drawn with */
+    SDL_RenderCommand *cmd, *next, *prev = NULL, *last_draw = NULL;
+    Uint32 count = 0;
+    int i;
+
+    for (cmd = renderer->render_commands; cmd; cmd = cmd->next) {
+        switch (cmd->command) {
+            case SDL_RENDERCMD_NO_OP:
+                break;
+
+            case SDL_RENDERCMD_SETVIEWPORT:
+            case SDL_RENDERCMD_SETCLIPRECT:
+            case SDL_RENDERCMD_SETDRAWCOLOR:
+                i = (cmd->command == SDL_RENDERCMD_SETVIEWPORT) ? 0 : (cmd->command == SDL_RENDERCMD_SETCLIPRECT) ? 1 : 2;
+                if (pending[i]) {
+                    pending[i]->command = SDL_RENDERCMD_NO_OP;
+                    pending[i] = NULL;
+                }
+                if (current[i] && SameRenderState(current[i], cmd)) {
+                    cmd->command = SDL_RENDERCMD_NO_OP;
+                } else {
+                    pending[i] = cmd;
+                }
+                break;
+
+            default:
+                /* Any state change left since the last draw goes between them */
+                if (!pending[0] && !pending[1] && !pending[2] &&
+                    last_draw && CanMergeGeometry(last_draw, cmd)) {
+                    last_draw->data.draw.count += cmd->data.draw.count;
+                    last_draw->vertex_end = cmd->vertex_end;
+                    cmd->command = SDL_RENDERCMD_NO_OP;
+                    break;
+                }
+                for (i = 0; i < SDL_arraysize(pending); i++) {
+                    if (pending[i]) {
+                        current[i] = pending[i];
+                        pending[i] = NULL;
+                    }
+                }
+                last_draw = cmd;
+                break;
+        }
+    }
+
+    /* Back to the pool with what was dropped */
+    for (cmd = renderer->render_commands; cmd; cmd = next) {
+        next = cmd->next;
+        if (cmd->command != SDL_RENDERCMD_NO_OP) {
+            prev = cmd;
+            count++;
+            continue;
+        }
+        if (prev) {
+            prev->next = next;
+        } else {
+            renderer->render_commands = next;
+        }
+        cmd->next = renderer->render_commands_pool;
+        renderer->render_commands_pool = cmd;
+    }
+    renderer->render_commands_tail = prev;
+    return count;
+}
+
 static int
 FlushRenderCommands(SDL_Renderer *renderer)
 {
+    SDL_RenderCommand *cmd;
     int retval;
 
     SDL_assert((renderer->render_commands == NULL) == (renderer->render_commands_tail == NULL));
@@ -239,9 +354,20 @@ FlushRenderCommands(SDL_Renderer *renderer)
         return 0;
     }
 
+    for (cmd = renderer->render_commands; cmd; cmd = cmd->next) {
+        if (cmd->command != SDL_RENDERCMD_NO_OP) {
+            renderer->stats.commands_queued++;
+        }
+    }
+    renderer->stats.commands_run += OptimizeRenderCommands(renderer);
+
     DebugLogRenderCommands(renderer->render_commands);
 
-    retval = renderer->RunCommandQueue(renderer, renderer->render_commands, renderer->vertex_data, renderer->vertex_data_used);
+    if (renderer->render_commands) {
+        retval = renderer->RunCommandQueue(renderer, renderer->render_commands, renderer->vertex_data, renderer->vertex_data_used);
+    } else {
+        retval = 0;  /* nothing left worth running */
+    }
 
     /* Move the whole render command queue to the unused pool so we can reuse them next time. */
     if (renderer->render_commands_tail != NULL) {
@@ -645,6 +771,7 @@ QueueCmdGeometry(SDL_Renderer *renderer, SDL_Texture *texture,
         if (retval < 0) {
             cmd->command = SDL_RENDERCMD_NO_OP;
         }
+        cmd->vertex_end = renderer->vertex_data_used;
     }
     return retval;
 }
@@ -1011,6 +1138,12 @@ SDL_CreateRenderer(SDL_Window * window, int index, Uint32 flags)
     }
 
     renderer->batching = batching;
+
+    /* Software rendering doesn't get faster by drawing from fewer textures */
+    if (!(renderer->info.flags & SDL_RENDERER_SOFTWARE)) {
+        renderer->atlas_enabled = SDL_GetHintBoolean(SDL_HINT_RENDER_ATLAS, SDL_FALSE);
+    }
+
     renderer->magic = &renderer_magic;
     renderer->window = window;
     renderer->target_mutex = SDL_CreateMutex();
@@ -1268,7 +1401,9 @@ SDL_CreateTexture(SDL_Renderer * renderer, Uint32 format, int access, int w, int
     texture_is_fourcc_and_target = (access == SDL_TEXTUREACCESS_TARGET && SDL_ISPIXELFORMAT_FOURCC(texture->format));
 
     if (texture_is_fourcc_and_target == SDL_FALSE && IsSupportedFormat(renderer, format)) {
-        if (renderer->CreateTexture(renderer, texture) < 0) {
+        if (SDL_AtlasAddTexture(renderer, texture)) {
+            /* drawn from a page shared with other textures */
+        } else if (renderer->CreateTexture(renderer, texture) < 0) {
             SDL_DestroyTexture(texture);
             return NULL;
         }
@@ -1605,6 +1740,8 @@ SDL_SetTextureScaleMode(SDL_Texture * texture, SDL_ScaleMode scaleMode)
     texture->scaleMode = scaleMode;
     if (texture->native) {
         return SDL_SetTextureScaleMode(texture->native, scaleMode);
+    } else if (texture->atlas) {
+        return SDL_AtlasSetTextureScaleMode(texture, scaleMode);
     } else {
         renderer->SetTextureScaleMode(renderer, texture, scaleMode);
     }
@@ -1761,6 +1898,8 @@ SDL_UpdateTexture(SDL_Texture * texture, const SDL_Rect * rect,
 #endif
     } else if (texture->native) {
         return SDL_UpdateTextureNative(texture, &real_rect, pixels, pitch);
+    } else if (texture->atlas) {
+        return SDL_AtlasUpdateTexture(texture, &real_rect, pixels, pitch);
     } else {
         SDL_Renderer *renderer = texture->renderer;
         if (FlushRenderCommandsIfTextureNeeded(texture) < 0) {
@@ -3460,6 +3599,10 @@ SDL_RenderCopyF(SDL_Renderer * renderer, SDL_Texture * texture,
         texture = texture->native;
     }
 
+    if (texture->atlas) {
+        texture = SDL_AtlasGetPage(texture, &real_srcrect);
+    }
+
     texture->last_command_generation = renderer->render_command_generation;
 
     if (use_rendergeometry) {
@@ -3601,6 +3744,10 @@ SDL_RenderCopyExF(SDL_Renderer * renderer, SDL_Texture * texture,
         texture = texture->native;
     }
 
+    if (texture->atlas) {
+        texture = SDL_AtlasGetPage(texture, &real_srcrect);
+    }
+
     if (center) {
         real_center = *center;
     } else {
@@ -4062,6 +4209,66 @@ end:
     return retval;
 }
 
+static int
+CheckGeometryBounds(SDL_Texture *texture,
+                    const float *uv, int uv_stride,
+                    int num_vertices,
+                    const void *indices, int num_indices, int size_indices)
+{
+    int i;
+
+    if (texture) {
+        for (i = 0; i < num_vertices; ++i) {
+            const float *uv_ = (const float *)((const char*)uv + i * uv_stride);
+            float u = uv_[0];
+            float v = uv_[1];
+            if (u < 0.0f || v < 0.0f || u > 1.0f || v > 1.0f) {
+                return SDL_SetError("Values of 'uv' out of bounds %f %f at %d/%d", u, v, i, num_vertices);
+            }
+        }
+    }
+
+    if (indices) {
+        for (i = 0; i < num_indices; ++i) {
+            int j;
+            if (size_indices == 4) {
+                j = ((const Uint32 *)indices)[i];
+            } else if (size_indices == 2) {
+                j = ((const Uint16 *)indices)[i];
+            } else {
+                j = ((const Uint8 *)indices)[i];
+            }
+            if (j < 0 || j >= num_vertices) {
+                return SDL_SetError("Values of 'indices' out of bounds");
+            }
+        }
+    }
+    return 0;
+}
+
+/* Texture coordinates of a texture in an atlas moved to where it is in its
+   page, free with SDL_small_free() */
+static float *
+GetAtlasGeometryUV(SDL_Texture *texture, const float *uv, int uv_stride, int num_vertices, SDL_bool *isstack)
+{
+    const SDL_Rect *rect = &texture->atlas_rect;
+    const SDL_Texture *page = texture->atlas->page;
+    float *atlas_uv;
+    int i;
+
+    atlas_uv = SDL_small_alloc(float, num_vertices * 2, isstack);
+    if (!atlas_uv) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    for (i = 0; i < num_vertices; ++i) {
+        const float *uv_ = (const float *)((const char*)uv + i * uv_stride);
+        atlas_uv[i * 2] = (rect->x + uv_[0] * rect->w) / page->w;
+        atlas_uv[i * 2 + 1] = (rect->y + uv_[1] * rect->h) / page->h;
+    }
+    return atlas_uv;
+}
+
 int
 SDL_RenderGeometryRaw(SDL_Renderer *renderer,
                                   SDL_Texture *texture,
@@ -4071,9 +4278,10 @@ SDL_RenderGeometryRaw(SDL_Renderer *renderer,
                                   int num_vertices,
                                   const void *indices, int num_indices, int size_indices)
 {
-    int i;
     int retval = 0;
     int count = indices ? num_indices : num_vertices;
+    float *atlas_uv = NULL;
+    SDL_bool isstack = SDL_FALSE;
 
     CHECK_RENDERER_MAGIC(renderer, -1);
 
@@ -4128,31 +4336,19 @@ SDL_RenderGeometryRaw(SDL_Renderer *renderer,
         texture = texture->native;
     }
 
-    if (texture) {
-        for (i = 0; i < num_vertices; ++i) {
-            const float *uv_ = (const float *)((const char*)uv + i * uv_stride);
-            float u = uv_[0];
-            float v = uv_[1];
-            if (u < 0.0f || v < 0.0f || u > 1.0f || v > 1.0f) {
-                return SDL_SetError("Values of 'uv' out of bounds %f %f at %d/%d", u, v, i, num_vertices);
-            }
-        }
+    if (CheckGeometryBounds(texture, uv, uv_stride, num_vertices, indices, num_indices, size_indices) < 0) {
+        return -1;
     }
 
-    if (indices) {
-        for (i = 0; i < num_indices; ++i) {
-            int j;
-            if (size_indices == 4) {
-                j = ((const Uint32 *)indices)[i];
-            } else if (size_indices == 2) {
-                j = ((const Uint16 *)indices)[i];
-            } else {
-                j = ((const Uint8 *)indices)[i];
-            }
-            if (j < 0 || j >= num_vertices) {
-                return SDL_SetError("Values of 'indices' out of bounds");
-            }
+    /* Texture coordinates of a texture in an atlas are moved into its page */
+    if (texture && texture->atlas) {
+        atlas_uv = GetAtlasGeometryUV(texture, uv, uv_stride, num_vertices, &isstack);
+        if (!atlas_uv) {
+            return -1;
         }
+        texture = SDL_AtlasGetPage(texture, NULL);
+        uv = atlas_uv;
+        uv_stride = 2 * sizeof (float);
     }
 
     if (texture) {
@@ -4172,9 +4368,422 @@ SDL_RenderGeometryRaw(SDL_Renderer *renderer,
             indices, num_indices, size_indices,
             renderer->scale.x, renderer->scale.y);
 
+    if (atlas_uv) {
+        SDL_small_free(atlas_uv, isstack);
+    }
+
     return retval < 0 ? retval : FlushRenderCommandsIfNotBatching(renderer);
 }
 
+/* The renderer's state the recorded commands depend on is taken over by the
+   recorder, its command queue and vertex data stay the buffer's own */
+static void
+SyncRenderCommandBuffer(SDL_RenderCommandBuffer *buffer)
+{
+    SDL_Renderer *recorder = &buffer->recorder;
+    SDL_RenderCommand *pool = recorder->render_commands_pool;
+    void *vertex_data = recorder->vertex_data;
+    const size_t vertex_data_allocation = recorder->vertex_data_allocation;
+
+    *recorder = *buffer->renderer;
+    recorder->magic = NULL;  /* not a renderer to call the API with */
+    recorder->render_commands = NULL;
+    recorder->render_commands_tail = NULL;
+    recorder->render_commands_pool = pool;
+    recorder->vertex_data = vertex_data;
+    recorder->vertex_data_used = 0;
+    recorder->vertex_data_allocation = vertex_data_allocation;
+}
+
+SDL_RenderCommandBuffer *
+SDL_CreateRenderCommandBuffer(SDL_Renderer * renderer)
+{
+    SDL_RenderCommandBuffer *buffer;
+
+    CHECK_RENDERER_MAGIC(renderer, NULL);
+
+    if (!renderer->QueueGeometry) {
+        SDL_Unsupported();
+        return NULL;
+    }
+
+    buffer = (SDL_RenderCommandBuffer *) SDL_calloc(1, sizeof(*buffer));
+    if (!buffer) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    buffer->magic = &command_buffer_magic;
+    buffer->renderer = renderer;
+    SyncRenderCommandBuffer(buffer);
+    return buffer;
+}
+
+/* Sets up a draw command in the buffer the way PrepQueueCmdDraw() does for
+   the renderer. The texture is the one drawn from, an atlas page instead of
+   the texture in it, without taking on its color and blend mode the way
+   SDL_AtlasGetPage() has it. */
+static SDL_RenderCommand *
+PrepRecordCmdDraw(SDL_RenderCommandBuffer *buffer, const SDL_RenderCommandType cmdtype, SDL_Texture *texture,
+                  const SDL_Color *mod, SDL_BlendMode blendMode)
+{
+    SDL_RenderCommand *cmd = AllocateRenderCommand(&buffer->recorder);
+    if (cmd) {
+        cmd->command = cmdtype;
+        cmd->data.draw.first = 0;  /* render backend will fill this in. */
+        cmd->data.draw.count = 0;  /* render backend will fill this in. */
+        cmd->data.draw.r = mod->r;
+        cmd->data.draw.g = mod->g;
+        cmd->data.draw.b = mod->b;
+        cmd->data.draw.a = mod->a;
+        cmd->data.draw.blend = blendMode;
+        cmd->data.draw.texture = texture;
+    }
+    return cmd;
+}
+
+/* The commands only need their vertex offsets moved once they are copied
+   into the renderer's queue, so the backend has to keep the vertices in the
+   buffer's vertex data */
+static int
+FinishRecordCmdDraw(SDL_RenderCommandBuffer *buffer, SDL_RenderCommand *cmd, size_t vertex_data_used, int retval)
+{
+    SDL_Renderer *recorder = &buffer->recorder;
+
+    if (retval == 0 && recorder->vertex_data_used == vertex_data_used) {
+        retval = SDL_Unsupported();
+    }
+    if (retval < 0) {
+        cmd->command = SDL_RENDERCMD_NO_OP;
+    }
+    cmd->vertex_end = recorder->vertex_data_used;
+    return retval;
+}
+
+/* Queues the geometry into the buffer the way QueueCmdGeometry() queues it for the renderer */
+static int
+RecordGeometry(SDL_RenderCommandBuffer *buffer, SDL_Texture *texture,
+               const SDL_Color *mod, SDL_BlendMode blendMode,
+               const float *xy, int xy_stride,
+               const SDL_Color *color, int color_stride,
+               const float *uv, int uv_stride,
+               int num_vertices,
+               const void *indices, int num_indices, int size_indices)
+{
+    SDL_Renderer *recorder = &buffer->recorder;
+    const size_t vertex_data_used = recorder->vertex_data_used;
+    SDL_RenderCommand *cmd = PrepRecordCmdDraw(buffer, SDL_RENDERCMD_GEOMETRY, texture, mod, blendMode);
+    int retval = -1;
+
+    if (cmd) {
+        retval = recorder->QueueGeometry(recorder, cmd, texture,
+                xy, xy_stride, color, color_stride, uv, uv_stride,
+                num_vertices, indices, num_indices, size_indices,
+                recorder->scale.x, recorder->scale.y);
+        retval = FinishRecordCmdDraw(buffer, cmd, vertex_data_used, retval);
+    }
+    return retval;
+}
+
+/* Same for QueueCmdCopy(), used by renderers that copy textures other than with geometry */
+static int
+RecordCopy(SDL_RenderCommandBuffer *buffer, SDL_Texture *texture,
+           const SDL_Color *mod, SDL_BlendMode blendMode,
+           const SDL_Rect *srcrect, const SDL_FRect *dstrect)
+{
+    SDL_Renderer *recorder = &buffer->recorder;
+    const size_t vertex_data_used = recorder->vertex_data_used;
+    SDL_RenderCommand *cmd = PrepRecordCmdDraw(buffer, SDL_RENDERCMD_COPY, texture, mod, blendMode);
+    int retval = -1;
+
+    if (cmd) {
+        retval = recorder->QueueCopy(recorder, cmd, texture, srcrect, dstrect);
+        retval = FinishRecordCmdDraw(buffer, cmd, vertex_data_used, retval);
+    }
+    return retval;
+}
+
+#define CHECK_COMMAND_BUFFER_MAGIC(buffer, retval) \
+    if (!buffer || buffer->magic != &command_buffer_magic) { \
+        SDL_InvalidParamError("buffer"); \
+        return retval; \
+    }
+
+int
+SDL_RecordRenderCopyF(SDL_RenderCommandBuffer * buffer, SDL_Texture * texture,
+                      const SDL_Rect * srcrect, const SDL_FRect * dstrect)
+{
+    SDL_Rect real_srcrect;
+    SDL_FRect real_dstrect;
+    SDL_Texture *drawn;
+    float xy[8];
+    float uv[8];
+    const int indices[6] = {0, 1, 2, 0, 2, 3};
+    float minu, minv, maxu, maxv;
+
+    CHECK_COMMAND_BUFFER_MAGIC(buffer, -1);
+    CHECK_TEXTURE_MAGIC(texture, -1);
+
+    if (buffer->renderer != texture->renderer) {
+        return SDL_SetError("Texture was not created with this renderer");
+    }
+
+    real_srcrect.x = 0;
+    real_srcrect.y = 0;
+    real_srcrect.w = texture->w;
+    real_srcrect.h = texture->h;
+    if (srcrect) {
+        if (!SDL_IntersectRect(srcrect, &real_srcrect, &real_srcrect)) {
+            return 0;
+        }
+    }
+
+    RenderGetViewportSize(&buffer->recorder, &real_dstrect);
+    if (dstrect) {
+        if (!SDL_HasIntersectionF(dstrect, &real_dstrect)) {
+            return 0;
+        }
+        real_dstrect = *dstrect;
+    }
+
+    if (texture->native) {
+        texture = texture->native;
+    }
+
+    drawn = texture;
+    if (texture->atlas) {
+        drawn = texture->atlas->page;
+        real_srcrect.x += texture->atlas_rect.x;
+        real_srcrect.y += texture->atlas_rect.y;
+    }
+
+    /* The same path SDL_RenderCopyF() takes, the software renderer blits copies */
+    if (buffer->recorder.QueueCopy) {
+        real_dstrect.x *= buffer->recorder.scale.x;
+        real_dstrect.y *= buffer->recorder.scale.y;
+        real_dstrect.w *= buffer->recorder.scale.x;
+        real_dstrect.h *= buffer->recorder.scale.y;
+        return RecordCopy(buffer, drawn, &texture->color, texture->blendMode, &real_srcrect, &real_dstrect);
+    }
+
+    minu = (float) (real_srcrect.x) / (float) drawn->w;
+    minv = (float) (real_srcrect.y) / (float) drawn->h;
+    maxu = (float) (real_srcrect.x + real_srcrect.w) / (float) drawn->w;
+    maxv = (float) (real_srcrect.y + real_srcrect.h) / (float) drawn->h;
+
+    uv[0] = minu;
+    uv[1] = minv;
+    uv[2] = maxu;
+    uv[3] = minv;
+    uv[4] = maxu;
+    uv[5] = maxv;
+    uv[6] = minu;
+    uv[7] = maxv;
+
+    xy[0] = real_dstrect.x;
+    xy[1] = real_dstrect.y;
+    xy[2] = real_dstrect.x + real_dstrect.w;
+    xy[3] = real_dstrect.y;
+    xy[4] = real_dstrect.x + real_dstrect.w;
+    xy[5] = real_dstrect.y + real_dstrect.h;
+    xy[6] = real_dstrect.x;
+    xy[7] = real_dstrect.y + real_dstrect.h;
+
+    return RecordGeometry(buffer, drawn, &texture->color, texture->blendMode,
+            xy, 2 * sizeof (float), &texture->color, 0 /* color_stride */, uv, 2 * sizeof (float),
+            4, indices, 6, 4);
+}
+
+int
+SDL_RecordRenderGeometry(SDL_RenderCommandBuffer * buffer, SDL_Texture * texture,
+                         const SDL_Vertex * vertices, int num_vertices,
+                         const int * indices, int num_indices)
+{
+    const int count = indices ? num_indices : num_vertices;
+    const float *uv;
+    int uv_stride = sizeof (SDL_Vertex);
+    float *atlas_uv = NULL;
+    SDL_bool isstack = SDL_FALSE;
+    SDL_Texture *drawn = texture;
+    int retval;
+
+    CHECK_COMMAND_BUFFER_MAGIC(buffer, -1);
+
+    /* SDL_RenderGeometry() has the software renderer draw rectangles where it can,
+       which takes the renderer's thread */
+    if (buffer->recorder.info.flags & SDL_RENDERER_SOFTWARE) {
+        return SDL_Unsupported();
+    }
+
+    if (texture) {
+        CHECK_TEXTURE_MAGIC(texture, -1);
+
+        if (buffer->renderer != texture->renderer) {
+            return SDL_SetError("Texture was not created with this renderer");
+        }
+    }
+
+    if (!vertices) {
+        return SDL_InvalidParamError("vertices");
+    }
+
+    if (count % 3 != 0) {
+        return SDL_InvalidParamError(indices ? "num_indices" : "num_vertices");
+    }
+
+    if (num_vertices < 3) {
+        return 0;
+    }
+
+    uv = &vertices->tex_coord.x;
+    if (CheckGeometryBounds(texture, uv, uv_stride, num_vertices, indices, num_indices, 4) < 0) {
+        return -1;
+    }
+
+    if (texture && texture->native) {
+        texture = drawn = texture->native;
+    }
+
+    if (texture && texture->atlas) {
+        atlas_uv = GetAtlasGeometryUV(texture, uv, uv_stride, num_vertices, &isstack);
+        if (!atlas_uv) {
+            return -1;
+        }
+        drawn = texture->atlas->page;
+        uv = atlas_uv;
+        uv_stride = 2 * sizeof (float);
+    }
+
+    retval = RecordGeometry(buffer, drawn,
+            texture ? &texture->color : &buffer->recorder.color,
+            texture ? texture->blendMode : buffer->recorder.blendMode,
+            &vertices->position.x, sizeof (SDL_Vertex),
+            &vertices->color, sizeof (SDL_Vertex),
+            uv, uv_stride,
+            num_vertices, indices, num_indices, indices ? 4 : 0);
+
+    if (atlas_uv) {
+        SDL_small_free(atlas_uv, isstack);
+    }
+    return retval;
+}
+
+/* The vertices were made for the target and scale the recorder has, and the
+   copies were culled against its viewport */
+static SDL_bool
+SameRecordingState(const SDL_Renderer *recorder, const SDL_Renderer *renderer)
+{
+    return recorder->target == renderer->target &&
+           recorder->scale.x == renderer->scale.x && recorder->scale.y == renderer->scale.y &&
+           recorder->logical_w == renderer->logical_w && recorder->logical_h == renderer->logical_h &&
+           SDL_memcmp(&recorder->viewport, &renderer->viewport, sizeof (renderer->viewport)) == 0;
+}
+
+/* Gives the recorded commands back to the buffer's pool */
+static void
+ResetRenderCommandBuffer(SDL_RenderCommandBuffer *buffer)
+{
+    SDL_Renderer *recorder = &buffer->recorder;
+
+    if (recorder->render_commands_tail) {
+        recorder->render_commands_tail->next = recorder->render_commands_pool;
+        recorder->render_commands_pool = recorder->render_commands;
+    }
+    SyncRenderCommandBuffer(buffer);
+}
+
+int
+SDL_RenderSubmitCommandBuffer(SDL_RenderCommandBuffer * buffer)
+{
+    SDL_Renderer *renderer;
+    SDL_Renderer *recorder;
+    SDL_RenderCommand *src, *cmd;
+    size_t offset = 0;
+    void *vertices;
+    int retval = 0;
+
+    CHECK_COMMAND_BUFFER_MAGIC(buffer, -1);
+
+    renderer = buffer->renderer;
+    recorder = &buffer->recorder;
+
+    if (!recorder->render_commands) {
+        ResetRenderCommandBuffer(buffer);
+        return 0;
+    }
+
+    if (!SameRecordingState(recorder, renderer)) {
+        ResetRenderCommandBuffer(buffer);
+        return SDL_SetError("The render target, scale or viewport changed while the commands were recorded");
+    }
+
+#if DONT_DRAW_WHILE_HIDDEN
+    /* Don't draw while we're hidden */
+    if (renderer->hidden) {
+        ResetRenderCommandBuffer(buffer);
+        return 0;
+    }
+#endif
+
+    /* Set the viewport and clip rect directly before draws, as PrepQueueCmdDraw() does */
+    if (!renderer->viewport_queued) {
+        retval = QueueCmdSetViewport(renderer);
+    }
+    if (retval == 0 && !renderer->cliprect_queued) {
+        retval = QueueCmdSetClipRect(renderer);
+    }
+
+    /* Aligned at least as much as the backends align anything in the buffer,
+       so the vertices stay aligned after they are moved */
+    if (retval == 0) {
+        vertices = SDL_AllocateRenderVertices(renderer, recorder->vertex_data_used, 16, &offset);
+        if (vertices) {
+            SDL_memcpy(vertices, recorder->vertex_data, recorder->vertex_data_used);
+        } else {
+            retval = -1;
+        }
+    }
+
+    for (src = recorder->render_commands; src && retval == 0; src = src->next) {
+        if (src->command == SDL_RENDERCMD_NO_OP) {
+            continue;
+        }
+        cmd = AllocateRenderCommand(renderer);
+        if (!cmd) {
+            retval = -1;
+            break;
+        }
+        cmd->command = src->command;
+        cmd->data = src->data;
+        cmd->data.draw.first += offset;
+        cmd->vertex_end = src->vertex_end + offset;
+        if (cmd->data.draw.texture) {
+            cmd->data.draw.texture->last_command_generation = renderer->render_command_generation;
+        }
+    }
+
+    ResetRenderCommandBuffer(buffer);
+
+    return retval < 0 ? retval : FlushRenderCommandsIfNotBatching(renderer);
+}
+
+void
+SDL_DestroyRenderCommandBuffer(SDL_RenderCommandBuffer * buffer)
+{
+    SDL_RenderCommand *cmd, *next;
+
+    CHECK_COMMAND_BUFFER_MAGIC(buffer, );
+
+    ResetRenderCommandBuffer(buffer);
+    for (cmd = buffer->recorder.render_commands_pool; cmd; cmd = next) {
+        next = cmd->next;
+        SDL_free(cmd);
+    }
+    SDL_free(buffer->recorder.vertex_data);
+
+    buffer->magic = NULL;
+    SDL_free(buffer);
+}
+
 
 int
 SDL_RenderReadPixels(SDL_Renderer * renderer, const SDL_Rect * rect,
@@ -4226,6 +4835,9 @@ SDL_RenderPresent(SDL_Renderer * renderer)
 
     FlushRenderCommands(renderer);  /* time to send everything to the GPU! */
 
+    renderer->last_stats = renderer->stats;
+    SDL_zero(renderer->stats);
+
 #if DONT_DRAW_WHILE_HIDDEN
     /* Don't present while we're hidden */
     if (renderer->hidden) {
@@ -4236,6 +4848,20 @@ SDL_RenderPresent(SDL_Renderer * renderer)
     renderer->RenderPresent(renderer);
 }
 
+int
+SDL_RenderGetStats(SDL_Renderer * renderer, SDL_RenderStats * stats)
+{
+    CHECK_RENDERER_MAGIC(renderer, -1);
+
+    if (!stats) {
+        return SDL_InvalidParamError("stats");
+    }
+
+    *stats = renderer->last_stats;
+    stats->atlas_pages = SDL_AtlasCountPages(renderer, &stats->atlas_textures);
+    return 0;
+}
+
 void
 SDL_DestroyTexture(SDL_Texture * texture)
 {
@@ -4271,7 +4897,11 @@ SDL_DestroyTexture(SDL_Texture * texture)
 #endif
     SDL_free(texture->pixels);
 
-    renderer->DestroyTexture(renderer, texture);
+    if (texture->atlas) {
+        SDL_AtlasRemoveTexture(texture);
+    } else {
+        renderer->DestroyTexture(renderer, texture);
+    }
 
     SDL_FreeSurface(texture->locked_surface);
     texture->locked_surface = NULL;
@@ -4335,6 +4965,12 @@ int SDL_GL_BindTexture(SDL_Texture *texture, float *texw, float *texh)
 
     CHECK_TEXTURE_MAGIC(texture, -1);
     renderer = texture->renderer;
+    if (texture->atlas && renderer->GL_BindTexture) {
+        /* The application can't tell where the texture is in its page */
+        if (SDL_AtlasUnpackTexture(texture) < 0) {
+            return -1;
+        }
+    }
     if (texture->native) {
         return SDL_GL_BindTexture(texture->native, texw, texh);
     } else if (renderer && renderer->GL_BindTexture) {
@@ -4351,6 +4987,9 @@ int SDL_GL_UnbindTexture(SDL_Texture *texture)
 
     CHECK_TEXTURE_MAGIC(texture, -1);
     renderer = texture->renderer;
+    if (texture->atlas) {
+        return 0;  /* it was never bound, binding takes it out of the atlas */
+    }
     if (texture->native) {
         return SDL_GL_UnbindTexture(texture->native);
     } else if (renderer && renderer->GL_UnbindTexture) {
@@ -27,6 +27,7 @@
 #include "SDL_events.h"
 #include "SDL_mutex.h"
 #include "SDL_yuv_sw_c.h"
+#include "SDL_atlas_c.h"
 
 
 /**
@@ -60,10 +61,14 @@ struct SDL_Texture
 
     SDL_Renderer *renderer;
 
+    /* Packed into a page shared with other textures, see SDL_atlas_c.h */
+    SDL_TextureAtlas *atlas;
+    SDL_Rect atlas_rect;
+
     /* Support for formats not supported directly by the renderer */
     SDL_Texture *native;
     SDL_SW_YUVTexture *yuv;
-    void *pixels;
+    void *pixels;               /**< also the contents of a texture in an atlas, to move it to another page */
     int pitch;
     SDL_Rect locked_rect;
     SDL_Surface *locked_surface;  /**< Locked region exposed as a SDL surface */
@@ -116,6 +121,7 @@ typedef struct SDL_RenderCommand
             Uint8 r, g, b, a;
         } color;
     } data;
+    size_t vertex_end;  /* vertex_data_used once the backend queued the geometry, see OptimizeRenderCommands() */
     struct SDL_RenderCommand *next;
 } SDL_RenderCommand;
 
@@ -268,9 +274,28 @@ struct SDL_Renderer
     size_t vertex_data_used;
     size_t vertex_data_allocation;
 
+    /* Pages small static textures are packed into, if SDL_HINT_RENDER_ATLAS is set */
+    SDL_bool atlas_enabled;
+    SDL_TextureAtlas *atlases;
+
+    /* Counted since the last present, the backends count draw_calls */
+    SDL_RenderStats stats;
+    SDL_RenderStats last_stats;
+
     void *driverdata;
 };
 
+/* Render commands recorded on other threads, see SDL_CreateRenderCommandBuffer() */
+struct SDL_RenderCommandBuffer
+{
+    const void *magic;
+    SDL_Renderer *renderer;
+
+    /* A copy of the renderer as of the last submit, with a command queue and
+       vertex data of its own that the backend queues into */
+    SDL_Renderer recorder;
+};
+
 /* Define the SDL render driver structure */
 struct SDL_RenderDriver
 {
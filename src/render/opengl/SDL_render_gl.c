@@ -1319,6 +1319,7 @@ GL_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *vertic
                     if (count > 2) {
                         /* joined lines cannot be grouped */
                         data->glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)count);
+                        renderer->stats.draw_calls++;
                     } else {
                         /* let's group non joined lines */
                         SDL_RenderCommand *finalcmd = cmd;
@@ -1341,6 +1342,7 @@ GL_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *vertic
                         }
 
                         data->glDrawArrays(GL_LINES, 0, (GLsizei)count);
+                        renderer->stats.draw_calls++;
                         cmd = finalcmd;  /* skip any copy commands we just combined in here. */
                     }
                 }
@@ -1400,6 +1402,7 @@ GL_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *vertic
                     }
 
                     data->glDrawArrays(op, 0, (GLsizei) count);
+                    renderer->stats.draw_calls++;
 
                     /* Restore previously set color when we're done. */
                     if (thiscmdtype != SDL_RENDERCMD_DRAW_POINTS) {
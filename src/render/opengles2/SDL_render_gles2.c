@@ -28,17 +28,24 @@
 #include "../../video/SDL_blit.h"
 #include "SDL_shaders_gles2.h"
 
+#include <stdio.h>  /* rename(), remove() */
+
 /* WebGL doesn't offer client-side arrays, so use Vertex Buffer Objects
    on Emscripten, which converts GLES2 into WebGL calls.
    In all other cases, attempt to use client-side arrays, as they tend to
-   be dramatically faster when not batching, and about the same when
-   we are. */
+   be dramatically faster when not batching. When batching, the driver
+   copying the vertices of every draw out of client memory costs more than
+   streaming them into a buffer object once per batch, so that is done where
+   GL_EXT_map_buffer_range is supported, see GLES2_UploadVertices(). */
 #if defined(__EMSCRIPTEN__)
 #define USE_VERTEX_BUFFER_OBJECTS 1
 #else
 #define USE_VERTEX_BUFFER_OBJECTS 0
 #endif
 
+/* Where the vertex ring starts out, it grows to hold the largest batch */
+#define GLES2_VERTEX_RING_SIZE (256 * 1024)
+
 /* To prevent unnecessary window recreation,
  * these should match the defaults selected in SDL_GL_ResetAttributes
  */
@@ -82,8 +89,8 @@ typedef struct GLES2_TextureData
 typedef struct GLES2_ProgramCacheEntry
 {
     GLuint id;
-    GLuint vertex_shader;
-    GLuint fragment_shader;
+    GLES2_ShaderType vertex_type;
+    GLES2_ShaderType fragment_type;
     GLuint uniform_locations[16];
     GLfloat projection[4][4];
     struct GLES2_ProgramCacheEntry *prev;
@@ -93,6 +100,7 @@ typedef struct GLES2_ProgramCacheEntry
 typedef struct GLES2_ProgramCache
 {
     int count;
+    int max_count;          /* GLES2_MAX_CACHED_PROGRAMS, unless they are all precompiled */
     GLES2_ProgramCacheEntry *head;
     GLES2_ProgramCacheEntry *tail;
 } GLES2_ProgramCache;
@@ -162,17 +170,29 @@ typedef struct GLES2_RenderData
     GLES2_ProgramCache program_cache;
     Uint8 clear_r, clear_g, clear_b, clear_a;
 
-#if USE_VERTEX_BUFFER_OBJECTS
-    GLuint vertex_buffers[8];
-    size_t vertex_buffer_size[8];
-    int current_vertex_buffer;
-#endif
+    /* Linked programs are kept between runs in program_binary_dir, see
+       SDL_HINT_RENDER_GLES2_PROGRAM_CACHE. NULL if they aren't. */
+    char *program_binary_dir;
+    Uint32 program_binary_driver;   /* hash of the driver, a new one can't load the old binaries */
+    PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOES;
+    PFNGLPROGRAMBINARYOESPROC glProgramBinaryOES;
+
+    /* Vertices of each batch go after those of the previous ones, the
+       buffer is only orphaned once it is full. 0 if client-side arrays are
+       used instead. */
+    GLuint vertex_buffer;
+    size_t vertex_buffer_size;
+    size_t vertex_buffer_used;
+    PFNGLMAPBUFFERRANGEEXTPROC glMapBufferRangeEXT;
+    PFNGLUNMAPBUFFEROESPROC glUnmapBufferOES;
 
     GLES2_DrawStateCache drawstate;
 } GLES2_RenderData;
 
 #define GLES2_MAX_CACHED_PROGRAMS 8
 
+#define GLES2_PROGRAM_BINARY_MAGIC SDL_FOURCC('S', 'G', 'P', 'B')
+
 static const float inv255f = 1.0f / 255.0f;
 
 
@@ -387,16 +407,208 @@ GLES2_SupportsBlendMode(SDL_Renderer * renderer, SDL_BlendMode blendMode)
 }
 
 
+static GLuint
+GLES2_CacheShader(GLES2_RenderData *data, GLES2_ShaderType type, GLenum shader_type)
+{
+    GLuint id;
+    GLint compileSuccessful = GL_FALSE;
+    const char *shader_src = (char *)GLES2_GetShader(type);
+
+    if (!shader_src) {
+        SDL_SetError("No shader src");
+        return 0;
+    }
+
+    /* Compile */
+    id = data->glCreateShader(shader_type);
+    data->glShaderSource(id, 1, &shader_src, NULL);
+    data->glCompileShader(id);
+    data->glGetShaderiv(id, GL_COMPILE_STATUS, &compileSuccessful);
+
+    if (!compileSuccessful) {
+        SDL_bool isstack = SDL_FALSE;
+        char *info = NULL;
+        int length = 0;
+
+        data->glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+        if (length > 0) {
+            info = SDL_small_alloc(char, length, &isstack);
+            if (info) {
+                data->glGetShaderInfoLog(id, length, &length, info);
+            }
+        }
+        if (info) {
+            SDL_SetError("Failed to load the shader: %s", info);
+            SDL_small_free(info, isstack);
+        } else {
+            SDL_SetError("Failed to load the shader");
+        }
+        data->glDeleteShader(id);
+        return 0;
+    }
+
+    /* Cache */
+    data->shader_id_cache[(Uint32)type] = id;
+
+    return id;
+}
+
+/* The file a linked program is kept in, named after a hash of the driver and
+   the shader sources, so a driver update or changed shaders never load a
+   stale binary. NULL if programs aren't kept between runs. */
+static char *
+GLES2_GetProgramBinaryPath(GLES2_RenderData *data, GLES2_ShaderType vtype, GLES2_ShaderType ftype)
+{
+    const char *vsrc = (const char *) GLES2_GetShader(vtype);
+    const char *fsrc = (const char *) GLES2_GetShader(ftype);
+    Uint32 hash = data->program_binary_driver;
+    size_t length;
+    char *path;
+
+    if (!data->program_binary_dir || !vsrc || !fsrc) {
+        return NULL;
+    }
+
+    hash = SDL_crc32(hash, vsrc, SDL_strlen(vsrc) + 1);
+    hash = SDL_crc32(hash, fsrc, SDL_strlen(fsrc) + 1);
+
+    length = SDL_strlen(data->program_binary_dir) + 32;
+    path = (char *) SDL_malloc(length);
+    if (path) {
+        SDL_snprintf(path, length, "%s/gles2-%08x.bin", data->program_binary_dir, (unsigned int) hash);
+    }
+    return path;
+}
+
+/* Creates the program from a binary an earlier run saved, 0 if there is none
+   or the driver doesn't take it anymore */
+static GLuint
+GLES2_LoadProgramBinary(GLES2_RenderData *data, const char *path)
+{
+    SDL_RWops *rw;
+    Uint32 header[3];   /* magic, binary format, length */
+    void *binary = NULL;
+    GLint linkSuccessful = GL_FALSE;
+    GLuint id = 0;
+
+    rw = SDL_RWFromFile(path, "rb");
+    if (!rw) {
+        return 0;
+    }
+    if (SDL_RWread(rw, header, sizeof(header), 1) == 1 &&
+        header[0] == GLES2_PROGRAM_BINARY_MAGIC && header[2] > 0 &&
+        (Sint64) (header[2] + sizeof(header)) == SDL_RWsize(rw)) {
+        binary = SDL_malloc(header[2]);
+    }
+    if (binary && SDL_RWread(rw, binary, header[2], 1) == 1) {
+        id = data->glCreateProgram();
+        data->glProgramBinaryOES(id, (GLenum) header[1], binary, (GLint) header[2]);
+        data->glGetProgramiv(id, GL_LINK_STATUS, &linkSuccessful);
+        if (!linkSuccessful) {
+            data->glDeleteProgram(id);
+            id = 0;
+        }
+    }
+    SDL_free(binary);
+    SDL_RWclose(rw);
+    return id;
+}
+
+/* Keeps the program for the next run, a program that isn't kept is only
+   linked again then */
+static void
+GLES2_SaveProgramBinary(GLES2_RenderData *data, GLuint id, const char *path)
+{
+    SDL_RWops *rw;
+    Uint32 header[3];
+    GLint length = 0;
+    GLenum format = 0;
+    void *binary;
+    char *tmp = NULL;
+    SDL_bool ok = SDL_FALSE;
+
+    data->glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0) {
+        return;
+    }
+    binary = SDL_malloc(length);
+    if (!binary) {
+        return;
+    }
+    data->glGetProgramBinaryOES(id, length, &length, &format, binary);
+
+    /* Written aside and renamed, so another process or a crash midway never
+       leaves a torn binary behind */
+    if (length > 0 && SDL_asprintf(&tmp, "%s.tmp", path) > 0) {
+        rw = SDL_RWFromFile(tmp, "wb");
+        if (rw) {
+            header[0] = GLES2_PROGRAM_BINARY_MAGIC;
+            header[1] = format;
+            header[2] = (Uint32) length;
+            ok = SDL_RWwrite(rw, header, sizeof(header), 1) == 1 &&
+                 SDL_RWwrite(rw, binary, length, 1) == 1;
+            ok = (SDL_RWclose(rw) == 0) && ok;
+            if (!ok || rename(tmp, path) != 0) {
+                remove(tmp);
+            }
+        }
+    }
+    SDL_free(tmp);
+    SDL_free(binary);
+}
+
+static GLuint
+GLES2_LinkProgram(GLES2_RenderData *data, GLES2_ShaderType vtype, GLES2_ShaderType ftype)
+{
+    GLuint vertex;
+    GLuint fragment;
+    GLuint id;
+    GLint linkSuccessful;
+
+    /* Load the requested shaders */
+    vertex = data->shader_id_cache[(Uint32)vtype];
+    if (!vertex) {
+        vertex = GLES2_CacheShader(data, vtype, GL_VERTEX_SHADER);
+        if (!vertex) {
+            return 0;
+        }
+    }
+
+    fragment = data->shader_id_cache[(Uint32)ftype];
+    if (!fragment) {
+        fragment = GLES2_CacheShader(data, ftype, GL_FRAGMENT_SHADER);
+        if (!fragment) {
+            return 0;
+        }
+    }
+
+    /* Create the program and link it */
+    id = data->glCreateProgram();
+    data->glAttachShader(id, vertex);
+    data->glAttachShader(id, fragment);
+    data->glBindAttribLocation(id, GLES2_ATTRIBUTE_POSITION, "a_position");
+    data->glBindAttribLocation(id, GLES2_ATTRIBUTE_COLOR, "a_color");
+    data->glBindAttribLocation(id, GLES2_ATTRIBUTE_TEXCOORD, "a_texCoord");
+    data->glLinkProgram(id);
+    data->glGetProgramiv(id, GL_LINK_STATUS, &linkSuccessful);
+    if (!linkSuccessful) {
+        data->glDeleteProgram(id);
+        SDL_SetError("Failed to link shader program");
+        return 0;
+    }
+    return id;
+}
+
 static GLES2_ProgramCacheEntry *
-GLES2_CacheProgram(GLES2_RenderData *data, GLuint vertex, GLuint fragment)
+GLES2_CacheProgram(GLES2_RenderData *data, GLES2_ShaderType vtype, GLES2_ShaderType ftype)
 {
     GLES2_ProgramCacheEntry *entry;
-    GLint linkSuccessful;
+    char *path;
 
     /* Check if we've already cached this program */
     entry = data->program_cache.head;
     while (entry) {
-        if (entry->vertex_shader == vertex && entry->fragment_shader == fragment) {
+        if (entry->vertex_type == vtype && entry->fragment_type == ftype) {
             break;
         }
         entry = entry->next;
@@ -423,24 +635,26 @@ GLES2_CacheProgram(GLES2_RenderData *data, GLuint vertex, GLuint fragment)
         SDL_OutOfMemory();
         return NULL;
     }
-    entry->vertex_shader = vertex;
-    entry->fragment_shader = fragment;
+    entry->vertex_type = vtype;
+    entry->fragment_type = ftype;
 
-    /* Create the program and link it */
-    entry->id = data->glCreateProgram();
-    data->glAttachShader(entry->id, vertex);
-    data->glAttachShader(entry->id, fragment);
-    data->glBindAttribLocation(entry->id, GLES2_ATTRIBUTE_POSITION, "a_position");
-    data->glBindAttribLocation(entry->id, GLES2_ATTRIBUTE_COLOR, "a_color");
-    data->glBindAttribLocation(entry->id, GLES2_ATTRIBUTE_TEXCOORD, "a_texCoord");
-    data->glLinkProgram(entry->id);
-    data->glGetProgramiv(entry->id, GL_LINK_STATUS, &linkSuccessful);
-    if (!linkSuccessful) {
-        data->glDeleteProgram(entry->id);
-        SDL_free(entry);
-        SDL_SetError("Failed to link shader program");
-        return NULL;
+    /* Load the program linked by an earlier run, or link it */
+    path = GLES2_GetProgramBinaryPath(data, vtype, ftype);
+    if (path) {
+        entry->id = GLES2_LoadProgramBinary(data, path);
     }
+    if (!entry->id) {
+        entry->id = GLES2_LinkProgram(data, vtype, ftype);
+        if (!entry->id) {
+            SDL_free(path);
+            SDL_free(entry);
+            return NULL;
+        }
+        if (path) {
+            GLES2_SaveProgramBinary(data, entry->id, path);
+        }
+    }
+    SDL_free(path);
 
     /* Predetermine locations of uniform variables */
     entry->uniform_locations[GLES2_UNIFORM_PROJECTION] =
@@ -477,7 +691,7 @@ GLES2_CacheProgram(GLES2_RenderData *data, GLuint vertex, GLuint fragment)
     ++data->program_cache.count;
 
     /* Evict the last entry from the cache if we exceed the limit */
-    if (data->program_cache.count > GLES2_MAX_CACHED_PROGRAMS) {
+    if (data->program_cache.count > data->program_cache.max_count) {
         data->glDeleteProgram(data->program_cache.tail->id);
         data->program_cache.tail = data->program_cache.tail->prev;
         if (data->program_cache.tail != NULL) {
@@ -489,57 +703,61 @@ GLES2_CacheProgram(GLES2_RenderData *data, GLuint vertex, GLuint fragment)
     return entry;
 }
 
-static GLuint
-GLES2_CacheShader(GLES2_RenderData *data, GLES2_ShaderType type, GLenum shader_type)
+/* Programs are only kept between runs where the driver can hand out binaries */
+static void
+GLES2_InitProgramBinaries(GLES2_RenderData *data)
 {
-    GLuint id;
-    GLint compileSuccessful = GL_FALSE;
-    const char *shader_src = (char *)GLES2_GetShader(type);
+    const char *dir = SDL_GetHint(SDL_HINT_RENDER_GLES2_PROGRAM_CACHE);
+    const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    GLint formats = 0;
+    int i;
 
-    if (!shader_src) {
-        SDL_SetError("No shader src");
-        return 0;
+    if (!dir || !*dir || !SDL_GL_ExtensionSupported("GL_OES_get_program_binary")) {
+        return;
+    }
+    data->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    if (formats <= 0) {
+        return;
     }
 
-    /* Compile */
-    id = data->glCreateShader(shader_type);
-    data->glShaderSource(id, 1, &shader_src, NULL);
-    data->glCompileShader(id);
-    data->glGetShaderiv(id, GL_COMPILE_STATUS, &compileSuccessful);
-
-    if (!compileSuccessful) {
-        SDL_bool isstack = SDL_FALSE;
-        char *info = NULL;
-        int length = 0;
+    data->glGetProgramBinaryOES = (PFNGLGETPROGRAMBINARYOESPROC) SDL_GL_GetProcAddress("glGetProgramBinaryOES");
+    data->glProgramBinaryOES = (PFNGLPROGRAMBINARYOESPROC) SDL_GL_GetProcAddress("glProgramBinaryOES");
+    if (!data->glGetProgramBinaryOES || !data->glProgramBinaryOES) {
+        return;
+    }
 
-        data->glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        if (length > 0) {
-            info = SDL_small_alloc(char, length, &isstack);
-            if (info) {
-                data->glGetShaderInfoLog(id, length, &length, info);
-            }
-        }
-        if (info) {
-            SDL_SetError("Failed to load the shader: %s", info);
-            SDL_small_free(info, isstack);
-        } else {
-            SDL_SetError("Failed to load the shader");
+    data->program_binary_driver = 0;
+    for (i = 0; i < SDL_arraysize(strings); i++) {
+        const char *string = (const char *) data->glGetString(strings[i]);
+        if (string) {
+            data->program_binary_driver = SDL_crc32(data->program_binary_driver, string, SDL_strlen(string) + 1);
         }
-        data->glDeleteShader(id);
-        return 0;
     }
+    data->program_binary_dir = SDL_strdup(dir);
+}
 
-    /* Cache */
-    data->shader_id_cache[(Uint32)type] = id;
+/* Links every program up front, so none of them is compiled in the middle of
+   drawing. They stay cached for as long as the renderer lives. */
+static void
+GLES2_PrecompilePrograms(GLES2_RenderData *data)
+{
+    int ftype;
 
-    return id;
+    data->program_cache.max_count = GLES2_SHADER_COUNT;
+
+    for (ftype = GLES2_SHADER_FRAGMENT_SOLID; ftype < GLES2_SHADER_COUNT; ftype++) {
+        if (ftype == GLES2_SHADER_FRAGMENT_TEXTURE_EXTERNAL_OES &&
+            !SDL_GL_ExtensionSupported("GL_OES_EGL_image_external")) {
+            continue;
+        }
+        /* One that fails is tried again when it's drawn with, and fails there */
+        GLES2_CacheProgram(data, GLES2_SHADER_VERTEX_DEFAULT, (GLES2_ShaderType) ftype);
+    }
 }
 
 static int
 GLES2_SelectProgram(GLES2_RenderData *data, GLES2_ImageSource source, int w, int h)
 {
-    GLuint vertex;
-    GLuint fragment;
     GLES2_ShaderType vtype, ftype;
     GLES2_ProgramCacheEntry *program;
 
@@ -626,32 +844,15 @@ GLES2_SelectProgram(GLES2_RenderData *data, GLES2_ImageSource source, int w, int
         goto fault;
     }
 
-    /* Load the requested shaders */
-    vertex = data->shader_id_cache[(Uint32)vtype];
-    if (!vertex) {
-        vertex = GLES2_CacheShader(data, vtype, GL_VERTEX_SHADER);
-        if (!vertex) {
-            goto fault;
-        }
-    }
-
-    fragment = data->shader_id_cache[(Uint32)ftype];
-    if (!fragment) {
-        fragment = GLES2_CacheShader(data, ftype, GL_FRAGMENT_SHADER);
-        if (!fragment) {
-            goto fault;
-        }
-    }
-
     /* Check if we need to change programs at all */
     if (data->drawstate.program &&
-        data->drawstate.program->vertex_shader == vertex &&
-        data->drawstate.program->fragment_shader == fragment) {
+        data->drawstate.program->vertex_type == vtype &&
+        data->drawstate.program->fragment_type == ftype) {
         return 0;
     }
 
     /* Generate a matching program */
-    program = GLES2_CacheProgram(data, vertex, fragment);
+    program = GLES2_CacheProgram(data, vtype, ftype);
     if (!program) {
         goto fault;
     }
@@ -1102,17 +1303,52 @@ SetCopyState(SDL_Renderer *renderer, const SDL_RenderCommand *cmd, void *vertice
     return ret;
 }
 
+/* Streams the vertices of a batch into the part of the buffer no draw has
+   used since it was last orphaned, so the upload never waits for the GPU to
+   be done with earlier batches. They are written through an unsynchronized
+   mapping where GL_EXT_map_buffer_range is supported. Returns the offset of
+   the vertices in the buffer. */
+static size_t
+GLES2_UploadVertices(GLES2_RenderData *data, const void *vertices, size_t vertsize)
+{
+    const GLbitfield access = GL_MAP_WRITE_BIT_EXT | GL_MAP_INVALIDATE_RANGE_BIT_EXT | GL_MAP_UNSYNCHRONIZED_BIT_EXT;
+    size_t offset = (data->vertex_buffer_used + 15) & ~15;  /* for any vertex attribute */
+    void *mapped = NULL;
+
+    data->glBindBuffer(GL_ARRAY_BUFFER, data->vertex_buffer);
+
+    if (offset + vertsize > data->vertex_buffer_size) {
+        /* Fresh storage, the draws still reading the old one keep it */
+        while (data->vertex_buffer_size < vertsize) {
+            data->vertex_buffer_size *= 2;
+        }
+        data->glBufferData(GL_ARRAY_BUFFER, data->vertex_buffer_size, NULL, GL_STREAM_DRAW);
+        offset = 0;
+    }
+
+    if (data->glMapBufferRangeEXT) {
+        mapped = data->glMapBufferRangeEXT(GL_ARRAY_BUFFER, offset, vertsize, access);
+    }
+    if (mapped) {
+        SDL_memcpy(mapped, vertices, vertsize);
+        if (!data->glUnmapBufferOES(GL_ARRAY_BUFFER)) {
+            mapped = NULL;  /* the contents got lost, upload them again */
+        }
+    }
+    if (!mapped) {
+        data->glBufferSubData(GL_ARRAY_BUFFER, offset, vertsize, vertices);
+    }
+
+    data->vertex_buffer_used = offset + vertsize;
+    return offset;
+}
+
 static int
 GLES2_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *vertices, size_t vertsize)
 {
     GLES2_RenderData *data = (GLES2_RenderData *) renderer->driverdata;
     const SDL_bool colorswap = (renderer->target && (renderer->target->format == SDL_PIXELFORMAT_ARGB8888 || renderer->target->format == SDL_PIXELFORMAT_RGB888));
 
-#if USE_VERTEX_BUFFER_OBJECTS
-    const int vboidx = data->current_vertex_buffer;
-    const GLuint vbo = data->vertex_buffers[vboidx];
-#endif
-
     if (GLES2_ActivateRenderer(renderer) < 0) {
         return -1;
     }
@@ -1129,23 +1365,11 @@ GLES2_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *ver
         }
     }
 
-#if USE_VERTEX_BUFFER_OBJECTS
-    /* upload the new VBO data for this set of commands. */
-    data->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    if (data->vertex_buffer_size[vboidx] < vertsize) {
-        data->glBufferData(GL_ARRAY_BUFFER, vertsize, vertices, GL_STREAM_DRAW);
-        data->vertex_buffer_size[vboidx] = vertsize;
-    } else {
-        data->glBufferSubData(GL_ARRAY_BUFFER, 0, vertsize, vertices);
-    }
-
-    /* cycle through a few VBOs so the GL has some time with the data before we replace it. */
-    data->current_vertex_buffer++;
-    if (data->current_vertex_buffer >= SDL_arraysize(data->vertex_buffers)) {
-        data->current_vertex_buffer = 0;
+    /* A draw at a time, client-side arrays still do better */
+    if (data->vertex_buffer && vertsize > 0 && (USE_VERTEX_BUFFER_OBJECTS || renderer->batching)) {
+        /* attrib pointers will be offsets into the VBO. */
+        vertices = (void *) (uintptr_t) GLES2_UploadVertices(data, vertices, vertsize);
     }
-    vertices = NULL;  /* attrib pointers will be offsets into the VBO. */
-#endif
 
     while (cmd) {
         switch (cmd->command) {
@@ -1215,6 +1439,7 @@ GLES2_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *ver
                     if (count > 2) {
                         /* joined lines cannot be grouped */
                         data->glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)count);
+                        renderer->stats.draw_calls++;
                     } else {
                         /* let's group non joined lines */
                         SDL_RenderCommand *finalcmd = cmd;
@@ -1237,6 +1462,7 @@ GLES2_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *ver
                         }
 
                         data->glDrawArrays(GL_LINES, 0, (GLsizei)count);
+                        renderer->stats.draw_calls++;
                         cmd = finalcmd;  /* skip any copy commands we just combined in here. */
                     }
                 }
@@ -1279,6 +1505,7 @@ GLES2_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *ver
                         op = GL_POINTS;
                     }
                     data->glDrawArrays(op, 0, (GLsizei) count);
+                    renderer->stats.draw_calls++;
                 }
 
                 cmd = finalcmd;  /* skip any copy commands we just combined in here. */
@@ -1334,14 +1561,15 @@ GLES2_DestroyRenderer(SDL_Renderer *renderer)
                 data->framebuffers = nextnode;
             }
 
-#if USE_VERTEX_BUFFER_OBJECTS
-            data->glDeleteBuffers(SDL_arraysize(data->vertex_buffers), data->vertex_buffers);
-            GL_CheckError("", renderer);
-#endif
+            if (data->vertex_buffer) {
+                data->glDeleteBuffers(1, &data->vertex_buffer);
+                GL_CheckError("", renderer);
+            }
 
             SDL_GL_DeleteContext(data->context);
         }
 
+        SDL_free(data->program_binary_dir);
         SDL_free(data);
     }
     SDL_free(renderer);
@@ -2101,10 +2329,23 @@ GLES2_CreateRenderer(SDL_Window *window, Uint32 flags)
     data->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &value);
     renderer->info.max_texture_height = value;
 
-#if USE_VERTEX_BUFFER_OBJECTS
-    /* we keep a few of these and cycle through them, so data can live for a few frames. */
-    data->glGenBuffers(SDL_arraysize(data->vertex_buffers), data->vertex_buffers);
-#endif
+    if (SDL_GL_ExtensionSupported("GL_EXT_map_buffer_range") &&
+        SDL_GL_ExtensionSupported("GL_OES_mapbuffer")) {
+        data->glMapBufferRangeEXT = (PFNGLMAPBUFFERRANGEEXTPROC) SDL_GL_GetProcAddress("glMapBufferRangeEXT");
+        data->glUnmapBufferOES = (PFNGLUNMAPBUFFEROESPROC) SDL_GL_GetProcAddress("glUnmapBufferOES");
+        if (!data->glMapBufferRangeEXT || !data->glUnmapBufferOES) {
+            data->glMapBufferRangeEXT = NULL;
+            data->glUnmapBufferOES = NULL;
+        }
+    }
+    if (USE_VERTEX_BUFFER_OBJECTS || data->glMapBufferRangeEXT) {
+        data->glGenBuffers(1, &data->vertex_buffer);
+        data->vertex_buffer_size = GLES2_VERTEX_RING_SIZE;
+        data->vertex_buffer_used = data->vertex_buffer_size;  /* allocated with the first batch */
+    }
+
+    data->program_cache.max_count = GLES2_MAX_CACHED_PROGRAMS;
+    GLES2_InitProgramBinaries(data);
 
     data->framebuffers = NULL;
     data->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &window_framebuffer);
@@ -2163,6 +2404,10 @@ GLES2_CreateRenderer(SDL_Window *window, Uint32 flags)
     data->drawstate.projection[3][0] = -1.0f;
     data->drawstate.projection[3][3] = 1.0f;
 
+    if (SDL_GetHintBoolean(SDL_HINT_RENDER_GLES2_PRECOMPILE, SDL_FALSE)) {
+        GLES2_PrecompilePrograms(data);
+    }
+
     GL_CheckError("", renderer);
 
     return renderer;
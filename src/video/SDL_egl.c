@@ -450,6 +450,7 @@ SDL_EGL_LoadLibraryOnly(_THIS, const char *egl_path)
     LOAD_FUNC(eglDestroySurface);
     LOAD_FUNC(eglMakeCurrent);
     LOAD_FUNC(eglSwapBuffers);
+    LOAD_FUNC(eglQuerySurface);
     LOAD_FUNC(eglSwapInterval);
     LOAD_FUNC(eglWaitNative);
     LOAD_FUNC(eglWaitGL);
@@ -710,16 +711,54 @@ static void dumpconfig(_THIS, EGLConfig config)
 
 #endif /* DUMP_EGL_CONFIG */
 
+static const SDL_EGL_CachedConfig *
+SDL_EGL_FindCachedConfig(_THIS, const EGLint *attribs, int num_attribs)
+{
+    int i;
+
+    for (i = 0; i < _this->egl_data->num_cached_configs; i++) {
+        const SDL_EGL_CachedConfig *cached = &_this->egl_data->config_cache[i];
+        if (cached->num_attribs == num_attribs &&
+            cached->required_visual_id == _this->egl_data->egl_required_visual_id &&
+            SDL_memcmp(cached->attribs, attribs, num_attribs * sizeof(EGLint)) == 0) {
+            return cached;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+SDL_EGL_CacheConfig(_THIS, const EGLint *attribs, int num_attribs, SDL_bool found)
+{
+    SDL_EGL_VideoData *egl_data = _this->egl_data;
+    SDL_EGL_CachedConfig *cached;
+
+    if (egl_data->num_cached_configs < SDL_EGL_CONFIG_CACHE_SIZE) {
+        cached = &egl_data->config_cache[egl_data->num_cached_configs++];
+    } else {
+        cached = &egl_data->config_cache[egl_data->next_cached_config];
+        egl_data->next_cached_config = (egl_data->next_cached_config + 1) % SDL_EGL_CONFIG_CACHE_SIZE;
+    }
+
+    SDL_memcpy(cached->attribs, attribs, num_attribs * sizeof(EGLint));
+    cached->num_attribs = num_attribs;
+    cached->required_visual_id = egl_data->egl_required_visual_id;
+    cached->found = found;
+    cached->config = found ? egl_data->egl_config : NULL;
+}
+
 static int
 SDL_EGL_PrivateChooseConfig(_THIS, SDL_bool set_config_caveat_none)
 {
     /* 64 seems nice. */
-    EGLint attribs[64];
+    EGLint attribs[SDL_EGL_MAX_CONFIG_ATTRIBS];
     EGLint found_configs = 0, value;
     /* 128 seems even nicer here */
     EGLConfig configs[128];
     SDL_bool has_matching_format = SDL_FALSE;
-    int i, j, best_bitdiff = -1, best_truecolor_bitdiff = -1;
+    const SDL_EGL_CachedConfig *cached;
+    int i, j, num_attribs, best_bitdiff = -1, best_truecolor_bitdiff = -1;
     int truecolor_config_idx = -1;
 
     /* Get a valid EGL configuration */
@@ -799,11 +838,23 @@ SDL_EGL_PrivateChooseConfig(_THIS, SDL_bool set_config_caveat_none)
 
     SDL_assert(i < SDL_arraysize(attribs));
 
+    /* The attributes and the visual ID decide the config, so the last choice for them still holds */
+    cached = SDL_EGL_FindCachedConfig(_this, attribs, i);
+    if (cached) {
+        if (!cached->found) {
+            return -1;
+        }
+        _this->egl_data->egl_config = cached->config;
+        return 0;
+    }
+    num_attribs = i;
+
     if (_this->egl_data->eglChooseConfig(_this->egl_data->egl_display,
         attribs,
         configs, SDL_arraysize(configs),
         &found_configs) == EGL_FALSE ||
         found_configs == 0) {
+        SDL_EGL_CacheConfig(_this, attribs, num_attribs, SDL_FALSE);
         return -1;
     }
 
@@ -903,6 +954,8 @@ SDL_EGL_PrivateChooseConfig(_THIS, SDL_bool set_config_caveat_none)
     dumpconfig(_this, _this->egl_data->egl_config);
 #endif
 
+    SDL_EGL_CacheConfig(_this, attribs, num_attribs, SDL_TRUE);
+
     return 0;
 }
 
@@ -30,6 +30,19 @@
 #include "SDL_sysvideo.h"
 
 #define SDL_EGL_MAX_DEVICES     8
+#define SDL_EGL_MAX_CONFIG_ATTRIBS  64
+#define SDL_EGL_CONFIG_CACHE_SIZE   8
+
+/* The config chosen for an attribute list, surfaces recreated with the same
+   GL attributes reuse it instead of querying and scoring every EGL config again */
+typedef struct SDL_EGL_CachedConfig
+{
+    EGLint attribs[SDL_EGL_MAX_CONFIG_ATTRIBS];  /* as passed to eglChooseConfig, up to EGL_NONE */
+    int num_attribs;
+    EGLint required_visual_id;
+    SDL_bool found;  /* whether any config matched */
+    EGLConfig config;
+} SDL_EGL_CachedConfig;
 
 typedef struct SDL_EGL_VideoData
 {
@@ -42,6 +55,10 @@ typedef struct SDL_EGL_VideoData
     EGLint egl_required_visual_id;
     SDL_bool is_offscreen;  /* whether EGL display was offscreen */
     EGLenum apitype;  /* EGL_OPENGL_ES_API, EGL_OPENGL_API, etc */
+
+    SDL_EGL_CachedConfig config_cache[SDL_EGL_CONFIG_CACHE_SIZE];
+    int num_cached_configs;
+    int next_cached_config;  /* replaced next once the cache is full */
     
     EGLDisplay(EGLAPIENTRY *eglGetDisplay) (NativeDisplayType display);
     EGLDisplay(EGLAPIENTRY *eglGetPlatformDisplay) (EGLenum platform,
@@ -95,6 +112,9 @@ typedef struct SDL_EGL_VideoData
                                  EGLSurface read, EGLContext ctx);
     
     EGLBoolean(EGLAPIENTRY *eglSwapBuffers) (EGLDisplay dpy, EGLSurface draw);
+
+    EGLBoolean(EGLAPIENTRY *eglQuerySurface) (EGLDisplay dpy, EGLSurface surface,
+                                  EGLint attribute, EGLint * value);
     
     EGLBoolean(EGLAPIENTRY *eglSwapInterval) (EGLDisplay dpy, EGLint interval);
     
@@ -244,6 +244,8 @@ struct SDL_VideoDevice
     int (*CreateWindowFramebuffer) (_THIS, SDL_Window * window, Uint32 * format, void ** pixels, int *pitch);
     int (*UpdateWindowFramebuffer) (_THIS, SDL_Window * window, const SDL_Rect * rects, int numrects);
     void (*DestroyWindowFramebuffer) (_THIS, SDL_Window * window);
+    int (*PresentDMABUF) (_THIS, SDL_Window * window, const SDL_DMABUFFrame * frame);
+    int (*GetWindowNextVsync) (_THIS, SDL_Window * window, Uint64 * vsync, Uint64 * period);
     void (*OnWindowEnter) (_THIS, SDL_Window * window);
     int (*FlashWindow) (_THIS, SDL_Window * window, SDL_FlashOperation operation);
 
@@ -270,6 +272,8 @@ struct SDL_VideoDevice
     int (*GL_SetSwapInterval) (_THIS, int interval);
     int (*GL_GetSwapInterval) (_THIS);
     int (*GL_SwapWindow) (_THIS, SDL_Window * window);
+    int (*GL_SwapWindowWithDamage) (_THIS, SDL_Window * window, const SDL_Rect * rects, int numrects);
+    int (*GL_GetFrameTimings) (_THIS, SDL_Window * window, SDL_GLFrameTiming * timings, int maxtimings);
     void (*GL_DeleteContext) (_THIS, SDL_GLContext context);
     void (*GL_DefaultProfileConfig) (_THIS, int *mask, int *major, int *minor);
 
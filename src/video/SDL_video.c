@@ -2520,6 +2520,11 @@ SDL_CreateWindowFramebuffer(SDL_Window * window)
             attempt_texture_framebuffer = SDL_FALSE;
         }
         #endif
+        #if SDL_VIDEO_DRIVER_MALI /* the surface is mapped onto the pages the blitter shows, a renderer only adds a copy. */
+        else if ((_this->CreateWindowFramebuffer != NULL) && (SDL_strcmp(_this->name, "mali") == 0)) {
+            attempt_texture_framebuffer = SDL_FALSE;
+        }
+        #endif
 
         if (attempt_texture_framebuffer) {
             if (SDL_CreateWindowTexture(_this, window, &format, &pixels, &pitch) == -1) {
@@ -2612,6 +2617,50 @@ SDL_UpdateWindowSurfaceRects(SDL_Window * window, const SDL_Rect * rects,
     return _this->UpdateWindowFramebuffer(_this, window, rects, numrects);
 }
 
+int
+SDL_PresentDMABUF(SDL_Window * window, const SDL_DMABUFFrame * frame)
+{
+    CHECK_WINDOW_MAGIC(window, -1);
+
+    if (!frame) {
+        return SDL_InvalidParamError("frame");
+    }
+
+    if (frame->w <= 0 || frame->h <= 0) {
+        return SDL_SetError("Invalid frame size %dx%d", frame->w, frame->h);
+    }
+
+    if (frame->num_planes < 1 || frame->num_planes > (int)SDL_arraysize(frame->planes)) {
+        return SDL_InvalidParamError("num_planes");
+    }
+
+    if (!_this->PresentDMABUF) {
+        return SDL_Unsupported();
+    }
+
+    return _this->PresentDMABUF(_this, window, frame);
+}
+
+int
+SDL_GetWindowNextVsync(SDL_Window * window, Uint64 * vsync, Uint64 * period)
+{
+    CHECK_WINDOW_MAGIC(window, -1);
+
+    if (!vsync) {
+        return SDL_InvalidParamError("vsync");
+    }
+
+    if (!period) {
+        return SDL_InvalidParamError("period");
+    }
+
+    if (!_this->GetWindowNextVsync) {
+        return SDL_Unsupported();
+    }
+
+    return _this->GetWindowNextVsync(_this, window, vsync, period);
+}
+
 int
 SDL_SetWindowBrightness(SDL_Window * window, float brightness)
 {
@@ -4037,6 +4086,54 @@ SDL_GL_SwapWindow(SDL_Window * window)
     _this->GL_SwapWindow(_this, window);
 }
 
+int
+SDL_GL_SwapWindowWithDamage(SDL_Window * window, const SDL_Rect * rects, int numrects)
+{
+    CHECK_WINDOW_MAGIC(window, -1);
+
+    if (!(window->flags & SDL_WINDOW_OPENGL)) {
+        return SDL_SetError("The specified window isn't an OpenGL window");
+    }
+
+    if (SDL_GL_GetCurrentWindow() != window) {
+        return SDL_SetError("The specified window has not been made current");
+    }
+
+    if (rects && numrects < 0) {
+        return SDL_InvalidParamError("numrects");
+    }
+
+    if (rects && _this->GL_SwapWindowWithDamage) {
+        return _this->GL_SwapWindowWithDamage(_this, window, rects, numrects);
+    }
+
+    return _this->GL_SwapWindow(_this, window);
+}
+
+int
+SDL_GL_GetFrameTimings(SDL_Window * window, SDL_GLFrameTiming * timings, int maxtimings)
+{
+    CHECK_WINDOW_MAGIC(window, -1);
+
+    if (!(window->flags & SDL_WINDOW_OPENGL)) {
+        return SDL_SetError("The specified window isn't an OpenGL window");
+    }
+
+    if (!timings) {
+        return SDL_InvalidParamError("timings");
+    }
+
+    if (maxtimings <= 0) {
+        return 0;
+    }
+
+    if (!_this->GL_GetFrameTimings) {
+        return SDL_Unsupported();
+    }
+
+    return _this->GL_GetFrameTimings(_this, window, timings, maxtimings);
+}
+
 void
 SDL_GL_DeleteContext(SDL_GLContext context)
 {
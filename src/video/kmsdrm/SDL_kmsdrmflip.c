@@ -0,0 +1,307 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_KMSDRM
+
+#include "SDL_hints.h"
+#include "SDL_log.h"
+
+#include "SDL_kmsdrmflip.h"
+#include "SDL_kmsdrmdyn.h"
+#include <poll.h>
+#include <errno.h>
+
+/* A flip lands on the next vblank, one that takes this long won't land anymore */
+#define KMSDRM_FLIP_TIMEOUT 1000
+
+static void
+KMSDRM_FlipQueue_Handler(int fd, unsigned int frame, unsigned int sec, unsigned int usec, void *data)
+{
+    KMSDRM_FlipQueue *queue = (KMSDRM_FlipQueue *) data;
+
+    queue->flip_time = (Uint64) sec * 1000000 + usec;
+    queue->flip_sequence = frame;
+    queue->flip_pending = SDL_FALSE;
+}
+
+/* Like KMSDRM_WaitPageflip, only with a timeout so a display that went away
+   can't keep the thread from stopping. */
+static SDL_bool
+KMSDRM_FlipQueue_WaitEvent(KMSDRM_FlipQueue *queue)
+{
+    drmEventContext ev = {0};
+    struct pollfd pfd = {0};
+    int ret;
+
+    ev.version = DRM_EVENT_CONTEXT_VERSION;
+    ev.page_flip_handler = KMSDRM_FlipQueue_Handler;
+
+    pfd.fd = queue->drm_fd;
+    pfd.events = POLLIN;
+
+    while (queue->flip_pending) {
+        pfd.revents = 0;
+        ret = poll(&pfd, 1, KMSDRM_FLIP_TIMEOUT);
+
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (ret <= 0 || (pfd.revents & (POLLHUP | POLLERR))) {
+            SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Page flip of FB %u didn't complete", queue->flipping.fb_id);
+            return SDL_FALSE;
+        }
+
+        /* Other events are consumed without touching flip_pending */
+        if (pfd.revents & POLLIN) {
+            KMSDRM_drmHandleEvent(queue->drm_fd, &ev);
+        }
+    }
+
+    return SDL_TRUE;
+}
+
+static int SDLCALL
+KMSDRM_FlipThread(void *data)
+{
+    KMSDRM_FlipQueue *queue = (KMSDRM_FlipQueue *) data;
+    KMSDRM_Frame frame;
+    SDL_bool shown;
+    int ret;
+
+    SDL_LockMutex(queue->lock);
+
+    for (;;) {
+        while (!queue->stop && queue->num_queued == 0) {
+            SDL_CondWait(queue->cond, queue->lock);
+        }
+
+        /* Frames still waiting are handed back by KMSDRM_FlipQueue_Quit() */
+        if (queue->stop) {
+            break;
+        }
+
+        frame = queue->queued[0];
+        queue->num_queued--;
+        SDL_memmove(&queue->queued[0], &queue->queued[1], queue->num_queued * sizeof(frame));
+        queue->flipping = frame;
+
+        /* A slot freed up, a FIFO producer may go on */
+        SDL_CondBroadcast(queue->cond);
+        SDL_UnlockMutex(queue->lock);
+
+        if (!queue->shown.bo) {
+            /* Before drmModePageFlip can be used the CRTC has to be configured to use
+               the current connector and mode with drmModeSetCrtc, which flips right away */
+            ret = KMSDRM_drmModeSetCrtc(queue->drm_fd, queue->crtc_id, frame.fb_id, 0, 0,
+                                        &queue->connector_id, 1, &queue->mode);
+            shown = (ret == 0);
+            if (!shown) {
+                SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Could not set videomode on CRTC.");
+            }
+        } else {
+            queue->flip_pending = SDL_TRUE;
+            ret = KMSDRM_drmModePageFlip(queue->drm_fd, queue->crtc_id, frame.fb_id,
+                                         DRM_MODE_PAGE_FLIP_EVENT, queue);
+            if (ret) {
+                /* The frame isn't shown, the next one may make it */
+                SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Could not queue pageflip: %d", ret);
+                queue->flip_pending = SDL_FALSE;
+                shown = SDL_FALSE;
+            } else {
+                shown = KMSDRM_FlipQueue_WaitEvent(queue);
+            }
+        }
+
+        SDL_LockMutex(queue->lock);
+
+        queue->flipping.bo = NULL;
+
+        /* A flip that never completes may still scan its BO out, it's leaked rather
+           than reused, and nothing more can be flipped */
+        if (queue->flip_pending) {
+            queue->failed = SDL_TRUE;
+            SDL_CondBroadcast(queue->cond);
+            break;
+        }
+
+        if (shown) {
+            if (queue->shown.bo) {
+                queue->done[queue->num_done++] = queue->shown.bo;
+                if (queue->flips++ == 0) {
+                    queue->first_flip_time = queue->flip_time;
+                }
+            }
+            queue->shown = frame;
+        } else {
+            queue->done[queue->num_done++] = frame.bo;
+        }
+
+        SDL_CondBroadcast(queue->cond);
+    }
+
+    SDL_UnlockMutex(queue->lock);
+
+    return 0;
+}
+
+int
+KMSDRM_FlipQueue_Init(KMSDRM_FlipQueue *queue, int drm_fd, uint32_t crtc_id, uint32_t connector_id,
+                      const drmModeModeInfo *mode)
+{
+    const char *hint = SDL_GetHint(SDL_HINT_KMSDRM_FLIP_QUEUE);
+
+    SDL_zerop(queue);
+    queue->drm_fd = drm_fd;
+    queue->crtc_id = crtc_id;
+    queue->connector_id = connector_id;
+    queue->mode = *mode;
+
+    if (!hint || !*hint) {
+        return 0;
+    }
+
+    queue->depth = SDL_clamp(SDL_atoi(hint), 0, KMSDRM_FLIP_QUEUE_MAX);
+    if (queue->depth == 0) {
+        return 0;
+    }
+
+    queue->lock = SDL_CreateMutex();
+    queue->cond = SDL_CreateCond();
+    if (!queue->lock || !queue->cond) {
+        KMSDRM_FlipQueue_Quit(queue, NULL);
+        return SDL_SetError("Could not create the flip queue");
+    }
+
+    queue->thread = SDL_CreateThread(KMSDRM_FlipThread, "KMSDRM_FlipThread", queue);
+    if (!queue->thread) {
+        KMSDRM_FlipQueue_Quit(queue, NULL);
+        return SDL_SetError("Could not start the flip thread");
+    }
+
+    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "Flipping on a thread, up to %d frames queued", queue->depth);
+
+    return 0;
+}
+
+int
+KMSDRM_FlipQueue_Push(KMSDRM_FlipQueue *queue, struct gbm_bo *bo, uint32_t fb_id, SDL_bool mailbox)
+{
+    SDL_LockMutex(queue->lock);
+
+    /* The newest waiting frame is replaced, it'll never be shown */
+    if (mailbox && queue->num_queued == queue->depth) {
+        queue->done[queue->num_done++] = queue->queued[--queue->num_queued].bo;
+        queue->dropped++;
+    }
+
+    while (!queue->failed && queue->num_queued == queue->depth) {
+        SDL_CondWait(queue->cond, queue->lock);
+    }
+
+    if (queue->failed) {
+        SDL_UnlockMutex(queue->lock);
+        return SDL_SetError("The display stopped flipping");
+    }
+
+    queue->queued[queue->num_queued].bo = bo;
+    queue->queued[queue->num_queued].fb_id = fb_id;
+    queue->num_queued++;
+
+    SDL_CondBroadcast(queue->cond);
+    SDL_UnlockMutex(queue->lock);
+
+    return 0;
+}
+
+/* The BOs that left the screen since the last call, for the caller to release to
+   the GBM surface. With wait, blocks until there's one unless none is coming. */
+int
+KMSDRM_FlipQueue_Collect(KMSDRM_FlipQueue *queue, struct gbm_bo **bos, SDL_bool wait)
+{
+    int count;
+
+    SDL_LockMutex(queue->lock);
+
+    while (wait && queue->num_done == 0 && !queue->failed &&
+           (queue->num_queued > 0 || queue->flipping.bo)) {
+        SDL_CondWait(queue->cond, queue->lock);
+    }
+
+    count = queue->num_done;
+    SDL_memcpy(bos, queue->done, count * sizeof(*bos));
+    queue->num_done = 0;
+
+    SDL_UnlockMutex(queue->lock);
+
+    return count;
+}
+
+/* Stops the thread once the flip in flight landed, and hands back every BO the
+   queue still holds, the one on screen included. */
+int
+KMSDRM_FlipQueue_Quit(KMSDRM_FlipQueue *queue, struct gbm_bo **bos)
+{
+    int i, count = 0;
+
+    if (queue->thread) {
+        SDL_LockMutex(queue->lock);
+        queue->stop = SDL_TRUE;
+        SDL_CondBroadcast(queue->cond);
+        SDL_UnlockMutex(queue->lock);
+        SDL_WaitThread(queue->thread, NULL);
+        queue->thread = NULL;
+
+        if (queue->flips > 1) {
+            SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "%u flips %.3f ms apart, %u frames dropped", queue->flips,
+                         (queue->flip_time - queue->first_flip_time) / (1000.0 * (queue->flips - 1)),
+                         queue->dropped);
+        }
+    }
+
+    if (bos) {
+        for (i = 0; i < queue->num_done; i++) {
+            bos[count++] = queue->done[i];
+        }
+        for (i = 0; i < queue->num_queued; i++) {
+            bos[count++] = queue->queued[i].bo;
+        }
+        if (queue->shown.bo) {
+            bos[count++] = queue->shown.bo;
+        }
+    }
+
+    if (queue->cond) {
+        SDL_DestroyCond(queue->cond);
+    }
+    if (queue->lock) {
+        SDL_DestroyMutex(queue->lock);
+    }
+    SDL_zerop(queue);
+
+    return count;
+}
+
+#endif /* SDL_VIDEO_DRIVER_KMSDRM */
+
+/* vi: set ts=4 sw=4 expandtab: */
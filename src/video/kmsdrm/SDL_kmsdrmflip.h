@@ -0,0 +1,91 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "../../SDL_internal.h"
+
+#ifndef SDL_KMSDRM_flip_h_
+#define SDL_KMSDRM_flip_h_
+
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+
+#include <xf86drmMode.h>
+#include <gbm.h>
+
+/* Most frames that can wait for their flip, GBM surfaces don't have many more buffers */
+#define KMSDRM_FLIP_QUEUE_MAX 2
+
+/* Every BO the queue can hold: the waiting ones, the one being flipped, the one
+   on screen and the ones that left the screen but weren't released yet. */
+#define KMSDRM_FLIP_QUEUE_BOS (2 * KMSDRM_FLIP_QUEUE_MAX + 2)
+
+typedef struct KMSDRM_Frame
+{
+    struct gbm_bo *bo;
+    uint32_t fb_id;
+} KMSDRM_Frame;
+
+/* Frames handed to a flip thread, so SwapWindow doesn't block on the previous
+   flip. With FIFO semantics (swap interval 1) every frame is shown and SwapWindow
+   only blocks when the queue is full; with mailbox semantics (swap interval 0) it
+   never blocks and a newer frame replaces the last waiting one instead.
+   The flip thread makes every DRM call on the display, the BOs that left the screen
+   are released by the render thread, which is the only one touching the GBM surface. */
+typedef struct KMSDRM_FlipQueue
+{
+    int drm_fd;
+    uint32_t crtc_id;
+    uint32_t connector_id;
+    drmModeModeInfo mode;
+    int depth;                  /* frames that can wait, 0 when there's no flip thread */
+
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+    SDL_bool stop;
+    SDL_bool failed;            /* the thread gave up, the display went away */
+
+    KMSDRM_Frame queued[KMSDRM_FLIP_QUEUE_MAX];
+    int num_queued;
+    KMSDRM_Frame flipping;      /* submitted, waiting for its event */
+    KMSDRM_Frame shown;
+    struct gbm_bo *done[KMSDRM_FLIP_QUEUE_BOS];
+    int num_done;
+
+    /* Of the last flip, from the sec/usec/frame of its event */
+    SDL_bool flip_pending;
+    Uint64 flip_time;           /* CLOCK_MONOTONIC microseconds */
+    unsigned int flip_sequence;
+
+    Uint64 first_flip_time;
+    Uint32 flips;
+    Uint32 dropped;             /* replaced in the mailbox before they were shown */
+} KMSDRM_FlipQueue;
+
+extern int KMSDRM_FlipQueue_Init(KMSDRM_FlipQueue *queue, int drm_fd, uint32_t crtc_id, uint32_t connector_id,
+                                 const drmModeModeInfo *mode);
+extern int KMSDRM_FlipQueue_Push(KMSDRM_FlipQueue *queue, struct gbm_bo *bo, uint32_t fb_id, SDL_bool mailbox);
+extern int KMSDRM_FlipQueue_Collect(KMSDRM_FlipQueue *queue, struct gbm_bo **bos, SDL_bool wait);
+extern int KMSDRM_FlipQueue_Quit(KMSDRM_FlipQueue *queue, struct gbm_bo **bos);
+
+#endif /* SDL_KMSDRM_flip_h_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
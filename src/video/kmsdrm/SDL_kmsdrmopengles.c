@@ -85,6 +85,62 @@ int KMSDRM_GLES_SetSwapInterval(_THIS, int interval) {
     return 0;
 }
 
+/* SwapWindow with a flip thread: the new front buffer is queued for it
+   instead of being flipped and waited for here. */
+static int
+KMSDRM_GLES_QueueSwap(_THIS, SDL_Window * window) {
+    SDL_WindowData *windata = ((SDL_WindowData *) window->driverdata);
+    struct gbm_bo *bos[KMSDRM_FLIP_QUEUE_BOS];
+    struct gbm_bo *bo;
+    KMSDRM_FBInfo *fb_info;
+    SDL_bool wait = SDL_FALSE;
+    int i, count;
+
+    if (!(_this->egl_data->eglSwapBuffers(_this->egl_data->egl_display,
+                                           windata->egl_surface))) {
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "eglSwapBuffers failed");
+        return 0;
+    }
+
+    bo = KMSDRM_gbm_surface_lock_front_buffer(windata->gs);
+    if (!bo) {
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Could not lock front buffer on GBM surface");
+        return 0;
+    }
+
+    fb_info = KMSDRM_FBFromBO(_this, bo);
+    if (!fb_info) {
+        KMSDRM_gbm_surface_release_buffer(windata->gs, bo);
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Could not get a framebuffer");
+        return 0;
+    }
+
+    /* Swap interval 1 waits for a free slot in the queue (FIFO), 0 replaces
+       the last frame waiting in it (mailbox), so it never tears. */
+    if (KMSDRM_FlipQueue_Push(&windata->flip_queue, bo, fb_info->fb_id,
+                              _this->egl_data->egl_swapinterval == 0) < 0) {
+        KMSDRM_gbm_surface_release_buffer(windata->gs, bo);
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "Could not queue pageflip: %s", SDL_GetError());
+        return 0;
+    }
+
+    /* Release the buffers that left the screen. EGL needs a free one to draw
+       the next frame into, if there's none we wait for the next flip. */
+    for (;;) {
+        count = KMSDRM_FlipQueue_Collect(&windata->flip_queue, bos, wait);
+        for (i = 0; i < count; i++) {
+            KMSDRM_gbm_surface_release_buffer(windata->gs, bos[i]);
+        }
+
+        if (KMSDRM_gbm_surface_has_free_buffers(windata->gs) || (wait && count == 0)) {
+            break;
+        }
+        wait = SDL_TRUE;
+    }
+
+    return 1;
+}
+
 int
 KMSDRM_GLES_SwapWindow(_THIS, SDL_Window * window) {
     SDL_WindowData *windata = ((SDL_WindowData *) window->driverdata);
@@ -102,6 +158,10 @@ KMSDRM_GLES_SwapWindow(_THIS, SDL_Window * window) {
         KMSDRM_CreateSurfaces(_this, window);
     }
 
+    if (windata->flip_queue.thread) {
+        return KMSDRM_GLES_QueueSwap(_this, window);
+    }
+
     /* Wait for confirmation that the next front buffer has been flipped, at which
        point the previous front buffer can be released */
     if (!KMSDRM_WaitPageflip(_this, windata)) {
@@ -868,6 +868,8 @@ KMSDRM_DestroySurfaces(_THIS, SDL_Window *window)
     SDL_VideoData *viddata = ((SDL_VideoData *)_this->driverdata);
     SDL_WindowData *windata = (SDL_WindowData *) window->driverdata;
     SDL_DisplayData *dispdata = (SDL_DisplayData *) SDL_GetDisplayForWindow(window)->driverdata;
+    struct gbm_bo *bos[KMSDRM_FLIP_QUEUE_BOS];
+    int i, num_bos;
     int ret;
 
     /**********************************************/
@@ -875,6 +877,10 @@ KMSDRM_DestroySurfaces(_THIS, SDL_Window *window)
     /**********************************************/
     /*KMSDRM_WaitPageflip(_this, windata);*/
 
+    /* The flip thread stops once its flip landed, it hands back its BOs for the
+       release below. */
+    num_bos = KMSDRM_FlipQueue_Quit(&windata->flip_queue, bos);
+
     /***********************************************************************/
     /* Restore the original CRTC configuration: configue the crtc with the */
     /* original video mode and make it point to the original TTY buffer.   */
@@ -920,6 +926,10 @@ KMSDRM_DestroySurfaces(_THIS, SDL_Window *window)
         windata->next_bo = NULL;
     }
 
+    for (i = 0; i < num_bos; i++) {
+        KMSDRM_gbm_surface_release_buffer(windata->gs, bos[i]);
+    }
+
     /***************************/
     /* Destroy the GBM surface */
     /***************************/
@@ -1029,6 +1039,13 @@ KMSDRM_CreateSurfaces(_THIS, SDL_Window * window)
     egl_context = (EGLContext)SDL_GL_GetCurrentContext();
     ret = SDL_EGL_MakeCurrent(_this, windata->egl_surface, egl_context);
 
+    /* If asked to, frames are flipped on a thread from now on, SwapWindow
+       waits for the flips itself otherwise. */
+    if (ret == 0 && KMSDRM_FlipQueue_Init(&windata->flip_queue, viddata->drm_fd, dispdata->crtc->crtc_id,
+                                          dispdata->connector->connector_id, &dispdata->mode) < 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "%s, flipping without a thread", SDL_GetError());
+    }
+
     SDL_SendWindowEvent(window, SDL_WINDOWEVENT_RESIZED,
                         dispdata->mode.hdisplay, dispdata->mode.vdisplay);
 
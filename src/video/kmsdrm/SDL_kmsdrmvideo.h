@@ -33,6 +33,8 @@
 #include <gbm.h>
 #include <EGL/egl.h>
 
+#include "SDL_kmsdrmflip.h"
+
 typedef struct SDL_VideoData
 {
     int devindex;               /* device index that was passed on creation */
@@ -97,6 +99,9 @@ typedef struct SDL_WindowData
     SDL_bool waiting_for_flip;
     SDL_bool double_buffer;
 
+    /* Frames waiting for their flip, when they're flipped on a thread */
+    KMSDRM_FlipQueue flip_queue;
+
     EGLSurface egl_surface;
     SDL_bool egl_surface_dirty;
 } SDL_WindowData;
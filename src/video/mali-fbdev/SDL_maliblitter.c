@@ -9,13 +9,14 @@
 #include "SDL_malivideo.h"
 #include "SDL_maliopengles.h"
 #include "SDL_maliblitter.h"
+#include "SDL_malitelemetry.h"
 
 /* used to simplify code */
 typedef struct mat4 {
     GLfloat v[16];
 } mat4;
 
-static GLchar* blit_vert_fmt =
+static const GLchar blit_vert_fmt[] =
 "#version 100\n"
 "varying vec2 vTexCoord;\n"
 "attribute vec2 aVertCoord;\n"
@@ -28,54 +29,62 @@ static GLchar* blit_vert_fmt =
 "   gl_Position = uProj * vec4(aVertCoord, 0.0, 1.0);\n"
 "}";
 
-static GLchar* blit_frag_standard =
+/*
+ * Samples the frames of SDL_PresentDMABUF, the GPU converts YUV on the fly. External
+ * textures only clamp, fract() stands in for the wrapping the rotated coordinates need.
+ */
+static const GLchar blit_frag_external[] =
 "#version 100\n"
+"#extension GL_OES_EGL_image_external : require\n"
 "precision mediump float;"
 "varying vec2 vTexCoord;\n"
-"uniform sampler2D uFBOTex;\n"
-"uniform vec2 uTexSize;\n"
-"uniform vec2 uScale;\n"
+"uniform samplerExternalOES uFBOTex;\n"
 "void main() {\n"
-"   vec2 texel_floored = floor(vTexCoord);\n"
-"   gl_FragColor = texture2D(uFBOTex, vTexCoord);\n"
+"   gl_FragColor = texture2D(uFBOTex, fract(vTexCoord));\n"
 "}\n";
 
-// Ported from TheMaister's sharp-bilinear-simple.slang
-static GLchar* blit_frag_bilinear_simple =
+static const MALI_Scaler external_scaler = {
+    "external", blit_frag_external, SDL_FALSE, SDL_TRUE, SDL_FALSE
+};
+
+/* Secondary windows aren't scaled, the same wrapping as above goes for their rotation */
+static const GLchar blit_frag_overlay[] =
 "#version 100\n"
 "precision mediump float;"
 "varying vec2 vTexCoord;\n"
 "uniform sampler2D uFBOTex;\n"
-"uniform vec2 uTexSize;\n"
-"uniform vec2 uScale;\n"
 "void main() {\n"
-"   vec2 texel_floored = floor(vTexCoord);\n"
-"   vec2 s = fract(vTexCoord);\n"
-"   vec2 region_range = 0.5 - 0.5 / uScale;\n"
-"   vec2 center_dist = s - 0.5;\n"
-"   vec2 f = (center_dist - clamp(center_dist, -region_range, region_range)) * uScale + 0.5;\n"
-"   vec2 mod_texel = texel_floored + f;\n"
-"   gl_FragColor = texture2D(uFBOTex, mod_texel / uTexSize);\n"
+"   gl_FragColor = texture2D(uFBOTex, fract(vTexCoord));\n"
 "}\n";
 
-// Ported from Iquilez
-static GLchar* blit_frag_quilez =
+static const MALI_Scaler overlay_scaler = {
+    "overlay", blit_frag_overlay, SDL_FALSE, SDL_FALSE, SDL_FALSE
+};
+
+/* The performance overlay is laid out in display coordinates, uProj turns it onto the viewport */
+static const GLchar hud_vert[] =
 "#version 100\n"
-"precision highp float;"
-"varying vec2 vTexCoord;\n"
-"uniform sampler2D uFBOTex;\n"
-"uniform vec2 uTexSize;\n"
-"uniform vec2 uScale;\n"
+"attribute vec2 aVertCoord;\n"
+"uniform mat4 uProj;\n"
 "void main() {\n"
-"   vec2 p = vTexCoord + 0.5;"
-"   vec2 i = floor(p);"
-"   vec2 f = p - i;"
-"   f = f*f*f*(f*(f*6.0-15.0)+10.0);"
-"   p = i + f;"
-"   p = (p - 0.5)/uTexSize;"
-"   gl_FragColor = texture2D( uFBOTex, p );"
+"   gl_Position = uProj * vec4(aVertCoord, 0.0, 1.0);\n"
+"}";
+
+static const GLchar hud_frag[] =
+"#version 100\n"
+"precision mediump float;"
+"uniform vec4 uColor;\n"
+"void main() {\n"
+"   gl_FragColor = uColor;\n"
 "}\n";
 
+static const GLfloat hud_colors[MALI_HUD_NUM_PARTS][4] = {
+    { 0.0f, 0.0f, 0.0f, 0.6f },     /* background */
+    { 1.0f, 1.0f, 1.0f, 1.0f },     /* text */
+    { 0.3f, 0.9f, 0.3f, 0.9f },     /* frame times */
+    { 1.0f, 0.3f, 0.3f, 0.9f },     /* one refresh period */
+};
+
 SDL_GLContext
 MALI_Blitter_CreateContext(_THIS, EGLSurface egl_surface)
 {
@@ -117,89 +126,347 @@ MALI_Blitter_CreateContext(_THIS, EGLSurface egl_surface)
     return (SDL_GLContext) egl_context;
 }
 
-static void
-get_aspect_correct_coords(int viewport[2], int plane[2], int rotation, GLfloat vert[4][4], GLfloat scale[2])
+static
+void mat_ortho(float left, float right, float bottom, float top, float Result[4][4])
+{
+    *(mat4*)Result = (mat4){{[0 ... 15] = 0}};
+    Result[0][0] = 2.0f / (right - left);
+    Result[1][1] = 2.0f / (top - bottom);
+    Result[2][2] = -1.0f;
+    Result[3][0] = - (right + left) / (right - left);
+    Result[3][1] = - (top + bottom) / (top - bottom);
+    Result[3][3] = 1.0f;
+}
+
+#ifndef GL_PROGRAM_BINARY_LENGTH_OES
+#define GL_PROGRAM_BINARY_LENGTH_OES 0x8741
+#endif
+
+#ifndef GL_TEXTURE_EXTERNAL_OES
+#define GL_TEXTURE_EXTERNAL_OES 0x8D65
+#endif
+
+static SDL_bool
+MALI_Blitter_HasGLExtension(MALI_Blitter *blitter, const char *ext)
 {
-    float aspect_plane, aspect_viewport, ratio_x, ratio_y;
-    int shift_x, shift_y, temp;
+    const char *exts = (const char *)blitter->glGetString(GL_EXTENSIONS);
+    size_t len = SDL_strlen(ext);
 
-    // when sideways, invert plane coords
-    if (rotation & 1) {
-        temp = plane[0];
-        plane[0] = plane[1];
-        plane[1] = temp;
+    while (exts && (exts = SDL_strstr(exts, ext)) != NULL) {
+        if (exts[len] == ' ' || exts[len] == '\0')
+            return SDL_TRUE;
+        exts += len;
     }
 
-    // Choose which edge to touch
-    aspect_plane = (float)plane[0] / plane[1];
-    aspect_viewport = (float)viewport[0] / viewport[1];
+    return SDL_FALSE;
+}
 
-    if (aspect_viewport > aspect_plane) {
-        // viewport wider than plane
-        ratio_x = plane[0] * ((float)viewport[1] / plane[1]);
-        ratio_y = viewport[1];
-        shift_x = (viewport[0] - ratio_x) / 2.0f;
-        shift_y = 0;
-    } else {
-        // plane wider than viewport
-        ratio_x = viewport[0];
-        ratio_y = plane[1] * ((float)viewport[0] / plane[0]);
-        shift_x = 0;
-        shift_y = (viewport[1] - ratio_y) / 2.0f;
+static GLuint
+MALI_Blitter_CompileShader(MALI_Blitter *blitter, GLenum type, const GLchar *source)
+{
+    GLchar msg[2048] = {};
+    GLuint shader;
+
+    shader = blitter->glCreateShader(type);
+    blitter->glShaderSource(shader, 1, &source, NULL);
+    blitter->glCompileShader(shader);
+    blitter->glGetShaderInfoLog(shader, sizeof(msg), NULL, msg);
+    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Blitter %s Shader Info: %s\n",
+        type == GL_VERTEX_SHADER ? "Vertex" : "Fragment", msg);
+
+    return shader;
+}
+
+static GLuint
+MALI_Blitter_BuildProgram(_THIS, MALI_Blitter *blitter, const MALI_Scaler *scaler)
+{
+    GLchar msg[2048] = {}, blit_vert[2048] = {};
+    GLuint prog, vert, frag;
+    GLint status = GL_FALSE, length = 0;
+    GLenum format;
+    GLsizei size;
+    Uint64 key = 0;
+    void *binary;
+
+    /* Setup vertex shader coord orientation */
+    SDL_snprintf(blit_vert, sizeof(blit_vert), blit_vert_fmt,
+        /* rotation */
+        (blitter->rotation == 0) ? "vTexCoord = aTexCoord;" :
+        (blitter->rotation == 1) ? "vTexCoord = vec2(aTexCoord.y, -aTexCoord.x);" :
+        (blitter->rotation == 2) ? "vTexCoord = vec2(-aTexCoord.x, -aTexCoord.y);" :
+        (blitter->rotation == 3) ? "vTexCoord = vec2(-aTexCoord.y, aTexCoord.x);" :
+        "#error Orientation out of scope",
+        /* scalers */
+        (scaler->texel_coords) ? "vTexCoord = vTexCoord;"
+                               : "vTexCoord = vTexCoord / uTexSize;");
+
+    prog = blitter->glCreateProgram();
+
+    /* A binary from a previous run skips compiling and linking altogether */
+    if (blitter->cache_dir) {
+        key = MALI_ProgramCache_Key(blit_vert, scaler->frag,
+            blitter->glGetString(GL_RENDERER), blitter->glGetString(GL_VERSION));
+        binary = MALI_ProgramCache_Load(blitter->cache_dir, key, &format, &size);
+        if (binary) {
+            blitter->glProgramBinaryOES(prog, format, binary, size);
+            SDL_free(binary);
+            blitter->glGetProgramiv(prog, GL_LINK_STATUS, &status);
+            if (status) {
+                SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Loaded cached '%s' scaler program", scaler->name);
+                return prog;
+            }
+        }
     }
 
-    // Instead of normalized UVs, use full texture size.
-    vert[0][2] = (int)(0.0f * plane[0]); vert[0][3] = (int)(0.0f * plane[1]);
-    vert[1][2] = (int)(0.0f * plane[0]); vert[1][3] = (int)(1.0f * plane[1]);
-    vert[2][2] = (int)(1.0f * plane[0]); vert[2][3] = (int)(0.0f * plane[1]);
-    vert[3][2] = (int)(1.0f * plane[0]); vert[3][3] = (int)(1.0f * plane[1]);
+    vert = MALI_Blitter_CompileShader(blitter, GL_VERTEX_SHADER, blit_vert);
+    frag = MALI_Blitter_CompileShader(blitter, GL_FRAGMENT_SHADER, scaler->frag);
+    blitter->glAttachShader(prog, vert);
+    blitter->glAttachShader(prog, frag);
+    blitter->glBindAttribLocation(prog, MALI_ATTRIB_VERTCOORD, "aVertCoord");
+    blitter->glBindAttribLocation(prog, MALI_ATTRIB_TEXCOORD, "aTexCoord");
+    blitter->glLinkProgram(prog);
+
+    /* The program keeps what it needs */
+    blitter->glDeleteShader(vert);
+    blitter->glDeleteShader(frag);
+
+    blitter->glGetProgramInfoLog(prog, sizeof(msg), NULL, msg);
+    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Blitter Program Info: %s\n", msg);
 
-    // Get aspect corrected sizes within pixel boundaries
-    vert[0][0] = (int)(0.0f * ratio_x) + shift_x; vert[0][1] = (int)(0.0f * ratio_y) + shift_y;
-    vert[1][0] = (int)(0.0f * ratio_x) + shift_x; vert[1][1] = (int)(1.0f * ratio_y) + shift_y;
-    vert[2][0] = (int)(1.0f * ratio_x) + shift_x; vert[2][1] = (int)(0.0f * ratio_y) + shift_y;
-    vert[3][0] = (int)(1.0f * ratio_x) + shift_x; vert[3][1] = (int)(1.0f * ratio_y) + shift_y;
+    blitter->glGetProgramiv(prog, GL_LINK_STATUS, &status);
+    if (!status) {
+        blitter->glDeleteProgram(prog);
+        SDL_SetError("mali-fbdev: Failed to link '%s' scaler program", scaler->name);
+        return 0;
+    }
 
-    // Get scale, for filtering.
-    scale[0] = ratio_x / plane[0];
-    scale[1] = ratio_y / plane[1];
+    if (blitter->cache_dir) {
+        blitter->glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+        binary = length > 0 ? SDL_malloc(length) : NULL;
+        if (binary) {
+            blitter->glGetProgramBinaryOES(prog, length, &size, &format, binary);
+            MALI_ProgramCache_Store(blitter->cache_dir, key, format, binary, size);
+            SDL_free(binary);
+        }
+    }
+
+    return prog;
 }
 
-static
-void mat_ortho(float left, float right, float bottom, float top, float Result[4][4])
+static void
+MALI_Blitter_UpdateGeometry(MALI_Blitter *blitter)
 {
-    *(mat4*)Result = (mat4){{[0 ... 15] = 0}};
-    Result[0][0] = 2.0f / (right - left);
-    Result[1][1] = 2.0f / (top - bottom);
-    Result[2][2] = -1.0f;
-    Result[3][0] = - (right + left) / (right - left);
-    Result[3][1] = - (top + bottom) / (top - bottom);
-    Result[3][3] = 1.0f;
+    MALI_ViewportPolicy policy = blitter->viewport;
+    float vert_buffer_data[4][4];
+
+    /* Nothing to lay out before the pages are attached, that does it again */
+    if (blitter->num_planes == 0)
+        return;
+
+    /* Scalers made for whole multiples ask for them unless the policy says otherwise */
+    if (policy.scaling == MALI_VIEWPORT_FIT && blitter->scaler->integer_scale)
+        policy.scaling = MALI_VIEWPORT_INTEGER;
+
+    MALI_Viewport_GetQuad(&policy, blitter->rotation, blitter->viewport_width, blitter->viewport_height,
+                          blitter->plane_width, blitter->plane_height, vert_buffer_data, blitter->scale);
+
+    /* Remember the quad, partial updates need to map damage onto the viewport */
+    SDL_memcpy(blitter->vertices, vert_buffer_data, sizeof(blitter->vertices));
+    blitter->covers_viewport =
+        vert_buffer_data[0][0] <= 0 && vert_buffer_data[0][1] <= 0 &&
+        vert_buffer_data[3][0] >= blitter->viewport_width && vert_buffer_data[3][1] >= blitter->viewport_height;
+
+    blitter->glBindVertexArrayOES(blitter->vao);
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->vbo);
+    blitter->glBufferData(GL_ARRAY_BUFFER, sizeof(vert_buffer_data), vert_buffer_data, GL_STATIC_DRAW);
 }
 
-#define fourcc_code(a, b, c, d) ((__u32)(a) | ((__u32)(b) << 8) | \
-                ((__u32)(c) << 16) | ((__u32)(d) << 24))
+/* Uniforms and sampling of the current program, these depend on the pages as well */
+static void
+MALI_Blitter_ApplyScaler(MALI_Blitter *blitter)
+{
+    GLuint prog = blitter->prog;
+    GLint filter;
+    int i;
+
+    /* Setup viewport, projection, scale, texture size */
+    blitter->glUseProgram(prog);
+    blitter->glUniform1i(blitter->glGetUniformLocation(prog, "uFBOTex"), 0);
+    blitter->glUniformMatrix4fv(blitter->glGetUniformLocation(prog, "uProj"), 1, 0, (GLfloat*)blitter->projection);
+    blitter->glUniform2f(blitter->glGetUniformLocation(prog, "uScale"), blitter->scale[0], blitter->scale[1]);
+    blitter->glUniform2f(blitter->glGetUniformLocation(prog, "uTexSize"), blitter->plane_width, blitter->plane_height);
+
+    // hq scalers require bilinear filtering to optimize texel fetch count
+    filter = blitter->scaler->linear ? GL_LINEAR : GL_NEAREST;
+    for (i = 0; i < blitter->num_planes; i++) {
+        blitter->glBindTexture(GL_TEXTURE_2D, blitter->planes[i].texture);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    }
+}
 
 int
-MALI_InitBlitter(_THIS, MALI_Blitter *blitter, NativeWindowType nw, int rotation)
+MALI_Blitter_SetScaler(_THIS, MALI_Blitter *blitter, const MALI_Scaler *scaler)
 {
-    char *use_hq_scaler;
-    GLchar msg[2048] = {}, blit_vert[2048] = {};
-    const GLchar *sources[2] = { blit_vert, blit_frag_standard };
-    float mat_projection[4][4];
-    float vert_buffer_data[4][4];
-    float scale[2];
+    int index;
+    GLuint prog;
+    SDL_bool relayout;
+
+    index = MALI_Scaler_GetIndex(scaler);
+    if (index < 0)
+        return SDL_SetError("mali-fbdev: Scaler '%s' isn't registered", scaler->name);
+
+    prog = blitter->programs[index];
+    if (!prog) {
+        prog = MALI_Blitter_BuildProgram(_this, blitter, scaler);
+        if (!prog)
+            return -1;
+        blitter->programs[index] = prog;
+    }
+
+    relayout = !blitter->scaler || blitter->scaler->integer_scale != scaler->integer_scale;
+    if (blitter->scaler && relayout) {
+        /* Every buffer in the chain still has the old letterbox */
+        blitter->clear_frames = MALI_BLITTER_MAX_AGE;
+        blitter->shown_count = 0;
+    }
+
+    blitter->scaler = scaler;
+    blitter->prog = prog;
+    if (relayout)
+        MALI_Blitter_UpdateGeometry(blitter);
+    MALI_Blitter_ApplyScaler(blitter);
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Using '%s' scaler", scaler->name);
+    return 0;
+}
+
+static int
+MALI_Blitter_ImportPage(_THIS, MALI_Blitter *blitter, int fd, int width, int height, int pitch, Uint32 fourcc,
+                        GLint wrap, EGLImageKHR *image, GLuint *texture)
+{
+    EGLint attribute_list[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, pitch,
+        EGL_LINUX_DRM_FOURCC_EXT, fourcc,
+        EGL_DMA_BUF_PLANE0_FD_EXT, fd,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT, 0,
+        EGL_NONE
+    };
+
+    *image = _this->egl_data->eglCreateImageKHR(
+        _this->egl_data->egl_display,
+        EGL_NO_CONTEXT,
+        EGL_LINUX_DMA_BUF_EXT,
+        (EGLClientBuffer)NULL,
+        &attribute_list[0]);
+    if (*image == EGL_NO_IMAGE_KHR)
+        return SDL_EGL_SetError("mali-fbdev: Failed to create Blitter EGL Image", "eglCreateImageKHR");
+
+    blitter->glGenTextures(1, texture);
+    blitter->glActiveTexture(GL_TEXTURE0);
+    blitter->glBindTexture(GL_TEXTURE_2D, *texture);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    blitter->glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, *image);
+    return 0;
+}
+
+int
+MALI_Blitter_AttachPlanes(_THIS, MALI_Blitter *blitter)
+{
+    int i;
 
-    if ((use_hq_scaler = SDL_getenv("SDL_MALI_HQ_SCALER")) != NULL && *use_hq_scaler != '0') {
-        switch (*use_hq_scaler) {
-            case '1': sources[1] = blit_frag_bilinear_simple; break;
-            case '2': sources[1] = blit_frag_quilez; break;
-            default: use_hq_scaler = NULL; break;
+    for (i = 0; i < blitter->num_planes; i++) {
+        if (MALI_Blitter_ImportPage(_this, blitter, blitter->planes[i].fd, blitter->plane_width,
+                                    blitter->plane_height, blitter->plane_pitch, blitter->plane_fourcc, GL_CLAMP,
+                                    &blitter->planes[i].image, &blitter->planes[i].texture) < 0) {
+            blitter->num_planes = i;
+            return 0;
         }
-    } else {
-        use_hq_scaler = NULL;
     }
 
+    /* New pages may have a different size, which moves the quad */
+    if (blitter->scaler) {
+        MALI_Blitter_UpdateGeometry(blitter);
+        MALI_Blitter_ApplyScaler(blitter);
+        blitter->clear_frames = MALI_BLITTER_MAX_AGE;
+        blitter->shown_count = 0;
+    }
+
+    return 1;
+}
+
+void
+MALI_Blitter_ReleasePlanes(_THIS, MALI_Blitter *blitter)
+{
+    int i;
+
+    for (i = 0; i < blitter->num_planes; i++) {
+        blitter->glDeleteTextures(1, &blitter->planes[i].texture);
+        _this->egl_data->eglDestroyImageKHR(_this->egl_data->egl_display, blitter->planes[i].image);
+        blitter->planes[i].texture = 0;
+        blitter->planes[i].image = EGL_NO_IMAGE_KHR;
+    }
+
+    blitter->num_planes = 0;
+}
+
+static int
+MALI_Blitter_ImportDMABUF(void *data, const EGLint *attribs, MALI_DMABUFImage *image)
+{
+    MALI_Blitter *blitter = (MALI_Blitter *)data;
+    SDL_VideoDevice *_this = SDL_GetVideoDevice();
+
+    image->image = _this->egl_data->eglCreateImageKHR(_this->egl_data->egl_display, EGL_NO_CONTEXT,
+                                                      EGL_LINUX_DMA_BUF_EXT, (EGLClientBuffer)NULL, attribs);
+    if (image->image == EGL_NO_IMAGE_KHR)
+        return SDL_EGL_SetError("mali-fbdev: Failed to import DMA-BUF frame", "eglCreateImageKHR");
+
+    blitter->glGenTextures(1, &image->texture);
+    blitter->glActiveTexture(GL_TEXTURE0);
+    blitter->glBindTexture(GL_TEXTURE_EXTERNAL_OES, image->texture);
+    blitter->glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    blitter->glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    blitter->glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    blitter->glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    blitter->glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, image->image);
+    return 0;
+}
+
+static void
+MALI_Blitter_ReleaseDMABUF(void *data, MALI_DMABUFImage *image)
+{
+    MALI_Blitter *blitter = (MALI_Blitter *)data;
+    SDL_VideoDevice *_this = SDL_GetVideoDevice();
+
+    blitter->glDeleteTextures(1, &image->texture);
+    _this->egl_data->eglDestroyImageKHR(_this->egl_data->egl_display, image->image);
+}
+
+static const MALI_DMABUFImportOps MALI_Blitter_DMABUFOps = {
+    MALI_Blitter_ImportDMABUF,
+    MALI_Blitter_ReleaseDMABUF
+};
+
+/* Moves the quad to where the policy now puts it, every buffer still has the old letterbox */
+static void
+MALI_Blitter_UpdateViewport(MALI_Blitter *blitter, const MALI_ViewportPolicy *policy)
+{
+    blitter->viewport = *policy;
+    MALI_Blitter_UpdateGeometry(blitter);
+    MALI_Blitter_ApplyScaler(blitter);
+    blitter->clear_frames = MALI_BLITTER_MAX_AGE;
+    blitter->shown_count = 0;
+}
+
+int
+MALI_InitBlitter(_THIS, MALI_Blitter *blitter, NativeWindowType nw, int rotation, const MALI_Scaler *scaler,
+                 const MALI_ViewportPolicy *policy)
+{
     /* Attempt to initialize necessary functions */
     #define SDL_PROC(ret,func,params) \
         blitter->func = SDL_GL_GetProcAddress(#func); \
@@ -221,76 +488,40 @@ MALI_InitBlitter(_THIS, MALI_Blitter *blitter, NativeWindowType nw, int rotation
         SDL_EGL_SetError("mali-fbdev: Failed to setup blitter EGL Context", "SDL_EGL_CreateContext");
         return 0;
     }
-    
+
     if (!_this->egl_data->eglMakeCurrent(_this->egl_data->egl_display,
-        blitter->surface, 
-        blitter->surface, 
+        blitter->surface,
+        blitter->surface,
         blitter->context))
     {
         SDL_EGL_SetError("mali-fbdev: Unable to make blitter EGL context current", "eglMakeCurrent");
         return 0;
     }
 
-    /* Setup vertex shader coord orientation */
-    SDL_snprintf(blit_vert, sizeof(blit_vert), blit_vert_fmt,
-        /* rotation */
-        (rotation == 0) ? "vTexCoord = aTexCoord;" :
-        (rotation == 1) ? "vTexCoord = vec2(aTexCoord.y, -aTexCoord.x);" :
-        (rotation == 2) ? "vTexCoord = vec2(-aTexCoord.x, -aTexCoord.y);" :
-        (rotation == 3) ? "vTexCoord = vec2(-aTexCoord.y, aTexCoord.x);" :
-        "#error Orientation out of scope",
-        /* scalers */
-        (use_hq_scaler) ? "vTexCoord = vTexCoord;"
-                        : "vTexCoord = vTexCoord / uTexSize;");
-
-    /* Compile vertex shader */
-    blitter->vert = blitter->glCreateShader(GL_VERTEX_SHADER);
-    blitter->glShaderSource(blitter->vert, 1, &sources[0], NULL);
-    blitter->glCompileShader(blitter->vert);
-    blitter->glGetShaderInfoLog(blitter->vert, sizeof(msg), NULL, msg);
-    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Blitter Vertex Shader Info: %s\n", msg);
-
-    /* Compile the fragment shader */
-    blitter->frag = blitter->glCreateShader(GL_FRAGMENT_SHADER);
-    blitter->glShaderSource(blitter->frag, 1, &sources[1], NULL);
-    blitter->glCompileShader(blitter->frag);
-    blitter->glGetShaderInfoLog(blitter->frag, sizeof(msg), NULL, msg);
-    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Blitter Fragment Shader Info: %s\n", msg);
-
-    blitter->prog = blitter->glCreateProgram();
-    blitter->glAttachShader(blitter->prog, blitter->vert);
-    blitter->glAttachShader(blitter->prog, blitter->frag);
-
-    blitter->glLinkProgram(blitter->prog);
-    blitter->loc_aVertCoord = blitter->glGetAttribLocation(blitter->prog, "aVertCoord");
-    blitter->loc_aTexCoord = blitter->glGetAttribLocation(blitter->prog, "aTexCoord");
-    blitter->loc_uFBOtex = blitter->glGetUniformLocation(blitter->prog, "uFBOTex");
-    blitter->loc_uProj = blitter->glGetUniformLocation(blitter->prog, "uProj");
-    blitter->loc_uTexSize = blitter->glGetUniformLocation(blitter->prog, "uTexSize");
-    blitter->loc_uScale = blitter->glGetUniformLocation(blitter->prog, "uScale");
-
-    blitter->glGetProgramInfoLog(blitter->prog, sizeof(msg), NULL, msg);
-    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Blitter Program Info: %s\n", msg);
+    blitter->rotation = rotation;
 
-    /* Setup programs */
-    blitter->glUseProgram(blitter->prog);
-    blitter->glUniform1i(blitter->loc_uFBOtex, 0);
-
-    /* Prepare projection and aspect corrected bounds */
-    mat_ortho(0, blitter->viewport_width, 0, blitter->viewport_height, mat_projection);
-    get_aspect_correct_coords(
-        (int [2]){blitter->viewport_width, blitter->viewport_height},
-        (int [2]){blitter->plane_width, blitter->plane_height},
-        rotation,
-        vert_buffer_data,
-        scale
-    );
+    /* Program binaries are optional, without them every start compiles from source */
+    if (MALI_Blitter_HasGLExtension(blitter, "GL_OES_get_program_binary")) {
+        blitter->glGetProgramBinaryOES = SDL_GL_GetProcAddress("glGetProgramBinaryOES");
+        blitter->glProgramBinaryOES = SDL_GL_GetProcAddress("glProgramBinaryOES");
+        if (blitter->glGetProgramBinaryOES && blitter->glProgramBinaryOES)
+            blitter->cache_dir = MALI_ProgramCache_GetDir();
+    }
 
-    /* Setup viewport, projection, scale, texture size */
+    /* Without external textures SDL_PresentDMABUF is unsupported, everything else still works */
+    blitter->has_external = MALI_Blitter_HasGLExtension(blitter, "GL_OES_EGL_image_external");
+    blitter->external_fence = EGL_NO_SYNC_KHR;
+    MALI_DMABUFCache_Init(&blitter->dmabuf_cache, &MALI_Blitter_DMABUFOps, blitter);
+
+    blitter->has_buffer_age = SDL_EGL_HasExtension(_this, SDL_EGL_DISPLAY_EXTENSION, "EGL_EXT_buffer_age") ||
+                              SDL_EGL_HasExtension(_this, SDL_EGL_DISPLAY_EXTENSION, "EGL_KHR_partial_update");
+    if (SDL_EGL_HasExtension(_this, SDL_EGL_DISPLAY_EXTENSION, "EGL_KHR_partial_update")) {
+        blitter->eglSetDamageRegionKHR = SDL_EGL_GetProcAddress(_this, "eglSetDamageRegionKHR");
+    }
+
+    /* Prepare projection, the aspect corrected bounds depend on the scaler */
+    mat_ortho(0, blitter->viewport_width, 0, blitter->viewport_height, blitter->projection);
     blitter->glViewport(0, 0, blitter->viewport_width, blitter->viewport_height);
-    blitter->glUniformMatrix4fv(blitter->loc_uProj, 1, 0, (GLfloat*)mat_projection);
-    blitter->glUniform2f(blitter->loc_uScale, scale[0], scale[1]);
-    blitter->glUniform2f(blitter->loc_uTexSize, blitter->plane_width, blitter->plane_height);
 
     /* Generate buffers */
     blitter->glGenBuffers(1, &blitter->vbo);
@@ -299,104 +530,761 @@ MALI_InitBlitter(_THIS, MALI_Blitter *blitter, NativeWindowType nw, int rotation
     /* Populate buffers */
     blitter->glBindVertexArrayOES(blitter->vao);
     blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->vbo);
-    blitter->glEnableVertexAttribArray(blitter->loc_aVertCoord);
-    blitter->glEnableVertexAttribArray(blitter->loc_aTexCoord);
-    blitter->glVertexAttribPointer(blitter->loc_aVertCoord, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float)));
-    blitter->glVertexAttribPointer(blitter->loc_aTexCoord, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    blitter->glBufferData(GL_ARRAY_BUFFER, sizeof(vert_buffer_data), vert_buffer_data, GL_STATIC_DRAW);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_VERTCOORD);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_TEXCOORD);
+    blitter->glVertexAttribPointer(MALI_ATTRIB_VERTCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float)));
+    blitter->glVertexAttribPointer(MALI_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+
+    /* Overlays get a quad of their own, refilled for each one */
+    blitter->glGenBuffers(1, &blitter->overlay_vbo);
+    blitter->glGenVertexArraysOES(1, &blitter->overlay_vao);
+    blitter->glBindVertexArrayOES(blitter->overlay_vao);
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->overlay_vbo);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_VERTCOORD);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_TEXCOORD);
+    blitter->glVertexAttribPointer(MALI_ATTRIB_VERTCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(0 * sizeof(float)));
+    blitter->glVertexAttribPointer(MALI_ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+
+    blitter->viewport = *policy;
+
+    if (MALI_Blitter_SetScaler(_this, blitter, scaler) < 0 &&
+        MALI_Blitter_SetScaler(_this, blitter, MALI_Scaler_Find("nearest")) < 0)
+        return 0;
 
-    for (int i = 0; i < 3; i++) {
-        EGLint attribute_list[] = {
-            EGL_WIDTH, blitter->plane_width,
-            EGL_HEIGHT, blitter->plane_height,
-            EGL_DMA_BUF_PLANE0_PITCH_EXT, blitter->plane_pitch,
-            EGL_LINUX_DRM_FOURCC_EXT, fourcc_code('A', 'R', '2', '4'),
-            EGL_DMA_BUF_PLANE0_FD_EXT, blitter->planes[i].fd,
-            EGL_DMA_BUF_PLANE0_OFFSET_EXT, 0,
-            EGL_NONE
-        };
-
-        blitter->planes[i].image = _this->egl_data->eglCreateImageKHR(
-            _this->egl_data->egl_display,
-            EGL_NO_CONTEXT,
-            EGL_LINUX_DMA_BUF_EXT,
-            (EGLClientBuffer)NULL,
-            &attribute_list[0]);
-        if (blitter->planes[i].image == EGL_NO_IMAGE_KHR) {
-            SDL_EGL_SetError("mali-fbdev: Failed to create Blitter EGL Image", "eglCreateImageKHR");
-            return 0;
-        }
+    return 1;
+}
 
-        blitter->glGenTextures(1, &blitter->planes[i].texture);
-        blitter->glActiveTexture(GL_TEXTURE0);
-        blitter->glBindTexture(GL_TEXTURE_2D, blitter->planes[i].texture);
-        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-        blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-        if (use_hq_scaler) {
-            // hq scaler requires bilinear filtering to optimize texel fetch count
-            blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        } else {
-            blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            blitter->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);            
+void
+MALI_DeinitBlitter(_THIS, MALI_Blitter *blitter)
+{
+    int i;
+
+    MALI_Blitter_RetireExternal(_this, blitter);
+    MALI_DMABUFCache_Quit(&blitter->dmabuf_cache);
+    if (blitter->external_prog)
+        blitter->glDeleteProgram(blitter->external_prog);
+    if (blitter->overlay_prog)
+        blitter->glDeleteProgram(blitter->overlay_prog);
+    blitter->glDeleteBuffers(1, &blitter->overlay_vbo);
+    blitter->glDeleteVertexArraysOES(1, &blitter->overlay_vao);
+    if (blitter->hud_prog) {
+        blitter->glDeleteProgram(blitter->hud_prog);
+        blitter->glDeleteBuffers(1, &blitter->hud_vbo);
+        blitter->glDeleteVertexArraysOES(1, &blitter->hud_vao);
+    }
+
+    for (i = 0; i < MALI_SCALER_MAX; i++) {
+        if (blitter->programs[i])
+            blitter->glDeleteProgram(blitter->programs[i]);
+    }
+    blitter->glDeleteBuffers(1, &blitter->vbo);
+    blitter->glDeleteVertexArraysOES(1, &blitter->vao);
+    MALI_Blitter_ReleasePlanes(_this, blitter);
+
+    _this->egl_data->eglMakeCurrent(_this->egl_data->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    _this->egl_data->eglDestroySurface(_this->egl_data->egl_display, blitter->surface);
+    _this->egl_data->eglDestroyContext(_this->egl_data->egl_display, blitter->context);
+
+    SDL_free(blitter->cache_dir);
+    blitter->cache_dir = NULL;
+}
+
+int MALI_Blitter_GetBufferAge(_THIS, MALI_Blitter *blitter)
+{
+    EGLint age = 0;
+
+    if (!blitter->has_buffer_age ||
+        !_this->egl_data->eglQuerySurface(_this->egl_data->egl_display, blitter->surface, EGL_BUFFER_AGE_EXT, &age))
+        return 0;
+
+    return age;
+}
+
+static void
+MALI_Blitter_DamageToViewport(MALI_Blitter *blitter, const SDL_Rect *damage, SDL_Rect *region)
+{
+    SDL_Rect plane = { 0, 0, blitter->plane_width, blitter->plane_height };
+    SDL_Rect viewport = { 0, 0, blitter->viewport_width, blitter->viewport_height };
+    GLfloat (*v)[4] = blitter->vertices;
+    GLfloat tx[2], ty[2], ax[2], ay[2], sx[2], sy[2];
+    SDL_Rect clipped;
+    int i;
+
+    if (!SDL_IntersectRect(damage, &plane, &clipped)) {
+        SDL_zerop(region);
+        return;
+    }
+
+    /* Window coordinates to texels, GL has the origin at the bottom left */
+    tx[0] = clipped.x;
+    tx[1] = clipped.x + clipped.w;
+    ty[0] = plane.h - (clipped.y + clipped.h);
+    ty[1] = plane.h - clipped.y;
+
+    for (i = 0; i < 2; i++) {
+        /* Undo the rotation the vertex shader applies to the texture coordinates */
+        switch (blitter->rotation) {
+            case 1: ax[i] = plane.h - ty[i]; ay[i] = tx[i]; break;
+            case 2: ax[i] = plane.w - tx[i]; ay[i] = plane.h - ty[i]; break;
+            case 3: ax[i] = ty[i]; ay[i] = plane.w - tx[i]; break;
+            default: ax[i] = tx[i]; ay[i] = ty[i]; break;
         }
-        blitter->glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, blitter->planes[i].image);
+
+        /* The quad maps texture coordinates linearly onto the viewport */
+        sx[i] = v[0][0] + (ax[i] - v[0][2]) * (v[3][0] - v[0][0]) / (v[3][2] - v[0][2]);
+        sy[i] = v[0][1] + (ay[i] - v[0][3]) * (v[3][1] - v[0][1]) / (v[3][3] - v[0][3]);
     }
 
-    return 1;
+    /* Round outwards, with some slack for the footprint of the filtering shaders */
+    region->x = (int)SDL_floorf(SDL_min(sx[0], sx[1])) - 2;
+    region->y = (int)SDL_floorf(SDL_min(sy[0], sy[1])) - 2;
+    region->w = (int)SDL_ceilf(SDL_max(sx[0], sx[1])) + 2 - region->x;
+    region->h = (int)SDL_ceilf(SDL_max(sy[0], sy[1])) + 2 - region->y;
+    if (!SDL_IntersectRect(region, &viewport, region))
+        SDL_zerop(region);
+}
+
+/*
+ * The quad is opaque, only buffers we haven't drawn to yet need their letterbox cleared,
+ * as do all of them after a scaler switch moved the quad.
+ */
+static void
+MALI_Blitter_ClearLetterbox(MALI_Blitter *blitter, int age)
+{
+    if ((age == 0 && !blitter->covers_viewport) || blitter->clear_frames > 0) {
+        blitter->glClearColor(0.0, 0.0, 0.0, 1.0);
+        blitter->glClear(GL_COLOR_BUFFER_BIT);
+        if (blitter->clear_frames > 0)
+            blitter->clear_frames--;
+    }
 }
 
-void MALI_Blitter_Blit(_THIS, MALI_Blitter *blitter, int texture)
+static int
+MALI_Blitter_InitHUD(MALI_Blitter *blitter)
 {
+    GLchar msg[2048] = {};
+    GLuint prog, vert, frag;
+    GLint status = GL_FALSE;
+
+    vert = MALI_Blitter_CompileShader(blitter, GL_VERTEX_SHADER, hud_vert);
+    frag = MALI_Blitter_CompileShader(blitter, GL_FRAGMENT_SHADER, hud_frag);
+    prog = blitter->glCreateProgram();
+    blitter->glAttachShader(prog, vert);
+    blitter->glAttachShader(prog, frag);
+    blitter->glBindAttribLocation(prog, MALI_ATTRIB_VERTCOORD, "aVertCoord");
+    blitter->glLinkProgram(prog);
+    blitter->glDeleteShader(vert);
+    blitter->glDeleteShader(frag);
+
+    blitter->glGetProgramiv(prog, GL_LINK_STATUS, &status);
+    if (!status) {
+        blitter->glGetProgramInfoLog(prog, sizeof(msg), NULL, msg);
+        blitter->glDeleteProgram(prog);
+        return SDL_SetError("mali-fbdev: Failed to link HUD program: %s", msg);
+    }
+
+    blitter->glGenBuffers(1, &blitter->hud_vbo);
+    blitter->glGenVertexArraysOES(1, &blitter->hud_vao);
+    blitter->glBindVertexArrayOES(blitter->hud_vao);
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->hud_vbo);
+    blitter->glEnableVertexAttribArray(MALI_ATTRIB_VERTCOORD);
+    blitter->glVertexAttribPointer(MALI_ATTRIB_VERTCOORD, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    blitter->hud_prog = prog;
+    return 0;
+}
+
+/* Blended over whatever has been drawn, the caller clears the frame as the overlay changes every time */
+void
+MALI_Blitter_DrawHUD(_THIS, MALI_Blitter *blitter, const MALI_HUD *hud)
+{
+    GLint color;
+    int i;
+
+    if (!blitter->hud_prog && MALI_Blitter_InitHUD(blitter) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "%s", SDL_GetError());
+        return;
+    }
+
+    blitter->glUseProgram(blitter->hud_prog);
+    blitter->glUniformMatrix4fv(blitter->glGetUniformLocation(blitter->hud_prog, "uProj"), 1, 0,
+                                (const GLfloat *)hud->projection);
+    color = blitter->glGetUniformLocation(blitter->hud_prog, "uColor");
+
+    blitter->glBindVertexArrayOES(blitter->hud_vao);
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->hud_vbo);
+    blitter->glBufferData(GL_ARRAY_BUFFER, hud->num_vertices * sizeof(hud->vertices[0]), hud->vertices,
+                          GL_STREAM_DRAW);
+
+    blitter->glEnable(GL_BLEND);
+    blitter->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    for (i = 0; i < MALI_HUD_NUM_PARTS; i++) {
+        if (hud->count[i] == 0)
+            continue;
+        blitter->glUniform4f(color, hud_colors[i][0], hud_colors[i][1], hud_colors[i][2], hud_colors[i][3]);
+        blitter->glDrawArrays(GL_TRIANGLES, hud->first[i], hud->count[i]);
+    }
+    blitter->glDisable(GL_BLEND);
+
+    blitter->glUseProgram(blitter->prog);
+}
+
+void MALI_Blitter_Blit(_THIS, MALI_Blitter *blitter, int texture, const SDL_Rect *damage, int age)
+{
+    SDL_Rect region = { 0, 0, blitter->viewport_width, blitter->viewport_height };
+    SDL_bool partial = (damage != NULL && age > 0);
+    EGLint rect[4];
+
+    if (partial)
+        MALI_Blitter_DamageToViewport(blitter, damage, &region);
+
+    /* Nothing changed, the back buffer already holds this frame */
+    if (SDL_RectEmpty(&region))
+        return;
+
+    /* Lets tiled GPUs skip loading and storing the parts we won't touch */
+    if (blitter->eglSetDamageRegionKHR) {
+        rect[0] = region.x; rect[1] = region.y;
+        rect[2] = region.w; rect[3] = region.h;
+        blitter->eglSetDamageRegionKHR(_this->egl_data->egl_display, blitter->surface, rect, 1);
+    }
+
+    MALI_Blitter_ClearLetterbox(blitter, age);
+
+    if (partial) {
+        blitter->glEnable(GL_SCISSOR_TEST);
+        blitter->glScissor(region.x, region.y, region.w, region.h);
+    }
+
     blitter->glBindVertexArrayOES(blitter->vao);
     blitter->glBindTexture(GL_TEXTURE_2D, blitter->planes[texture].texture);
     blitter->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    if (partial)
+        blitter->glDisable(GL_SCISSOR_TEST);
+}
+
+/* Draws a frame straight from its DMA-BUF into the same quad the pages would cover */
+int
+MALI_Blitter_BlitExternal(_THIS, MALI_Blitter *blitter, const SDL_DMABUFFrame *frame, int age)
+{
+    MALI_DMABUFImage *image;
+    GLuint prog;
+
+    if (!blitter->has_external)
+        return SDL_SetError("mali-fbdev: GL_OES_EGL_image_external isn't supported");
+
+    image = MALI_DMABUFCache_Get(&blitter->dmabuf_cache, frame);
+    if (!image)
+        return -1;
+
+    if (!blitter->external_prog) {
+        blitter->external_prog = MALI_Blitter_BuildProgram(_this, blitter, &external_scaler);
+        if (!blitter->external_prog)
+            return -1;
+    }
+
+    MALI_Blitter_ClearLetterbox(blitter, age);
+
+    /* Normalized coordinates over the pages' quad stretch the frame across the window */
+    prog = blitter->external_prog;
+    blitter->glUseProgram(prog);
+    blitter->glUniform1i(blitter->glGetUniformLocation(prog, "uFBOTex"), 0);
+    blitter->glUniformMatrix4fv(blitter->glGetUniformLocation(prog, "uProj"), 1, 0, (GLfloat*)blitter->projection);
+    blitter->glUniform2f(blitter->glGetUniformLocation(prog, "uTexSize"), blitter->plane_width, blitter->plane_height);
+
+    blitter->glBindVertexArrayOES(blitter->vao);
+    blitter->glBindTexture(GL_TEXTURE_EXTERNAL_OES, image->texture);
+    blitter->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    blitter->glUseProgram(blitter->prog);
+
+    /* The back buffers no longer hold frames of the swap chain, partial updates have to start over */
+    blitter->shown_count = 0;
+    return 0;
+}
+
+/* Hands the frame that was on screen back to its owner once the GPU is done reading it */
+void
+MALI_Blitter_RetireExternal(_THIS, MALI_Blitter *blitter)
+{
+    if (!blitter->showing_external)
+        return;
+
+    if (blitter->external_fence != EGL_NO_SYNC_KHR) {
+        _this->egl_data->eglClientWaitSyncKHR(_this->egl_data->egl_display, blitter->external_fence,
+            EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_NV);
+        _this->egl_data->eglDestroySyncKHR(_this->egl_data->egl_display, blitter->external_fence);
+        blitter->external_fence = EGL_NO_SYNC_KHR;
+    }
+
+    blitter->showing_external = SDL_FALSE;
+    MALI_DMABUF_Release(&blitter->external);
+}
+
+/*
+ * Draws a new frame, or redraws the one on screen when passed blitter->external. It
+ * is held on to until the next one is drawn rather than waiting for the GPU here,
+ * by then its fence has long signaled.
+ */
+static void
+MALI_Blitter_ShowExternal(_THIS, MALI_Blitter *blitter, const SDL_DMABUFFrame *frame, int age)
+{
+    SDL_bool held = (frame == &blitter->external);
+    EGLSyncKHR fence;
+
+    if (MALI_Blitter_BlitExternal(_this, blitter, frame, age) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "%s", SDL_GetError());
+        if (!held)
+            MALI_DMABUF_Release(frame);
+        return;
+    }
+
+    fence = _this->egl_data->eglCreateSyncKHR(_this->egl_data->egl_display, EGL_SYNC_FENCE_KHR, NULL);
+    if (held) {
+        if (blitter->external_fence != EGL_NO_SYNC_KHR)
+            _this->egl_data->eglDestroySyncKHR(_this->egl_data->egl_display, blitter->external_fence);
+    } else {
+        MALI_Blitter_RetireExternal(_this, blitter);
+        blitter->external = *frame;
+        blitter->showing_external = SDL_TRUE;
+    }
+    blitter->external_fence = fence;
+}
+
+/*
+ * Where a window at rect in display coordinates lands on the viewport. The display is
+ * the viewport turned by the rotation, the texture coordinates get turned back by the
+ * vertex shader like those of the scaled quad.
+ */
+void
+MALI_Blitter_GetOverlayQuad(int rotation, int viewport_width, int viewport_height, const SDL_Rect *rect,
+                            GLfloat vert[4][4])
+{
+    int display_w = (rotation & 1) ? viewport_height : viewport_width;
+    int display_h = (rotation & 1) ? viewport_width : viewport_height;
+    GLfloat tx[2], ty[2], ax[2], ay[2], x0, y0, x1, y1, u, v;
+    int i;
+
+    /* GL has the origin at the bottom left */
+    tx[0] = rect->x;
+    tx[1] = rect->x + rect->w;
+    ty[0] = display_h - (rect->y + rect->h);
+    ty[1] = display_h - rect->y;
+
+    /* Same as MALI_Blitter_DamageToViewport */
+    for (i = 0; i < 2; i++) {
+        switch (rotation) {
+            case 1: ax[i] = display_h - ty[i]; ay[i] = tx[i]; break;
+            case 2: ax[i] = display_w - tx[i]; ay[i] = display_h - ty[i]; break;
+            case 3: ax[i] = ty[i]; ay[i] = display_w - tx[i]; break;
+            default: ax[i] = tx[i]; ay[i] = ty[i]; break;
+        }
+    }
+
+    x0 = SDL_min(ax[0], ax[1]);
+    x1 = SDL_max(ax[0], ax[1]);
+    y0 = SDL_min(ay[0], ay[1]);
+    y1 = SDL_max(ay[0], ay[1]);
+    u = (rotation & 1) ? rect->h : rect->w;
+    v = (rotation & 1) ? rect->w : rect->h;
+
+    vert[0][0] = x0; vert[0][1] = y0; vert[0][2] = 0; vert[0][3] = 0;
+    vert[1][0] = x0; vert[1][1] = y1; vert[1][2] = 0; vert[1][3] = v;
+    vert[2][0] = x1; vert[2][1] = y0; vert[2][2] = u; vert[2][3] = 0;
+    vert[3][0] = x1; vert[3][1] = y1; vert[3][2] = u; vert[3][3] = v;
+}
+
+int
+MALI_Blitter_AttachOverlay(_THIS, MALI_Blitter *blitter, SDL_WindowData *windowdata)
+{
+    MALI_EGL_Surface *surf;
+    int i;
+
+    if (!blitter->overlay_prog) {
+        blitter->overlay_prog = MALI_Blitter_BuildProgram(_this, blitter, &overlay_scaler);
+        if (!blitter->overlay_prog)
+            return -1;
+    }
+
+    for (i = 0; i < windowdata->swapchain.depth; i++) {
+        surf = &windowdata->surface[i];
+        if (MALI_Blitter_ImportPage(_this, blitter, surf->pixmap.handles[0], surf->pixmap.width,
+                                    surf->pixmap.height, surf->pixmap.planes[0].stride, windowdata->format->fourcc,
+                                    GL_CLAMP_TO_EDGE, &surf->egl_image, &surf->texture) < 0) {
+            MALI_Blitter_ReleaseOverlay(_this, blitter, windowdata);
+            return -1;
+        }
+    }
+
+    windowdata->overlay = SDL_TRUE;
+    return 0;
+}
+
+void
+MALI_Blitter_ReleaseOverlay(_THIS, MALI_Blitter *blitter, SDL_WindowData *windowdata)
+{
+    MALI_EGL_Surface *surf;
+    int i;
+
+    for (i = 0; i < MALI_SWAPCHAIN_MAX_DEPTH; i++) {
+        surf = &windowdata->surface[i];
+        if (surf->texture)
+            blitter->glDeleteTextures(1, &surf->texture);
+        if (surf->egl_image != EGL_NO_IMAGE_KHR)
+            _this->egl_data->eglDestroyImageKHR(_this->egl_data->egl_display, surf->egl_image);
+        surf->texture = 0;
+        surf->egl_image = EGL_NO_IMAGE_KHR;
+    }
+
+    windowdata->overlay = SDL_FALSE;
+}
+
+/* Pages with alpha are blended over what's below, the others replace it */
+void
+MALI_Blitter_BlitOverlay(_THIS, MALI_Blitter *blitter, SDL_WindowData *windowdata, int page)
+{
+    MALI_EGL_Surface *surf = &windowdata->surface[page];
+    GLfloat vert[4][4];
+    SDL_Rect rect;
+    GLuint prog;
+
+    rect.x = windowdata->x;
+    rect.y = windowdata->y;
+    rect.w = surf->pixmap.width;
+    rect.h = surf->pixmap.height;
+    MALI_Blitter_GetOverlayQuad(blitter->rotation, blitter->viewport_width, blitter->viewport_height, &rect, vert);
+
+    prog = blitter->overlay_prog;
+    blitter->glUseProgram(prog);
+    blitter->glUniform1i(blitter->glGetUniformLocation(prog, "uFBOTex"), 0);
+    blitter->glUniformMatrix4fv(blitter->glGetUniformLocation(prog, "uProj"), 1, 0, (GLfloat*)blitter->projection);
+    blitter->glUniform2f(blitter->glGetUniformLocation(prog, "uTexSize"), rect.w, rect.h);
+
+    blitter->glBindVertexArrayOES(blitter->overlay_vao);
+    blitter->glBindBuffer(GL_ARRAY_BUFFER, blitter->overlay_vbo);
+    blitter->glBufferData(GL_ARRAY_BUFFER, sizeof(vert), vert, GL_STREAM_DRAW);
+    blitter->glBindTexture(GL_TEXTURE_2D, surf->texture);
+
+    if (windowdata->format->alpha_size > 0) {
+        blitter->glEnable(GL_BLEND);
+        blitter->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    blitter->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    if (windowdata->format->alpha_size > 0)
+        blitter->glDisable(GL_BLEND);
+
+    blitter->glUseProgram(blitter->prog);
+}
+
+static void
+MALI_PushFrameTiming(SDL_WindowData *windowdata, const SDL_GLFrameTiming *timing)
+{
+    int slot;
+
+    /* Overwrite the oldest record when the application doesn't keep up */
+    if (windowdata->timings_count == MALI_MAX_FRAME_TIMINGS) {
+        windowdata->timings_start = (windowdata->timings_start + 1) % MALI_MAX_FRAME_TIMINGS;
+        windowdata->timings_count--;
+    }
+
+    slot = (windowdata->timings_start + windowdata->timings_count) % MALI_MAX_FRAME_TIMINGS;
+    windowdata->timings[slot] = *timing;
+    windowdata->timings_count++;
+}
+
+/* Union of the damage after the frame in the back buffer up to the one being shown */
+static SDL_bool
+MALI_CollectDamage(SDL_WindowData *windowdata, MALI_Blitter *blitter, int age, Uint32 frame, SDL_Rect *damage)
+{
+    MALI_FrameDamage *entry;
+    SDL_bool full;
+    SDL_Rect rect;
+    Uint32 since, f;
+
+    /* A buffer age of N means the back buffer holds what was shown N swaps ago */
+    if (age <= 0 || age > blitter->shown_count)
+        return SDL_FALSE;
+
+    since = blitter->shown[age - 1];
+    if (frame - since > MALI_MAX_FRAME_DAMAGE)
+        return SDL_FALSE;
+
+    SDL_zerop(damage);
+    for (f = since + 1; f != frame + 1; f++) {
+        entry = &windowdata->damage[f % MALI_MAX_FRAME_DAMAGE];
+        if (entry->frame != f)
+            return SDL_FALSE;
+        SDL_MemoryBarrierAcquire();
+        full = entry->full;
+        rect = entry->rect;
+
+        /* The application may have started to reuse the slot meanwhile, see MALI_GLES_SwapWindowWithDamage */
+        SDL_MemoryBarrierAcquire();
+        if (entry->frame != f || full)
+            return SDL_FALSE;
+        SDL_UnionRect(damage, &rect, damage);
+    }
+
+    return SDL_TRUE;
+}
+
+static void
+MALI_Blitter_UsePages(MALI_Blitter *blitter, SDL_WindowData *windowdata)
+{
+    int i;
+
+    blitter->plane_width = windowdata->surface[0].pixmap.width;
+    blitter->plane_height = windowdata->surface[0].pixmap.height;
+    blitter->plane_pitch = windowdata->surface[0].pixmap.planes[0].stride;
+    blitter->plane_fourcc = windowdata->format->fourcc;
+    blitter->num_planes = windowdata->swapchain.depth;
+
+    for (i = 0; i < blitter->num_planes; i++) {
+        blitter->planes[i].fd = windowdata->surface[i].pixmap.handles[0];
+    }
+}
+
+/* The bottom window is scaled to the screen, may be scanned out directly and takes SDL_PresentDMABUF frames */
+static SDL_WindowData *
+MALI_GetBaseWindow(SDL_DisplayData *displaydata)
+{
+    return displaydata->num_windows > 0 ? (SDL_WindowData *)displaydata->windows[0]->driverdata : NULL;
+}
+
+static SDL_bool
+MALI_HasWork(SDL_DisplayData *displaydata)
+{
+    SDL_WindowData *windowdata;
+    int i;
+
+    if (displaydata->triplebuf_thread_stop || displaydata->redraw)
+        return SDL_TRUE;
+
+    for (i = 0; i < displaydata->num_windows; i++) {
+        windowdata = (SDL_WindowData *)displaydata->windows[i]->driverdata;
+        if (windowdata->reconfigure == MALI_RECONFIGURE_REQUESTED ||
+            windowdata->reconfigure == MALI_RECONFIGURE_RESUMED || windowdata->dmabuf_pending)
+            return SDL_TRUE;
+        if (windowdata->reconfigure == MALI_RECONFIGURE_NONE && MALI_SwapChain_HasQueued(&windowdata->swapchain))
+            return SDL_TRUE;
+    }
+
+    return SDL_FALSE;
+}
+
+/* The policy the viewport hints last made, set from the threads changing them */
+static void
+MALI_GetViewportPolicy(SDL_DisplayData *displaydata, MALI_ViewportPolicy *policy)
+{
+    SDL_AtomicLock(&displaydata->viewport_lock);
+    *policy = displaydata->viewport;
+    SDL_AtomicUnlock(&displaydata->viewport_lock);
+}
+
+/*
+ * Sleeps until a window has a frame to show or needs reconfiguring, or the thread
+ * has to stop. Lock-free swap chains never take the mutex on a swap, so we say we're
+ * going to sleep before looking for work one last time. Whoever clears the flag first
+ * posts the semaphore, which then holds at most that one post.
+ */
+static void
+MALI_WaitForWork(SDL_DisplayData *displaydata)
+{
+    while (!MALI_HasWork(displaydata)) {
+        SDL_AtomicCAS(&displaydata->triplebuf_sleeping, 0, 1);
+        if (MALI_HasWork(displaydata) && SDL_AtomicCAS(&displaydata->triplebuf_sleeping, 1, 0))
+            break;
+
+        /* Either nothing came in or a waker beat us to the flag, its post is on the way */
+        SDL_UnlockMutex(displaydata->triplebuf_mutex);
+        SDL_SemWait(displaydata->triplebuf_sem);
+        SDL_LockMutex(displaydata->triplebuf_mutex);
+    }
+}
+
+/*
+ * Keeps the pages the blitter has imported in step with the windows, the bottom one's
+ * go into the planes and those of the others become overlays. Windows changing size or
+ * going away get their pages swapped out from under us without holding up the rest.
+ */
+static void
+MALI_UpdateLayers(_THIS, MALI_Blitter *blitter, SDL_DisplayData *displaydata, SDL_WindowData **base)
+{
+    SDL_WindowData *windowdata, *bottom = MALI_GetBaseWindow(displaydata);
+    int i, ok;
+
+    for (i = 0; i < displaydata->num_windows; i++) {
+        windowdata = (SDL_WindowData *)displaydata->windows[i]->driverdata;
+
+        if (windowdata->reconfigure == MALI_RECONFIGURE_REQUESTED) {
+            if (windowdata == *base) {
+                MALI_Blitter_ReleasePlanes(_this, blitter);
+                *base = NULL;
+            }
+            MALI_Blitter_ReleaseOverlay(_this, blitter, windowdata);
+            windowdata->shown = SDL_FALSE;
+            windowdata->reconfigure = MALI_RECONFIGURE_PAUSED;
+            SDL_CondBroadcast(displaydata->triplebuf_cond);
+        } else if (windowdata->reconfigure == MALI_RECONFIGURE_RESUMED) {
+            windowdata->import_failed = SDL_FALSE;
+            if (windowdata == bottom) {
+                MALI_Blitter_UsePages(blitter, windowdata);
+                ok = MALI_Blitter_AttachPlanes(_this, blitter);
+                if (ok)
+                    *base = windowdata;
+            } else {
+                ok = (MALI_Blitter_AttachOverlay(_this, blitter, windowdata) == 0);
+            }
+
+            if (!ok) {
+                SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "%s", SDL_GetError());
+                windowdata->import_failed = SDL_TRUE;
+            }
+            windowdata->reconfigure = ok ? MALI_RECONFIGURE_NONE : MALI_RECONFIGURE_FAILED;
+            SDL_CondBroadcast(displaydata->triplebuf_cond);
+        }
+    }
+
+    /* The bottom window went away, the one above it takes its place */
+    if (bottom && bottom != *base && bottom->reconfigure == MALI_RECONFIGURE_NONE && !bottom->import_failed) {
+        MALI_Blitter_RetireExternal(_this, blitter);
+        MALI_Blitter_ReleasePlanes(_this, blitter);
+        MALI_Blitter_ReleaseOverlay(_this, blitter, bottom);
+        MALI_Blitter_UsePages(blitter, bottom);
+        if (MALI_Blitter_AttachPlanes(_this, blitter)) {
+            *base = bottom;
+            bottom->dmabuf_supported = blitter->has_external;
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "%s", SDL_GetError());
+            bottom->import_failed = SDL_TRUE;
+        }
+    }
+
+    for (i = 1; i < displaydata->num_windows; i++) {
+        windowdata = (SDL_WindowData *)displaydata->windows[i]->driverdata;
+        if (windowdata->reconfigure != MALI_RECONFIGURE_NONE || windowdata->overlay || windowdata->import_failed)
+            continue;
+
+        if (MALI_Blitter_AttachOverlay(_this, blitter, windowdata) < 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "%s", SDL_GetError());
+            windowdata->import_failed = SDL_TRUE;
+        }
+    }
+}
+
+/* Waits for the application's GPU to finish the page, pages drawn by the CPU come without a fence */
+static void
+MALI_WaitForPage(_THIS, MALI_EGL_Surface *surface, SDL_GLFrameTiming *timing)
+{
+    *timing = (SDL_GLFrameTiming){
+        .frame = surface->frame,
+        .swap_requested = surface->swap_requested,
+        .fence_wait_start = SDL_GetPerformanceCounter(),
+    };
+
+    if (surface->fence == EGL_NO_SYNC_KHR) {
+        timing->fence_signaled = timing->fence_wait_start;
+    } else if (_this->egl_data->eglClientWaitSyncKHR(
+        _this->egl_data->egl_display,
+        surface->fence,
+        EGL_SYNC_FLUSH_COMMANDS_BIT_KHR,
+        EGL_FOREVER_NV))
+    {
+        timing->fence_signaled = SDL_GetPerformanceCounter();
+    }
 }
 
 int MALI_TripleBufferingThread(void *data)
 {
     int first = 1;
     int prevSwapInterval = -1;
-    unsigned int page;
+    int i, page, refresh_rate, repeats, buffer_age, num_layers;
+    SDL_bool partial, redraw, drawable, overlays, swapped;
+    SDL_Rect damage;
+    Uint64 now, last_swap = 0;
+    SDL_GLFrameTiming timing;
+    SDL_DMABUFFrame external;
+    SDL_bool external_pending;
+    MALI_Telemetry telemetry;
+    MALI_HUD hud;
+    EGLSyncKHR blit_fence;
+    const MALI_Scaler *scaler;
+    MALI_ViewportPolicy policy;
     MALI_EGL_Surface *current_surface;
-    SDL_WindowData *windowdata;
+    SDL_WindowData *windowdata, *base;
     SDL_DisplayData *displaydata;
+    SDL_VideoDisplay *display;
     SDL_VideoDevice* _this;
     MALI_Blitter blitter;
-    
-    _this = (SDL_VideoDevice*)data;
-    windowdata = (SDL_WindowData *)_this->windows->driverdata;
-    displaydata = (SDL_DisplayData*)SDL_GetDisplayDriverData(0);
+
+    /* Windows drawn over the base one this time around, the page is -1 when it has no new frame */
+    struct {
+        SDL_WindowData *windowdata;
+        int page;
+        SDL_GLFrameTiming timing;
+    } layers[MALI_MAX_WINDOWS];
+
+    _this = SDL_GetVideoDevice();
+    display = (SDL_VideoDisplay *)data;
+    displaydata = (SDL_DisplayData *)display->driverdata;
+    base = MALI_GetBaseWindow(displaydata);
+
+    refresh_rate = display->current_mode.refresh_rate;
+    MALI_Telemetry_Init(&telemetry);
 
     /* Setup blitter props */
     blitter = (MALI_Blitter){
         .viewport_width = displaydata->vinfo.xres,
         .viewport_height = displaydata->vinfo.yres,
-        .plane_width = windowdata->surface[0].pixmap.width,
-        .plane_height = windowdata->surface[0].pixmap.height,
-        .plane_pitch = windowdata->surface[0].pixmap.planes[0].stride,
-        .planes = {
-            { .fd = windowdata->surface[0].pixmap.handles[0] },
-            { .fd = windowdata->surface[1].pixmap.handles[0] },
-            { .fd = windowdata->surface[2].pixmap.handles[0] },
-        }
     };
 
-    /* Initialize blitter */
-    if (!MALI_InitBlitter(_this, &blitter, (NativeWindowType)&displaydata->native_display, 
-        displaydata->rotation))
-    {
-        SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Failed to create blitter thread context");
-        SDL_Quit();
+    /* Initialize blitter, direct scanout has the display read the pages itself */
+    buffer_age = 0;
+    if (!base->direct_scanout) {
+        SDL_AtomicSet(&displaydata->scaler_changed, 0);
+        SDL_AtomicSet(&displaydata->viewport_changed, 0);
+        MALI_GetViewportPolicy(displaydata, &policy);
+        if (!MALI_InitBlitter(_this, &blitter, (NativeWindowType)&displaydata->native_display, 
+            displaydata->rotation, SDL_AtomicGetPtr(&displaydata->scaler), &policy))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Failed to create blitter thread context");
+            SDL_Quit();
+        }
+
+        buffer_age = MALI_Blitter_GetBufferAge(_this, &blitter);
+    }
+
+    /* MALI_CreateWindow allocates the pages meanwhile, they're imported once they're all there */
+    if (MALI_TripleBufferWaitForPages(displaydata)) {
+        MALI_Blitter_UsePages(&blitter, base);
+        if (blitter.surface && !MALI_Blitter_AttachPlanes(_this, &blitter)) {
+            /* The application may already be drawing, its frames are taken and not shown */
+            SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "%s", SDL_GetError());
+            base->import_failed = SDL_TRUE;
+        }
+    }
+
+    /* The performance overlay needs the blitter, and the blit time it shows needs a fence */
+    SDL_zero(hud);
+    if (blitter.surface) {
+        MALI_HUD_Init(&hud, displaydata->rotation, blitter.viewport_width, blitter.viewport_height, refresh_rate);
+        telemetry.measure_gpu |= hud.enabled;
     }
 
     /* Signal triplebuf available */
-    SDL_LockMutex(windowdata->triplebuf_mutex);
-    SDL_CondSignal(windowdata->triplebuf_cond);
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    if (base->import_failed)
+        base = NULL;
+    else
+        base->dmabuf_supported = !base->direct_scanout && blitter.has_external;
+    displaydata->startup.blitter_ready = SDL_GetPerformanceCounter();
+    displaydata->triplebuf_thread_ready = 1;
+    SDL_CondBroadcast(displaydata->triplebuf_cond);
 
     for (;;) {
-        SDL_CondWait(windowdata->triplebuf_cond, windowdata->triplebuf_mutex);
-        if (first) {
+        MALI_WaitForWork(displaydata);
+
+        if (first && blitter.surface) {
             /* 
              * Reset vinfo, otherwise applications can get stuck. This is done
              * a bit late to avoid applications getting rid of the splash screen.
@@ -412,86 +1300,234 @@ int MALI_TripleBufferingThread(void *data)
             first = 0;
         }
         
-        if (windowdata->triplebuf_thread_stop)
+        if (displaydata->triplebuf_thread_stop)
             break;
 
-        if (prevSwapInterval != windowdata->swapInterval) {
-            _this->egl_data->eglSwapInterval(_this->egl_data->egl_display, windowdata->swapInterval);
+        /* Direct scanout means a single window, which can't be resized under us */
+        if (blitter.surface)
+            MALI_UpdateLayers(_this, &blitter, displaydata, &base);
+        redraw = displaydata->redraw;
+        displaydata->redraw = SDL_FALSE;
+
+        /*
+         * Frames of windows we can't draw are taken all the same, they would keep us
+         * awake otherwise. The bottom one can't be drawn while it's being replaced.
+         */
+        windowdata = MALI_GetBaseWindow(displaydata);
+        if (windowdata && windowdata->reconfigure != MALI_RECONFIGURE_NONE)
+            windowdata = NULL;
+        drawable = windowdata && (windowdata->direct_scanout || windowdata == base);
+
+        if (drawable && prevSwapInterval != windowdata->swapInterval) {
+            if (!windowdata->direct_scanout)
+                _this->egl_data->eglSwapInterval(_this->egl_data->egl_display, windowdata->swapInterval);
             prevSwapInterval = windowdata->swapInterval;
         }
 
-        /* Flip the most recent back buffer with the front buffer */
-        page = windowdata->current_page;
-        windowdata->current_page = windowdata->new_page;
-        windowdata->new_page = page;
-
-        /* select surface to wait and blit */
-        current_surface = &windowdata->surface[windowdata->current_page];
+        /* Frames from SDL_PresentDMABUF bypass the swap chain, the GPU reads the decoder's buffer itself */
+        page = -1;
+        partial = SDL_FALSE;
+        external_pending = SDL_FALSE;
+        if (windowdata && windowdata->dmabuf_pending) {
+            external = windowdata->dmabuf_frame;
+            windowdata->dmabuf_pending = SDL_FALSE;
+            external_pending = SDL_TRUE;
+        } else if (windowdata && MALI_SwapChain_HasQueued(&windowdata->swapchain)) {
+            /* Take the next page to show, this releases the one we were showing back to the app */
+            page = MALI_SwapChain_AcquirePresent(&windowdata->swapchain);
+            partial = MALI_CollectDamage(windowdata, &blitter, buffer_age, windowdata->surface[page].frame, &damage);
+        }
 
-        /* wait for fence and flip display */
-        if (_this->egl_data->eglClientWaitSyncKHR(
-            _this->egl_data->egl_display,
-            current_surface->fence, 
-            EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, 
-            EGL_FOREVER_NV))
-        {
-            blitter.glClearColor(0.0, 0.0, 0.0, 1.0);
-            blitter.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            MALI_Blitter_Blit(_this, &blitter, windowdata->current_page);
-            _this->egl_data->eglSwapBuffers(_this->egl_data->egl_display, blitter.surface);
+        /* Same for the windows on top, paused ones are left out */
+        num_layers = 0;
+        overlays = SDL_FALSE;
+        for (i = 1; i < displaydata->num_windows; i++) {
+            layers[num_layers].windowdata = (SDL_WindowData *)displaydata->windows[i]->driverdata;
+            layers[num_layers].page = -1;
+            if (layers[num_layers].windowdata->reconfigure != MALI_RECONFIGURE_NONE)
+                continue;
+            if (MALI_SwapChain_HasQueued(&layers[num_layers].windowdata->swapchain))
+                layers[num_layers].page = MALI_SwapChain_AcquirePresent(&layers[num_layers].windowdata->swapchain);
+            overlays |= layers[num_layers].windowdata->overlay;
+            num_layers++;
+        }
+        SDL_CondBroadcast(displaydata->triplebuf_cond);
+        SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+        /* wait for fences and flip display */
+        current_surface = NULL;
+        swapped = SDL_FALSE;
+        if (page >= 0) {
+            current_surface = &windowdata->surface[page];
+            MALI_WaitForPage(_this, current_surface, &timing);
+        }
+        for (i = 0; i < num_layers; i++) {
+            if (layers[i].page >= 0)
+                MALI_WaitForPage(_this, &layers[i].windowdata->surface[layers[i].page], &layers[i].timing);
         }
-    }
 
-    /* Execution is done, teardown the allocated resources */ 
-    _this->egl_data->eglMakeCurrent(_this->egl_data->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-    for (int i = 0; i < 3; i++) {
-        blitter.glDeleteTextures(1, &blitter.planes[i].texture);
-        _this->egl_data->eglDestroyImageKHR(_this->egl_data->egl_display, blitter.planes[i].image);
-    }
-    _this->egl_data->eglDestroySurface(_this->egl_data->egl_display, blitter.surface);
-    _this->egl_data->eglDestroyContext(_this->egl_data->egl_display, blitter.context);
-    _this->egl_data->eglReleaseThread();
+        if (!drawable) {
+            /* The bottom window is being resized or replaced, there's nothing to put underneath */
+            if (external_pending)
+                MALI_DMABUF_Release(&external);
+        } else if (windowdata->direct_scanout) {
+            /* The page goes on screen as is, once the pan lands the page it replaced is free again */
+            if (page >= 0) {
+                if (MALI_Scanout_Present(&windowdata->scanout, page, prevSwapInterval > 0) < 0)
+                    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: FBIOPAN_DISPLAY failed.");
+                timing.blit_done = SDL_GetPerformanceCounter();
+                swapped = SDL_TRUE;
+            }
+        } else if (page < 0 || timing.fence_signaled) {
+            /* Switching scalers in between frames, the whole frame gets redrawn with the new one */
+            if (SDL_AtomicSet(&displaydata->scaler_changed, 0)) {
+                scaler = SDL_AtomicGetPtr(&displaydata->scaler);
+                if (scaler != blitter.scaler && MALI_Blitter_SetScaler(_this, &blitter, scaler) == 0)
+                    partial = SDL_FALSE;
+            }
+            if (SDL_AtomicSet(&displaydata->viewport_changed, 0)) {
+                MALI_GetViewportPolicy(displaydata, &policy);
+                MALI_Blitter_UpdateViewport(&blitter, &policy);
+                partial = SDL_FALSE;
+            }
 
-    /* Signal thread done */
-    SDL_UnlockMutex(windowdata->triplebuf_mutex);
-    return 0;
-}
+            /* Overlays can be anywhere, every frame with them in it is drawn in full */
+            if (overlays || redraw || hud.enabled) {
+                partial = SDL_FALSE;
+                blitter.clear_frames = MALI_BLITTER_MAX_AGE;
+                blitter.shown_count = 0;
+            }
 
-void MALI_TripleBufferInit(SDL_WindowData *windowdata)
-{
-    windowdata->triplebuf_mutex = SDL_CreateMutex();
-    windowdata->triplebuf_cond = SDL_CreateCond();
-    windowdata->triplebuf_thread = NULL;
-}
+            if (external_pending) {
+                MALI_Blitter_ShowExternal(_this, &blitter, &external, buffer_age);
+            } else if (page >= 0) {
+                MALI_Blitter_Blit(_this, &blitter, page, partial ? &damage : NULL, buffer_age);
+            } else if (blitter.showing_external) {
+                MALI_Blitter_ShowExternal(_this, &blitter, &blitter.external, buffer_age);
+            } else if (windowdata->shown) {
+                MALI_Blitter_Blit(_this, &blitter, windowdata->swapchain.presenting, NULL, buffer_age);
+            }
 
-void MALI_TripleBufferStop(_THIS)
-{
-    SDL_WindowData *windowdata = (SDL_WindowData*)_this->windows->driverdata;
-    if (!windowdata || windowdata->triplebuf_thread == NULL)
-        return;
+            for (i = 0; i < num_layers; i++) {
+                if (!layers[i].windowdata->overlay || layers[i].windowdata->hidden)
+                    continue;
+                if (layers[i].page >= 0)
+                    MALI_Blitter_BlitOverlay(_this, &blitter, layers[i].windowdata, layers[i].page);
+                else if (layers[i].windowdata->shown)
+                    MALI_Blitter_BlitOverlay(_this, &blitter, layers[i].windowdata,
+                                             layers[i].windowdata->swapchain.presenting);
+            }
+            if (hud.enabled)
+                MALI_Blitter_DrawHUD(_this, &blitter, &hud);
+            timing.blit_done = SDL_GetPerformanceCounter();
+
+            /* Telemetry only, waiting here keeps the blit from overlapping the next frame */
+            if (telemetry.measure_gpu && page >= 0) {
+                blit_fence = _this->egl_data->eglCreateSyncKHR(_this->egl_data->egl_display, EGL_SYNC_FENCE_KHR, NULL);
+                if (blit_fence != EGL_NO_SYNC_KHR) {
+                    _this->egl_data->eglClientWaitSyncKHR(_this->egl_data->egl_display, blit_fence,
+                        EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_NV);
+                    timing.blit_gpu_done = SDL_GetPerformanceCounter();
+                    _this->egl_data->eglDestroySyncKHR(_this->egl_data->egl_display, blit_fence);
+                }
+            }
 
-    SDL_LockMutex(windowdata->triplebuf_mutex);
-    windowdata->triplebuf_thread_stop = 1;
-    SDL_CondSignal(windowdata->triplebuf_cond);
-    SDL_UnlockMutex(windowdata->triplebuf_mutex);
+            _this->egl_data->eglSwapBuffers(_this->egl_data->egl_display, blitter.surface);
+            swapped = SDL_TRUE;
+            if (page >= 0)
+                MALI_Blitter_RetireExternal(_this, &blitter);
+
+            /* Only a frame of the swap chain alone can be patched up with the damage of the next ones */
+            if (page >= 0 && !overlays && !hud.enabled) {
+                SDL_memmove(&blitter.shown[1], &blitter.shown[0], sizeof(blitter.shown) - sizeof(blitter.shown[0]));
+                blitter.shown[0] = timing.frame;
+                blitter.shown_count = SDL_min(blitter.shown_count + 1, MALI_BLITTER_MAX_AGE);
+            } else {
+                blitter.shown_count = 0;
+            }
+            buffer_age = MALI_Blitter_GetBufferAge(_this, &blitter);
+        }
 
-    SDL_WaitThread(windowdata->triplebuf_thread, NULL);
-    windowdata->triplebuf_thread = NULL;
-}
+        /* The fences have served their purpose, the pages can't be rendered into again until we let go of them */
+        now = SDL_GetPerformanceCounter();
+        if (current_surface)
+            MALI_GLES_DestroyFence(_this, current_surface);
+        for (i = 0; i < num_layers; i++) {
+            if (layers[i].page < 0)
+                continue;
+            MALI_GLES_DestroyFence(_this, &layers[i].windowdata->surface[layers[i].page]);
+            layers[i].timing.blit_done = timing.blit_done;
+            layers[i].timing.swap_returned = now;
+        }
 
-void MALI_TripleBufferQuit(_THIS)
-{
-    SDL_WindowData *windowdata;
-    if (!_this->windows)
-        return;
+        /* With vsync on, every refresh past the first one kept the previous frame on screen */
+        repeats = 0;
+        if (current_surface) {
+            if (prevSwapInterval > 0 && last_swap != 0)
+                repeats = MALI_Vsync_CountRefreshes(&displaydata->vsync, last_swap, now) - 1;
+            last_swap = now;
+            timing.swap_returned = now;
+            timing.missed_vsyncs = SDL_max(repeats, 0);
+            MALI_Telemetry_Record(&telemetry, &timing);
+            MALI_HUD_Record(&hud, &timing);
+        }
 
-    windowdata = (SDL_WindowData*)_this->windows->driverdata;
-    if (!windowdata || windowdata->triplebuf_thread == NULL)
-        return;
+        SDL_LockMutex(displaydata->triplebuf_mutex);
+        /* A swap with vsync on returns right after a refresh, that keeps the clock in step */
+        if (swapped && prevSwapInterval > 0)
+            MALI_Vsync_Record(&displaydata->vsync, now);
+        if (swapped && current_surface && displaydata->startup.first_present == 0) {
+            displaydata->startup.first_present = now;
+            MALI_Telemetry_LogStartup(&displaydata->startup);
+        }
+        if (current_surface) {
+            if (windowdata->direct_scanout) {
+                MALI_SwapChain_ReleasePrevious(&windowdata->swapchain);
+                SDL_CondBroadcast(displaydata->triplebuf_cond);
+            }
+            MALI_SwapChain_AddRepeats(&windowdata->swapchain, repeats);
+            MALI_PushFrameTiming(windowdata, &timing);
+            windowdata->shown = SDL_TRUE;
+        }
+        for (i = 0; i < num_layers; i++) {
+            if (layers[i].page < 0)
+                continue;
+            MALI_PushFrameTiming(layers[i].windowdata, &layers[i].timing);
+            layers[i].windowdata->shown = SDL_TRUE;
+        }
+    }
+
+    if (base) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO,
+            "mali-fbdev: %s swap chain presented %" SDL_PRIu64 ", dropped %" SDL_PRIu64 ", repeated %" SDL_PRIu64 " frames",
+            base->swapchain.mode == MALI_PRESENT_FIFO ? "FIFO" : "Mailbox",
+            base->swapchain.frames_presented,
+            base->swapchain.frames_dropped,
+            base->swapchain.frames_repeated);
+    }
+
+    /* Release callbacks may call back into SDL, none of them run with the mutex held */
+    external_pending = SDL_FALSE;
+    windowdata = MALI_GetBaseWindow(displaydata);
+    if (windowdata) {
+        external = windowdata->dmabuf_frame;
+        external_pending = windowdata->dmabuf_pending;
+        windowdata->dmabuf_pending = SDL_FALSE;
+    }
+    for (i = 0; i < displaydata->num_windows; i++) {
+        MALI_Blitter_ReleaseOverlay(_this, &blitter, (SDL_WindowData *)displaydata->windows[i]->driverdata);
+    }
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+    /* Execution is done, teardown the allocated resources */ 
+    if (blitter.surface)
+        MALI_DeinitBlitter(_this, &blitter);
+    MALI_HUD_Quit(&hud);
+    _this->egl_data->eglReleaseThread();
 
-    MALI_TripleBufferStop(_this);
-    SDL_DestroyMutex(windowdata->triplebuf_mutex);
-    SDL_DestroyCond(windowdata->triplebuf_cond);
+    if (external_pending)
+        MALI_DMABUF_Release(&external);
+    return 0;
 }
 
-#endif /* SDL_VIDEO_DRIVER_MALI */
\ No newline at end of file
+#endif /* SDL_VIDEO_DRIVER_MALI */
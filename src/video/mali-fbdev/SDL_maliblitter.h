@@ -11,31 +11,91 @@
 #include "SDL_egl.h"
 #include "SDL_opengl.h"
 
+#include "SDL_maliswapchain.h"
+#include "SDL_maliscaler.h"
+#include "SDL_malidmabuf.h"
+#include "SDL_malihud.h"
+#include "SDL_maliviewport.h"
+#include "SDL_malitriplebuf.h"
+
+/* Deepest EGL_EXT_buffer_age we can resolve to a previously shown frame */
+#define MALI_BLITTER_MAX_AGE 4
+
 typedef struct MALI_Blitter {
     /* OpenGL Surface and Context */
     EGLSurface *surface;
     SDL_GLContext *context;
-    GLuint frag, vert, prog, vbo, vao;
-    GLint loc_aVertCoord, loc_aTexCoord, loc_uFBOtex, loc_uProj, loc_uTexSize, loc_uScale;
+    GLuint prog, vbo, vao;
     GLsizei viewport_width, viewport_height;
     GLint plane_width, plane_height, plane_pitch;
+    Uint32 plane_fourcc;
+    int rotation;
+
+    /* Scaler programs are linked on first use and kept around for switching back */
+    const MALI_Scaler *scaler;
+    GLuint programs[MALI_SCALER_MAX];
+    GLfloat projection[4][4];
+    GLfloat scale[2];
+    int clear_frames;
+
+    /* GL_OES_get_program_binary, NULL when unsupported or the cache is off */
+    char *cache_dir;
+    void (APIENTRY *glGetProgramBinaryOES)(GLuint, GLsizei, GLsizei *, GLenum *, void *);
+    void (APIENTRY *glProgramBinaryOES)(GLuint, GLenum, const void *, GLint);
+
+    /* Screen quad, x/y in viewport pixels and u/v in texels before rotation */
+    MALI_ViewportPolicy viewport;
+    GLfloat vertices[4][4];
+    SDL_bool covers_viewport;
+
+    /* Partial updates, frames shown by the most recent swaps, newest first */
+    SDL_bool has_buffer_age;
+    PFNEGLSETDAMAGEREGIONKHRPROC eglSetDamageRegionKHR;
+    Uint32 shown[MALI_BLITTER_MAX_AGE];
+    int shown_count;
+
+    /* Frames from SDL_PresentDMABUF, sampled through GL_OES_EGL_image_external */
+    SDL_bool has_external;
+    GLuint external_prog;
+    MALI_DMABUFCache dmabuf_cache;
+    SDL_bool showing_external;
+    SDL_DMABUFFrame external;
+    EGLSyncKHR external_fence;
+
+    /* Secondary windows, drawn over the scaled one 1:1 at their place on the display */
+    GLuint overlay_prog, overlay_vbo, overlay_vao;
+
+    /* SDL_HINT_MALI_HUD, flat colored triangles set up on first use */
+    GLuint hud_prog, hud_vbo, hud_vao;
 
+    int num_planes;
     struct {
         int fd;
         GLuint texture;
         EGLImageKHR image;
-    } planes[3];
+    } planes[MALI_SWAPCHAIN_MAX_DEPTH];
 
     #define SDL_PROC(ret,func,params) ret (APIENTRY *func) params;
     #include "SDL_maliblitter_funcs.h"
     #undef SDL_PROC
 } MALI_Blitter;
 
-int MALI_InitBlitter(_THIS, MALI_Blitter *blitter, NativeWindowType nw, int rotation);
-void MALI_Blitter_Blit(_THIS, MALI_Blitter *blitter, int texture);
-void MALI_TripleBufferInit(SDL_WindowData *windowdata);
-void MALI_TripleBufferStop(_THIS);
-void MALI_TripleBufferQuit(_THIS);
+int MALI_InitBlitter(_THIS, MALI_Blitter *blitter, NativeWindowType nw, int rotation, const MALI_Scaler *scaler,
+                     const MALI_ViewportPolicy *policy);
+void MALI_DeinitBlitter(_THIS, MALI_Blitter *blitter);
+int MALI_Blitter_SetScaler(_THIS, MALI_Blitter *blitter, const MALI_Scaler *scaler);
+int MALI_Blitter_AttachPlanes(_THIS, MALI_Blitter *blitter);
+void MALI_Blitter_ReleasePlanes(_THIS, MALI_Blitter *blitter);
+int MALI_Blitter_GetBufferAge(_THIS, MALI_Blitter *blitter);
+void MALI_Blitter_Blit(_THIS, MALI_Blitter *blitter, int texture, const SDL_Rect *damage, int age);
+int MALI_Blitter_BlitExternal(_THIS, MALI_Blitter *blitter, const SDL_DMABUFFrame *frame, int age);
+void MALI_Blitter_RetireExternal(_THIS, MALI_Blitter *blitter);
+void MALI_Blitter_GetOverlayQuad(int rotation, int viewport_width, int viewport_height, const SDL_Rect *rect,
+                                 GLfloat vert[4][4]);
+int MALI_Blitter_AttachOverlay(_THIS, MALI_Blitter *blitter, SDL_WindowData *windowdata);
+void MALI_Blitter_ReleaseOverlay(_THIS, MALI_Blitter *blitter, SDL_WindowData *windowdata);
+void MALI_Blitter_BlitOverlay(_THIS, MALI_Blitter *blitter, SDL_WindowData *windowdata, int page);
+void MALI_Blitter_DrawHUD(_THIS, MALI_Blitter *blitter, const MALI_HUD *hud);
 int MALI_TripleBufferingThread(void *data);
 
 #endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL */
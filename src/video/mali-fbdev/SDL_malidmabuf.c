@@ -0,0 +1,283 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SDL_error.h"
+#include "SDL_pixels.h"
+
+#include "SDL_malidmabuf.h"
+
+/* Frames taller than this are HD, same threshold the YUV surface conversion uses */
+#define MALI_DMABUF_SD_THRESHOLD 576
+
+typedef struct MALI_DMABUFFormat
+{
+    Uint32 sdl_format;
+    Uint32 fourcc;          // DRM fourcc the frame is imported as
+    int num_planes;
+    int bytes_per_pixel;    // of the first plane
+    int chroma_pairs;       // chroma planes carry interleaved U/V pairs
+    SDL_bool yuv;
+} MALI_DMABUFFormat;
+
+static const MALI_DMABUFFormat dmabuf_formats[] = {
+    { SDL_PIXELFORMAT_NV12, SDL_DEFINE_PIXELFOURCC('N', 'V', '1', '2'), 2, 1, 2, SDL_TRUE },
+    { SDL_PIXELFORMAT_NV21, SDL_DEFINE_PIXELFOURCC('N', 'V', '2', '1'), 2, 1, 2, SDL_TRUE },
+    { SDL_PIXELFORMAT_IYUV, SDL_DEFINE_PIXELFOURCC('Y', 'U', '1', '2'), 3, 1, 1, SDL_TRUE },
+    { SDL_PIXELFORMAT_YV12, SDL_DEFINE_PIXELFOURCC('Y', 'V', '1', '2'), 3, 1, 1, SDL_TRUE },
+    { SDL_PIXELFORMAT_YUY2, SDL_DEFINE_PIXELFOURCC('Y', 'U', 'Y', 'V'), 1, 2, 0, SDL_TRUE },
+    { SDL_PIXELFORMAT_UYVY, SDL_DEFINE_PIXELFOURCC('U', 'Y', 'V', 'Y'), 1, 2, 0, SDL_TRUE },
+    { SDL_PIXELFORMAT_ARGB8888, SDL_DEFINE_PIXELFOURCC('A', 'R', '2', '4'), 1, 4, 0, SDL_FALSE },
+    { SDL_PIXELFORMAT_XRGB8888, SDL_DEFINE_PIXELFOURCC('X', 'R', '2', '4'), 1, 4, 0, SDL_FALSE },
+    { SDL_PIXELFORMAT_ABGR8888, SDL_DEFINE_PIXELFOURCC('A', 'B', '2', '4'), 1, 4, 0, SDL_FALSE },
+    { SDL_PIXELFORMAT_XBGR8888, SDL_DEFINE_PIXELFOURCC('X', 'B', '2', '4'), 1, 4, 0, SDL_FALSE },
+    { SDL_PIXELFORMAT_RGB565, SDL_DEFINE_PIXELFOURCC('R', 'G', '1', '6'), 1, 2, 0, SDL_FALSE },
+};
+
+static const EGLint plane_attribs[3][3] = {
+    { EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT },
+    { EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT },
+    { EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT },
+};
+
+static const MALI_DMABUFFormat *
+MALI_DMABUF_FindFormat(Uint32 sdl_format)
+{
+    int i;
+
+    for (i = 0; i < SDL_arraysize(dmabuf_formats); i++) {
+        if (dmabuf_formats[i].sdl_format == sdl_format)
+            return &dmabuf_formats[i];
+    }
+
+    return NULL;
+}
+
+/* Checks the frame fits into its buffers, so a bad frame fails here instead of on the GPU */
+int
+MALI_DMABUF_Validate(const SDL_DMABUFFrame *frame)
+{
+    const MALI_DMABUFFormat *format;
+    const SDL_DMABUFPlane *plane;
+    struct stat st;
+    Uint64 rows, min_pitch;
+    off_t size;
+    int i;
+
+    format = MALI_DMABUF_FindFormat(frame->format);
+    if (!format)
+        return SDL_SetError("mali-fbdev: %s frames can't be imported", SDL_GetPixelFormatName(frame->format));
+
+    if (frame->num_planes != format->num_planes)
+        return SDL_SetError("mali-fbdev: %s frames have %d planes, not %d",
+                            SDL_GetPixelFormatName(frame->format), format->num_planes, frame->num_planes);
+
+    for (i = 0; i < frame->num_planes; i++) {
+        plane = &frame->planes[i];
+        if (plane->fd < 0 || fstat(plane->fd, &st) < 0)
+            return SDL_SetError("mali-fbdev: Plane %d has no valid DMA-BUF descriptor", i);
+
+        /* Chroma planes are subsampled both ways */
+        if (i == 0) {
+            rows = frame->h;
+            min_pitch = (Uint64)frame->w * format->bytes_per_pixel;
+            if (format->yuv && format->bytes_per_pixel == 2)
+                min_pitch = (Uint64)((frame->w + 1) & ~1) * 2;
+        } else {
+            rows = (frame->h + 1) / 2;
+            min_pitch = (Uint64)((frame->w + 1) / 2) * format->chroma_pairs;
+        }
+
+        if (plane->pitch < min_pitch)
+            return SDL_SetError("mali-fbdev: Plane %d pitch %u is too small for a width of %d", i, plane->pitch, frame->w);
+
+        /* Not every exporter can tell its size, those we have to trust */
+        size = lseek(plane->fd, 0, SEEK_END);
+        if (size < 0)
+            continue;
+        lseek(plane->fd, 0, SEEK_SET);
+
+        if (plane->offset + (rows - 1) * plane->pitch + min_pitch > (Uint64)size)
+            return SDL_SetError("mali-fbdev: Plane %d runs past the end of its %ld byte buffer", i, (long)size);
+    }
+
+    return 0;
+}
+
+/* EGL_EXT_image_dma_buf_import attributes, returns how many were written before EGL_NONE */
+int
+MALI_DMABUF_GetAttributes(const SDL_DMABUFFrame *frame, EGLint *attribs, int maxattribs)
+{
+    const MALI_DMABUFFormat *format = MALI_DMABUF_FindFormat(frame->format);
+    SDL_YUV_CONVERSION_MODE mode = frame->conversion_mode;
+    int i, n = 0;
+
+    if (!format || maxattribs < 7 + frame->num_planes * 6 + 8)
+        return SDL_SetError("mali-fbdev: Can't describe %s frame", SDL_GetPixelFormatName(frame->format));
+
+    attribs[n++] = EGL_WIDTH;
+    attribs[n++] = frame->w;
+    attribs[n++] = EGL_HEIGHT;
+    attribs[n++] = frame->h;
+    attribs[n++] = EGL_LINUX_DRM_FOURCC_EXT;
+    attribs[n++] = format->fourcc;
+
+    for (i = 0; i < frame->num_planes; i++) {
+        attribs[n++] = plane_attribs[i][0];
+        attribs[n++] = frame->planes[i].fd;
+        attribs[n++] = plane_attribs[i][1];
+        attribs[n++] = frame->planes[i].offset;
+        attribs[n++] = plane_attribs[i][2];
+        attribs[n++] = frame->planes[i].pitch;
+    }
+
+    /* The GPU converts to RGB while sampling, it needs to know how */
+    if (format->yuv) {
+        if (mode == SDL_YUV_CONVERSION_AUTOMATIC)
+            mode = (frame->h > MALI_DMABUF_SD_THRESHOLD) ? SDL_YUV_CONVERSION_BT709 : SDL_YUV_CONVERSION_BT601;
+
+        attribs[n++] = EGL_YUV_COLOR_SPACE_HINT_EXT;
+        attribs[n++] = (mode == SDL_YUV_CONVERSION_BT709) ? EGL_ITU_REC709_EXT : EGL_ITU_REC601_EXT;
+        attribs[n++] = EGL_SAMPLE_RANGE_HINT_EXT;
+        attribs[n++] = (mode == SDL_YUV_CONVERSION_JPEG) ? EGL_YUV_FULL_RANGE_EXT : EGL_YUV_NARROW_RANGE_EXT;
+
+        /* MPEG-2 and later codecs put chroma left aligned between two rows */
+        attribs[n++] = EGL_YUV_CHROMA_HORIZONTAL_SITING_HINT_EXT;
+        attribs[n++] = EGL_YUV_CHROMA_SITING_0_EXT;
+        attribs[n++] = EGL_YUV_CHROMA_VERTICAL_SITING_HINT_EXT;
+        attribs[n++] = EGL_YUV_CHROMA_SITING_0_5_EXT;
+    }
+
+    attribs[n] = EGL_NONE;
+    return n;
+}
+
+void
+MALI_DMABUF_Release(const SDL_DMABUFFrame *frame)
+{
+    if (frame->release)
+        frame->release(frame->userdata, frame);
+}
+
+static int
+MALI_DMABUF_GetKey(const SDL_DMABUFFrame *frame, MALI_DMABUFKey *key)
+{
+    struct stat st;
+    int i;
+
+    SDL_zerop(key);
+    key->format = frame->format;
+    key->w = frame->w;
+    key->h = frame->h;
+    key->num_planes = frame->num_planes;
+
+    for (i = 0; i < frame->num_planes; i++) {
+        if (fstat(frame->planes[i].fd, &st) < 0)
+            return SDL_SetError("mali-fbdev: Plane %d has no valid DMA-BUF descriptor", i);
+        key->planes[i].dev = st.st_dev;
+        key->planes[i].ino = st.st_ino;
+        key->planes[i].offset = frame->planes[i].offset;
+        key->planes[i].pitch = frame->planes[i].pitch;
+    }
+
+    return 0;
+}
+
+static SDL_bool
+MALI_DMABUF_KeyEquals(const MALI_DMABUFKey *a, const MALI_DMABUFKey *b)
+{
+    int i;
+
+    if (a->format != b->format || a->w != b->w || a->h != b->h || a->num_planes != b->num_planes)
+        return SDL_FALSE;
+
+    for (i = 0; i < a->num_planes; i++) {
+        if (a->planes[i].dev != b->planes[i].dev || a->planes[i].ino != b->planes[i].ino ||
+            a->planes[i].offset != b->planes[i].offset || a->planes[i].pitch != b->planes[i].pitch)
+            return SDL_FALSE;
+    }
+
+    return SDL_TRUE;
+}
+
+void
+MALI_DMABUFCache_Init(MALI_DMABUFCache *cache, const MALI_DMABUFImportOps *ops, void *data)
+{
+    SDL_zerop(cache);
+    cache->ops = ops;
+    cache->data = data;
+}
+
+static void
+MALI_DMABUFCache_Remove(MALI_DMABUFCache *cache, int index)
+{
+    cache->ops->release(cache->data, &cache->images[index]);
+    cache->images[index] = cache->images[--cache->count];
+}
+
+/* The image for a frame, imported on first sight, or NULL on error */
+MALI_DMABUFImage *
+MALI_DMABUFCache_Get(MALI_DMABUFCache *cache, const SDL_DMABUFFrame *frame)
+{
+    EGLint attribs[MALI_DMABUF_MAX_ATTRIBS];
+    MALI_DMABUFImage *image;
+    MALI_DMABUFKey key;
+    int i, oldest;
+
+    if (MALI_DMABUF_GetKey(frame, &key) < 0)
+        return NULL;
+
+    for (i = 0; i < cache->count; i++) {
+        if (MALI_DMABUF_KeyEquals(&cache->images[i].key, &key)) {
+            cache->images[i].last_used = ++cache->clock;
+            cache->hits++;
+            return &cache->images[i];
+        }
+    }
+
+    /* A new stream gets new buffers, the ones of the previous stream won't come back */
+    for (i = 0; i < cache->count; ) {
+        if (cache->images[i].key.format != key.format || cache->images[i].key.w != key.w ||
+            cache->images[i].key.h != key.h) {
+            MALI_DMABUFCache_Remove(cache, i);
+        } else {
+            i++;
+        }
+    }
+
+    if (cache->count == MALI_DMABUF_CACHE_SIZE) {
+        oldest = 0;
+        for (i = 1; i < cache->count; i++) {
+            if (cache->images[i].last_used < cache->images[oldest].last_used)
+                oldest = i;
+        }
+        MALI_DMABUFCache_Remove(cache, oldest);
+    }
+
+    if (MALI_DMABUF_GetAttributes(frame, attribs, SDL_arraysize(attribs)) < 0)
+        return NULL;
+
+    image = &cache->images[cache->count];
+    SDL_zerop(image);
+    if (cache->ops->import(cache->data, attribs, image) < 0)
+        return NULL;
+
+    image->key = key;
+    image->last_used = ++cache->clock;
+    cache->count++;
+    cache->imports++;
+    return image;
+}
+
+void
+MALI_DMABUFCache_Quit(MALI_DMABUFCache *cache)
+{
+    while (cache->count > 0) {
+        MALI_DMABUFCache_Remove(cache, cache->count - 1);
+    }
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL */
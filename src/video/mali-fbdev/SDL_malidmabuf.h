@@ -0,0 +1,77 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malidmabuf_h
+#define _SDL_malidmabuf_h
+
+#if SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL
+
+#include <sys/types.h>
+
+#include "SDL_video.h"
+#include "SDL_egl.h"
+#include "SDL_opengl.h"
+
+/* Decoders cycle through a fixed set of buffers, enough to cover their whole pool */
+#define MALI_DMABUF_CACHE_SIZE  16
+#define MALI_DMABUF_MAX_ATTRIBS 48
+
+/*
+ * What an imported frame is recognized by. Descriptors get closed and reopened,
+ * but the inode stays with the buffer, and the EGLImage holding on to the buffer
+ * keeps the inode number from being handed out again.
+ */
+typedef struct MALI_DMABUFKey
+{
+    Uint32 format;
+    int w, h;
+    int num_planes;
+    struct {
+        dev_t dev;
+        ino_t ino;
+        Uint32 offset, pitch;
+    } planes[3];
+} MALI_DMABUFKey;
+
+typedef struct MALI_DMABUFImage
+{
+    MALI_DMABUFKey key;
+    EGLImageKHR image;
+    GLuint texture;
+    Uint32 last_used;
+} MALI_DMABUFImage;
+
+/*
+ * Turns EGL_LINUX_DMA_BUF_EXT attributes into an external texture, done by the
+ * blitter on device while tests plug in their own to check the attributes.
+ */
+typedef struct MALI_DMABUFImportOps
+{
+    int (*import)(void *data, const EGLint *attribs, MALI_DMABUFImage *image);
+    void (*release)(void *data, MALI_DMABUFImage *image);
+} MALI_DMABUFImportOps;
+
+/* Buffers imported so far, importing every frame anew would cost more than showing it */
+typedef struct MALI_DMABUFCache
+{
+    const MALI_DMABUFImportOps *ops;
+    void *data;
+    Uint32 clock;
+    int count;
+    MALI_DMABUFImage images[MALI_DMABUF_CACHE_SIZE];
+
+    /* Statistics */
+    Uint32 imports;
+    Uint32 hits;
+} MALI_DMABUFCache;
+
+int MALI_DMABUF_Validate(const SDL_DMABUFFrame *frame);
+int MALI_DMABUF_GetAttributes(const SDL_DMABUFFrame *frame, EGLint *attribs, int maxattribs);
+void MALI_DMABUF_Release(const SDL_DMABUFFrame *frame);
+
+void MALI_DMABUFCache_Init(MALI_DMABUFCache *cache, const MALI_DMABUFImportOps *ops, void *data);
+MALI_DMABUFImage *MALI_DMABUFCache_Get(MALI_DMABUFCache *cache, const SDL_DMABUFFrame *frame);
+void MALI_DMABUFCache_Quit(MALI_DMABUFCache *cache);
+
+#endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL */
+
+#endif /* _SDL_malidmabuf_h */
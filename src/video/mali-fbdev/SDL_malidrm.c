@@ -0,0 +1,522 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <sys/ioctl.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "SDL_error.h"
+
+#include "SDL_malidrm.h"
+
+/* Boards have a handful of each, those past these limits are ignored */
+#define MALI_DRM_MAX_OBJECTS 32
+#define MALI_DRM_MAX_PROPERTIES 64
+
+#define MALI_DRM_PTR(p) ((__u64)(uintptr_t)(p))
+
+static int
+MALI_DRM_OpenDevice(const char *path)
+{
+    return open(path, O_RDWR | O_CLOEXEC);
+}
+
+static void
+MALI_DRM_CloseDevice(int fd)
+{
+    close(fd);
+}
+
+/* Like drmIoctl, interrupted calls are restarted */
+static int
+MALI_DRM_Ioctl(int fd, unsigned long request, void *arg)
+{
+    int ret;
+
+    do {
+        ret = ioctl(fd, request, arg);
+    } while (ret == -1 && (errno == EINTR || errno == EAGAIN));
+
+    return ret;
+}
+
+static int
+MALI_DRM_ReadEvents(int fd, void *buffer, int size, int timeout)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int ret;
+
+    do {
+        ret = poll(&pfd, 1, timeout);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret <= 0)
+        return ret;
+
+    return (int)read(fd, buffer, size);
+}
+
+const MALI_DRMOps MALI_DRM_DeviceOps = {
+    MALI_DRM_OpenDevice,
+    MALI_DRM_CloseDevice,
+    MALI_DRM_Ioctl,
+    MALI_DRM_ReadEvents
+};
+
+static const char *const mali_drm_plane_properties[MALI_DRM_PLANE_NUM_PROPERTIES] = {
+    "FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H", "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"
+};
+
+/* Property IDs and values of an object by name, 0 for the ones it doesn't have */
+static int
+MALI_DRM_GetProperties(MALI_DRM *drm, Uint32 obj_id, Uint32 obj_type, const char *const *names, Uint32 *ids,
+                       Uint64 *values, int count)
+{
+    __u32 props[MALI_DRM_MAX_PROPERTIES];
+    __u64 prop_values[MALI_DRM_MAX_PROPERTIES];
+    struct drm_mode_obj_get_properties obj = {
+        .props_ptr = MALI_DRM_PTR(props),
+        .prop_values_ptr = MALI_DRM_PTR(prop_values),
+        .count_props = MALI_DRM_MAX_PROPERTIES,
+        .obj_id = obj_id,
+        .obj_type = obj_type,
+    };
+    struct drm_mode_get_property prop;
+    int i, j;
+
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_OBJ_GETPROPERTIES, &obj) < 0)
+        return -1;
+
+    for (i = 0; i < count; i++) {
+        ids[i] = 0;
+        if (values)
+            values[i] = 0;
+    }
+
+    for (j = 0; j < (int)SDL_min(obj.count_props, MALI_DRM_MAX_PROPERTIES); j++) {
+        SDL_zero(prop);
+        prop.prop_id = props[j];
+        if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETPROPERTY, &prop) < 0)
+            continue;
+
+        for (i = 0; i < count; i++) {
+            if (SDL_strncmp(prop.name, names[i], DRM_PROP_NAME_LEN) != 0)
+                continue;
+            ids[i] = props[j];
+            if (values)
+                values[i] = prop_values[j];
+        }
+    }
+
+    return 0;
+}
+
+/* The CRTC and mode of a connector, the ones the console uses if it's lit up */
+static void
+MALI_DRM_PickCRTC(MALI_DRM *drm, const struct drm_mode_get_connector *conn, const __u32 *encoders,
+                  const struct drm_mode_modeinfo *modes, const __u32 *crtcs, int num_crtcs)
+{
+    struct drm_mode_get_encoder enc;
+    struct drm_mode_crtc crtc;
+    int i, j;
+
+    SDL_zero(enc);
+    enc.encoder_id = conn->encoder_id;
+    if (conn->encoder_id && drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETENCODER, &enc) == 0 && enc.crtc_id) {
+        SDL_zero(crtc);
+        crtc.crtc_id = enc.crtc_id;
+        if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETCRTC, &crtc) == 0 && crtc.mode_valid) {
+            drm->crtc_id = enc.crtc_id;
+            drm->mode = crtc.mode;
+            return;
+        }
+    }
+
+    /* Dark, any CRTC one of its encoders can be driven by at the preferred mode */
+    for (i = 0; i < (int)conn->count_encoders && !drm->crtc_id; i++) {
+        SDL_zero(enc);
+        enc.encoder_id = encoders[i];
+        if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETENCODER, &enc) < 0)
+            continue;
+        for (j = 0; j < num_crtcs; j++) {
+            if (enc.possible_crtcs & (1u << j)) {
+                drm->crtc_id = crtcs[j];
+                break;
+            }
+        }
+    }
+
+    drm->mode = modes[0];
+    for (i = 0; i < (int)conn->count_modes; i++) {
+        if (modes[i].type & DRM_MODE_TYPE_PREFERRED) {
+            drm->mode = modes[i];
+            break;
+        }
+    }
+}
+
+/* The first connected connector with a CRTC to drive it, returns the index of the CRTC */
+static int
+MALI_DRM_FindDisplay(MALI_DRM *drm)
+{
+    __u32 crtcs[MALI_DRM_MAX_OBJECTS], connectors[MALI_DRM_MAX_OBJECTS], encoders[MALI_DRM_MAX_OBJECTS];
+    struct drm_mode_card_res res = {
+        .crtc_id_ptr = MALI_DRM_PTR(crtcs),
+        .connector_id_ptr = MALI_DRM_PTR(connectors),
+        .count_crtcs = MALI_DRM_MAX_OBJECTS,
+        .count_connectors = MALI_DRM_MAX_OBJECTS,
+    };
+    struct drm_mode_get_connector conn;
+    struct drm_mode_modeinfo *modes;
+    int i, num_crtcs;
+
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0)
+        return SDL_SetError("mali-fbdev: Can't get the DRM resources");
+    num_crtcs = (int)SDL_min(res.count_crtcs, MALI_DRM_MAX_OBJECTS);
+
+    for (i = 0; i < (int)SDL_min(res.count_connectors, MALI_DRM_MAX_OBJECTS) && !drm->crtc_id; i++) {
+        /* The first call probes the display and counts the modes, the second one fetches them */
+        SDL_zero(conn);
+        conn.connector_id = connectors[i];
+        if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETCONNECTOR, &conn) < 0 ||
+            conn.connection != DRM_MODE_CONNECTED || conn.count_modes == 0)
+            continue;
+
+        modes = SDL_calloc(conn.count_modes, sizeof(*modes));
+        if (!modes)
+            return SDL_OutOfMemory();
+
+        conn.modes_ptr = MALI_DRM_PTR(modes);
+        conn.encoders_ptr = MALI_DRM_PTR(encoders);
+        conn.count_encoders = SDL_min(conn.count_encoders, MALI_DRM_MAX_OBJECTS);
+        conn.count_props = 0;
+        if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETCONNECTOR, &conn) == 0) {
+            MALI_DRM_PickCRTC(drm, &conn, encoders, modes, crtcs, num_crtcs);
+            if (drm->crtc_id)
+                drm->connector_id = conn.connector_id;
+        }
+        SDL_free(modes);
+    }
+
+    if (!drm->crtc_id)
+        return SDL_SetError("mali-fbdev: No connected display on the DRM device");
+
+    for (i = 0; i < num_crtcs; i++) {
+        if (crtcs[i] == drm->crtc_id)
+            return i;
+    }
+
+    return SDL_SetError("mali-fbdev: DRM CRTC %u isn't listed", drm->crtc_id);
+}
+
+/* The primary plane of the CRTC and the formats it takes */
+static int
+MALI_DRM_FindPlane(MALI_DRM *drm, int crtc_index)
+{
+    static const char *const type_name[] = { "type" };
+    __u32 planes[MALI_DRM_MAX_OBJECTS];
+    struct drm_mode_get_plane_res res = {
+        .plane_id_ptr = MALI_DRM_PTR(planes),
+        .count_planes = MALI_DRM_MAX_OBJECTS,
+    };
+    struct drm_mode_get_plane plane;
+    Uint32 type_id;
+    Uint64 type;
+    int i;
+
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &res) < 0)
+        return SDL_SetError("mali-fbdev: Can't get the DRM planes");
+
+    for (i = 0; i < (int)SDL_min(res.count_planes, MALI_DRM_MAX_OBJECTS); i++) {
+        SDL_zero(plane);
+        plane.plane_id = planes[i];
+        if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETPLANE, &plane) < 0 ||
+            !(plane.possible_crtcs & (1u << crtc_index)))
+            continue;
+
+        if (MALI_DRM_GetProperties(drm, planes[i], DRM_MODE_OBJECT_PLANE, type_name, &type_id, &type, 1) < 0 ||
+            type_id == 0 || type != DRM_PLANE_TYPE_PRIMARY)
+            continue;
+
+        /* The formats are only copied when they all fit */
+        drm->formats = SDL_calloc(SDL_max(plane.count_format_types, 1), sizeof(Uint32));
+        if (!drm->formats)
+            return SDL_OutOfMemory();
+        plane.format_type_ptr = MALI_DRM_PTR(drm->formats);
+        if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_GETPLANE, &plane) < 0) {
+            SDL_free(drm->formats);
+            drm->formats = NULL;
+            continue;
+        }
+
+        drm->num_formats = plane.count_format_types;
+        drm->plane_id = planes[i];
+        return 0;
+    }
+
+    return SDL_SetError("mali-fbdev: The DRM CRTC has no primary plane");
+}
+
+static int
+MALI_DRM_Setup(MALI_DRM *drm, const char *path)
+{
+    static const char *const crtc_names[] = { "ACTIVE", "MODE_ID" };
+    static const char *const connector_names[] = { "CRTC_ID" };
+    struct drm_set_client_cap cap;
+    struct drm_mode_create_blob blob;
+    Uint32 crtc_props[2];
+    int i, crtc_index;
+
+    /* Atomic commits need every plane to be visible, not only the primary and cursor ones */
+    cap.capability = DRM_CLIENT_CAP_UNIVERSAL_PLANES;
+    cap.value = 1;
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_SET_CLIENT_CAP, &cap) < 0)
+        return SDL_SetError("mali-fbdev: %s has no universal planes", path);
+
+    cap.capability = DRM_CLIENT_CAP_ATOMIC;
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_SET_CLIENT_CAP, &cap) < 0)
+        return SDL_SetError("mali-fbdev: %s has no atomic modesetting", path);
+
+    /* Somebody else driving the display would have every commit turned down */
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_SET_MASTER, NULL) < 0)
+        return SDL_SetError("mali-fbdev: %s is driven by another process", path);
+
+    crtc_index = MALI_DRM_FindDisplay(drm);
+    if (crtc_index < 0 || MALI_DRM_FindPlane(drm, crtc_index) < 0)
+        return -1;
+
+    if (MALI_DRM_GetProperties(drm, drm->plane_id, DRM_MODE_OBJECT_PLANE, mali_drm_plane_properties,
+                               drm->plane_props, NULL, MALI_DRM_PLANE_NUM_PROPERTIES) < 0 ||
+        MALI_DRM_GetProperties(drm, drm->crtc_id, DRM_MODE_OBJECT_CRTC, crtc_names, crtc_props, NULL, 2) < 0 ||
+        MALI_DRM_GetProperties(drm, drm->connector_id, DRM_MODE_OBJECT_CONNECTOR, connector_names,
+                               &drm->connector_crtc_id, NULL, 1) < 0)
+        return SDL_SetError("mali-fbdev: Can't get the DRM object properties");
+
+    drm->crtc_active = crtc_props[0];
+    drm->crtc_mode_id = crtc_props[1];
+    for (i = 0; i < MALI_DRM_PLANE_NUM_PROPERTIES; i++) {
+        if (!drm->plane_props[i])
+            return SDL_SetError("mali-fbdev: DRM plane has no %s property", mali_drm_plane_properties[i]);
+    }
+    if (!drm->crtc_active || !drm->crtc_mode_id || !drm->connector_crtc_id)
+        return SDL_SetError("mali-fbdev: DRM CRTC or connector lacks atomic properties");
+
+    /* The mode goes in as a blob, the first commit sets it */
+    SDL_zero(blob);
+    blob.data = MALI_DRM_PTR(&drm->mode);
+    blob.length = sizeof(drm->mode);
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_CREATEPROPBLOB, &blob) < 0)
+        return SDL_SetError("mali-fbdev: Can't create the DRM mode blob");
+    drm->mode_blob = blob.blob_id;
+    drm->modeset = SDL_TRUE;
+
+    return 0;
+}
+
+int
+MALI_DRM_Open(MALI_DRM *drm, const MALI_DRMOps *ops, const char *path)
+{
+    SDL_zerop(drm);
+    drm->ops = ops;
+    drm->fd = ops->open(path);
+    if (drm->fd < 0)
+        return SDL_SetError("mali-fbdev: Can't open %s", path);
+
+    if (MALI_DRM_Setup(drm, path) < 0) {
+        MALI_DRM_Close(drm);
+        return -1;
+    }
+
+    return 0;
+}
+
+SDL_bool
+MALI_DRM_HasFormat(const MALI_DRM *drm, Uint32 fourcc)
+{
+    int i;
+
+    for (i = 0; i < drm->num_formats; i++) {
+        if (drm->formats[i] == fourcc)
+            return SDL_TRUE;
+    }
+
+    return SDL_FALSE;
+}
+
+/* Like KMSDRM_FBFromBO, only the page is a DMA_BUF we import instead of a GBM buffer */
+int
+MALI_DRM_AddPage(MALI_DRM *drm, int page, int dmabuf_fd, int width, int height, int pitch, Uint32 offset,
+                 Uint32 fourcc)
+{
+    struct drm_prime_handle prime = { .fd = dmabuf_fd };
+    struct drm_mode_fb_cmd2 fb;
+
+    if (page < 0 || page >= MALI_SWAPCHAIN_MAX_DEPTH)
+        return SDL_SetError("mali-fbdev: No DRM framebuffer for page %d", page);
+
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime) < 0)
+        return SDL_SetError("mali-fbdev: Can't import page %d into DRM", page);
+    drm->handles[page] = prime.handle;
+
+    SDL_zero(fb);
+    fb.width = width;
+    fb.height = height;
+    fb.pixel_format = fourcc;
+    fb.handles[0] = prime.handle;
+    fb.pitches[0] = pitch;
+    fb.offsets[0] = offset;
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_ADDFB2, &fb) < 0)
+        return SDL_SetError("mali-fbdev: Can't add page %d as a DRM framebuffer", page);
+
+    drm->fb_ids[page] = fb.fb_id;
+    drm->width = width;
+    drm->height = height;
+    return 0;
+}
+
+/*
+ * Puts the page on the primary plane with an atomic commit, the first one also
+ * sets the mode. Like KMSDRM_WaitPageflip a flip still in flight is waited for
+ * first, and with vsync this one as well, until then the old page is scanned out.
+ */
+int
+MALI_DRM_Present(MALI_DRM *drm, int page, SDL_bool vsync)
+{
+    Uint32 objs[3], counts[3], props[MALI_DRM_PLANE_NUM_PROPERTIES + 3];
+    Uint64 values[MALI_DRM_PLANE_NUM_PROPERTIES + 3];
+    struct drm_mode_atomic atomic;
+    int i, num_objs = 0, num_props = 0;
+    Uint64 plane_values[MALI_DRM_PLANE_NUM_PROPERTIES] = {
+        drm->fb_ids[page], drm->crtc_id,
+        0, 0, (Uint64)drm->width << 16, (Uint64)drm->height << 16,     // 16.16 fixed point
+        0, 0, drm->mode.hdisplay, drm->mode.vdisplay
+    };
+
+    if (drm->flip_pending && MALI_DRM_WaitFlip(drm, MALI_DRM_FLIP_TIMEOUT) < 0)
+        return -1;
+
+    objs[num_objs] = drm->plane_id;
+    counts[num_objs++] = MALI_DRM_PLANE_NUM_PROPERTIES;
+    for (i = 0; i < MALI_DRM_PLANE_NUM_PROPERTIES; i++) {
+        props[num_props] = drm->plane_props[i];
+        values[num_props++] = plane_values[i];
+    }
+
+    if (drm->modeset) {
+        objs[num_objs] = drm->crtc_id;
+        counts[num_objs++] = 2;
+        props[num_props] = drm->crtc_active;
+        values[num_props++] = 1;
+        props[num_props] = drm->crtc_mode_id;
+        values[num_props++] = drm->mode_blob;
+
+        objs[num_objs] = drm->connector_id;
+        counts[num_objs++] = 1;
+        props[num_props] = drm->connector_crtc_id;
+        values[num_props++] = drm->crtc_id;
+    }
+
+    SDL_zero(atomic);
+    atomic.flags = DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK;
+    if (drm->modeset)
+        atomic.flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
+    atomic.count_objs = num_objs;
+    atomic.objs_ptr = MALI_DRM_PTR(objs);
+    atomic.count_props_ptr = MALI_DRM_PTR(counts);
+    atomic.props_ptr = MALI_DRM_PTR(props);
+    atomic.prop_values_ptr = MALI_DRM_PTR(values);
+    atomic.user_data = page;
+    if (drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_ATOMIC, &atomic) < 0)
+        return SDL_SetError("mali-fbdev: Atomic commit of page %d failed", page);
+
+    drm->modeset = SDL_FALSE;
+    drm->flip_pending = SDL_TRUE;
+
+    if (vsync)
+        return MALI_DRM_WaitFlip(drm, MALI_DRM_FLIP_TIMEOUT);
+
+    return 0;
+}
+
+/* Reads events until the flip completes, the kernel's timestamp of it is kept */
+int
+MALI_DRM_WaitFlip(MALI_DRM *drm, int timeout)
+{
+    Uint8 buffer[1024];
+    struct drm_event event;
+    struct drm_event_vblank vblank;
+    int i, length;
+
+    while (drm->flip_pending) {
+        length = drm->ops->read_events(drm->fd, buffer, sizeof(buffer), timeout);
+        if (length <= 0) {
+            /* Given up on, the next commit tells whether the display is still there */
+            drm->flip_pending = SDL_FALSE;
+            if (length == 0)
+                return SDL_SetError("mali-fbdev: Page flip didn't complete within %d ms", timeout);
+            return SDL_SetError("mali-fbdev: Can't read DRM events");
+        }
+
+        /* Events come back to back, each one says how long it is */
+        for (i = 0; i + (int)sizeof(event) <= length; i += event.length) {
+            SDL_memcpy(&event, &buffer[i], sizeof(event));
+            if (event.length < sizeof(event) || i + (int)event.length > length)
+                break;
+
+            if (event.type == DRM_EVENT_FLIP_COMPLETE && event.length >= sizeof(vblank)) {
+                SDL_memcpy(&vblank, &buffer[i], sizeof(vblank));
+                drm->flip_time = (Uint64)vblank.tv_sec * 1000000 + vblank.tv_usec;
+                drm->flip_sequence = vblank.sequence;
+                drm->flip_pending = SDL_FALSE;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* Dropping master on close has the kernel's fbdev emulation put the console back */
+void
+MALI_DRM_Close(MALI_DRM *drm)
+{
+    struct drm_gem_close gem;
+    struct drm_mode_destroy_blob blob;
+    int i, j;
+
+    if (!drm->ops || drm->fd < 0)
+        return;
+
+    if (drm->flip_pending)
+        MALI_DRM_WaitFlip(drm, MALI_DRM_FLIP_TIMEOUT);
+
+    for (i = 0; i < MALI_SWAPCHAIN_MAX_DEPTH; i++) {
+        if (drm->fb_ids[i])
+            drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_RMFB, &drm->fb_ids[i]);
+
+        /* Pages sharing a buffer share its handle as well */
+        if (!drm->handles[i])
+            continue;
+        for (j = 0; j < i && drm->handles[j] != drm->handles[i]; j++) {
+        }
+        if (j == i) {
+            SDL_zero(gem);
+            gem.handle = drm->handles[i];
+            drm->ops->ioctl(drm->fd, DRM_IOCTL_GEM_CLOSE, &gem);
+        }
+    }
+
+    if (drm->mode_blob) {
+        blob.blob_id = drm->mode_blob;
+        drm->ops->ioctl(drm->fd, DRM_IOCTL_MODE_DESTROYPROPBLOB, &blob);
+    }
+
+    SDL_free(drm->formats);
+    drm->ops->close(drm->fd);
+    SDL_zerop(drm);
+    drm->fd = -1;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
@@ -0,0 +1,85 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malidrm_h
+#define _SDL_malidrm_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_stdinc.h"
+
+#include "drm_uapi.h"
+#include "SDL_maliswapchain.h"
+
+/* Flips land within a few refreshes, anything longer is a display that went away */
+#define MALI_DRM_FLIP_TIMEOUT 1000
+
+/*
+ * Kernel access, the device implementation is used on device while tests
+ * plug in a fake KMS device to exercise the modesetting logic without one.
+ */
+typedef struct MALI_DRMOps
+{
+    int (*open)(const char *path);
+    void (*close)(int fd);
+    int (*ioctl)(int fd, unsigned long request, void *arg);
+    int (*read_events)(int fd, void *buffer, int size, int timeout);    // bytes read, 0 on timeout
+} MALI_DRMOps;
+
+extern const MALI_DRMOps MALI_DRM_DeviceOps;
+
+typedef enum MALI_DRMPlaneProperty
+{
+    MALI_DRM_PLANE_FB_ID = 0,
+    MALI_DRM_PLANE_CRTC_ID,
+    MALI_DRM_PLANE_SRC_X,
+    MALI_DRM_PLANE_SRC_Y,
+    MALI_DRM_PLANE_SRC_W,
+    MALI_DRM_PLANE_SRC_H,
+    MALI_DRM_PLANE_CRTC_X,
+    MALI_DRM_PLANE_CRTC_Y,
+    MALI_DRM_PLANE_CRTC_W,
+    MALI_DRM_PLANE_CRTC_H,
+    MALI_DRM_PLANE_NUM_PROPERTIES
+} MALI_DRMPlaneProperty;
+
+/*
+ * The primary plane of the first connected display, driven with atomic
+ * commits. Pages are DMA_BUFs added as framebuffers, presenting one is a
+ * flip that completes with an event, like the KMSDRM driver's.
+ */
+typedef struct MALI_DRM
+{
+    const MALI_DRMOps *ops;
+    int fd;
+    Uint32 connector_id, crtc_id, plane_id;
+    struct drm_mode_modeinfo mode;
+    Uint32 mode_blob;
+
+    // Property IDs, the plane's by MALI_DRMPlaneProperty
+    Uint32 plane_props[MALI_DRM_PLANE_NUM_PROPERTIES];
+    Uint32 crtc_active, crtc_mode_id, connector_crtc_id;
+
+    Uint32 *formats;            // what the plane scans out, as fourccs
+    int num_formats;
+
+    Uint32 fb_ids[MALI_SWAPCHAIN_MAX_DEPTH];
+    Uint32 handles[MALI_SWAPCHAIN_MAX_DEPTH];
+    int width, height;
+
+    SDL_bool modeset;           // the next commit lights the CRTC up with our mode
+    SDL_bool flip_pending;
+    Uint64 flip_time;           // CLOCK_MONOTONIC microseconds of the last completed flip
+    Uint32 flip_sequence;
+} MALI_DRM;
+
+int MALI_DRM_Open(MALI_DRM *drm, const MALI_DRMOps *ops, const char *path);
+SDL_bool MALI_DRM_HasFormat(const MALI_DRM *drm, Uint32 fourcc);
+int MALI_DRM_AddPage(MALI_DRM *drm, int page, int dmabuf_fd, int width, int height, int pitch, Uint32 offset,
+                     Uint32 fourcc);
+int MALI_DRM_Present(MALI_DRM *drm, int page, SDL_bool vsync);
+int MALI_DRM_WaitFlip(MALI_DRM *drm, int timeout);
+void MALI_DRM_Close(MALI_DRM *drm);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_malidrm_h */
@@ -0,0 +1,215 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "SDL_error.h"
+#include "SDL_log.h"
+
+#include "SDL_malifb.h"
+
+/* Not in the kernel headers of most vendor BSPs */
+#ifndef DMA_BUF_IOCTL_SYNC
+struct dma_buf_sync
+{
+    Uint64 flags;
+};
+#define DMA_BUF_SYNC_READ  (1 << 0)
+#define DMA_BUF_SYNC_WRITE (2 << 0)
+#define DMA_BUF_SYNC_RW    (DMA_BUF_SYNC_READ | DMA_BUF_SYNC_WRITE)
+#define DMA_BUF_SYNC_START (0 << 2)
+#define DMA_BUF_SYNC_END   (1 << 2)
+#define DMA_BUF_IOCTL_SYNC _IOW('b', 0, struct dma_buf_sync)
+#endif
+
+static int
+MALI_DMABUF_Sync(int fd, Uint64 flags)
+{
+    struct dma_buf_sync sync = { .flags = flags };
+
+    return ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+
+const MALI_FramebufferOps MALI_DMABUF_FramebufferOps = {
+    MALI_DMABUF_Sync
+};
+
+static void
+MALI_Framebuffer_Sync(MALI_Framebuffer *fb, MALI_FramebufferPage *page, Uint64 flags)
+{
+    if (fb->ops->sync(page->fd, flags) < 0)
+        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: DMA_BUF_IOCTL_SYNC failed.");
+}
+
+int
+MALI_Framebuffer_Map(MALI_Framebuffer *fb, const MALI_FramebufferOps *ops, int depth, const int *fds,
+                     const Uint32 *offsets, int width, int height, int pitch, int bytes_per_pixel)
+{
+    MALI_FramebufferPage *page;
+    long page_size = sysconf(_SC_PAGESIZE);
+    off_t start;
+    int i;
+
+    SDL_zerop(fb);
+    fb->ops = ops;
+    fb->depth = depth;
+    fb->width = width;
+    fb->height = height;
+    fb->pitch = pitch;
+    fb->bytes_per_pixel = bytes_per_pixel;
+    fb->current = -1;
+    fb->latest = -1;
+
+    for (i = 0; i < depth; i++) {
+        page = &fb->pages[i];
+        page->fd = fds[i];
+
+        /* Direct scanout pages are slices of one buffer, mmap wants the offset page aligned */
+        start = offsets[i] - offsets[i] % page_size;
+        page->map_size = (offsets[i] - start) + (size_t)pitch * height;
+        page->map = mmap(NULL, page->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, page->fd, start);
+        if (page->map == MAP_FAILED) {
+            page->map = NULL;
+            MALI_Framebuffer_Unmap(fb);
+            return SDL_SetError("mali-fbdev: Unable to map swap chain page %d", i);
+        }
+        page->pixels = (Uint8 *)page->map + (offsets[i] - start);
+
+        /* Pages may be recycled from an earlier swap chain, start every one out in the same state */
+        MALI_Framebuffer_Sync(fb, page, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+        SDL_memset(page->pixels, 0, (size_t)pitch * height);
+        MALI_Framebuffer_Sync(fb, page, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+    }
+
+    return 0;
+}
+
+static void
+MALI_Framebuffer_CopyRect(MALI_Framebuffer *fb, MALI_FramebufferPage *dst, const MALI_FramebufferPage *src,
+                          const SDL_Rect *rect)
+{
+    size_t offset = (size_t)rect->y * fb->pitch + (size_t)rect->x * fb->bytes_per_pixel;
+    size_t length = (size_t)rect->w * fb->bytes_per_pixel;
+    int y;
+
+    if (rect->w == fb->width) {
+        length = (size_t)rect->h * fb->pitch;
+        SDL_memcpy(dst->pixels + offset, src->pixels + offset, length);
+        fb->bytes_copied += length;
+        return;
+    }
+
+    for (y = 0; y < rect->h; y++, offset += fb->pitch) {
+        SDL_memcpy(dst->pixels + offset, src->pixels + offset, length);
+    }
+    fb->bytes_copied += length * rect->h;
+}
+
+/*
+ * Gives the CPU access to a page and brings it up to date with the last frame
+ * presented, returns the pixels or NULL on error.
+ */
+void *
+MALI_Framebuffer_Acquire(MALI_Framebuffer *fb, int page)
+{
+    MALI_FramebufferPage *dst, *src;
+    SDL_Rect rect;
+    Uint32 f;
+
+    if (page < 0 || page >= fb->depth || !fb->pages[page].pixels) {
+        SDL_SetError("mali-fbdev: Swap chain page %d isn't mapped", page);
+        return NULL;
+    }
+
+    if (fb->current == page)
+        return fb->pages[page].pixels;
+    if (fb->current >= 0)
+        MALI_Framebuffer_Sync(fb, &fb->pages[fb->current], DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+
+    dst = &fb->pages[page];
+    MALI_Framebuffer_Sync(fb, dst, DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW);
+    fb->current = page;
+
+    if (fb->latest < 0 || fb->latest == page || dst->frame == fb->frame)
+        return dst->pixels;
+
+    /* Everything that changed after the page was last drawn into, or all of it if that's too long ago */
+    SDL_zero(rect);
+    if (fb->frame - dst->frame > MALI_FRAMEBUFFER_HISTORY) {
+        rect.w = fb->width;
+        rect.h = fb->height;
+    } else {
+        for (f = dst->frame + 1; f != fb->frame + 1; f++) {
+            SDL_UnionRect(&rect, &fb->damage[f % MALI_FRAMEBUFFER_HISTORY], &rect);
+        }
+    }
+
+    if (!SDL_RectEmpty(&rect)) {
+        src = &fb->pages[fb->latest];
+        MALI_Framebuffer_Sync(fb, src, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+        MALI_Framebuffer_CopyRect(fb, dst, src, &rect);
+        MALI_Framebuffer_Sync(fb, src, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+    }
+
+    dst->frame = fb->frame;
+    return dst->pixels;
+}
+
+/* Ends CPU access to the current page, which now holds the newest frame */
+void
+MALI_Framebuffer_Present(MALI_Framebuffer *fb, const SDL_Rect *rects, int numrects)
+{
+    MALI_FramebufferPage *page;
+    SDL_Rect full, clipped, *damage;
+    int i;
+
+    if (fb->current < 0)
+        return;
+
+    full.x = full.y = 0;
+    full.w = fb->width;
+    full.h = fb->height;
+
+    fb->frame++;
+    damage = &fb->damage[fb->frame % MALI_FRAMEBUFFER_HISTORY];
+    if (!rects) {
+        *damage = full;
+    } else {
+        SDL_zerop(damage);
+        for (i = 0; i < numrects; i++) {
+            if (SDL_IntersectRect(&rects[i], &full, &clipped))
+                SDL_UnionRect(damage, &clipped, damage);
+        }
+    }
+
+    page = &fb->pages[fb->current];
+    page->frame = fb->frame;
+    MALI_Framebuffer_Sync(fb, page, DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+    fb->latest = fb->current;
+    fb->current = -1;
+}
+
+void
+MALI_Framebuffer_Unmap(MALI_Framebuffer *fb)
+{
+    int i;
+
+    if (fb->current >= 0)
+        MALI_Framebuffer_Sync(fb, &fb->pages[fb->current], DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+
+    /* The descriptors belong to the swap chain */
+    for (i = 0; i < fb->depth; i++) {
+        if (fb->pages[i].map)
+            munmap(fb->pages[i].map, fb->pages[i].map_size);
+    }
+
+    fb->depth = 0;
+    fb->current = -1;
+    fb->latest = -1;
+    SDL_zeroa(fb->pages);
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
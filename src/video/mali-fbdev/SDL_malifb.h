@@ -0,0 +1,67 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malifb_h
+#define _SDL_malifb_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_rect.h"
+
+#include "SDL_maliswapchain.h"
+
+/* Frames of damage kept around to bring a page back up to date */
+#define MALI_FRAMEBUFFER_HISTORY 8
+
+/*
+ * CPU cache maintenance around accesses to a page, DMA_BUF_IOCTL_SYNC on device
+ * while tests plug in their own to check the accesses are bracketed correctly.
+ */
+typedef struct MALI_FramebufferOps
+{
+    int (*sync)(int fd, Uint64 flags);
+} MALI_FramebufferOps;
+
+extern const MALI_FramebufferOps MALI_DMABUF_FramebufferOps;
+
+typedef struct MALI_FramebufferPage
+{
+    int fd;
+    void *map;
+    size_t map_size;
+    Uint8 *pixels;
+
+    /* Last frame the page holds */
+    Uint32 frame;
+} MALI_FramebufferPage;
+
+/*
+ * The window surface of SDL_GetWindowSurface() mapped straight onto the swap
+ * chain pages, the application draws into the page it owns and presenting is
+ * handing it to the blitter. Surface contents have to survive a present, so a
+ * page coming back is brought up to date by copying whatever changed since it
+ * was last drawn into from the newest page.
+ */
+typedef struct MALI_Framebuffer
+{
+    const MALI_FramebufferOps *ops;
+    int depth;
+    int width, height, pitch, bytes_per_pixel;
+    MALI_FramebufferPage pages[MALI_SWAPCHAIN_MAX_DEPTH];
+    int current;            /* page the CPU has access to, -1 if none */
+    int latest;             /* page holding the last presented frame, -1 if none */
+    Uint32 frame;
+    SDL_Rect damage[MALI_FRAMEBUFFER_HISTORY];
+
+    /* Statistics, bytes copied to keep pages up to date */
+    Uint64 bytes_copied;
+} MALI_Framebuffer;
+
+int MALI_Framebuffer_Map(MALI_Framebuffer *fb, const MALI_FramebufferOps *ops, int depth, const int *fds,
+                         const Uint32 *offsets, int width, int height, int pitch, int bytes_per_pixel);
+void *MALI_Framebuffer_Acquire(MALI_Framebuffer *fb, int page);
+void MALI_Framebuffer_Present(MALI_Framebuffer *fb, const SDL_Rect *rects, int numrects);
+void MALI_Framebuffer_Unmap(MALI_Framebuffer *fb);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_malifb_h */
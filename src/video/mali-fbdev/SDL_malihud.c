@@ -0,0 +1,334 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+#include "SDL_rwops.h"
+#include "SDL_timer.h"
+
+#include "SDL_malihud.h"
+
+/* Font pixels, the glyphs are 5x7 on a 6x9 grid */
+#define MALI_HUD_MARGIN      8
+#define MALI_HUD_PADDING     2
+#define MALI_HUD_ADVANCE     6
+#define MALI_HUD_LINE_HEIGHT 9
+#define MALI_HUD_GRAPH_HEIGHT 32
+
+/* Only what the statistics need, rows top to bottom with the leftmost pixel in bit 4 */
+static const struct {
+    char c;
+    Uint8 rows[7];
+} mali_hud_font[] = {
+    { '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+    { '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+    { '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+    { '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+    { '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+    { '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+    { '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+    { '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+    { '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+    { '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+    { '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+    { '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+    { 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+    { 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+    { 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+    { 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+    { 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+};
+
+void
+MALI_HUD_GetProjection(int rotation, int display_width, int display_height, float projection[4][4])
+{
+    /* Display to clip coordinates with y pointing down, as factors of x and y and a constant */
+    const float dx[3] = { 2.0f / display_width, 0.0f, -1.0f };
+    const float dy[3] = { 0.0f, -2.0f / display_height, 1.0f };
+    float vx[3], vy[3];
+    int i;
+
+    /* Then turned the way the blitter turns the pages onto the viewport */
+    for (i = 0; i < 3; i++) {
+        switch (rotation) {
+            case 1: vx[i] = -dy[i]; vy[i] = dx[i]; break;
+            case 2: vx[i] = -dx[i]; vy[i] = -dy[i]; break;
+            case 3: vx[i] = dy[i]; vy[i] = -dx[i]; break;
+            default: vx[i] = dx[i]; vy[i] = dy[i]; break;
+        }
+    }
+
+    SDL_memset(projection, 0, sizeof(float) * 16);
+    projection[0][0] = vx[0]; projection[1][0] = vx[1]; projection[3][0] = vx[2];
+    projection[0][1] = vy[0]; projection[1][1] = vy[1]; projection[3][1] = vy[2];
+    projection[2][2] = -1.0f;
+    projection[3][3] = 1.0f;
+}
+
+/* The aggregate "cpu" line of /proc/stat */
+SDL_bool
+MALI_HUD_ParseCPUStat(const char *stat, Uint64 *busy, Uint64 *total)
+{
+    Uint64 value, idle = 0, sum = 0;
+    char *end;
+    int i;
+
+    if (SDL_strncmp(stat, "cpu ", 4) != 0)
+        return SDL_FALSE;
+
+    /* user nice system idle iowait irq softirq steal, guest time is counted in user already */
+    stat += 4;
+    for (i = 0; i < 8; i++) {
+        while (*stat == ' ')
+            stat++;
+        value = SDL_strtoull(stat, &end, 10);
+        if (end == stat)
+            break;
+        if (i == 3 || i == 4)
+            idle += value;
+        sum += value;
+        stat = end;
+    }
+
+    if (i < 4)
+        return SDL_FALSE;
+
+    *busy = sum - idle;
+    *total = sum;
+    return SDL_TRUE;
+}
+
+/* Percentage of CPU time spent busy since the previous call, -1 if unknown */
+static int
+MALI_HUD_ReadCPULoad(MALI_HUD *hud)
+{
+    char stat[256];
+    SDL_RWops *rw;
+    size_t length;
+    Uint64 busy, total;
+    int load = -1;
+
+    rw = SDL_RWFromFile("/proc/stat", "r");
+    if (!rw)
+        return -1;
+    length = SDL_RWread(rw, stat, 1, sizeof(stat) - 1);
+    SDL_RWclose(rw);
+    stat[length] = '\0';
+
+    if (!MALI_HUD_ParseCPUStat(stat, &busy, &total))
+        return -1;
+
+    if (hud->cpu_total != 0 && total > hud->cpu_total)
+        load = (int)((busy - hud->cpu_busy) * 100 / (total - hud->cpu_total));
+    hud->cpu_busy = busy;
+    hud->cpu_total = total;
+    return load;
+}
+
+static void
+MALI_HUD_AddRect(MALI_HUD *hud, float x, float y, float w, float h)
+{
+    float (*v)[2];
+
+    if (hud->num_vertices + 6 > MALI_HUD_MAX_VERTICES)
+        return;
+
+    v = &hud->vertices[hud->num_vertices];
+    v[0][0] = x;     v[0][1] = y;
+    v[1][0] = x + w; v[1][1] = y;
+    v[2][0] = x;     v[2][1] = y + h;
+    v[3][0] = x + w; v[3][1] = y;
+    v[4][0] = x + w; v[4][1] = y + h;
+    v[5][0] = x;     v[5][1] = y + h;
+    hud->num_vertices += 6;
+}
+
+/* One rectangle per run of set pixels in a glyph row, characters without a glyph are left blank */
+static void
+MALI_HUD_AddText(MALI_HUD *hud, const char *text, int x, int y)
+{
+    const Uint8 *rows;
+    int s = hud->scale;
+    int i, row, col, run;
+
+    for (; *text; text++, x += MALI_HUD_ADVANCE * s) {
+        rows = NULL;
+        for (i = 0; i < (int)SDL_arraysize(mali_hud_font); i++) {
+            if (mali_hud_font[i].c == *text) {
+                rows = mali_hud_font[i].rows;
+                break;
+            }
+        }
+        if (!rows)
+            continue;
+
+        for (row = 0; row < 7; row++) {
+            for (col = 0; col < 5; col += run + 1) {
+                for (run = 0; col + run < 5 && (rows[row] & (0x10 >> (col + run))); run++) {
+                }
+                if (run > 0)
+                    MALI_HUD_AddRect(hud, x + col * s, y + row * s, run * s, s);
+            }
+        }
+    }
+}
+
+static int
+MALI_HUD_GetWidth(const MALI_HUD *hud)
+{
+    return (MALI_HUD_HISTORY + 2 * MALI_HUD_PADDING) * hud->scale;
+}
+
+static int
+MALI_HUD_GetGraphTop(const MALI_HUD *hud)
+{
+    return MALI_HUD_MARGIN + (MALI_HUD_PADDING + MALI_HUD_LINES * MALI_HUD_LINE_HEIGHT) * hud->scale;
+}
+
+/* Background and text, these stay put until the next update */
+static void
+MALI_HUD_Layout(MALI_HUD *hud)
+{
+    int s = hud->scale;
+    int x = MALI_HUD_MARGIN + MALI_HUD_PADDING * s;
+    int y = MALI_HUD_MARGIN + MALI_HUD_PADDING * s;
+    int i;
+
+    hud->num_vertices = 0;
+    hud->first[MALI_HUD_BACKGROUND] = 0;
+    MALI_HUD_AddRect(hud, MALI_HUD_MARGIN, MALI_HUD_MARGIN, MALI_HUD_GetWidth(hud),
+                     MALI_HUD_GetGraphTop(hud) - MALI_HUD_MARGIN + (MALI_HUD_GRAPH_HEIGHT + MALI_HUD_PADDING) * s);
+    hud->count[MALI_HUD_BACKGROUND] = hud->num_vertices;
+
+    hud->first[MALI_HUD_TEXT] = hud->num_vertices;
+    for (i = 0; i < MALI_HUD_LINES; i++) {
+        MALI_HUD_AddText(hud, hud->lines[i], x, y + i * MALI_HUD_LINE_HEIGHT * s);
+    }
+    hud->count[MALI_HUD_TEXT] = hud->num_vertices - hud->first[MALI_HUD_TEXT];
+}
+
+/* A bar per frame, the full height is two refresh periods, which puts the budget line halfway */
+static void
+MALI_HUD_BuildGraph(MALI_HUD *hud)
+{
+    int s = hud->scale;
+    int x = MALI_HUD_MARGIN + MALI_HUD_PADDING * s;
+    int bottom = MALI_HUD_GetGraphTop(hud) + MALI_HUD_GRAPH_HEIGHT * s;
+    Uint64 full_scale = 2 * hud->refresh_period;
+    Uint64 frame_time;
+    float h;
+    int i;
+
+    hud->num_vertices = hud->first[MALI_HUD_TEXT] + hud->count[MALI_HUD_TEXT];
+    hud->first[MALI_HUD_GRAPH] = hud->num_vertices;
+    for (i = 0; i < hud->history_count; i++) {
+        frame_time = SDL_min(hud->history[(hud->history_start + i) % MALI_HUD_HISTORY], full_scale);
+        h = (float)frame_time * MALI_HUD_GRAPH_HEIGHT * s / full_scale;
+        MALI_HUD_AddRect(hud, x + i * s, bottom - h, s, h);
+    }
+    hud->count[MALI_HUD_GRAPH] = hud->num_vertices - hud->first[MALI_HUD_GRAPH];
+
+    hud->first[MALI_HUD_BUDGET] = hud->num_vertices;
+    MALI_HUD_AddRect(hud, x, bottom - MALI_HUD_GRAPH_HEIGHT / 2 * s, MALI_HUD_HISTORY * s, s);
+    hud->count[MALI_HUD_BUDGET] = hud->num_vertices - hud->first[MALI_HUD_BUDGET];
+}
+
+static void
+MALI_HUD_Update(MALI_HUD *hud)
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    int load = MALI_HUD_ReadCPULoad(hud);
+
+    if (hud->frames > 0 && hud->frame_time_sum > 0) {
+        SDL_snprintf(hud->lines[0], sizeof(hud->lines[0]), "FPS %5.1f", hud->frames * frequency / hud->frame_time_sum);
+        SDL_snprintf(hud->lines[1], sizeof(hud->lines[1]), "MS  %5.1f",
+                     hud->frame_time_sum * 1000.0 / frequency / hud->frames);
+    }
+    if (load >= 0)
+        SDL_snprintf(hud->lines[2], sizeof(hud->lines[2]), "CPU %4d%%", load);
+    if (hud->gpu_frames > 0)
+        SDL_snprintf(hud->lines[3], sizeof(hud->lines[3]), "GPU %5.2f",
+                     hud->gpu_time_sum * 1000.0 / frequency / hud->gpu_frames);
+
+    hud->frames = 0;
+    hud->frame_time_sum = 0;
+    hud->gpu_frames = 0;
+    hud->gpu_time_sum = 0;
+    MALI_HUD_Layout(hud);
+}
+
+void
+MALI_HUD_Init(MALI_HUD *hud, int rotation, int viewport_width, int viewport_height, int refresh_rate)
+{
+    int display_width = (rotation & 1) ? viewport_height : viewport_width;
+    int display_height = (rotation & 1) ? viewport_width : viewport_height;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+
+    SDL_zerop(hud);
+    if (!SDL_GetHintBoolean(SDL_HINT_MALI_HUD, SDL_FALSE))
+        return;
+
+    hud->vertices = SDL_malloc(MALI_HUD_MAX_VERTICES * sizeof(*hud->vertices));
+    if (!hud->vertices)
+        return;
+
+    hud->enabled = SDL_TRUE;
+    hud->scale = SDL_max(1, display_height / 360);
+    hud->refresh_period = frequency / (refresh_rate > 0 ? refresh_rate : 60);
+    hud->update_interval = frequency / 2;
+    MALI_HUD_GetProjection(rotation, display_width, display_height, hud->projection);
+
+    SDL_strlcpy(hud->lines[0], "FPS     -", sizeof(hud->lines[0]));
+    SDL_strlcpy(hud->lines[1], "MS      -", sizeof(hud->lines[1]));
+    SDL_strlcpy(hud->lines[2], "CPU     -", sizeof(hud->lines[2]));
+    SDL_strlcpy(hud->lines[3], "GPU     -", sizeof(hud->lines[3]));
+    MALI_HUD_ReadCPULoad(hud);
+    MALI_HUD_Layout(hud);
+    MALI_HUD_BuildGraph(hud);
+}
+
+void
+MALI_HUD_Quit(MALI_HUD *hud)
+{
+    SDL_free(hud->vertices);
+    SDL_zerop(hud);
+}
+
+/* Takes the timing of every frame the blitter shows, the text is refreshed twice a second */
+void
+MALI_HUD_Record(MALI_HUD *hud, const SDL_GLFrameTiming *timing)
+{
+    Uint64 frame_time;
+
+    if (!hud->enabled)
+        return;
+
+    if (hud->last_swap != 0 && timing->swap_returned > hud->last_swap) {
+        frame_time = timing->swap_returned - hud->last_swap;
+        if (hud->history_count == MALI_HUD_HISTORY) {
+            hud->history_start = (hud->history_start + 1) % MALI_HUD_HISTORY;
+            hud->history_count--;
+        }
+        hud->history[(hud->history_start + hud->history_count) % MALI_HUD_HISTORY] = frame_time;
+        hud->history_count++;
+        hud->frames++;
+        hud->frame_time_sum += frame_time;
+    }
+    hud->last_swap = timing->swap_returned;
+
+    if (timing->blit_done != 0 && timing->blit_gpu_done > timing->blit_done) {
+        hud->gpu_frames++;
+        hud->gpu_time_sum += timing->blit_gpu_done - timing->blit_done;
+    }
+
+    if (timing->swap_returned >= hud->next_update) {
+        MALI_HUD_Update(hud);
+        hud->next_update = timing->swap_returned + hud->update_interval;
+    }
+    MALI_HUD_BuildGraph(hud);
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
@@ -0,0 +1,65 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malihud_h
+#define _SDL_malihud_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_video.h"
+
+/* Frames in the graph, one bar each */
+#define MALI_HUD_HISTORY      120
+#define MALI_HUD_LINES        4
+#define MALI_HUD_MAX_VERTICES 8192
+
+/* Drawn in this order, each in a color of its own */
+typedef enum MALI_HUDPart
+{
+    MALI_HUD_BACKGROUND = 0,
+    MALI_HUD_TEXT,
+    MALI_HUD_GRAPH,
+    MALI_HUD_BUDGET,
+    MALI_HUD_NUM_PARTS
+} MALI_HUDPart;
+
+/*
+ * SDL_HINT_MALI_HUD, statistics of the frames the blitter shows. Everything is
+ * laid out in display coordinates, the projection turns it the way the display is.
+ */
+typedef struct MALI_HUD
+{
+    SDL_bool enabled;
+    int scale;                      // display pixels per font pixel
+    float projection[4][4];
+
+    /* Frame times in performance counter ticks, oldest first from history_start */
+    Uint64 last_swap;
+    Uint64 refresh_period;
+    Uint64 history[MALI_HUD_HISTORY];
+    int history_start, history_count;
+
+    /* Accumulated since the text was last updated */
+    Uint64 update_interval, next_update;
+    Uint32 frames;
+    Uint64 frame_time_sum;
+    Uint32 gpu_frames;
+    Uint64 gpu_time_sum;
+    Uint64 cpu_busy, cpu_total;
+    char lines[MALI_HUD_LINES][16];
+
+    /* Triangles, the text only changes on updates so the graph goes after it */
+    float (*vertices)[2];
+    int num_vertices;
+    int first[MALI_HUD_NUM_PARTS];
+    int count[MALI_HUD_NUM_PARTS];
+} MALI_HUD;
+
+void MALI_HUD_Init(MALI_HUD *hud, int rotation, int viewport_width, int viewport_height, int refresh_rate);
+void MALI_HUD_Quit(MALI_HUD *hud);
+void MALI_HUD_Record(MALI_HUD *hud, const SDL_GLFrameTiming *timing);
+SDL_bool MALI_HUD_ParseCPUStat(const char *stat, Uint64 *busy, Uint64 *total);
+void MALI_HUD_GetProjection(int rotation, int display_width, int display_height, float projection[4][4]);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_malihud_h */
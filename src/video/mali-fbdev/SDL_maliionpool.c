@@ -0,0 +1,182 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "SDL_error.h"
+#include "SDL_log.h"
+
+#include "SDL_maliionpool.h"
+
+static int
+MALI_ION_Alloc(int ion_fd, size_t size, ion_user_handle_t *handle, int *fd)
+{
+    struct ion_fd_data ion_data;
+    struct ion_allocation_data allocation_data;
+    struct ion_handle_data ionHandleData;
+
+    /* Allocate framebuffer data */
+    allocation_data = (struct ion_allocation_data){
+        .len = size,
+        .heap_id_mask = (1 << ION_HEAP_TYPE_SYSTEM),
+        .flags = 1 << ION_FLAG_CACHED
+    };
+
+    if (ioctl(ion_fd, ION_IOC_ALLOC, &allocation_data) != 0)
+        return SDL_SetError("mali-fbdev: Unable to create backing ION buffers");
+
+    /* Export DMA_BUF handle for the framebuffer */
+    ion_data = (struct ion_fd_data){
+        .handle = allocation_data.handle
+    };
+
+    if (ioctl(ion_fd, ION_IOC_SHARE, &ion_data) != 0) {
+        ionHandleData = (struct ion_handle_data){ .handle = allocation_data.handle };
+        ioctl(ion_fd, ION_IOC_FREE, &ionHandleData);
+        return SDL_SetError("mali-fbdev: Unable to create backing ION buffers");
+    }
+
+    *handle = allocation_data.handle;
+    *fd = ion_data.fd;
+    return 0;
+}
+
+static void
+MALI_ION_Free(int ion_fd, ion_user_handle_t handle)
+{
+    struct ion_handle_data ionHandleData = { .handle = handle };
+
+    if (ioctl(ion_fd, ION_IOC_FREE, &ionHandleData) != 0) {
+        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: ION_IOC_FREE ioctl failed.");
+    }
+}
+
+const MALI_IONOps MALI_ION_Ops = {
+    MALI_ION_Alloc,
+    MALI_ION_Free
+};
+
+void
+MALI_IONPool_Init(MALI_IONPool *pool, const MALI_IONOps *ops, int ion_fd)
+{
+    int i;
+
+    SDL_zerop(pool);
+    pool->ops = ops;
+    pool->ion_fd = ion_fd;
+    for (i = 0; i < MALI_ION_POOL_SIZE; i++)
+        pool->buffers[i].fd = -1;
+}
+
+static void
+MALI_IONPool_Free(MALI_IONPool *pool, MALI_IONBuffer *buffer)
+{
+    pool->ops->free(pool->ion_fd, buffer->handle);
+    close(buffer->fd);
+    SDL_zerop(buffer);
+    buffer->fd = -1;
+}
+
+static int
+MALI_IONPool_Allocate(MALI_IONPool *pool, MALI_IONBuffer *buffer, size_t size)
+{
+    if (pool->ops->alloc(pool->ion_fd, size, &buffer->handle, &buffer->fd) < 0)
+        return -1;
+
+    buffer->size = size;
+    pool->allocations++;
+    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Created ION buffer %d (fd: %d, %u bytes)\n",
+        buffer->handle, buffer->fd, (unsigned)size);
+    return 0;
+}
+
+int
+MALI_IONPool_Acquire(MALI_IONPool *pool, size_t size, ion_user_handle_t *handle, int *fd)
+{
+    MALI_IONBuffer *buffer, *best = NULL, *empty = NULL, *oldest = NULL;
+    int i;
+
+    for (i = 0; i < MALI_ION_POOL_SIZE; i++) {
+        buffer = &pool->buffers[i];
+        if (buffer->fd < 0) {
+            if (!empty)
+                empty = buffer;
+        } else if (!buffer->in_use) {
+            /* Smallest idle buffer that fits, without wasting more than half of it */
+            if (buffer->size >= size && buffer->size <= size * 2 && (!best || buffer->size < best->size))
+                best = buffer;
+            if (!oldest || buffer->last_used < oldest->last_used)
+                oldest = buffer;
+        }
+    }
+
+    if (best) {
+        pool->reuses++;
+    } else {
+        /* Make room by dropping the idle buffer that went unused the longest */
+        if (!empty && oldest) {
+            MALI_IONPool_Free(pool, oldest);
+            empty = oldest;
+        }
+        if (!empty)
+            return SDL_SetError("mali-fbdev: ION buffer pool exhausted");
+
+        size = (size + MALI_ION_POOL_GRANULARITY - 1) / MALI_ION_POOL_GRANULARITY * MALI_ION_POOL_GRANULARITY;
+        if (MALI_IONPool_Allocate(pool, empty, size) < 0)
+            return -1;
+        best = empty;
+    }
+
+    best->in_use = SDL_TRUE;
+    *handle = best->handle;
+    *fd = best->fd;
+    return 0;
+}
+
+void
+MALI_IONPool_Release(MALI_IONPool *pool, int fd)
+{
+    MALI_IONBuffer *buffer, *oldest;
+    int i, idle;
+
+    for (i = 0; i < MALI_ION_POOL_SIZE; i++) {
+        if (pool->buffers[i].fd == fd && pool->buffers[i].in_use) {
+            pool->buffers[i].in_use = SDL_FALSE;
+            pool->buffers[i].last_used = ++pool->clock;
+            break;
+        }
+    }
+
+    /* Keep enough for a full swap chain, free whatever lingers beyond that */
+    for (;;) {
+        idle = 0;
+        oldest = NULL;
+        for (i = 0; i < MALI_ION_POOL_SIZE; i++) {
+            buffer = &pool->buffers[i];
+            if (buffer->fd >= 0 && !buffer->in_use) {
+                idle++;
+                if (!oldest || buffer->last_used < oldest->last_used)
+                    oldest = buffer;
+            }
+        }
+
+        if (idle <= MALI_ION_POOL_MAX_IDLE)
+            break;
+        MALI_IONPool_Free(pool, oldest);
+    }
+}
+
+void
+MALI_IONPool_Quit(MALI_IONPool *pool)
+{
+    int i;
+
+    for (i = 0; i < MALI_ION_POOL_SIZE; i++) {
+        if (pool->buffers[i].fd >= 0)
+            MALI_IONPool_Free(pool, &pool->buffers[i]);
+    }
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
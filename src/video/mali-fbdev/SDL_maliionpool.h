@@ -0,0 +1,62 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_maliionpool_h
+#define _SDL_maliionpool_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_stdinc.h"
+
+#include "ion.h"
+
+#define MALI_ION_POOL_SIZE        32
+#define MALI_ION_POOL_GRANULARITY (256 * 1024)
+
+/* Idle buffers kept around for the next swap chain, the rest goes back to the system */
+#define MALI_ION_POOL_MAX_IDLE    8
+
+/*
+ * How buffers are allocated and shared as DMA_BUFs, /dev/ion on device while
+ * tests plug in their own backed by plain memory file descriptors.
+ */
+typedef struct MALI_IONOps
+{
+    int (*alloc)(int ion_fd, size_t size, ion_user_handle_t *handle, int *fd);
+    void (*free)(int ion_fd, ion_user_handle_t handle);
+} MALI_IONOps;
+
+extern const MALI_IONOps MALI_ION_Ops;
+
+typedef struct MALI_IONBuffer
+{
+    size_t size;
+    ion_user_handle_t handle;
+    int fd;
+    SDL_bool in_use;
+    Uint32 last_used;
+} MALI_IONBuffer;
+
+/*
+ * ION allocations rounded up to MALI_ION_POOL_GRANULARITY and recycled, so a
+ * mode change can pick up the buffers the previous swap chain just let go of.
+ */
+typedef struct MALI_IONPool
+{
+    const MALI_IONOps *ops;
+    int ion_fd;
+    Uint32 clock;
+    MALI_IONBuffer buffers[MALI_ION_POOL_SIZE];
+
+    /* Statistics */
+    Uint32 allocations;
+    Uint32 reuses;
+} MALI_IONPool;
+
+void MALI_IONPool_Init(MALI_IONPool *pool, const MALI_IONOps *ops, int ion_fd);
+int MALI_IONPool_Acquire(MALI_IONPool *pool, size_t size, ion_user_handle_t *handle, int *fd);
+void MALI_IONPool_Release(MALI_IONPool *pool, int fd);
+void MALI_IONPool_Quit(MALI_IONPool *pool);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_maliionpool_h */
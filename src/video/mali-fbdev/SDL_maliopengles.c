@@ -14,30 +14,131 @@ int MALI_GLES_LoadLibrary(_THIS, const char *path)
     return SDL_EGL_LoadLibrary(_this, path, EGL_DEFAULT_DISPLAY, 0);
 }
 
+void MALI_GLES_UnloadLibrary(_THIS)
+{
+    int i;
+
+    /* The configs cached by MALI_EGL_ChooseConfig belong to the display going away */
+    for (i = 0; i < _this->num_displays; i++) {
+        SDL_DisplayData *displaydata = (SDL_DisplayData *) _this->displays[i].driverdata;
+        if (displaydata) {
+            displaydata->pixmap_config_base = NULL;
+            displaydata->pixmap_config_format = NULL;
+        }
+    }
+
+    SDL_EGL_UnloadLibrary(_this);
+}
+
+/*
+ * EGL fences can't be re-armed, so every page owns at most one and whoever owns
+ * the page is responsible for it: the blitter destroys it once it has been waited
+ * on, pages dropped before reaching the blitter get theirs destroyed here.
+ */
+void
+MALI_GLES_DestroyFence(_THIS, MALI_EGL_Surface *surf)
+{
+    if (surf->fence != EGL_NO_SYNC_KHR) {
+        _this->egl_data->eglDestroySyncKHR(_this->egl_data->egl_display, surf->fence);
+        surf->fence = EGL_NO_SYNC_KHR;
+    }
+}
+
 int MALI_GLES_SwapWindow(_THIS, SDL_Window * window)
 {
-    int r;
-    unsigned int page;
-    EGLSurface surf;
+    return MALI_GLES_SwapWindowWithDamage(_this, window, NULL, 0);
+}
+
+/*
+ * Hands the page the application finished to the blitter and returns the next one
+ * to draw into. Pages drawn by the CPU don't need a fence, they are complete by now.
+ */
+int
+MALI_QueueFrame(_THIS, SDL_WindowData *windowdata, SDL_bool fence, const SDL_Rect *rects, int numrects)
+{
+    int i, page;
+    SDL_bool wake;
+    SDL_DisplayData *displaydata = windowdata->displaydata;
+    MALI_EGL_Surface *surf;
+    MALI_FrameDamage *damage;
+
+    surf = &windowdata->surface[windowdata->swapchain.rendering];
+    MALI_GLES_DestroyFence(_this, surf);
+    if (fence)
+        surf->fence = _this->egl_data->eglCreateSyncKHR(_this->egl_data->egl_display, EGL_SYNC_FENCE_KHR, NULL);
+    surf->frame = windowdata->frame_count++;
+    surf->swap_requested = SDL_GetPerformanceCounter();
+
+    /*
+     * The blitter may be reading an older entry in the same slot, so it's marked with a
+     * frame number that can't match anything before being rewritten.
+     */
+    damage = &windowdata->damage[surf->frame % MALI_MAX_FRAME_DAMAGE];
+    damage->frame = surf->frame + 1;
+    SDL_MemoryBarrierRelease();
+    damage->full = (rects == NULL);
+    SDL_zero(damage->rect);
+    for (i = 0; i < numrects; i++) {
+        SDL_UnionRect(&damage->rect, &rects[i], &damage->rect);
+    }
+    SDL_MemoryBarrierRelease();
+    damage->frame = surf->frame;
+
+    if (windowdata->swapchain.lockfree) {
+        /* The exchange always yields a page right away, the blitter only needs a nudge if it ran dry */
+        if (MALI_SwapChain_Queue(&windowdata->swapchain))
+            MALI_WakeBlitter(displaydata);
+        page = MALI_SwapChain_AcquireRender(&windowdata->swapchain);
+    } else {
+        /* Hand the finished page to the blitter, then wait for a page we're allowed to draw into */
+        SDL_LockMutex(displaydata->triplebuf_mutex);
+        wake = !MALI_SwapChain_HasQueued(&windowdata->swapchain);
+        MALI_SwapChain_Queue(&windowdata->swapchain);
+        if (wake)
+            MALI_WakeBlitter(displaydata);
+        while ((page = MALI_SwapChain_AcquireRender(&windowdata->swapchain)) < 0)
+            SDL_CondWait(displaydata->triplebuf_cond, displaydata->triplebuf_mutex);
+        SDL_UnlockMutex(displaydata->triplebuf_mutex);
+    }
+
+    return page;
+}
+
+int MALI_GLES_SwapWindowWithDamage(_THIS, SDL_Window * window, const SDL_Rect * rects, int numrects)
+{
+    int page;
+    EGLSurface egl_surface;
     SDL_WindowData *windowdata;
 
-    windowdata = (SDL_WindowData*)_this->windows->driverdata;
+    windowdata = (SDL_WindowData*)window->driverdata;
+    page = MALI_QueueFrame(_this, windowdata, SDL_TRUE, rects, numrects);
 
-    // First create the necessary fence
-    windowdata->surface[windowdata->flip_page].fence = _this->egl_data->eglCreateSyncKHR(_this->egl_data->egl_display, EGL_SYNC_FENCE_KHR, NULL);
-    SDL_LockMutex(windowdata->triplebuf_mutex);
+    egl_surface = windowdata->surface[page].egl_surface;
+    if (!_this->egl_data->eglMakeCurrent(_this->egl_data->egl_display, egl_surface, egl_surface, _this->current_glctx))
+        return SDL_EGL_SetError("Unable to make EGL context current", "eglMakeCurrent");
 
-    page = windowdata->new_page;
-    windowdata->new_page = windowdata->flip_page;
-    windowdata->flip_page = page;
+    return 0;
+}
+
+int
+MALI_GLES_GetFrameTimings(_THIS, SDL_Window * window, SDL_GLFrameTiming * timings, int maxtimings)
+{
+    int i, count;
+    SDL_WindowData *windowdata = (SDL_WindowData *)window->driverdata;
 
-    surf = windowdata->surface[windowdata->flip_page].egl_surface;
-    r = _this->egl_data->eglMakeCurrent(_this->egl_data->egl_display, surf, surf, _this->current_glctx);
+    if (!windowdata || !windowdata->displaydata->triplebuf_mutex)
+        return 0;
 
-    SDL_CondSignal(windowdata->triplebuf_cond);
-    SDL_UnlockMutex(windowdata->triplebuf_mutex);
+    SDL_LockMutex(windowdata->displaydata->triplebuf_mutex);
+    count = SDL_min(maxtimings, windowdata->timings_count);
+    for (i = 0; i < count; i++) {
+        timings[i] = windowdata->timings[(windowdata->timings_start + i) % MALI_MAX_FRAME_TIMINGS];
+    }
+    windowdata->timings_start = (windowdata->timings_start + count) % MALI_MAX_FRAME_TIMINGS;
+    windowdata->timings_count -= count;
+    SDL_UnlockMutex(windowdata->displaydata->triplebuf_mutex);
 
-    return r;
+    return count;
 }
 
 int
@@ -46,7 +147,7 @@ MALI_GLES_MakeCurrent(_THIS, SDL_Window * window, SDL_GLContext context)
     SDL_WindowData *windowdata;
     if (window) {
         windowdata = window->driverdata;
-        return SDL_EGL_MakeCurrent(_this, windowdata->surface[windowdata->flip_page].egl_surface, context);
+        return SDL_EGL_MakeCurrent(_this, windowdata->surface[windowdata->swapchain.rendering].egl_surface, context);
 
     } else {
         return SDL_EGL_MakeCurrent(_this, EGL_NO_SURFACE, context);
@@ -57,7 +158,7 @@ SDL_GLContext
 MALI_GLES_CreateContext(_THIS, SDL_Window * window)
 {
     SDL_WindowData *windowdata = (SDL_WindowData *)window->driverdata;
-    return SDL_EGL_CreateContext(_this, windowdata->surface[windowdata->new_page].egl_surface);
+    return SDL_EGL_CreateContext(_this, windowdata->surface[windowdata->swapchain.rendering].egl_surface);
 }
 
 #endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL */
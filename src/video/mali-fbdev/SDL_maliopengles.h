@@ -8,16 +8,22 @@
 #include "../SDL_sysvideo.h"
 #include "../SDL_egl_c.h"
 
+#include "SDL_malivideo.h"
+
 /* OpenGLES functions */
 #define MALI_GLES_GetAttribute SDL_EGL_GetAttribute
 #define MALI_GLES_GetProcAddress SDL_EGL_GetProcAddress
-#define MALI_GLES_UnloadLibrary SDL_EGL_UnloadLibrary
 #define MALI_GLES_DeleteContext SDL_EGL_DeleteContext
 
 int MALI_GLES_LoadLibrary(_THIS, const char *path);
+void MALI_GLES_UnloadLibrary(_THIS);
 SDL_GLContext MALI_GLES_CreateContext(_THIS, SDL_Window * window);
 int MALI_GLES_SwapWindow(_THIS, SDL_Window * window);
+int MALI_GLES_SwapWindowWithDamage(_THIS, SDL_Window * window, const SDL_Rect * rects, int numrects);
 int MALI_GLES_MakeCurrent(_THIS, SDL_Window * window, SDL_GLContext context);
+int MALI_GLES_GetFrameTimings(_THIS, SDL_Window * window, SDL_GLFrameTiming * timings, int maxtimings);
+void MALI_GLES_DestroyFence(_THIS, MALI_EGL_Surface *surf);
+int MALI_QueueFrame(_THIS, SDL_WindowData *windowdata, SDL_bool fence, const SDL_Rect *rects, int numrects);
 
 #endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL */
 
@@ -0,0 +1,349 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL
+
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "SDL_hints.h"
+#include "SDL_log.h"
+#include "SDL_rwops.h"
+
+#include "SDL_maliscaler.h"
+
+static const GLchar blit_frag_standard[] =
+"#version 100\n"
+"precision mediump float;"
+"varying vec2 vTexCoord;\n"
+"uniform sampler2D uFBOTex;\n"
+"uniform vec2 uTexSize;\n"
+"uniform vec2 uScale;\n"
+"void main() {\n"
+"   vec2 texel_floored = floor(vTexCoord);\n"
+"   gl_FragColor = texture2D(uFBOTex, vTexCoord);\n"
+"}\n";
+
+// Ported from TheMaister's sharp-bilinear-simple.slang
+static const GLchar blit_frag_bilinear_simple[] =
+"#version 100\n"
+"precision mediump float;"
+"varying vec2 vTexCoord;\n"
+"uniform sampler2D uFBOTex;\n"
+"uniform vec2 uTexSize;\n"
+"uniform vec2 uScale;\n"
+"void main() {\n"
+"   vec2 texel_floored = floor(vTexCoord);\n"
+"   vec2 s = fract(vTexCoord);\n"
+"   vec2 region_range = 0.5 - 0.5 / uScale;\n"
+"   vec2 center_dist = s - 0.5;\n"
+"   vec2 f = (center_dist - clamp(center_dist, -region_range, region_range)) * uScale + 0.5;\n"
+"   vec2 mod_texel = texel_floored + f;\n"
+"   gl_FragColor = texture2D(uFBOTex, mod_texel / uTexSize);\n"
+"}\n";
+
+// Ported from Iquilez
+static const GLchar blit_frag_quilez[] =
+"#version 100\n"
+"precision highp float;"
+"varying vec2 vTexCoord;\n"
+"uniform sampler2D uFBOTex;\n"
+"uniform vec2 uTexSize;\n"
+"uniform vec2 uScale;\n"
+"void main() {\n"
+"   vec2 p = vTexCoord + 0.5;"
+"   vec2 i = floor(p);"
+"   vec2 f = p - i;"
+"   f = f*f*f*(f*(f*6.0-15.0)+10.0);"
+"   p = i + f;"
+"   p = (p - 0.5)/uTexSize;"
+"   gl_FragColor = texture2D( uFBOTex, p );"
+"}\n";
+
+// Pixel coverage, a screen pixel straddling two texels gets both weighted by area
+static const GLchar blit_frag_area[] =
+"#version 100\n"
+"precision highp float;"
+"varying vec2 vTexCoord;\n"
+"uniform sampler2D uFBOTex;\n"
+"uniform vec2 uTexSize;\n"
+"uniform vec2 uScale;\n"
+"void main() {\n"
+"   vec2 footprint = 0.5 / uScale;\n"
+"   vec2 hi = vTexCoord + footprint;\n"
+"   vec2 edge = floor(hi);\n"
+"   vec2 w = clamp((hi - edge) / (2.0 * footprint), 0.0, 1.0);\n"
+"   gl_FragColor = texture2D(uFBOTex, (edge - 0.5 + w) / uTexSize);\n"
+"}\n";
+
+// Separable 4x4 Lanczos window, a = 2
+static const GLchar blit_frag_lanczos2[] =
+"#version 100\n"
+"precision highp float;"
+"varying vec2 vTexCoord;\n"
+"uniform sampler2D uFBOTex;\n"
+"uniform vec2 uTexSize;\n"
+"uniform vec2 uScale;\n"
+"vec4 lanczos2(vec4 x) {\n"
+"   vec4 px = max(abs(x) * 3.14159265, 1e-4);\n"
+"   return 2.0 * sin(px) * sin(px * 0.5) / (px * px);\n"
+"}\n"
+"void main() {\n"
+"   vec2 t = vTexCoord - 0.5;\n"
+"   vec2 f = fract(t);\n"
+"   vec2 base = floor(t) - 0.5;\n"
+"   vec4 wx = lanczos2(vec4(f.x + 1.0, f.x, 1.0 - f.x, 2.0 - f.x));\n"
+"   vec4 wy = lanczos2(vec4(f.y + 1.0, f.y, 1.0 - f.y, 2.0 - f.y));\n"
+"   vec3 color = vec3(0.0);\n"
+"   wx /= dot(wx, vec4(1.0));\n"
+"   wy /= dot(wy, vec4(1.0));\n"
+"   for (int j = 0; j < 4; j++) {\n"
+"      vec3 row = vec3(0.0);\n"
+"      for (int i = 0; i < 4; i++)\n"
+"         row += wx[i] * texture2D(uFBOTex, (base + vec2(float(i), float(j))) / uTexSize).rgb;\n"
+"      color += wy[j] * row;\n"
+"   }\n"
+"   gl_FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);\n"
+"}\n";
+
+// sharp-bilinear with darkened gaps between rows, faded out below 2x where there's no room for them
+static const GLchar blit_frag_crt_lite[] =
+"#version 100\n"
+"precision mediump float;"
+"varying vec2 vTexCoord;\n"
+"uniform sampler2D uFBOTex;\n"
+"uniform vec2 uTexSize;\n"
+"uniform vec2 uScale;\n"
+"void main() {\n"
+"   vec2 texel_floored = floor(vTexCoord);\n"
+"   vec2 region_range = 0.5 - 0.5 / uScale;\n"
+"   vec2 center_dist = fract(vTexCoord) - 0.5;\n"
+"   vec2 f = (center_dist - clamp(center_dist, -region_range, region_range)) * uScale + 0.5;\n"
+"   vec3 color = texture2D(uFBOTex, (texel_floored + f) / uTexSize).rgb;\n"
+"   float scan = 1.0 - 2.0 * center_dist.y * center_dist.y;\n"
+"   scan = mix(1.0, scan, clamp(uScale.y - 1.0, 0.0, 1.0));\n"
+"   gl_FragColor = vec4(min(color * scan * 1.15, 1.0), 1.0);\n"
+"}\n";
+
+static const MALI_Scaler builtin_scalers[] = {
+    { "nearest",          blit_frag_standard,         SDL_FALSE, SDL_FALSE, SDL_FALSE },
+    { "sharp-bilinear",   blit_frag_bilinear_simple,  SDL_TRUE,  SDL_TRUE,  SDL_FALSE },
+    { "quilez",           blit_frag_quilez,           SDL_TRUE,  SDL_TRUE,  SDL_FALSE },
+    { "integer-nearest",  blit_frag_standard,         SDL_FALSE, SDL_FALSE, SDL_TRUE  },
+    { "area",             blit_frag_area,             SDL_TRUE,  SDL_TRUE,  SDL_FALSE },
+    { "lanczos2",         blit_frag_lanczos2,         SDL_TRUE,  SDL_FALSE, SDL_FALSE },
+    { "crt-lite",         blit_frag_crt_lite,         SDL_TRUE,  SDL_TRUE,  SDL_FALSE },
+};
+
+static const MALI_Scaler *scalers[MALI_SCALER_MAX] = {
+    &builtin_scalers[0], &builtin_scalers[1], &builtin_scalers[2], &builtin_scalers[3],
+    &builtin_scalers[4], &builtin_scalers[5], &builtin_scalers[6],
+};
+static int num_scalers = SDL_arraysize(builtin_scalers);
+
+int
+MALI_Scaler_Register(const MALI_Scaler *scaler)
+{
+    if (MALI_Scaler_Find(scaler->name))
+        return SDL_SetError("mali-fbdev: Scaler '%s' already registered", scaler->name);
+    if (num_scalers == MALI_SCALER_MAX)
+        return SDL_SetError("mali-fbdev: Too many scalers");
+
+    scalers[num_scalers] = scaler;
+    return num_scalers++;
+}
+
+const MALI_Scaler *
+MALI_Scaler_Find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < num_scalers; i++) {
+        if (SDL_strcasecmp(scalers[i]->name, name) == 0)
+            return scalers[i];
+    }
+
+    return NULL;
+}
+
+const MALI_Scaler *
+MALI_Scaler_FromHint(const char *hint)
+{
+    const MALI_Scaler *scaler;
+    const char *legacy;
+
+    if (hint && *hint) {
+        scaler = MALI_Scaler_Find(hint);
+        if (scaler)
+            return scaler;
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Unknown scaler '%s', using nearest", hint);
+        return scalers[0];
+    }
+
+    /* Older releases only knew the two HQ scalers by number */
+    legacy = SDL_getenv("SDL_MALI_HQ_SCALER");
+    if (legacy && *legacy == '1')
+        return MALI_Scaler_Find("sharp-bilinear");
+    if (legacy && *legacy == '2')
+        return MALI_Scaler_Find("quilez");
+
+    return scalers[0];
+}
+
+int
+MALI_Scaler_GetIndex(const MALI_Scaler *scaler)
+{
+    int i;
+
+    for (i = 0; i < num_scalers; i++) {
+        if (scalers[i] == scaler)
+            return i;
+    }
+
+    return -1;
+}
+
+/* Header in front of every cached program binary */
+typedef struct MALI_ProgramCacheHeader
+{
+    Uint32 magic;
+    Uint32 format;
+    Uint32 length;
+} MALI_ProgramCacheHeader;
+
+#define MALI_PROGRAM_CACHE_MAGIC 0x4250434d /* "MCPB" */
+
+char *
+MALI_ProgramCache_GetDir(void)
+{
+    const char *hint, *base;
+    char *dir;
+    size_t len;
+
+    /* An empty hint turns caching off */
+    hint = SDL_GetHint(SDL_HINT_MALI_SHADER_CACHE);
+    if (hint)
+        return *hint ? SDL_strdup(hint) : NULL;
+
+    if ((base = SDL_getenv("XDG_CACHE_HOME")) != NULL && *base) {
+        len = SDL_strlen(base) + 16;
+        dir = SDL_malloc(len);
+        if (!dir)
+            return NULL;
+        SDL_snprintf(dir, len, "%s/sdl2-mali", base);
+    } else if ((base = SDL_getenv("HOME")) != NULL && *base) {
+        len = SDL_strlen(base) + 24;
+        dir = SDL_malloc(len);
+        if (!dir)
+            return NULL;
+        SDL_snprintf(dir, len, "%s/.cache", base);
+        mkdir(dir, 0700);
+        SDL_strlcat(dir, "/sdl2-mali", len);
+    } else {
+        return NULL;
+    }
+
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Can't create shader cache %s", dir);
+        SDL_free(dir);
+        return NULL;
+    }
+
+    return dir;
+}
+
+static Uint64
+MALI_ProgramCache_Hash(Uint64 hash, const void *data)
+{
+    const Uint8 *p = data;
+
+    /* FNV-1a, the terminator is hashed too so the fields can't run into each other */
+    if (p == NULL)
+        return hash;
+
+    do {
+        hash ^= *p;
+        hash *= 0x100000001b3ULL;
+    } while (*p++);
+
+    return hash;
+}
+
+Uint64
+MALI_ProgramCache_Key(const GLchar *vert, const GLchar *frag, const GLubyte *renderer, const GLubyte *version)
+{
+    Uint64 hash = 0xcbf29ce484222325ULL;
+
+    hash = MALI_ProgramCache_Hash(hash, vert);
+    hash = MALI_ProgramCache_Hash(hash, frag);
+    hash = MALI_ProgramCache_Hash(hash, renderer);
+    hash = MALI_ProgramCache_Hash(hash, version);
+    return hash;
+}
+
+static void
+MALI_ProgramCache_Path(char *path, size_t len, const char *dir, Uint64 key, const char *suffix)
+{
+    SDL_snprintf(path, len, "%s/%016" SDL_PRIx64 ".bin%s", dir, key, suffix);
+}
+
+void *
+MALI_ProgramCache_Load(const char *dir, Uint64 key, GLenum *format, GLsizei *length)
+{
+    MALI_ProgramCacheHeader header;
+    char path[4096];
+    SDL_RWops *rw;
+    void *binary = NULL;
+
+    MALI_ProgramCache_Path(path, sizeof(path), dir, key, "");
+    rw = SDL_RWFromFile(path, "rb");
+    if (!rw)
+        return NULL;
+
+    if (SDL_RWread(rw, &header, sizeof(header), 1) == 1 &&
+        header.magic == MALI_PROGRAM_CACHE_MAGIC &&
+        header.length > 0 &&
+        (Sint64)(header.length + sizeof(header)) == SDL_RWsize(rw)) {
+        binary = SDL_malloc(header.length);
+        if (binary && SDL_RWread(rw, binary, header.length, 1) != 1) {
+            SDL_free(binary);
+            binary = NULL;
+        }
+    }
+
+    SDL_RWclose(rw);
+
+    if (binary) {
+        *format = header.format;
+        *length = header.length;
+    }
+
+    return binary;
+}
+
+void
+MALI_ProgramCache_Store(const char *dir, Uint64 key, GLenum format, const void *binary, GLsizei length)
+{
+    MALI_ProgramCacheHeader header = { MALI_PROGRAM_CACHE_MAGIC, format, length };
+    char path[4096], tmp[4096];
+    SDL_RWops *rw;
+    SDL_bool ok;
+
+    /* Write aside and rename, so a concurrent or interrupted writer never leaves a torn binary */
+    MALI_ProgramCache_Path(path, sizeof(path), dir, key, "");
+    MALI_ProgramCache_Path(tmp, sizeof(tmp), dir, key, ".tmp");
+    rw = SDL_RWFromFile(tmp, "wb");
+    if (!rw)
+        return;
+
+    ok = SDL_RWwrite(rw, &header, sizeof(header), 1) == 1 &&
+         SDL_RWwrite(rw, binary, length, 1) == 1;
+    ok = (SDL_RWclose(rw) == 0) && ok;
+
+    if (!ok || rename(tmp, path) != 0) {
+        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Failed to store program binary %s", path);
+        remove(tmp);
+    }
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL */
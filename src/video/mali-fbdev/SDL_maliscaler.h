@@ -0,0 +1,42 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_maliscaler_h
+#define _SDL_maliscaler_h
+
+#if SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL
+
+#include "SDL_opengl.h"
+
+#define MALI_SCALER_MAX 16
+
+/* Attribute slots are fixed so every scaler program works with the same VAO */
+#define MALI_ATTRIB_VERTCOORD 0
+#define MALI_ATTRIB_TEXCOORD  1
+
+/*
+ * A fragment shader used by the blitter to scale the application's pages
+ * onto the display. The shader gets vTexCoord, uFBOTex, uTexSize and uScale.
+ */
+typedef struct MALI_Scaler
+{
+    const char *name;
+    const GLchar *frag;
+    SDL_bool texel_coords;      /* vTexCoord in texels instead of normalized coordinates */
+    SDL_bool linear;            /* sample the pages with bilinear filtering */
+    SDL_bool integer_scale;     /* only scale the quad by whole multiples when possible */
+} MALI_Scaler;
+
+int MALI_Scaler_Register(const MALI_Scaler *scaler);
+const MALI_Scaler *MALI_Scaler_Find(const char *name);
+const MALI_Scaler *MALI_Scaler_FromHint(const char *hint);
+int MALI_Scaler_GetIndex(const MALI_Scaler *scaler);
+
+/* Program binary cache, keyed on the shader sources and the GL driver */
+char *MALI_ProgramCache_GetDir(void);
+Uint64 MALI_ProgramCache_Key(const GLchar *vert, const GLchar *frag, const GLubyte *renderer, const GLubyte *version);
+void *MALI_ProgramCache_Load(const char *dir, Uint64 key, GLenum *format, GLsizei *length);
+void MALI_ProgramCache_Store(const char *dir, Uint64 key, GLenum format, const void *binary, GLsizei length);
+
+#endif /* SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL */
+
+#endif /* _SDL_maliscaler_h */
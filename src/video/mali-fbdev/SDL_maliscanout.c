@@ -0,0 +1,219 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "SDL_error.h"
+#include "SDL_pixels.h"
+
+#include "SDL_maliscanout.h"
+
+/* Exposed by the Amlogic and Rockchip framebuffer drivers */
+#ifndef FBIOGET_DMABUF
+struct fb_dmabuf_export
+{
+    __u32 fd;
+    __u32 flags;
+};
+#define FBIOGET_DMABUF _IOR('F', 0x21, struct fb_dmabuf_export)
+#endif
+
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC _IOW('F', 0x20, __u32)
+#endif
+
+static int
+MALI_FBDEV_GetFix(int fd, struct fb_fix_screeninfo *finfo)
+{
+    return ioctl(fd, FBIOGET_FSCREENINFO, finfo);
+}
+
+static int
+MALI_FBDEV_PutVar(int fd, struct fb_var_screeninfo *vinfo)
+{
+    return ioctl(fd, FBIOPUT_VSCREENINFO, vinfo);
+}
+
+static int
+MALI_FBDEV_Pan(int fd, struct fb_var_screeninfo *vinfo)
+{
+    return ioctl(fd, FBIOPAN_DISPLAY, vinfo);
+}
+
+static int
+MALI_FBDEV_WaitVSync(int fd)
+{
+    __u32 crtc = 0;
+    return ioctl(fd, FBIO_WAITFORVSYNC, &crtc);
+}
+
+static int
+MALI_FBDEV_ExportDMABuf(int fd)
+{
+    struct fb_dmabuf_export dmabuf = { .fd = 0, .flags = O_CLOEXEC };
+
+    if (ioctl(fd, FBIOGET_DMABUF, &dmabuf) < 0)
+        return -1;
+
+    return (int)dmabuf.fd;
+}
+
+const MALI_ScanoutOps MALI_FBDEV_ScanoutOps = {
+    MALI_FBDEV_GetFix,
+    MALI_FBDEV_PutVar,
+    MALI_FBDEV_Pan,
+    MALI_FBDEV_WaitVSync,
+    MALI_FBDEV_ExportDMABuf
+};
+
+static SDL_bool
+MALI_Scanout_MatchesMask(const struct fb_bitfield *field, Uint32 mask)
+{
+    /* Not every driver fills in the lengths, where the component starts is what matters */
+    return mask != 0 && (mask & (~mask + 1)) == (1u << field->offset);
+}
+
+SDL_bool
+MALI_Scanout_CanUse(const struct fb_var_screeninfo *vinfo, const struct fb_fix_screeninfo *finfo,
+                    Uint32 format, int width, int height, int rotation, int depth)
+{
+    int bpp;
+    Uint32 rmask, gmask, bmask, amask;
+
+    /* Nothing to scale or rotate, the GPU renders exactly what the panel shows */
+    if (rotation != 0 || width != (int)vinfo->xres || height != (int)vinfo->yres)
+        return SDL_FALSE;
+
+    /* The framebuffer has to scan the pixmaps out as is */
+    if (!SDL_PixelFormatEnumToMasks(format, &bpp, &rmask, &gmask, &bmask, &amask))
+        return SDL_FALSE;
+
+    if (vinfo->bits_per_pixel != (Uint32)bpp || !MALI_Scanout_MatchesMask(&vinfo->red, rmask) ||
+        !MALI_Scanout_MatchesMask(&vinfo->green, gmask) || !MALI_Scanout_MatchesMask(&vinfo->blue, bmask))
+        return SDL_FALSE;
+
+    /* Mali wants its pixmap rows aligned, and every page has to fit in video memory */
+    if (finfo->line_length % 64 != 0 || finfo->line_length < (Uint32)(width * bpp / 8))
+        return SDL_FALSE;
+
+    if ((Uint64)finfo->line_length * vinfo->yres * depth > finfo->smem_len)
+        return SDL_FALSE;
+
+    return SDL_TRUE;
+}
+
+int
+MALI_Scanout_Init(MALI_Scanout *scanout, const MALI_ScanoutOps *ops, int fb_fd, const struct fb_var_screeninfo *vinfo,
+                  Uint32 format, int width, int height, int rotation, int depth)
+{
+    struct fb_fix_screeninfo finfo;
+
+    SDL_zerop(scanout);
+    scanout->backend = MALI_SCANOUT_FBDEV;
+    scanout->ops = ops;
+    scanout->fb_fd = fb_fd;
+    scanout->dmabuf_fd = -1;
+    scanout->depth = depth;
+    scanout->vinfo = *vinfo;
+
+    if (ops->get_fix(fb_fd, &finfo) < 0)
+        return SDL_SetError("mali-fbdev: Could not get fixed framebuffer information");
+
+    if (!MALI_Scanout_CanUse(vinfo, &finfo, format, width, height, rotation, depth))
+        return SDL_SetError("mali-fbdev: Framebuffer layout not suitable for direct scanout");
+
+    scanout->dmabuf_fd = ops->export_dmabuf(fb_fd);
+    if (scanout->dmabuf_fd < 0)
+        return SDL_SetError("mali-fbdev: Framebuffer can't be exported as a DMA_BUF");
+
+    /* Make room for every page below the visible one */
+    scanout->vinfo.yoffset = 0;
+    scanout->vinfo.yres_virtual = vinfo->yres * depth;
+    if (ops->put_var(fb_fd, &scanout->vinfo) < 0) {
+        MALI_Scanout_Quit(scanout);
+        return SDL_SetError("mali-fbdev: Could not resize the virtual framebuffer");
+    }
+
+    scanout->stride = finfo.line_length;
+    scanout->page_size = finfo.line_length * vinfo->yres;
+    return 0;
+}
+
+/* The display takes the swap chain's pages as they are, nothing to carve out of video memory */
+int
+MALI_Scanout_InitDRM(MALI_Scanout *scanout, const MALI_DRMOps *ops, const char *path, Uint32 fourcc,
+                     int width, int height, int rotation, int depth)
+{
+    SDL_zerop(scanout);
+    scanout->backend = MALI_SCANOUT_DRM;
+    scanout->fb_fd = -1;
+    scanout->dmabuf_fd = -1;
+    scanout->depth = depth;
+
+    if (MALI_DRM_Open(&scanout->drm, ops, path) < 0)
+        return -1;
+
+    if (rotation != 0 || width != scanout->drm.mode.hdisplay || height != scanout->drm.mode.vdisplay) {
+        SDL_SetError("mali-fbdev: Window doesn't match the %ux%u DRM mode", scanout->drm.mode.hdisplay,
+                     scanout->drm.mode.vdisplay);
+        MALI_DRM_Close(&scanout->drm);
+        return -1;
+    }
+
+    if (!MALI_DRM_HasFormat(&scanout->drm, fourcc)) {
+        MALI_DRM_Close(&scanout->drm);
+        return SDL_SetError("mali-fbdev: DRM plane can't scan out the pages' format");
+    }
+
+    return 0;
+}
+
+/* DRM needs every page as a framebuffer of its own, the framebuffer's slices are known already */
+int
+MALI_Scanout_AddPage(MALI_Scanout *scanout, int page, int dmabuf_fd, int width, int height, int pitch, Uint32 fourcc)
+{
+    if (scanout->backend != MALI_SCANOUT_DRM)
+        return 0;
+
+    return MALI_DRM_AddPage(&scanout->drm, page, dmabuf_fd, width, height, pitch, 0, fourcc);
+}
+
+Uint32
+MALI_Scanout_GetPageOffset(const MALI_Scanout *scanout, int page)
+{
+    return scanout->page_size * page;
+}
+
+int
+MALI_Scanout_Present(MALI_Scanout *scanout, int page, SDL_bool vsync)
+{
+    if (scanout->backend == MALI_SCANOUT_DRM)
+        return MALI_DRM_Present(&scanout->drm, page, vsync);
+
+    scanout->vinfo.yoffset = scanout->vinfo.yres * page;
+    if (scanout->ops->pan(scanout->fb_fd, &scanout->vinfo) < 0)
+        return -1;
+
+    /* The page we flipped away from may still be scanned out until the next refresh */
+    if (vsync)
+        scanout->ops->wait_vsync(scanout->fb_fd);
+
+    return 0;
+}
+
+void
+MALI_Scanout_Quit(MALI_Scanout *scanout)
+{
+    if (scanout->backend == MALI_SCANOUT_DRM)
+        MALI_DRM_Close(&scanout->drm);
+
+    if (scanout->dmabuf_fd >= 0) {
+        close(scanout->dmabuf_fd);
+        scanout->dmabuf_fd = -1;
+    }
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
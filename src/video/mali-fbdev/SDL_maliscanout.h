@@ -0,0 +1,67 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_maliscanout_h
+#define _SDL_maliscanout_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <linux/fb.h>
+
+#include "SDL_stdinc.h"
+
+#include "SDL_malidrm.h"
+
+/*
+ * Low level framebuffer access, the fbdev implementation is used on device
+ * while tests plug in their own to exercise the scanout logic without hardware.
+ */
+typedef struct MALI_ScanoutOps
+{
+    int (*get_fix)(int fd, struct fb_fix_screeninfo *finfo);
+    int (*put_var)(int fd, struct fb_var_screeninfo *vinfo);
+    int (*pan)(int fd, struct fb_var_screeninfo *vinfo);
+    int (*wait_vsync)(int fd);
+    int (*export_dmabuf)(int fd);
+} MALI_ScanoutOps;
+
+extern const MALI_ScanoutOps MALI_FBDEV_ScanoutOps;
+
+typedef enum MALI_ScanoutBackend
+{
+    MALI_SCANOUT_FBDEV = 0,
+    MALI_SCANOUT_DRM
+} MALI_ScanoutBackend;
+
+/*
+ * Direct scanout renders straight into the framebuffer: with fbdev every swap
+ * chain page is a yres tall slice of the virtual framebuffer and presenting one
+ * is a pan, with DRM the pages are the swap chain's own buffers and presenting
+ * one is an atomic flip. No GPU blit is involved either way.
+ */
+typedef struct MALI_Scanout
+{
+    MALI_ScanoutBackend backend;
+    MALI_DRM drm;
+    const MALI_ScanoutOps *ops;
+    int fb_fd;
+    int dmabuf_fd;
+    int depth;
+    Uint32 stride;
+    Uint32 page_size;
+    struct fb_var_screeninfo vinfo;
+} MALI_Scanout;
+
+SDL_bool MALI_Scanout_CanUse(const struct fb_var_screeninfo *vinfo, const struct fb_fix_screeninfo *finfo,
+                             Uint32 format, int width, int height, int rotation, int depth);
+int MALI_Scanout_Init(MALI_Scanout *scanout, const MALI_ScanoutOps *ops, int fb_fd, const struct fb_var_screeninfo *vinfo,
+                      Uint32 format, int width, int height, int rotation, int depth);
+int MALI_Scanout_InitDRM(MALI_Scanout *scanout, const MALI_DRMOps *ops, const char *path, Uint32 fourcc,
+                         int width, int height, int rotation, int depth);
+int MALI_Scanout_AddPage(MALI_Scanout *scanout, int page, int dmabuf_fd, int width, int height, int pitch, Uint32 fourcc);
+Uint32 MALI_Scanout_GetPageOffset(const MALI_Scanout *scanout, int page);
+int MALI_Scanout_Present(MALI_Scanout *scanout, int page, SDL_bool vsync);
+void MALI_Scanout_Quit(MALI_Scanout *scanout);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_maliscanout_h */
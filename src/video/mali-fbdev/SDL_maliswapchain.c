@@ -0,0 +1,236 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+
+#include "SDL_maliswapchain.h"
+
+int
+MALI_SwapChain_GetDepthHint(void)
+{
+    const char *hint = SDL_GetHint(SDL_HINT_MALI_SWAPCHAIN_DEPTH);
+    int depth;
+
+    if (!hint || !*hint)
+        return MALI_SWAPCHAIN_DEFAULT_DEPTH;
+
+    depth = SDL_atoi(hint);
+    return SDL_clamp(depth, MALI_SWAPCHAIN_MIN_DEPTH, MALI_SWAPCHAIN_MAX_DEPTH);
+}
+
+MALI_PresentMode
+MALI_SwapChain_GetPresentModeHint(void)
+{
+    const char *hint = SDL_GetHint(SDL_HINT_MALI_PRESENT_MODE);
+
+    if (hint && SDL_strcasecmp(hint, "fifo") == 0)
+        return MALI_PRESENT_FIFO;
+
+    return MALI_PRESENT_MAILBOX;
+}
+
+void
+MALI_SwapChain_Init(MALI_SwapChain *chain, int depth, MALI_PresentMode mode)
+{
+    SDL_zerop(chain);
+    chain->depth = SDL_clamp(depth, MALI_SWAPCHAIN_MIN_DEPTH, MALI_SWAPCHAIN_MAX_DEPTH);
+    chain->mode = mode;
+    chain->presenting = -1;
+    chain->retiring = -1;
+
+    /* The application starts out drawing into the first page */
+    chain->rendering = 0;
+    chain->state[0] = MALI_PAGE_RENDERING;
+
+    /*
+     * A lock-free chain starts with the second page in ready and the blitter holding
+     * the last one, the exchange always needs a page to give back.
+     */
+    if (chain->mode == MALI_PRESENT_MAILBOX && chain->depth == 3) {
+        chain->lockfree = SDL_TRUE;
+        SDL_AtomicSet(&chain->ready, 1);
+        chain->presenting = 2;
+        chain->state[2] = MALI_PAGE_PRESENTING;
+    }
+}
+
+void
+MALI_SwapChain_DeferRelease(MALI_SwapChain *chain)
+{
+    /* The exchange hands the shown page straight back, which a page still being scanned out can't be */
+    if (chain->lockfree) {
+        chain->lockfree = SDL_FALSE;
+        chain->state[chain->presenting] = MALI_PAGE_FREE;
+        chain->presenting = -1;
+    }
+    chain->defer_release = SDL_TRUE;
+}
+
+/*
+ * Returns SDL_TRUE when the blitter may be waiting for this frame. A lock-free chain
+ * only says so when the frame didn't replace one the blitter hadn't seen yet.
+ */
+SDL_bool
+MALI_SwapChain_Queue(MALI_SwapChain *chain)
+{
+    int page = chain->rendering, old;
+    if (page < 0)
+        return SDL_FALSE;
+
+    chain->state[page] = MALI_PAGE_QUEUED;
+    chain->sequence[page] = chain->next_sequence++;
+    chain->rendering = -1;
+
+    if (!chain->lockfree)
+        return SDL_TRUE;
+
+    /* Publish the frame and take whatever was in ready as the next page to draw into */
+    old = SDL_AtomicSet(&chain->ready, page | MALI_SWAPCHAIN_NEW_FRAME);
+    page = old & MALI_SWAPCHAIN_PAGE_MASK;
+    chain->state[page] = MALI_PAGE_RENDERING;
+    chain->rendering = page;
+
+    if (old & MALI_SWAPCHAIN_NEW_FRAME) {
+        chain->frames_dropped++;
+        return SDL_FALSE;
+    }
+    return SDL_TRUE;
+}
+
+static int
+MALI_SwapChain_FindQueued(const MALI_SwapChain *chain, SDL_bool newest, int *count)
+{
+    int i, found = -1, queued = 0;
+
+    for (i = 0; i < chain->depth; i++) {
+        if (chain->state[i] != MALI_PAGE_QUEUED)
+            continue;
+
+        queued++;
+        if (found < 0) {
+            found = i;
+        } else {
+            /* Compare through the difference so sequence wraparound is harmless */
+            Sint32 delta = (Sint32)(chain->sequence[i] - chain->sequence[found]);
+            if ((newest && delta > 0) || (!newest && delta < 0))
+                found = i;
+        }
+    }
+
+    if (count)
+        *count = queued;
+    return found;
+}
+
+int
+MALI_SwapChain_AcquireRender(MALI_SwapChain *chain)
+{
+    int i, page = -1, queued;
+
+    if (chain->rendering >= 0)
+        return chain->rendering;
+
+    for (i = 0; i < chain->depth; i++) {
+        if (chain->state[i] == MALI_PAGE_FREE) {
+            page = i;
+            break;
+        }
+    }
+
+    /*
+     * Out of free pages, in mailbox mode steal back the oldest frame the blitter hasn't
+     * picked up yet, it would have been skipped anyway. The newest queued frame is never
+     * stolen, so the blitter always has something to show and shallow chains simply wait
+     * instead. FIFO never drops frames, the application has to wait for the blitter.
+     */
+    if (page < 0) {
+        if (chain->mode == MALI_PRESENT_FIFO)
+            return -1;
+
+        page = MALI_SwapChain_FindQueued(chain, SDL_FALSE, &queued);
+        if (queued < 2)
+            return -1;
+
+        chain->frames_dropped++;
+    }
+
+    chain->state[page] = MALI_PAGE_RENDERING;
+    chain->rendering = page;
+    return page;
+}
+
+SDL_bool
+MALI_SwapChain_HasQueued(const MALI_SwapChain *chain)
+{
+    if (chain->lockfree)
+        return (SDL_AtomicGet((SDL_atomic_t *)&chain->ready) & MALI_SWAPCHAIN_NEW_FRAME) ? SDL_TRUE : SDL_FALSE;
+
+    return MALI_SwapChain_FindQueued(chain, SDL_TRUE, NULL) >= 0;
+}
+
+int
+MALI_SwapChain_AcquirePresent(MALI_SwapChain *chain)
+{
+    int i, page;
+
+    if (chain->lockfree) {
+        if (!MALI_SwapChain_HasQueued(chain))
+            return -1;
+
+        /* Only the blitter clears the flag, so the newest frame is guaranteed to be there */
+        chain->state[chain->presenting] = MALI_PAGE_FREE;
+        page = SDL_AtomicSet(&chain->ready, chain->presenting) & MALI_SWAPCHAIN_PAGE_MASK;
+        chain->state[page] = MALI_PAGE_PRESENTING;
+        chain->presenting = page;
+        chain->frames_presented++;
+        return page;
+    }
+
+    page = MALI_SwapChain_FindQueued(chain, chain->mode == MALI_PRESENT_MAILBOX, NULL);
+    if (page < 0)
+        return -1;
+
+    /* In mailbox mode anything older than the newest frame will never be shown */
+    if (chain->mode == MALI_PRESENT_MAILBOX) {
+        for (i = 0; i < chain->depth; i++) {
+            if (chain->state[i] == MALI_PAGE_QUEUED && i != page) {
+                chain->state[i] = MALI_PAGE_FREE;
+                chain->frames_dropped++;
+            }
+        }
+    }
+
+    if (chain->presenting >= 0) {
+        if (chain->defer_release) {
+            MALI_SwapChain_ReleasePrevious(chain);
+            chain->retiring = chain->presenting;
+        } else {
+            chain->state[chain->presenting] = MALI_PAGE_FREE;
+        }
+    }
+
+    chain->state[page] = MALI_PAGE_PRESENTING;
+    chain->presenting = page;
+    chain->frames_presented++;
+    return page;
+}
+
+void
+MALI_SwapChain_ReleasePrevious(MALI_SwapChain *chain)
+{
+    if (chain->retiring < 0)
+        return;
+
+    chain->state[chain->retiring] = MALI_PAGE_FREE;
+    chain->retiring = -1;
+}
+
+void
+MALI_SwapChain_AddRepeats(MALI_SwapChain *chain, int refreshes)
+{
+    if (refreshes > 0)
+        chain->frames_repeated += refreshes;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
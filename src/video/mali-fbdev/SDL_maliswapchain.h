@@ -0,0 +1,89 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_maliswapchain_h
+#define _SDL_maliswapchain_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_stdinc.h"
+#include "SDL_atomic.h"
+
+#define MALI_SWAPCHAIN_MIN_DEPTH     2
+#define MALI_SWAPCHAIN_MAX_DEPTH     8
+#define MALI_SWAPCHAIN_DEFAULT_DEPTH 3
+
+/*
+ * Every pixmap page is owned by exactly one party at a time: the application
+ * renders into a single RENDERING page, swapped pages wait as QUEUED until the
+ * blitter thread picks them up, and the blitter holds on to its PRESENTING page
+ * until a newer one replaces it on screen.
+ */
+typedef enum MALI_PageState
+{
+    MALI_PAGE_FREE = 0,
+    MALI_PAGE_RENDERING,
+    MALI_PAGE_QUEUED,
+    MALI_PAGE_PRESENTING
+} MALI_PageState;
+
+/*
+ * MAILBOX always shows the newest frame and recycles stale ones, FIFO shows every
+ * frame exactly once in order and throttles the application instead.
+ */
+typedef enum MALI_PresentMode
+{
+    MALI_PRESENT_MAILBOX = 0,
+    MALI_PRESENT_FIFO
+} MALI_PresentMode;
+
+/* The page handed over through MALI_SwapChain::ready, flagged until the blitter took it */
+#define MALI_SWAPCHAIN_PAGE_MASK 0xff
+#define MALI_SWAPCHAIN_NEW_FRAME 0x100
+
+typedef struct MALI_SwapChain
+{
+    int depth;
+    MALI_PresentMode mode;
+    int rendering;
+    int presenting;
+
+    /* With direct scanout the replaced page stays on screen until the flip lands, so it's released separately */
+    SDL_bool defer_release;
+    int retiring;
+    Uint32 next_sequence;
+    MALI_PageState state[MALI_SWAPCHAIN_MAX_DEPTH];
+    Uint32 sequence[MALI_SWAPCHAIN_MAX_DEPTH];
+
+    /*
+     * Mailbox with three pages is the classic lock-free triple buffer: the application
+     * and the blitter each own a page and swap it for the one in ready, which only ever
+     * changes hands through an atomic exchange. Neither side has to hold a lock for it.
+     */
+    SDL_bool lockfree;
+    SDL_atomic_t ready;
+
+    /* Statistics, frames handed to the blitter, never shown, and refreshes that showed an old frame */
+    Uint64 frames_presented;
+    Uint64 frames_dropped;
+    Uint64 frames_repeated;
+} MALI_SwapChain;
+
+/*
+ * None of these lock, callers are expected to serialize access to the chain. The
+ * exception is a lock-free chain, where the application may call Queue and
+ * AcquireRender while the blitter calls HasQueued and AcquirePresent.
+ */
+int MALI_SwapChain_GetDepthHint(void);
+MALI_PresentMode MALI_SwapChain_GetPresentModeHint(void);
+void MALI_SwapChain_Init(MALI_SwapChain *chain, int depth, MALI_PresentMode mode);
+void MALI_SwapChain_DeferRelease(MALI_SwapChain *chain);
+SDL_bool MALI_SwapChain_Queue(MALI_SwapChain *chain);
+int MALI_SwapChain_AcquireRender(MALI_SwapChain *chain);
+SDL_bool MALI_SwapChain_HasQueued(const MALI_SwapChain *chain);
+int MALI_SwapChain_AcquirePresent(MALI_SwapChain *chain);
+void MALI_SwapChain_ReleasePrevious(MALI_SwapChain *chain);
+void MALI_SwapChain_AddRepeats(MALI_SwapChain *chain, int refreshes);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_maliswapchain_h */
@@ -0,0 +1,99 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+#include "SDL_log.h"
+#include "SDL_timer.h"
+
+#include "SDL_malitelemetry.h"
+
+void
+MALI_Telemetry_Init(MALI_Telemetry *telemetry)
+{
+    const char *hint;
+
+    SDL_zerop(telemetry);
+    telemetry->measure_gpu = SDL_GetHintBoolean(SDL_HINT_MALI_TELEMETRY, SDL_FALSE);
+
+    hint = SDL_GetHint(SDL_HINT_MALI_TELEMETRY_LOG_INTERVAL);
+    if (hint && SDL_atoi(hint) > 0) {
+        telemetry->log_interval = SDL_GetPerformanceFrequency() * SDL_atoi(hint) / 1000;
+        telemetry->next_log = SDL_GetPerformanceCounter() + telemetry->log_interval;
+    }
+}
+
+static void
+MALI_Telemetry_Accumulate(Uint64 *sum, Uint64 *max, Uint64 start, Uint64 end)
+{
+    Uint64 delta;
+
+    /* Stages the driver didn't reach are left at zero */
+    if (start == 0 || end < start)
+        return;
+
+    delta = end - start;
+    *sum += delta;
+    if (delta > *max)
+        *max = delta;
+}
+
+static double
+MALI_Telemetry_ToMS(Uint64 ticks)
+{
+    return (double)ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void
+MALI_Telemetry_Record(MALI_Telemetry *telemetry, const SDL_GLFrameTiming *timing)
+{
+    Uint32 frames;
+
+    if (telemetry->log_interval == 0)
+        return;
+
+    telemetry->frames++;
+    telemetry->missed_vsyncs += timing->missed_vsyncs;
+    MALI_Telemetry_Accumulate(&telemetry->latency_sum, &telemetry->latency_max, timing->swap_requested, timing->swap_returned);
+    MALI_Telemetry_Accumulate(&telemetry->blit_gpu_sum, &telemetry->blit_gpu_max, timing->blit_done, timing->blit_gpu_done);
+    MALI_Telemetry_Accumulate(&telemetry->fence_wait_sum, &telemetry->fence_wait_max, timing->fence_wait_start, timing->fence_signaled);
+
+    if (timing->swap_returned < telemetry->next_log)
+        return;
+
+    frames = telemetry->frames;
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO,
+        "mali-fbdev: %u frames, latency %.2f/%.2f ms, blit GPU %.2f/%.2f ms, fence wait %.2f/%.2f ms (avg/max), %u missed vsyncs",
+        frames,
+        MALI_Telemetry_ToMS(telemetry->latency_sum / frames), MALI_Telemetry_ToMS(telemetry->latency_max),
+        MALI_Telemetry_ToMS(telemetry->blit_gpu_sum / frames), MALI_Telemetry_ToMS(telemetry->blit_gpu_max),
+        MALI_Telemetry_ToMS(telemetry->fence_wait_sum / frames), MALI_Telemetry_ToMS(telemetry->fence_wait_max),
+        telemetry->missed_vsyncs);
+
+    telemetry->frames = 0;
+    telemetry->missed_vsyncs = 0;
+    telemetry->latency_sum = telemetry->latency_max = 0;
+    telemetry->blit_gpu_sum = telemetry->blit_gpu_max = 0;
+    telemetry->fence_wait_sum = telemetry->fence_wait_max = 0;
+    telemetry->next_log = timing->swap_returned + telemetry->log_interval;
+}
+
+static double
+MALI_Telemetry_SinceStart(const MALI_StartupTiming *startup, Uint64 timestamp)
+{
+    return timestamp > startup->create_window ? MALI_Telemetry_ToMS(timestamp - startup->create_window) : 0.0;
+}
+
+/* Everything is measured from MALI_CreateWindow, the pages and the blitter come up side by side */
+void
+MALI_Telemetry_LogStartup(const MALI_StartupTiming *startup)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO,
+        "mali-fbdev: First frame presented after %.2f ms, pages ready at %.2f ms, blitter built at %.2f ms and ready at %.2f ms",
+        MALI_Telemetry_SinceStart(startup, startup->first_present),
+        MALI_Telemetry_SinceStart(startup, startup->pages_ready),
+        MALI_Telemetry_SinceStart(startup, startup->blitter_built),
+        MALI_Telemetry_SinceStart(startup, startup->blitter_ready));
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
@@ -0,0 +1,40 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malitelemetry_h
+#define _SDL_malitelemetry_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_video.h"
+
+typedef struct MALI_Telemetry
+{
+    SDL_bool measure_gpu;
+    Uint64 log_interval;
+    Uint64 next_log;
+
+    /* Accumulated since the last log, in performance counter ticks */
+    Uint32 frames;
+    Uint32 missed_vsyncs;
+    Uint64 latency_sum, latency_max;
+    Uint64 blit_gpu_sum, blit_gpu_max;
+    Uint64 fence_wait_sum, fence_wait_max;
+} MALI_Telemetry;
+
+/* How long the first window took to come up, in performance counter ticks */
+typedef struct MALI_StartupTiming
+{
+    Uint64 create_window;   // MALI_CreateWindow was called
+    Uint64 pages_ready;     // the swap chain's pages and surfaces exist
+    Uint64 blitter_built;   // the blitter has its context and programs
+    Uint64 blitter_ready;   // and has imported the pages
+    Uint64 first_present;   // the first frame reached the display
+} MALI_StartupTiming;
+
+void MALI_Telemetry_Init(MALI_Telemetry *telemetry);
+void MALI_Telemetry_Record(MALI_Telemetry *telemetry, const SDL_GLFrameTiming *timing);
+void MALI_Telemetry_LogStartup(const MALI_StartupTiming *startup);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_malitelemetry_h */
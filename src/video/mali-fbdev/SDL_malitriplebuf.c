@@ -0,0 +1,89 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+
+#include "SDL_malitriplebuf.h"
+
+/* Every first window starts a new blitter, nothing of the last one's may carry over */
+void MALI_TripleBufferInit(SDL_DisplayData *displaydata)
+{
+    displaydata->triplebuf_mutex = SDL_CreateMutex();
+    displaydata->triplebuf_cond = SDL_CreateCond();
+    displaydata->triplebuf_sem = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&displaydata->triplebuf_sleeping, 0);
+    displaydata->triplebuf_thread = NULL;
+    displaydata->triplebuf_pages_ready = 0;
+    displaydata->triplebuf_thread_ready = 0;
+    displaydata->triplebuf_thread_stop = 0;
+    displaydata->redraw = SDL_FALSE;
+}
+
+/* Hands the blitter work it may be sleeping through, safe without the mutex */
+void MALI_WakeBlitter(SDL_DisplayData *displaydata)
+{
+    if (SDL_AtomicCAS(&displaydata->triplebuf_sleeping, 1, 0))
+        SDL_SemPost(displaydata->triplebuf_sem);
+}
+
+/* The first window's pages are all allocated, the blitter may import them */
+void MALI_TripleBufferPagesReady(SDL_DisplayData *displaydata)
+{
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    displaydata->startup.pages_ready = SDL_GetPerformanceCounter();
+    displaydata->triplebuf_pages_ready = 1;
+    SDL_CondBroadcast(displaydata->triplebuf_cond);
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+}
+
+/* Called by the blitter once it's built, SDL_FALSE if it was stopped before there were pages */
+SDL_bool MALI_TripleBufferWaitForPages(SDL_DisplayData *displaydata)
+{
+    SDL_bool ready;
+
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    displaydata->startup.blitter_built = SDL_GetPerformanceCounter();
+    while (!displaydata->triplebuf_pages_ready && !displaydata->triplebuf_thread_stop)
+        SDL_CondWait(displaydata->triplebuf_cond, displaydata->triplebuf_mutex);
+    ready = displaydata->triplebuf_pages_ready ? SDL_TRUE : SDL_FALSE;
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+    return ready;
+}
+
+void MALI_TripleBufferStop(SDL_DisplayData *displaydata)
+{
+    if (!displaydata || displaydata->triplebuf_thread == NULL)
+        return;
+
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    displaydata->triplebuf_thread_stop = 1;
+    SDL_CondSignal(displaydata->triplebuf_cond);
+    MALI_WakeBlitter(displaydata);
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+    SDL_WaitThread(displaydata->triplebuf_thread, NULL);
+    displaydata->triplebuf_thread = NULL;
+}
+
+/* The thread may never have started or be stopped already, the sync objects go either way */
+void MALI_TripleBufferQuit(SDL_DisplayData *displaydata)
+{
+    if (!displaydata)
+        return;
+
+    MALI_TripleBufferStop(displaydata);
+    SDL_DestroyMutex(displaydata->triplebuf_mutex);
+    SDL_DestroyCond(displaydata->triplebuf_cond);
+    SDL_DestroySemaphore(displaydata->triplebuf_sem);
+    displaydata->triplebuf_mutex = NULL;
+    displaydata->triplebuf_cond = NULL;
+    displaydata->triplebuf_sem = NULL;
+    displaydata->triplebuf_pages_ready = 0;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
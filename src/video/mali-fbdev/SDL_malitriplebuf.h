@@ -0,0 +1,23 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malitriplebuf_h
+#define _SDL_malitriplebuf_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_malivideo.h"
+
+/*
+ * The blitter thread's lifetime and the hand-offs with it, the sync objects in
+ * SDL_DisplayData live from the first window of a display to the last one.
+ */
+void MALI_TripleBufferInit(SDL_DisplayData *displaydata);
+void MALI_WakeBlitter(SDL_DisplayData *displaydata);
+void MALI_TripleBufferPagesReady(SDL_DisplayData *displaydata);
+SDL_bool MALI_TripleBufferWaitForPages(SDL_DisplayData *displaydata);
+void MALI_TripleBufferStop(SDL_DisplayData *displaydata);
+void MALI_TripleBufferQuit(SDL_DisplayData *displaydata);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_malitriplebuf_h */
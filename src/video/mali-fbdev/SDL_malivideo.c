@@ -8,6 +8,8 @@
 #include "SDL_syswm.h"
 #include "SDL_loadso.h"
 #include "SDL_events.h"
+#include "SDL_hints.h"
+#include "SDL_timer.h"
 #include "../../events/SDL_events_c.h"
 
 #ifdef SDL_INPUT_LINUXEV
@@ -51,14 +53,16 @@ MALI_Destroy(SDL_VideoDevice * device)
     }
 }
 
+/* The interval goes with the window the context is current on, only the bottom one's paces the display */
 static int
 MALI_GLES_SetSwapInterval(_THIS, int interval)
 {
+    SDL_Window *window = SDL_GL_GetCurrentWindow();
     SDL_WindowData *windowdata;
-    if (!_this->windows)
+    if (!window || !window->driverdata)
         return 0;
 
-    windowdata = (SDL_WindowData *)_this->windows->driverdata;
+    windowdata = (SDL_WindowData *)window->driverdata;
     windowdata->swapInterval = interval != 0;
     return 0;
 }
@@ -66,11 +70,12 @@ MALI_GLES_SetSwapInterval(_THIS, int interval)
 static int
 MALI_GLES_GetSwapInterval(_THIS)
 {
+    SDL_Window *window = SDL_GL_GetCurrentWindow();
     SDL_WindowData *windowdata;
-    if (!_this->windows)
+    if (!window || !window->driverdata)
         return 0;
 
-    windowdata = (SDL_WindowData *)_this->windows->driverdata;
+    windowdata = (SDL_WindowData *)window->driverdata;
     return windowdata->swapInterval;
 }
 
@@ -108,6 +113,11 @@ MALI_Create()
     device->ShowWindow = MALI_ShowWindow;
     device->HideWindow = MALI_HideWindow;
     device->DestroyWindow = MALI_DestroyWindow;
+    device->CreateWindowFramebuffer = MALI_CreateWindowFramebuffer;
+    device->UpdateWindowFramebuffer = MALI_UpdateWindowFramebuffer;
+    device->DestroyWindowFramebuffer = MALI_DestroyWindowFramebuffer;
+    device->PresentDMABUF = MALI_PresentDMABUF;
+    device->GetWindowNextVsync = MALI_GetWindowNextVsync;
     device->GetWindowWMInfo = MALI_GetWindowWMInfo;
 
     device->GL_LoadLibrary = MALI_GLES_LoadLibrary;
@@ -118,6 +128,8 @@ MALI_Create()
     device->GL_SetSwapInterval = MALI_GLES_SetSwapInterval;
     device->GL_GetSwapInterval = MALI_GLES_GetSwapInterval;
     device->GL_SwapWindow = MALI_GLES_SwapWindow;
+    device->GL_SwapWindowWithDamage = MALI_GLES_SwapWindowWithDamage;
+    device->GL_GetFrameTimings = MALI_GLES_GetFrameTimings;
     device->GL_DeleteContext = MALI_GLES_DeleteContext;
 
     device->GL_DefaultProfileConfig = MALI_GLES_DefaultProfileConfig;
@@ -166,12 +178,39 @@ MALI_Reset_Orientation_Rotation(_THIS, SDL_VideoDisplay *display, SDL_DisplayDat
     display->desktop_mode = display->current_mode;
 }
 
+/*
+ * SDL's hints aren't safe to touch from the blitter thread, the callback runs on the
+ * thread setting the hint and the blitter picks the scaler up before its next frame.
+ */
+static void SDLCALL
+MALI_ScalerHintChanged(void *userdata, const char *name, const char *oldValue, const char *newValue)
+{
+    SDL_DisplayData *displaydata = (SDL_DisplayData *)userdata;
+
+    SDL_AtomicSetPtr(&displaydata->scaler, (void *)MALI_Scaler_FromHint(newValue));
+    SDL_AtomicSet(&displaydata->scaler_changed, 1);
+}
+
+static void SDLCALL
+MALI_ViewportHintChanged(void *userdata, const char *name, const char *oldValue, const char *newValue)
+{
+    SDL_DisplayData *displaydata = (SDL_DisplayData *)userdata;
+
+    SDL_AtomicLock(&displaydata->viewport_lock);
+    MALI_Viewport_ApplyHint(&displaydata->viewport, name, newValue);
+    SDL_AtomicUnlock(&displaydata->viewport_lock);
+    SDL_AtomicSet(&displaydata->viewport_changed, 1);
+}
+
 int
 MALI_VideoInit(_THIS)
 {
     SDL_VideoDisplay display;
     SDL_DisplayMode current_mode;
     SDL_DisplayData *data;
+    const char *source;
+    Uint32 millihertz;
+    int i;
 
     data = (SDL_DisplayData *) SDL_calloc(1, sizeof(SDL_DisplayData));
     if (data == NULL) {
@@ -199,15 +238,35 @@ MALI_VideoInit(_THIS)
     if (data->ion_fd < 0) {
         return SDL_SetError("mali-fbdev: Could not open ion device");
     }
+    MALI_IONPool_Init(&data->ion_pool, &MALI_ION_Ops, data->ion_fd);
 
     MALI_SetTTYCursor(SDL_FALSE);
 
     data->native_display.width = data->vinfo.xres;
     data->native_display.height = data->vinfo.yres;
 
+    /* Not every driver fills in the mode timings, then the refreshes are timed instead */
+    millihertz = MALI_Vsync_GetModeRate(&data->vinfo);
+    source = "mode timings";
+    if (millihertz == 0) {
+        millihertz = MALI_Vsync_Measure(&MALI_FBDEV_ScanoutOps, data->fb_fd);
+        source = "measured";
+    }
+    if (millihertz == 0) {
+        millihertz = 60000;
+        source = "assumed";
+    }
+    MALI_Vsync_Init(&data->vsync, millihertz);
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Display refreshes at %u.%03u Hz (%s)",
+        millihertz / 1000, millihertz % 1000, source);
+
+    SDL_AddHintCallback(SDL_HINT_MALI_SCALER, MALI_ScalerHintChanged, data);
+    for (i = 0; i < MALI_VIEWPORT_NUM_HINTS; i++) {
+        SDL_AddHintCallback(MALI_Viewport_Hints[i], MALI_ViewportHintChanged, data);
+    }
+
     SDL_zero(current_mode);
-    /* FIXME: Is there a way to tell the actual refresh rate? */
-    current_mode.refresh_rate = 60;
+    current_mode.refresh_rate = (millihertz + 500) / 1000;
     /* 32 bpp for default */
     //current_mode.format = SDL_PIXELFORMAT_ABGR8888;
     current_mode.format = SDL_PIXELFORMAT_RGBX8888;
@@ -235,14 +294,22 @@ MALI_VideoInit(_THIS)
 void
 MALI_VideoQuit(_THIS)
 {
-    SDL_DisplayData *displaydata = (SDL_DisplayData*)SDL_GetDisplayDriverData(0);
-    int fd = open("/dev/tty", O_RDWR);
+    SDL_DisplayData *displaydata;
+    int i, j, fd = open("/dev/tty", O_RDWR);
+
+    for (i = 0; i < _this->num_displays; i++) {
+        displaydata = (SDL_DisplayData *)_this->displays[i].driverdata;
+        MALI_TripleBufferQuit(displaydata);
+        SDL_DelHintCallback(SDL_HINT_MALI_SCALER, MALI_ScalerHintChanged, displaydata);
+        for (j = 0; j < MALI_VIEWPORT_NUM_HINTS; j++) {
+            SDL_DelHintCallback(MALI_Viewport_Hints[j], MALI_ViewportHintChanged, displaydata);
+        }
 
-    MALI_TripleBufferQuit(_this);
-    
-    /* Cleanup after ion and ge2d */
-    close(displaydata->ion_fd);
-    close(displaydata->fb_fd);
+        /* Cleanup after ion and ge2d */
+        MALI_IONPool_Quit(&displaydata->ion_pool);
+        close(displaydata->ion_fd);
+        close(displaydata->fb_fd);
+    }
 
     /* Clear the framebuffer and ser cursor on again */
     ioctl(fd, VT_ACTIVATE, 5);
@@ -257,30 +324,198 @@ MALI_VideoQuit(_THIS)
 
 }
 
-static EGLSurface
-*MALI_EGL_InitPixmapSurfaces(_THIS, int width, int height, SDL_WindowData *windowdata, SDL_DisplayData *displaydata) 
+/* Both 8888 layouts share a pixmap format, the blitter just ignores alpha for XRGB */
+static const MALI_PixelFormat mali_formats[] = {
+    { "XRGB8888", MALI_FORMAT_ARGB8888, fourcc_code('X', 'R', '2', '4'), SDL_PIXELFORMAT_RGB888, 4, 8, 8, 8, 0 },
+    { "ARGB8888", MALI_FORMAT_ARGB8888, fourcc_code('A', 'R', '2', '4'), SDL_PIXELFORMAT_ARGB8888, 4, 8, 8, 8, 8 },
+    { "RGB565", MALI_FORMAT_RGB565, fourcc_code('R', 'G', '1', '6'), SDL_PIXELFORMAT_RGB565, 2, 5, 6, 5, 0 },
+    { "ABGR2101010", MALI_FORMAT_ABGR2101010, fourcc_code('A', 'B', '3', '0'), SDL_PIXELFORMAT_UNKNOWN, 4, 10, 10, 10, 2 },
+};
+
+/*
+ * 16 bit pages halve what the application renders and the blitter reads, so
+ * they're used whenever the application asks for no more than 5/6/5 bits. The
+ * 3/3/2 SDL asks for by default keeps getting 32 bit pages, the way
+ * SDL_EGL_ChooseConfig favors true color for it.
+ */
+static const MALI_PixelFormat *
+MALI_ChoosePixelFormat(_THIS)
+{
+    int red = _this->gl_config.red_size;
+    int green = _this->gl_config.green_size;
+    int blue = _this->gl_config.blue_size;
+    int alpha = _this->gl_config.alpha_size;
+
+    if (red >= 10 && green >= 10 && blue >= 10)
+        return &mali_formats[3];
+
+    if (red <= 5 && green <= 6 && blue <= 5 && alpha <= 0 && red + green + blue > 8)
+        return &mali_formats[2];
+
+    return alpha > 0 ? &mali_formats[1] : &mali_formats[0];
+}
+
+static SDL_bool
+MALI_EGL_ConfigMatches(_THIS, EGLConfig config, const MALI_PixelFormat *format)
+{
+    EGLint red, green, blue, alpha;
+
+    _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, config, EGL_RED_SIZE, &red);
+    _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, config, EGL_GREEN_SIZE, &green);
+    _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, config, EGL_BLUE_SIZE, &blue);
+    _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, config, EGL_ALPHA_SIZE, &alpha);
+
+    return (red == format->red_size && green == format->green_size && blue == format->blue_size &&
+            alpha <= format->alpha_size) ? SDL_TRUE : SDL_FALSE;
+}
+
+/*
+ * SDL_EGL_ChooseConfig goes for the closest config to the attributes, favoring true
+ * color, but rendering into a pixmap needs one with exactly its component sizes.
+ */
+static int
+MALI_EGL_ChooseConfig(_THIS, SDL_DisplayData *displaydata, const MALI_PixelFormat *format)
 {
-    struct ion_fd_data ion_data;
-    struct ion_allocation_data allocation_data;
-    int i, io, stride;
+    EGLConfig configs[128];
+    EGLint attribs[16], count = 0, renderable, depth, stencil;
+    int i = 0;
+
+    /* Mode changes recreate the surfaces with the same attributes, SDL comes back with the same config */
+    if (displaydata->pixmap_config_base == _this->egl_data->egl_config && displaydata->pixmap_config_format == format) {
+        _this->egl_data->egl_config = displaydata->pixmap_config;
+        return 0;
+    }
+    displaydata->pixmap_config_base = _this->egl_data->egl_config;
+    displaydata->pixmap_config_format = NULL;
+
+    if (MALI_EGL_ConfigMatches(_this, _this->egl_data->egl_config, format)) {
+        displaydata->pixmap_config = _this->egl_data->egl_config;
+        displaydata->pixmap_config_format = format;
+        return 0;
+    }
+
+    /* Otherwise keep what SDL picked apart from the color */
+    _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, _this->egl_data->egl_config, EGL_RENDERABLE_TYPE, &renderable);
+    _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, _this->egl_data->egl_config, EGL_DEPTH_SIZE, &depth);
+    _this->egl_data->eglGetConfigAttrib(_this->egl_data->egl_display, _this->egl_data->egl_config, EGL_STENCIL_SIZE, &stencil);
+
+    attribs[i++] = EGL_SURFACE_TYPE;
+    attribs[i++] = EGL_PIXMAP_BIT;
+    attribs[i++] = EGL_RENDERABLE_TYPE;
+    attribs[i++] = renderable;
+    attribs[i++] = EGL_RED_SIZE;
+    attribs[i++] = format->red_size;
+    attribs[i++] = EGL_GREEN_SIZE;
+    attribs[i++] = format->green_size;
+    attribs[i++] = EGL_BLUE_SIZE;
+    attribs[i++] = format->blue_size;
+    attribs[i++] = EGL_DEPTH_SIZE;
+    attribs[i++] = depth;
+    attribs[i++] = EGL_STENCIL_SIZE;
+    attribs[i++] = stencil;
+    attribs[i++] = EGL_NONE;
+
+    if (!_this->egl_data->eglChooseConfig(_this->egl_data->egl_display, attribs, configs, SDL_arraysize(configs), &count))
+        count = 0;
+
+    for (i = 0; i < count; i++) {
+        if (MALI_EGL_ConfigMatches(_this, configs[i], format)) {
+            _this->egl_data->egl_config = configs[i];
+            displaydata->pixmap_config = configs[i];
+            displaydata->pixmap_config_format = format;
+            return 0;
+        }
+    }
+
+    return SDL_SetError("mali-fbdev: No EGL config for %s pixmaps", format->name);
+}
+
+/* DRM where the kernel offers atomic modesetting, the framebuffer otherwise, see SDL_HINT_MALI_SCANOUT_BACKEND */
+static int
+MALI_InitScanout(SDL_WindowData *windowdata, SDL_DisplayData *displaydata, int width, int height)
+{
+    const char *backend = SDL_GetHint(SDL_HINT_MALI_SCANOUT_BACKEND);
+    const char *device = SDL_GetHint(SDL_HINT_MALI_DRM_DEVICE);
+    SDL_bool use_drm = SDL_TRUE, use_fbdev = SDL_TRUE;
+
+    if (backend && SDL_strcasecmp(backend, "drm") == 0) {
+        use_fbdev = SDL_FALSE;
+    } else if (backend && SDL_strcasecmp(backend, "fbdev") == 0) {
+        use_drm = SDL_FALSE;
+    } else if (backend && *backend && SDL_strcasecmp(backend, "auto") != 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Unknown scanout backend '%s'", backend);
+    }
+
+    if (!device || !*device)
+        device = "/dev/dri/card0";
+
+    if (use_drm) {
+        if (MALI_Scanout_InitDRM(&windowdata->scanout, &MALI_DRM_DeviceOps, device, windowdata->format->fourcc,
+                                 width, height, displaydata->rotation, windowdata->swapchain.depth) == 0) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Flipping pages with atomic commits on %s", device);
+            return 0;
+        }
+        if (!use_fbdev)
+            return -1;
+        SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "%s, falling back to the framebuffer", SDL_GetError());
+    }
+
+    return MALI_Scanout_Init(&windowdata->scanout, &MALI_FBDEV_ScanoutOps, displaydata->fb_fd, &displaydata->vinfo,
+                             windowdata->format->sdl_format, width, height, displaydata->rotation,
+                             windowdata->swapchain.depth);
+}
 
+/* The page format, EGL config and whether the display scans the pages out, everything the blitter starts with */
+static int
+MALI_EGL_ChooseSurfaceConfig(_THIS, int width, int height, SDL_WindowData *windowdata, SDL_DisplayData *displaydata,
+                             SDL_bool allow_scanout)
+{
+    windowdata->format = MALI_ChoosePixelFormat(_this);
     _this->egl_data->egl_surfacetype = EGL_PIXMAP_BIT;
     if (SDL_EGL_ChooseConfig(_this) != 0) {
-        SDL_SetError("mali-fbdev: Unable to find a suitable EGL config");
-        return EGL_NO_SURFACE;
+        return SDL_SetError("mali-fbdev: Unable to find a suitable EGL config");
+    }
+
+    if (MALI_EGL_ChooseConfig(_this, displaydata, windowdata->format) < 0) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "%s, falling back to %s", SDL_GetError(), mali_formats[0].name);
+        windowdata->format = &mali_formats[0];
+        if (MALI_EGL_ChooseConfig(_this, displaydata, windowdata->format) < 0)
+            return -1;
     }
 
-    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Creating Pixmap (%dx%d) buffers", width, height);
     if (_this->gl_config.framebuffer_srgb_capable) {
-        {
-            SDL_SetError("mali-fbdev: EGL implementation does not support sRGB system framebuffers");
-            return EGL_NO_SURFACE;
+        return SDL_SetError("mali-fbdev: EGL implementation does not support sRGB system framebuffers");
+    }
+
+    /* Skip the blitter altogether when the framebuffer can scan the pages out as is */
+    windowdata->direct_scanout = SDL_FALSE;
+    if (allow_scanout && SDL_GetHintBoolean(SDL_HINT_MALI_DIRECT_SCANOUT, SDL_FALSE)) {
+        if (MALI_InitScanout(windowdata, displaydata, width, height) == 0) {
+            windowdata->direct_scanout = SDL_TRUE;
+            MALI_SwapChain_DeferRelease(&windowdata->swapchain);
+            SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Using direct scanout");
+        } else {
+            SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "%s, falling back to the blitter", SDL_GetError());
         }
     }
 
-    // Populate pixmap definitions
-    stride = MALI_ALIGN(width * 4, 64);
-    for (i = 0; i < 3; i++)
+    return 0;
+}
+
+static EGLSurface
+*MALI_EGL_InitPixmapSurfaces(_THIS, int width, int height, SDL_WindowData *windowdata, SDL_DisplayData *displaydata)
+{
+    SDL_bool in_framebuffer;
+    int i, stride;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Creating %d %s Pixmap (%dx%d) buffers", windowdata->swapchain.depth,
+                windowdata->format->name, width, height);
+
+    // Populate pixmap definitions, the framebuffer's slices come with its pitch
+    in_framebuffer = windowdata->direct_scanout && windowdata->scanout.backend == MALI_SCANOUT_FBDEV;
+    stride = in_framebuffer ? (int)windowdata->scanout.stride :
+             MALI_ALIGN(width * windowdata->format->bytes_per_pixel, 64);
+    for (i = 0; i < windowdata->swapchain.depth; i++)
     {
         MALI_EGL_Surface *surf = &windowdata->surface[i];
         surf->pixmap = (mali_pixmap) {
@@ -293,44 +528,31 @@ static EGLSurface
             },
             .planes[1] = (mali_plane) {},
             .planes[2] = (mali_plane) {},
-            .format = MALI_FORMAT_ARGB8888,
+            .format = windowdata->format->mali_format,
             .handles = {-1, -1, -1},
         };
 
-        /* Allocate framebuffer data */
-        allocation_data = (struct ion_allocation_data){
-            .len = surf->pixmap.planes[0].size,
-            .heap_id_mask = (1 << ION_HEAP_TYPE_SYSTEM),
-            .flags = 1 << ION_FLAG_CACHED
-        };
-
-        io = ioctl(displaydata->ion_fd, ION_IOC_ALLOC, &allocation_data);
-        if (io != 0)
-        {
-            SDL_SetError("mali-fbdev: Unable to create backing ION buffers");
-            return EGL_NO_SURFACE;
-        }
-
-        /* Export DMA_BUF handle for the framebuffer */  
-        ion_data = (struct ion_fd_data){
-            .handle = allocation_data.handle
-        };
-
-        io = ioctl(displaydata->ion_fd, ION_IOC_SHARE, &ion_data);
-        if (io != 0)
-        {
-            SDL_SetError("mali-fbdev: Unable to create backing ION buffers");
-            return EGL_NO_SURFACE;
+        if (in_framebuffer) {
+            /* Every page is a slice of the exported framebuffer, nothing to allocate */
+            surf->handle = 0;
+            surf->shared_fd = -1;
+            surf->pixmap.handles[0] = windowdata->scanout.dmabuf_fd;
+            surf->pixmap.planes[0].offset = MALI_Scanout_GetPageOffset(&windowdata->scanout, i);
+        } else {
+            /* Allocate framebuffer data, recycling the pages of a previous swap chain if possible */
+            if (MALI_IONPool_Acquire(&displaydata->ion_pool, surf->pixmap.planes[0].size, &surf->handle, &surf->shared_fd) < 0)
+                return EGL_NO_SURFACE;
+
+            /* Create Pixmap Surface using DMA_BUF framebuffer fd */
+            surf->pixmap.handles[0] = surf->shared_fd;
+
+            /* DRM flips to the page itself */
+            if (windowdata->direct_scanout &&
+                MALI_Scanout_AddPage(&windowdata->scanout, i, surf->shared_fd, width, height, stride,
+                                     windowdata->format->fourcc) < 0)
+                return EGL_NO_SURFACE;
         }
 
-        /* Recall fd and handle for teardown later */
-        surf->handle = allocation_data.handle;
-        surf->shared_fd = ion_data.fd;
-        SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Created ION buffer %d (fd: %d)\n", surf->handle, surf->shared_fd);
-
-        /* Create Pixmap Surface using DMA_BUF framebuffer fd */
-        surf->pixmap.handles[0] = ion_data.fd;
-
         surf->pixmap_handle = displaydata->egl_create_pixmap_ID_mapping(&surf->pixmap);
         SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Created pixmap handle %p\n", surf->pixmap_handle);
         
@@ -344,7 +566,90 @@ static EGLSurface
         }
     }
 
-    return windowdata->surface[1].egl_surface;
+    return windowdata->surface[windowdata->swapchain.rendering].egl_surface;
+}
+
+static void
+MALI_EGL_DestroyPixmapSurfaces(_THIS, SDL_WindowData *windowdata, SDL_DisplayData *displaydata)
+{
+    int i;
+
+    MALI_Framebuffer_Unmap(&windowdata->framebuffer);
+
+    for (i = 0; i < windowdata->swapchain.depth; i++) {
+        MALI_EGL_Surface *surf = &windowdata->surface[i];
+
+        MALI_GLES_DestroyFence(_this, surf);
+        if (surf->egl_surface != EGL_NO_SURFACE) {
+            SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Destroying Surface %d.", i);
+            SDL_EGL_DestroySurface(_this, surf->egl_surface);
+            surf->egl_surface = EGL_NO_SURFACE;
+
+            displaydata->egl_destroy_pixmap_ID_mapping((unsigned long)surf->pixmap_handle);
+        }
+
+        /* Pages carved out of the framebuffer have no ION buffer */
+        if (surf->shared_fd >= 0) {
+            MALI_IONPool_Release(&displaydata->ion_pool, surf->shared_fd);
+            surf->shared_fd = -1;
+        }
+
+        surf->handle = 0;
+        surf->pixmap_handle = 0;
+    }
+}
+
+static SDL_WindowData *
+MALI_GetBaseWindowData(SDL_DisplayData *displaydata)
+{
+    return (SDL_WindowData *)displaydata->windows[0]->driverdata;
+}
+
+/* Waits for the blitter to let go of the window's pages, called with the mutex held */
+static void
+MALI_PauseWindow(SDL_DisplayData *displaydata, SDL_WindowData *windowdata)
+{
+    windowdata->reconfigure = MALI_RECONFIGURE_REQUESTED;
+    MALI_WakeBlitter(displaydata);
+    while (windowdata->reconfigure != MALI_RECONFIGURE_PAUSED)
+        SDL_CondWait(displaydata->triplebuf_cond, displaydata->triplebuf_mutex);
+}
+
+/* Takes a window out of the composition while the blitter carries on with the others */
+static void
+MALI_RemoveWindow(SDL_DisplayData *displaydata, SDL_Window *window)
+{
+    SDL_WindowData *windowdata = (SDL_WindowData *)window->driverdata;
+    SDL_DMABUFFrame dropped;
+    SDL_bool drop;
+    int i;
+
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    MALI_PauseWindow(displaydata, windowdata);
+    for (i = 0; i < displaydata->num_windows; i++) {
+        if (displaydata->windows[i] == window)
+            break;
+    }
+    if (i < displaydata->num_windows) {
+        SDL_memmove(&displaydata->windows[i], &displaydata->windows[i + 1],
+                    (displaydata->num_windows - i - 1) * sizeof(displaydata->windows[0]));
+        displaydata->num_windows--;
+    }
+    drop = windowdata->dmabuf_pending;
+    dropped = windowdata->dmabuf_frame;
+    windowdata->dmabuf_pending = SDL_FALSE;
+    displaydata->redraw = SDL_TRUE;
+    MALI_WakeBlitter(displaydata);
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+    if (drop)
+        MALI_DMABUF_Release(&dropped);
+
+    /* The window above the old bottom one takes over the input */
+    if (i == 0) {
+        SDL_SetMouseFocus(displaydata->windows[0]);
+        SDL_SetKeyboardFocus(displaydata->windows[0]);
+    }
 }
 
 int
@@ -354,6 +659,8 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
     SDL_WindowData *windowdata;
     SDL_DisplayData *displaydata;
     SDL_VideoDisplay *display;
+    SDL_bool first, configured;
+    Uint64 start = SDL_GetPerformanceCounter();
 
     display = SDL_GetDisplayForWindow(window);
     displaydata = display->driverdata;
@@ -367,10 +674,12 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
     /* Initialize defaults for SDL_WindowData */
     *windowdata = (SDL_WindowData){
         .swapInterval = 1,
-        .current_page = 0,
-        .flip_page = 1,
-        .new_page = 2
+        .displaydata = displaydata,
+        .framebuffer = { .current = -1, .latest = -1 },
     };
+    for (int i = 0; i < MALI_SWAPCHAIN_MAX_DEPTH; i++)
+        windowdata->surface[i].shared_fd = -1;
+    MALI_SwapChain_Init(&windowdata->swapchain, MALI_SwapChain_GetDepthHint(), MALI_SwapChain_GetPresentModeHint());
 
     /* OpenGL ES is the law here */
     window->flags |= SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN;
@@ -381,7 +690,15 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
         }
     }
 
-    MALI_TripleBufferQuit(_this);
+    /* Secondary windows are drawn by the blitter, direct scanout leaves it out */
+    if (displaydata->num_windows == MALI_MAX_WINDOWS) {
+        SDL_free(windowdata);
+        return SDL_SetError("mali-fbdev: Too many windows, at most %d are composited", MALI_MAX_WINDOWS);
+    }
+    if (displaydata->num_windows > 0 && MALI_GetBaseWindowData(displaydata)->direct_scanout) {
+        SDL_free(windowdata);
+        return SDL_SetError("mali-fbdev: The display is scanned out directly, it can't show more windows");
+    }
 
     /* Acquire handle to internal pixmap routines */
     if (!displaydata->egl_create_pixmap_ID_mapping) {
@@ -403,7 +720,10 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
      * otherwise FNA fails, but we want to be able to set arbitrary resolutions
      * when you actually define a video mode.
      */
-    MALI_Reset_Orientation_Rotation(_this, display, displaydata);
+    first = (displaydata->num_windows == 0);
+    if (first) {
+        MALI_Reset_Orientation_Rotation(_this, display, displaydata);
+    }
     if ((window->flags & SDL_WINDOW_FULLSCREEN) != 0)
     {
         window->w = display->current_mode.w;
@@ -412,29 +732,63 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
 
     windowdata->prev_w = window->w;
     windowdata->prev_h = window->h;
+    windowdata->x = SDL_WINDOWPOS_ISUNDEFINED(window->x) || SDL_WINDOWPOS_ISCENTERED(window->x) ? 0 : window->x;
+    windowdata->y = SDL_WINDOWPOS_ISUNDEFINED(window->y) || SDL_WINDOWPOS_ISCENTERED(window->y) ? 0 : window->y;
+
+    /* Only the bottom window may be scanned out, that's decided before anything is allocated */
+    egl_surface = EGL_NO_SURFACE;
+    configured = (MALI_EGL_ChooseSurfaceConfig(_this, window->w, window->h, windowdata, displaydata, first) == 0);
+
+    if (first) {
+        /*
+         * The blitter builds its context and programs while we allocate the DMA_BUF-backed
+         * pages, and only waits for them to import them. Nobody waits for the blitter,
+         * frames rendered before it's ready stay queued until it is.
+         */
+        MALI_TripleBufferInit(displaydata);
+        displaydata->startup = (MALI_StartupTiming){ .create_window = start };
+        displaydata->windows[displaydata->num_windows++] = window;
+        if (configured) {
+            displaydata->triplebuf_thread = SDL_CreateThread(MALI_TripleBufferingThread, "MALI_TripleBufferingThread",
+                                                             display);
+            egl_surface = MALI_EGL_InitPixmapSurfaces(_this, window->w, window->h, windowdata, displaydata);
+        }
 
-    /* Initialize DMA_BUF-backed Pixmap surfaces */
-    egl_surface = MALI_EGL_InitPixmapSurfaces(_this, window->w, window->h, windowdata, displaydata);
-
-    /* Populate triplebuffering data and threads */
-    MALI_TripleBufferInit(windowdata);
-    windowdata->triplebuf_thread = SDL_CreateThread(MALI_TripleBufferingThread, "MALI_TripleBufferingThread", _this);
-
-    /* Wait until the triplebuf thread is ready */
-    SDL_LockMutex(windowdata->triplebuf_mutex);
-    SDL_CondWait(windowdata->triplebuf_cond, windowdata->triplebuf_mutex);
-    SDL_UnlockMutex(windowdata->triplebuf_mutex);
+        /* Without pages the thread is stopped below */
+        if (egl_surface != EGL_NO_SURFACE)
+            MALI_TripleBufferPagesReady(displaydata);
+    } else {
+        if (configured)
+            egl_surface = MALI_EGL_InitPixmapSurfaces(_this, window->w, window->h, windowdata, displaydata);
+
+        /* Goes on top, the blitter imports its pages when it next wakes up */
+        if (egl_surface != EGL_NO_SURFACE) {
+            SDL_LockMutex(displaydata->triplebuf_mutex);
+            displaydata->windows[displaydata->num_windows++] = window;
+            displaydata->redraw = SDL_TRUE;
+            MALI_WakeBlitter(displaydata);
+            SDL_UnlockMutex(displaydata->triplebuf_mutex);
+        }
+    }
     
     if (egl_surface == EGL_NO_SURFACE) {
+        if (!first) {
+            MALI_EGL_DestroyPixmapSurfaces(_this, windowdata, displaydata);
+            SDL_free(windowdata);
+            window->driverdata = NULL;
+            return SDL_SetError("mali-fbdev: Can't create EGL window surface");
+        }
         MALI_VideoQuit(_this);
         return SDL_SetError("mali-fbdev: Can't create EGL window surface");
     } else {
         MALI_GLES_MakeCurrent(_this, window, _this->current_glctx);
     }
 
-    /* One window, it always has focus */
-    SDL_SetMouseFocus(window);
-    SDL_SetKeyboardFocus(window);
+    /* The bottom window has the focus, the ones over it are overlays */
+    if (first) {
+        SDL_SetMouseFocus(window);
+        SDL_SetKeyboardFocus(window);
+    }
 
     /* Window has been successfully created */
     return 0;
@@ -443,54 +797,218 @@ MALI_CreateWindow(_THIS, SDL_Window * window)
 void
 MALI_DestroyWindow(_THIS, SDL_Window * window)
 {
-    int i, io;
     SDL_WindowData *windowdata;
     SDL_DisplayData *displaydata;
-    struct ion_handle_data ionHandleData;
 
     SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Destroying MALI window %p.", window);
 
     windowdata = window->driverdata;
-    displaydata = SDL_GetDisplayDriverData(0);
+    if (!windowdata)
+        return;
+    displaydata = windowdata->displaydata;
 
-    MALI_TripleBufferQuit(_this);
+    /* The last window takes the blitter with it, the others only leave the composition */
+    if (displaydata->num_windows <= 1) {
+        MALI_TripleBufferQuit(displaydata);
+        displaydata->num_windows = 0;
+    } else {
+        MALI_RemoveWindow(displaydata, window);
+    }
 
     // You MUST ensure all of the surfaces are unbound, otherwise deletion fails, and mode changes will fail.
     // We're not using the SDL built-in here to avoid any unecessary state changes from it
     _this->egl_data->eglMakeCurrent(_this->egl_data->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _this->current_glctx);
 
-    if (windowdata) {
-        for (i = 0; i < 3; i++) {
-            MALI_EGL_Surface *surf = &windowdata->surface[i];
+    MALI_EGL_DestroyPixmapSurfaces(_this, windowdata, displaydata);
 
-            if (surf->egl_surface != EGL_NO_SURFACE) {
-                SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Destroying Surface %d.", i);
-                SDL_EGL_DestroySurface(_this, surf->egl_surface);
-                surf->egl_surface = EGL_NO_SURFACE;
+    if (windowdata->direct_scanout)
+        MALI_Scanout_Quit(&windowdata->scanout);
 
-                displaydata->egl_destroy_pixmap_ID_mapping((unsigned long)surf->pixmap_handle);
-                
-                ionHandleData = (struct ion_handle_data) {
-                    .handle = surf->handle
-                };
+    SDL_free(windowdata);
+    window->driverdata = NULL;
+}
 
-                io = ioctl(displaydata->ion_fd, ION_IOC_FREE, &ionHandleData);
-                if (io != 0) {
-                    SDL_LogDebug(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: ION_IOC_FREE ioctl failed.");
-                }
+/*
+ * SDL_GetWindowSurface() draws straight into the swap chain pages, there's no
+ * renderer and texture upload in between.
+ */
+int
+MALI_CreateWindowFramebuffer(_THIS, SDL_Window *window, Uint32 *format, void **pixels, int *pitch)
+{
+    SDL_WindowData *windowdata = window->driverdata;
+    int fds[MALI_SWAPCHAIN_MAX_DEPTH];
+    Uint32 offsets[MALI_SWAPCHAIN_MAX_DEPTH];
+    int i;
 
-                close(surf->shared_fd);
-                surf->shared_fd = -1;
-            }
+    if (!windowdata || windowdata->swapchain.rendering < 0)
+        return SDL_SetError("mali-fbdev: Window has no swap chain");
 
-            surf->handle = 0;
-            surf->pixmap_handle = 0;
-        }
+    if (windowdata->format->sdl_format == SDL_PIXELFORMAT_UNKNOWN)
+        return SDL_SetError("mali-fbdev: %s pages can't back a window surface", windowdata->format->name);
 
-        SDL_free(windowdata);
+    for (i = 0; i < windowdata->swapchain.depth; i++) {
+        fds[i] = windowdata->surface[i].pixmap.handles[0];
+        offsets[i] = windowdata->surface[i].pixmap.planes[0].offset;
     }
 
-    window->driverdata = NULL;
+    MALI_Framebuffer_Unmap(&windowdata->framebuffer);
+    if (MALI_Framebuffer_Map(&windowdata->framebuffer, &MALI_DMABUF_FramebufferOps, windowdata->swapchain.depth,
+                             fds, offsets, windowdata->surface[0].pixmap.width, windowdata->surface[0].pixmap.height,
+                             windowdata->surface[0].pixmap.planes[0].stride, windowdata->format->bytes_per_pixel) < 0)
+        return -1;
+
+    *pixels = MALI_Framebuffer_Acquire(&windowdata->framebuffer, windowdata->swapchain.rendering);
+    if (!*pixels)
+        return -1;
+
+    *format = windowdata->format->sdl_format;
+    *pitch = windowdata->framebuffer.pitch;
+    return 0;
+}
+
+int
+MALI_UpdateWindowFramebuffer(_THIS, SDL_Window *window, const SDL_Rect *rects, int numrects)
+{
+    SDL_WindowData *windowdata = window->driverdata;
+    void *pixels;
+    int page;
+
+    if (!windowdata || windowdata->framebuffer.current < 0 || !window->surface)
+        return SDL_SetError("mali-fbdev: Window surface isn't mapped");
+
+    MALI_Framebuffer_Present(&windowdata->framebuffer, rects, numrects);
+    page = MALI_QueueFrame(_this, windowdata, SDL_FALSE, rects, numrects);
+
+    /* The surface moves along to the next page, which already has the frame we just presented */
+    pixels = MALI_Framebuffer_Acquire(&windowdata->framebuffer, page);
+    if (!pixels)
+        return -1;
+
+    window->surface->pixels = pixels;
+    return 0;
+}
+
+void
+MALI_DestroyWindowFramebuffer(_THIS, SDL_Window *window)
+{
+    SDL_WindowData *windowdata = window->driverdata;
+
+    if (windowdata)
+        MALI_Framebuffer_Unmap(&windowdata->framebuffer);
+}
+
+/*
+ * Mailbox semantics, the newest frame replaces one the blitter hasn't gotten to,
+ * and that one goes straight back to its owner.
+ */
+int
+MALI_PresentDMABUF(_THIS, SDL_Window *window, const SDL_DMABUFFrame *frame)
+{
+    SDL_WindowData *windowdata = window->driverdata;
+    SDL_DisplayData *displaydata;
+    SDL_DMABUFFrame dropped;
+    SDL_bool drop;
+
+    if (!windowdata || windowdata->displaydata->triplebuf_thread == NULL)
+        return SDL_SetError("mali-fbdev: Window has no blitter");
+    displaydata = windowdata->displaydata;
+
+    if (MALI_DMABUF_Validate(frame) < 0)
+        return -1;
+
+    /* Whether the blitter can import them is known once it's up, which it may not be right after SDL_CreateWindow */
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    while (!displaydata->triplebuf_thread_ready)
+        SDL_CondWait(displaydata->triplebuf_cond, displaydata->triplebuf_mutex);
+    if (!windowdata->dmabuf_supported) {
+        SDL_UnlockMutex(displaydata->triplebuf_mutex);
+        return SDL_SetError("mali-fbdev: DMA-BUF frames need the GLES blitter, GL_OES_EGL_image_external and the bottom window");
+    }
+
+    drop = windowdata->dmabuf_pending;
+    dropped = windowdata->dmabuf_frame;
+    windowdata->dmabuf_frame = *frame;
+    windowdata->dmabuf_pending = SDL_TRUE;
+    SDL_CondBroadcast(displaydata->triplebuf_cond);
+    MALI_WakeBlitter(displaydata);
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+    if (drop)
+        MALI_DMABUF_Release(&dropped);
+
+    return 0;
+}
+
+/* The blitter keeps the clock in step with the display while it is swapping with vsync on */
+int
+MALI_GetWindowNextVsync(_THIS, SDL_Window *window, Uint64 *vsync, Uint64 *period)
+{
+    SDL_WindowData *windowdata = window->driverdata;
+    SDL_DisplayData *displaydata;
+    Uint64 now;
+
+    if (!windowdata || !windowdata->displaydata->triplebuf_mutex)
+        return SDL_SetError("mali-fbdev: Window has no blitter");
+    displaydata = windowdata->displaydata;
+
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    now = SDL_GetPerformanceCounter();
+    *vsync = MALI_Vsync_Predict(&displaydata->vsync, now);
+    *period = displaydata->vsync.period;
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+    return 0;
+}
+
+/*
+ * Swaps the pages for ones of the new size while the blitter thread keeps its
+ * context, programs and EGL window surface, only its EGLImages are rebuilt.
+ */
+static int
+MALI_ResizeSwapChain(_THIS, SDL_Window *window, int w, int h)
+{
+    SDL_WindowData *windowdata = window->driverdata;
+    SDL_DisplayData *displaydata = windowdata->displaydata;
+    EGLSurface egl_surface;
+    SDL_bool resumed;
+
+    /* Direct scanout has no blitter to keep around */
+    if (windowdata->direct_scanout || displaydata->triplebuf_thread == NULL)
+        return -1;
+
+    /*
+     * Have the blitter let go of the old pages. Paused windows are left alone, so the
+     * pages are replaced without the mutex and the other windows keep being drawn.
+     */
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    MALI_PauseWindow(displaydata, windowdata);
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+    // The application's surfaces have to be unbound before they can go, see MALI_DestroyWindow
+    _this->egl_data->eglMakeCurrent(_this->egl_data->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _this->current_glctx);
+    MALI_EGL_DestroyPixmapSurfaces(_this, windowdata, displaydata);
+    MALI_SwapChain_Init(&windowdata->swapchain, windowdata->swapchain.depth, windowdata->swapchain.mode);
+    egl_surface = EGL_NO_SURFACE;
+    if (MALI_EGL_ChooseSurfaceConfig(_this, w, h, windowdata, displaydata, SDL_FALSE) == 0)
+        egl_surface = MALI_EGL_InitPixmapSurfaces(_this, w, h, windowdata, displaydata);
+
+    /* Resume even on failure, the thread has to be running for a full teardown */
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    windowdata->reconfigure = MALI_RECONFIGURE_RESUMED;
+    MALI_WakeBlitter(displaydata);
+    while (windowdata->reconfigure == MALI_RECONFIGURE_RESUMED)
+        SDL_CondWait(displaydata->triplebuf_cond, displaydata->triplebuf_mutex);
+    resumed = (windowdata->reconfigure == MALI_RECONFIGURE_NONE);
+    windowdata->reconfigure = MALI_RECONFIGURE_NONE;
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+
+    if (egl_surface == EGL_NO_SURFACE || !resumed)
+        return -1;
+
+    windowdata->prev_w = w;
+    windowdata->prev_h = h;
+    MALI_GLES_MakeCurrent(_this, window, _this->current_glctx);
+    return 0;
 }
 
 void MALI_MaybeRecreate(_THIS, SDL_Window *window, int w, int h)
@@ -505,6 +1023,9 @@ void MALI_MaybeRecreate(_THIS, SDL_Window *window, int w, int h)
     SDL_SendWindowEvent(window, SDL_WINDOWEVENT_RESIZED, w, h);
     window->w = w;
     window->h = h;
+    if (MALI_ResizeSwapChain(_this, window, w, h) == 0)
+        return;
+
     MALI_DestroyWindow(_this, window);
     MALI_CreateWindow(_this, window);
 }
@@ -519,10 +1040,11 @@ MALI_GetDisplayModes(_THIS, SDL_VideoDisplay * display)
 int
 MALI_SetDisplayMode(_THIS, SDL_VideoDisplay * display, SDL_DisplayMode * mode)
 {
+    SDL_DisplayData *displaydata = (SDL_DisplayData *)display->driverdata;
     SDL_Window *window;
     window = display->fullscreen_window;
-    if (!window)
-        window = display->device->windows;
+    if (!window && displaydata->num_windows > 0)
+        window = displaydata->windows[0];
     if (!window)
         return 0;
 
@@ -537,9 +1059,32 @@ MALI_SetWindowTitle(_THIS, SDL_Window * window)
 {
 }
 
+/* Overlays are redrawn at their new place, the bottom window always fills the screen */
+static void
+MALI_UpdatePlacement(SDL_Window *window, SDL_bool hidden)
+{
+    SDL_WindowData *windowdata = (SDL_WindowData *)window->driverdata;
+    SDL_DisplayData *displaydata;
+
+    if (!windowdata || windowdata->displaydata->triplebuf_thread == NULL)
+        return;
+    displaydata = windowdata->displaydata;
+
+    SDL_LockMutex(displaydata->triplebuf_mutex);
+    windowdata->x = window->x;
+    windowdata->y = window->y;
+    windowdata->hidden = hidden;
+    displaydata->redraw = SDL_TRUE;
+    MALI_WakeBlitter(displaydata);
+    SDL_UnlockMutex(displaydata->triplebuf_mutex);
+}
+
 void
 MALI_SetWindowPosition(_THIS, SDL_Window * window)
 {
+    SDL_WindowData *windowdata = (SDL_WindowData *)window->driverdata;
+    if (windowdata)
+        MALI_UpdatePlacement(window, windowdata->hidden);
 }
 
 void
@@ -558,11 +1103,13 @@ MALI_SetWindowFullscreen(_THIS, SDL_Window * window, SDL_VideoDisplay * display,
 void
 MALI_ShowWindow(_THIS, SDL_Window * window)
 {
+    MALI_UpdatePlacement(window, SDL_FALSE);
 }
 
 void
 MALI_HideWindow(_THIS, SDL_Window * window)
 {
+    MALI_UpdatePlacement(window, SDL_TRUE);
 }
 
 /*****************************************************************************/
@@ -19,6 +19,29 @@
 
 #include "mali.h"
 #include "ion.h"
+#include "SDL_maliswapchain.h"
+#include "SDL_maliscanout.h"
+#include "SDL_maliionpool.h"
+#include "SDL_malifb.h"
+#include "SDL_malidmabuf.h"
+#include "SDL_malivsync.h"
+#include "SDL_malitelemetry.h"
+#include "SDL_maliviewport.h"
+
+#define MALI_MAX_FRAME_TIMINGS 64
+#define MALI_MAX_FRAME_DAMAGE 16
+#define MALI_MAX_WINDOWS 8
+
+/* What the pages are allocated as, picked from the SDL_GL_*_SIZE attributes */
+typedef struct MALI_PixelFormat
+{
+    const char *name;
+    Uint64 mali_format;     // mali_pixmap::format
+    Uint32 fourcc;          // how the blitter imports the pages
+    Uint32 sdl_format;      // framebuffer layout direct scanout needs, unknown if there's none
+    int bytes_per_pixel;
+    int red_size, green_size, blue_size, alpha_size;
+} MALI_PixelFormat;
 
 typedef struct SDL_DisplayData
 {
@@ -30,34 +53,117 @@ typedef struct SDL_DisplayData
     NativePixmapType (*egl_destroy_pixmap_ID_mapping)(int id);
 
     int ion_fd, fb_fd;
+    MALI_IONPool ion_pool;
+
+    // The pixmap config last picked for a format from what SDL_EGL_ChooseConfig returned
+    EGLConfig pixmap_config_base, pixmap_config;
+    const MALI_PixelFormat *pixmap_config_format;
+
+    // The scaler SDL_HINT_MALI_SCALER names, resolved on the thread setting the hint
+    void *scaler;
+    SDL_atomic_t scaler_changed;
+
+    // Same for the viewport hints, each one updates its part of the policy
+    MALI_ViewportPolicy viewport;
+    SDL_SpinLock viewport_lock;
+    SDL_atomic_t viewport_changed;
+
+    // Updated by the blitter thread with triplebuf_mutex held, see SDL_GetWindowNextVsync
+    MALI_VsyncClock vsync;
+
+    // One blitter thread composites every window on the display, see MALI_TripleBufferingThread
+    SDL_mutex *triplebuf_mutex;
+    SDL_cond *triplebuf_cond;
+    SDL_sem *triplebuf_sem;     // wakes the blitter up, see MALI_WakeBlitter
+    SDL_atomic_t triplebuf_sleeping; // the blitter waits on triplebuf_sem, only the first waker posts it
+    SDL_Thread *triplebuf_thread;
+    int triplebuf_pages_ready;  // the bottom window's first pages exist, the blitter waits for them to start
+    int triplebuf_thread_ready;
+    int triplebuf_thread_stop;
+    MALI_StartupTiming startup;
+    SDL_bool redraw;            // a window was shown, hidden, moved or removed
+
+    // Bottom to top, the first window is scaled to the screen and the others drawn over it
+    SDL_Window *windows[MALI_MAX_WINDOWS];
+    int num_windows;
 } SDL_DisplayData;
 
 typedef struct MALI_EGL_Surface
 {
     // A pixmap is backed by multiple ION allocated backbuffers, EGL fences, etc.
+    // The blitter imports the pages of overlay windows into egl_image and texture.
     EGLImageKHR egl_image;
-    GLuint texture; 
+    GLuint texture;
     EGLSyncKHR fence;
     EGLSurface egl_surface;
     NativePixmapType pixmap_handle;
     mali_pixmap pixmap;
     int shared_fd;
     int handle;
+
+    // Timing of the frame last rendered into this page
+    Uint32 frame;
+    Uint64 swap_requested;
 } MALI_EGL_Surface;
 
+typedef struct MALI_FrameDamage
+{
+    // What changed in a frame compared to the previous one, in window coordinates. The
+    // application fills entries in without a lock, frame only matches once it is done.
+    Uint32 frame;
+    SDL_bool full;
+    SDL_Rect rect;
+} MALI_FrameDamage;
+
+/* Handshake with the blitter thread while the swap chain is resized underneath it */
+typedef enum MALI_Reconfigure
+{
+    MALI_RECONFIGURE_NONE = 0,
+    MALI_RECONFIGURE_REQUESTED,
+    MALI_RECONFIGURE_PAUSED,
+    MALI_RECONFIGURE_RESUMED,
+    MALI_RECONFIGURE_FAILED
+} MALI_Reconfigure;
+
 typedef struct SDL_WindowData
 {
     int prev_w, prev_h;
     int swapInterval;
-    int flip_page;
-    int current_page;
-    int new_page;
-    SDL_mutex *triplebuf_mutex;
-    SDL_cond *triplebuf_cond;
-    SDL_Thread *triplebuf_thread;
-    int triplebuf_thread_stop;
+    MALI_SwapChain swapchain;
+    SDL_DisplayData *displaydata;
+    MALI_Reconfigure reconfigure;
+
+    // Where the blitter puts the window, SDL_Window is updated only after the driver hears of a change
+    int x, y;
+    SDL_bool hidden;
+
+    // The blitter has shown a frame of this window, imported its pages as an overlay or failed to
+    SDL_bool shown;
+    SDL_bool overlay;
+    SDL_bool import_failed;
+
+    MALI_EGL_Surface surface[MALI_SWAPCHAIN_MAX_DEPTH];
+    const MALI_PixelFormat *format;
+
+    // Pages live in the framebuffer itself and are presented by panning, see SDL_HINT_MALI_DIRECT_SCANOUT
+    SDL_bool direct_scanout;
+    MALI_Scanout scanout;
+
+    // The pages mapped for the CPU while SDL_GetWindowSurface is in use
+    MALI_Framebuffer framebuffer;
+
+    // Frame handed over by SDL_PresentDMABUF that the blitter hasn't picked up yet
+    SDL_bool dmabuf_supported;
+    SDL_bool dmabuf_pending;
+    SDL_DMABUFFrame dmabuf_frame;
+
+    // Presented frames not yet read back through SDL_GL_GetFrameTimings, oldest first
+    Uint32 frame_count;
+    SDL_GLFrameTiming timings[MALI_MAX_FRAME_TIMINGS];
+    int timings_start, timings_count;
 
-    MALI_EGL_Surface surface[3];
+    // Damage of recent frames, indexed by frame number, so the blitter can catch up on dropped frames
+    MALI_FrameDamage damage[MALI_MAX_FRAME_DAMAGE];
 
     // The created EGL Surface is backed by a mali pixmap
 } SDL_WindowData;
@@ -79,6 +185,11 @@ void MALI_SetWindowFullscreen(_THIS, SDL_Window * window, SDL_VideoDisplay * dis
 void MALI_ShowWindow(_THIS, SDL_Window * window);
 void MALI_HideWindow(_THIS, SDL_Window * window);
 void MALI_DestroyWindow(_THIS, SDL_Window * window);
+int MALI_CreateWindowFramebuffer(_THIS, SDL_Window * window, Uint32 * format, void ** pixels, int *pitch);
+int MALI_UpdateWindowFramebuffer(_THIS, SDL_Window * window, const SDL_Rect * rects, int numrects);
+void MALI_DestroyWindowFramebuffer(_THIS, SDL_Window * window);
+int MALI_PresentDMABUF(_THIS, SDL_Window * window, const SDL_DMABUFFrame * frame);
+int MALI_GetWindowNextVsync(_THIS, SDL_Window * window, Uint64 * vsync, Uint64 * period);
 
 /* Window manager function */
 SDL_bool MALI_GetWindowWMInfo(_THIS, SDL_Window * window,
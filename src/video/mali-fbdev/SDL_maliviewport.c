@@ -0,0 +1,209 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+#include "SDL_log.h"
+
+#include "SDL_maliviewport.h"
+
+SDL_bool
+MALI_Viewport_ParseScaling(const char *hint, MALI_ViewportScaling *scaling)
+{
+    if (!hint || !*hint || SDL_strcasecmp(hint, "fit") == 0)
+        *scaling = MALI_VIEWPORT_FIT;
+    else if (SDL_strcasecmp(hint, "integer") == 0)
+        *scaling = MALI_VIEWPORT_INTEGER;
+    else if (SDL_strcasecmp(hint, "stretch") == 0)
+        *scaling = MALI_VIEWPORT_STRETCH;
+    else
+        return SDL_FALSE;
+
+    return SDL_TRUE;
+}
+
+/* "8:7", "8/7" or "1.143" */
+SDL_bool
+MALI_Viewport_ParseRatio(const char *hint, float *ratio)
+{
+    double width, height = 1.0;
+    char *end;
+
+    width = SDL_strtod(hint, &end);
+    if (end == hint)
+        return SDL_FALSE;
+
+    if (*end == ':' || *end == '/') {
+        hint = end + 1;
+        height = SDL_strtod(hint, &end);
+        if (end == hint)
+            return SDL_FALSE;
+    }
+
+    if (*end != '\0' || width <= 0.0 || height <= 0.0)
+        return SDL_FALSE;
+
+    *ratio = (float)(width / height);
+    return SDL_TRUE;
+}
+
+/* One value for every edge, "horizontal,vertical" or "left,top,right,bottom" */
+SDL_bool
+MALI_Viewport_ParseCrop(const char *hint, int crop[4])
+{
+    long values[4];
+    char *end;
+    int i, count = 0;
+
+    for (;;) {
+        values[count] = SDL_strtol(hint, &end, 10);
+        if (end == hint || values[count] < 0)
+            return SDL_FALSE;
+        count++;
+        if (*end == '\0')
+            break;
+        if (*end != ',' || count == 4)
+            return SDL_FALSE;
+        hint = end + 1;
+    }
+
+    for (i = 0; i < 4; i++) {
+        switch (count) {
+            case 1: crop[i] = (int)values[0]; break;
+            case 2: crop[i] = (int)values[i & 1]; break;
+            case 4: crop[i] = (int)values[i]; break;
+            default: return SDL_FALSE;
+        }
+    }
+
+    return SDL_TRUE;
+}
+
+const char *const MALI_Viewport_Hints[MALI_VIEWPORT_NUM_HINTS] = {
+    SDL_HINT_MALI_VIEWPORT,
+    SDL_HINT_MALI_PIXEL_ASPECT,
+    SDL_HINT_MALI_DISPLAY_ASPECT,
+    SDL_HINT_MALI_OVERSCAN
+};
+
+/* Sets the part of the policy one of the hints controls, back to its default if the value is empty or invalid */
+void
+MALI_Viewport_ApplyHint(MALI_ViewportPolicy *policy, const char *name, const char *hint)
+{
+    if (SDL_strcmp(name, SDL_HINT_MALI_VIEWPORT) == 0) {
+        if (!MALI_Viewport_ParseScaling(hint, &policy->scaling)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Unknown viewport scaling '%s'", hint);
+            policy->scaling = MALI_VIEWPORT_FIT;
+        }
+    } else if (SDL_strcmp(name, SDL_HINT_MALI_PIXEL_ASPECT) == 0) {
+        policy->pixel_aspect = 1.0f;
+        if (hint && *hint && !MALI_Viewport_ParseRatio(hint, &policy->pixel_aspect))
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Invalid pixel aspect '%s'", hint);
+    } else if (SDL_strcmp(name, SDL_HINT_MALI_DISPLAY_ASPECT) == 0) {
+        policy->display_aspect = 0.0f;
+        if (hint && *hint && !MALI_Viewport_ParseRatio(hint, &policy->display_aspect))
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Invalid display aspect '%s'", hint);
+    } else if (SDL_strcmp(name, SDL_HINT_MALI_OVERSCAN) == 0) {
+        SDL_zeroa(policy->crop);
+        if (hint && *hint && !MALI_Viewport_ParseCrop(hint, policy->crop))
+            SDL_LogWarn(SDL_LOG_CATEGORY_VIDEO, "mali-fbdev: Invalid overscan '%s'", hint);
+    }
+}
+
+void
+MALI_Viewport_GetPolicy(MALI_ViewportPolicy *policy)
+{
+    int i;
+
+    for (i = 0; i < MALI_VIEWPORT_NUM_HINTS; i++) {
+        MALI_Viewport_ApplyHint(policy, MALI_Viewport_Hints[i], SDL_GetHint(MALI_Viewport_Hints[i]));
+    }
+}
+
+/*
+ * The quad the blitter draws the bottom window with, x/y in viewport pixels and
+ * u/v in texels before the vertex shader turns them, and the scale factors for
+ * the scalers. The picture is sized in the window's orientation, then turned.
+ */
+void
+MALI_Viewport_GetQuad(const MALI_ViewportPolicy *policy, int rotation, int viewport_width, int viewport_height,
+                      int plane_width, int plane_height, float vert[4][4], float scale[2])
+{
+    int display_w = (rotation & 1) ? viewport_height : viewport_width;
+    int display_h = (rotation & 1) ? viewport_width : viewport_height;
+    int crop[4], edges[4], out_w, out_h, quad_w, quad_h, x0, y0;
+    float w, h, aspect, fit_w, fit_h, factor, u0, v0, u1, v1;
+    SDL_bool square;
+
+    /* Cropping everything away crops nothing */
+    SDL_memcpy(crop, policy->crop, sizeof(crop));
+    if (crop[0] + crop[2] >= plane_width)
+        crop[0] = crop[2] = 0;
+    if (crop[1] + crop[3] >= plane_height)
+        crop[1] = crop[3] = 0;
+
+    w = (float)(plane_width - crop[0] - crop[2]);
+    h = (float)(plane_height - crop[1] - crop[3]);
+    square = policy->display_aspect <= 0.0f && policy->pixel_aspect == 1.0f;
+    aspect = policy->display_aspect > 0.0f ? policy->display_aspect : w * policy->pixel_aspect / h;
+
+    /* Touch the display on the sides or the top and bottom */
+    if ((float)display_w / display_h > aspect) {
+        fit_w = display_h * aspect;
+        fit_h = (float)display_h;
+    } else {
+        fit_w = (float)display_w;
+        fit_h = display_w / aspect;
+    }
+
+    switch (policy->scaling) {
+        case MALI_VIEWPORT_STRETCH:
+            fit_w = (float)display_w;
+            fit_h = (float)display_h;
+            break;
+        case MALI_VIEWPORT_INTEGER:
+            /* Whole multiples of the lines, the width follows unless the pixels are square */
+            factor = SDL_floorf(fit_h / h + 0.001f);
+            if (factor >= 1.0f) {
+                fit_h = h * factor;
+                fit_w = square ? w * factor : fit_h * aspect;
+            }
+            break;
+        default:
+            break;
+    }
+
+    out_w = SDL_min((int)(fit_w + 0.5f), display_w);
+    out_h = SDL_min((int)(fit_h + 0.5f), display_h);
+
+    /* Turned onto the viewport and centered */
+    quad_w = (rotation & 1) ? out_h : out_w;
+    quad_h = (rotation & 1) ? out_w : out_h;
+    x0 = (viewport_width - quad_w) / 2;
+    y0 = (viewport_height - quad_h) / 2;
+
+    /*
+     * The edges of the window going counterclockwise from the left, in texture
+     * coordinates the bottom comes second. Turning the window turns which of
+     * them ends up at the low and high u and v.
+     */
+    edges[0] = crop[0];
+    edges[1] = crop[3];
+    edges[2] = crop[2];
+    edges[3] = crop[1];
+    u0 = (float)edges[(4 - rotation) % 4];
+    v0 = (float)edges[(5 - rotation) % 4];
+    u1 = (float)((rotation & 1) ? plane_height : plane_width) - edges[(6 - rotation) % 4];
+    v1 = (float)((rotation & 1) ? plane_width : plane_height) - edges[(7 - rotation) % 4];
+
+    vert[0][0] = x0;          vert[0][1] = y0;          vert[0][2] = u0; vert[0][3] = v0;
+    vert[1][0] = x0;          vert[1][1] = y0 + quad_h; vert[1][2] = u0; vert[1][3] = v1;
+    vert[2][0] = x0 + quad_w; vert[2][1] = y0;          vert[2][2] = u1; vert[2][3] = v0;
+    vert[3][0] = x0 + quad_w; vert[3][1] = y0 + quad_h; vert[3][2] = u1; vert[3][3] = v1;
+
+    /* Viewport pixels per texel, for filtering */
+    scale[0] = quad_w / (u1 - u0);
+    scale[1] = quad_h / (v1 - v0);
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
@@ -0,0 +1,44 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_maliviewport_h
+#define _SDL_maliviewport_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_stdinc.h"
+
+typedef enum MALI_ViewportScaling
+{
+    MALI_VIEWPORT_FIT = 0,      // as large as fits, letterboxed
+    MALI_VIEWPORT_INTEGER,      // whole multiples of the source lines where the picture fits at least once
+    MALI_VIEWPORT_STRETCH       // the whole display, aspect ignored
+} MALI_ViewportScaling;
+
+/*
+ * How the bottom window is laid out on the display, see SDL_HINT_MALI_VIEWPORT.
+ * Sizes are in the window's own orientation, the rotation is applied on top.
+ */
+typedef struct MALI_ViewportPolicy
+{
+    MALI_ViewportScaling scaling;
+    float pixel_aspect;         // width over height of a source pixel, 1 for square ones
+    float display_aspect;       // width over height of the whole picture, 0 to follow the pixels
+    int crop[4];                // source pixels cut off the left, top, right and bottom
+} MALI_ViewportPolicy;
+
+/* The hints making up the policy, they can be applied one at a time from a hint callback */
+#define MALI_VIEWPORT_NUM_HINTS 4
+extern const char *const MALI_Viewport_Hints[MALI_VIEWPORT_NUM_HINTS];
+
+void MALI_Viewport_GetPolicy(MALI_ViewportPolicy *policy);
+void MALI_Viewport_ApplyHint(MALI_ViewportPolicy *policy, const char *name, const char *hint);
+SDL_bool MALI_Viewport_ParseScaling(const char *hint, MALI_ViewportScaling *scaling);
+SDL_bool MALI_Viewport_ParseRatio(const char *hint, float *ratio);
+SDL_bool MALI_Viewport_ParseCrop(const char *hint, int crop[4]);
+
+void MALI_Viewport_GetQuad(const MALI_ViewportPolicy *policy, int rotation, int viewport_width, int viewport_height,
+                           int plane_width, int plane_height, float vert[4][4], float scale[2]);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_maliviewport_h */
@@ -0,0 +1,146 @@
+#include "../../SDL_internal.h"
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_timer.h"
+
+#include "SDL_malivsync.h"
+
+/* Anything outside of this is a driver making numbers up */
+#define MALI_VSYNC_MIN_RATE 20000
+#define MALI_VSYNC_MAX_RATE 250000
+
+/* Filter gains as divisors, the phase follows quickly and the period slowly */
+#define MALI_VSYNC_PHASE_GAIN  4
+#define MALI_VSYNC_PERIOD_GAIN 16
+
+/* Refreshes between two swaps that still count as keeping track, more is a stall */
+#define MALI_VSYNC_MAX_GAP 8
+
+static Uint32
+MALI_Vsync_CheckRate(Uint64 millihertz)
+{
+    if (millihertz < MALI_VSYNC_MIN_RATE || millihertz > MALI_VSYNC_MAX_RATE)
+        return 0;
+    return (Uint32)millihertz;
+}
+
+/* From the pixel clock and the blanking intervals, 0 when the driver leaves them out */
+Uint32
+MALI_Vsync_GetModeRate(const struct fb_var_screeninfo *vinfo)
+{
+    Uint64 htotal, vtotal, millihertz;
+
+    htotal = (Uint64)vinfo->xres + vinfo->left_margin + vinfo->right_margin + vinfo->hsync_len;
+    vtotal = (Uint64)vinfo->yres + vinfo->upper_margin + vinfo->lower_margin + vinfo->vsync_len;
+    if (vinfo->pixclock == 0 || htotal == 0 || vtotal == 0)
+        return 0;
+
+    /* pixclock is in picoseconds */
+    millihertz = 1000000000000000ULL / ((Uint64)vinfo->pixclock * htotal * vtotal);
+    if ((vinfo->vmode & FB_VMODE_MASK) == FB_VMODE_INTERLACED)
+        millihertz *= 2;
+    else if ((vinfo->vmode & FB_VMODE_MASK) == FB_VMODE_DOUBLE)
+        millihertz /= 2;
+
+    return MALI_Vsync_CheckRate(millihertz);
+}
+
+/* The median of the intervals between consecutive timestamps, a late wake-up skews only one of them */
+Uint32
+MALI_Vsync_GetMeasuredRate(const Uint64 *timestamps, int count)
+{
+    Uint64 intervals[MALI_VSYNC_MEASURE_FRAMES], interval;
+    int i, j, n = 0;
+
+    for (i = 1; i < count && n < MALI_VSYNC_MEASURE_FRAMES; i++) {
+        if (timestamps[i] <= timestamps[i - 1])
+            return 0;
+        interval = timestamps[i] - timestamps[i - 1];
+        for (j = n++; j > 0 && intervals[j - 1] > interval; j--) {
+            intervals[j] = intervals[j - 1];
+        }
+        intervals[j] = interval;
+    }
+
+    if (n == 0)
+        return 0;
+
+    return MALI_Vsync_CheckRate(SDL_GetPerformanceFrequency() * 1000 / intervals[n / 2]);
+}
+
+/* Times a few refreshes with FBIO_WAITFORVSYNC, 0 when the driver doesn't implement it */
+Uint32
+MALI_Vsync_Measure(const MALI_ScanoutOps *ops, int fd)
+{
+    Uint64 timestamps[MALI_VSYNC_MEASURE_FRAMES + 1];
+    int i;
+
+    /* The first wait lines us up with the refresh */
+    if (ops->wait_vsync(fd) < 0)
+        return 0;
+
+    for (i = 0; i < (int)SDL_arraysize(timestamps); i++) {
+        if (ops->wait_vsync(fd) < 0)
+            return 0;
+        timestamps[i] = SDL_GetPerformanceCounter();
+    }
+
+    return MALI_Vsync_GetMeasuredRate(timestamps, SDL_arraysize(timestamps));
+}
+
+void
+MALI_Vsync_Init(MALI_VsyncClock *clock, Uint32 millihertz)
+{
+    SDL_zerop(clock);
+    clock->nominal_period = SDL_GetPerformanceFrequency() * 1000 / (millihertz > 0 ? millihertz : 60000);
+    clock->period = clock->nominal_period;
+}
+
+/* A swap with vsync on returned at timestamp, so a refresh happened just before */
+void
+MALI_Vsync_Record(MALI_VsyncClock *clock, Uint64 timestamp)
+{
+    Uint64 elapsed, expected, n;
+    Sint64 error, limit = (Sint64)clock->period / 4;
+
+    if (clock->phase != 0 && timestamp > clock->phase) {
+        elapsed = timestamp - clock->phase;
+        n = (elapsed + clock->period / 2) / clock->period;
+        expected = clock->phase + n * clock->period;
+        error = (Sint64)(timestamp - expected);
+
+        if (n >= 1 && n <= MALI_VSYNC_MAX_GAP && error > -limit && error < limit) {
+            clock->period = (Uint64)((Sint64)clock->period + error / (Sint64)(n * MALI_VSYNC_PERIOD_GAIN));
+            clock->period = SDL_clamp(clock->period, clock->nominal_period * 3 / 4, clock->nominal_period * 5 / 4);
+            clock->phase = (Uint64)((Sint64)expected + error / MALI_VSYNC_PHASE_GAIN);
+            return;
+        }
+    }
+
+    /* The first refresh, or we lost track of them */
+    clock->phase = timestamp;
+}
+
+/* Refreshes between two swaps, rounded to the nearest */
+int
+MALI_Vsync_CountRefreshes(const MALI_VsyncClock *clock, Uint64 from, Uint64 to)
+{
+    if (to <= from)
+        return 0;
+    return (int)SDL_min((to - from + clock->period / 2) / clock->period, (Uint64)SDL_MAX_SINT32);
+}
+
+/* The first refresh after now, one period out while the phase is unknown */
+Uint64
+MALI_Vsync_Predict(const MALI_VsyncClock *clock, Uint64 now)
+{
+    if (clock->phase == 0)
+        return now + clock->period;
+    if (now < clock->phase)
+        return clock->phase;
+
+    return clock->phase + ((now - clock->phase) / clock->period + 1) * clock->period;
+}
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
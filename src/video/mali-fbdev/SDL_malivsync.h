@@ -0,0 +1,40 @@
+#include "../../SDL_internal.h"
+
+#ifndef _SDL_malivsync_h
+#define _SDL_malivsync_h
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include <linux/fb.h>
+
+#include "SDL_stdinc.h"
+
+#include "SDL_maliscanout.h"
+
+/* Refreshes timed by MALI_Vsync_Measure, the median interval is used */
+#define MALI_VSYNC_MEASURE_FRAMES 8
+
+/*
+ * Where the display is in its refresh cycle, an alpha-beta filter over the
+ * times the blitter's swaps return with vsync on. Starts out from the rate
+ * the display mode reports and follows the panel's actual clock from there.
+ */
+typedef struct MALI_VsyncClock
+{
+    Uint64 nominal_period;  // performance counter ticks per refresh, as reported
+    Uint64 period;          // as measured, kept within a quarter of the nominal one
+    Uint64 phase;           // time of the last refresh, 0 until one has been seen
+} MALI_VsyncClock;
+
+Uint32 MALI_Vsync_GetModeRate(const struct fb_var_screeninfo *vinfo);
+Uint32 MALI_Vsync_GetMeasuredRate(const Uint64 *timestamps, int count);
+Uint32 MALI_Vsync_Measure(const MALI_ScanoutOps *ops, int fd);
+
+void MALI_Vsync_Init(MALI_VsyncClock *clock, Uint32 millihertz);
+void MALI_Vsync_Record(MALI_VsyncClock *clock, Uint64 timestamp);
+int MALI_Vsync_CountRefreshes(const MALI_VsyncClock *clock, Uint64 from, Uint64 to);
+Uint64 MALI_Vsync_Predict(const MALI_VsyncClock *clock, Uint64 now);
+
+#endif /* SDL_VIDEO_DRIVER_MALI */
+
+#endif /* _SDL_malivsync_h */
@@ -0,0 +1,267 @@
+/*
+ * include/uapi/drm/drm.h and include/uapi/drm/drm_mode.h
+ *
+ * Copyright 1999 Precision Insight, Inc., Cedar Park, Texas.
+ * Copyright 2000 VA Linux Systems, Inc., Sunnyvale, California.
+ * Copyright (c) 2007 Dave Airlie <airlied@linux.ie>
+ * Copyright (c) 2007 Jakob Bornecrantz <wallbraker@gmail.com>
+ * Copyright (c) 2008 Red Hat Inc.
+ * Copyright (c) 2007-2008 Tungsten Graphics, Inc., Cedar Park, TX., USA
+ * Copyright (c) 2007-2008 Intel Corporation
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * VA LINUX SYSTEMS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Only the parts atomic modesetting of a single plane needs, the board
+ * toolchains don't always ship the DRM headers and libdrm isn't required.
+ */
+
+#ifndef _UAPI_DRM_MALI_H
+#define _UAPI_DRM_MALI_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+#define DRM_IOCTL_BASE          'd'
+#define DRM_IO(nr)              _IO(DRM_IOCTL_BASE, nr)
+#define DRM_IOW(nr, type)       _IOW(DRM_IOCTL_BASE, nr, type)
+#define DRM_IOWR(nr, type)      _IOWR(DRM_IOCTL_BASE, nr, type)
+
+#define DRM_CLIENT_CAP_UNIVERSAL_PLANES 2
+#define DRM_CLIENT_CAP_ATOMIC           3
+
+#define DRM_MODE_OBJECT_CRTC        0xcccccccc
+#define DRM_MODE_OBJECT_CONNECTOR   0xc0c0c0c0
+#define DRM_MODE_OBJECT_PLANE       0xeeeeeeee
+
+#define DRM_MODE_TYPE_PREFERRED     (1 << 3)
+#define DRM_MODE_CONNECTED          1
+#define DRM_PLANE_TYPE_PRIMARY      1
+
+#define DRM_MODE_PAGE_FLIP_EVENT        0x01
+#define DRM_MODE_ATOMIC_TEST_ONLY       0x0100
+#define DRM_MODE_ATOMIC_NONBLOCK        0x0200
+#define DRM_MODE_ATOMIC_ALLOW_MODESET   0x0400
+
+#define DRM_EVENT_FLIP_COMPLETE     0x02
+
+#define DRM_DISPLAY_MODE_LEN    32
+#define DRM_PROP_NAME_LEN       32
+
+struct drm_gem_close {
+    __u32 handle;
+    __u32 pad;
+};
+
+struct drm_set_client_cap {
+    __u64 capability;
+    __u64 value;
+};
+
+struct drm_prime_handle {
+    __u32 handle;
+    __u32 flags;
+    __s32 fd;
+};
+
+struct drm_mode_modeinfo {
+    __u32 clock;
+    __u16 hdisplay;
+    __u16 hsync_start;
+    __u16 hsync_end;
+    __u16 htotal;
+    __u16 hskew;
+    __u16 vdisplay;
+    __u16 vsync_start;
+    __u16 vsync_end;
+    __u16 vtotal;
+    __u16 vscan;
+    __u32 vrefresh;
+    __u32 flags;
+    __u32 type;
+    char name[DRM_DISPLAY_MODE_LEN];
+};
+
+struct drm_mode_card_res {
+    __u64 fb_id_ptr;
+    __u64 crtc_id_ptr;
+    __u64 connector_id_ptr;
+    __u64 encoder_id_ptr;
+    __u32 count_fbs;
+    __u32 count_crtcs;
+    __u32 count_connectors;
+    __u32 count_encoders;
+    __u32 min_width;
+    __u32 max_width;
+    __u32 min_height;
+    __u32 max_height;
+};
+
+struct drm_mode_create_dumb {
+    __u32 height;
+    __u32 width;
+    __u32 bpp;
+    __u32 flags;
+    __u32 handle;
+    __u32 pitch;
+    __u64 size;
+};
+
+struct drm_mode_crtc {
+    __u64 set_connectors_ptr;
+    __u32 count_connectors;
+    __u32 crtc_id;
+    __u32 fb_id;
+    __u32 x;
+    __u32 y;
+    __u32 gamma_size;
+    __u32 mode_valid;
+    struct drm_mode_modeinfo mode;
+};
+
+struct drm_mode_get_plane_res {
+    __u64 plane_id_ptr;
+    __u32 count_planes;
+};
+
+struct drm_mode_get_plane {
+    __u32 plane_id;
+    __u32 crtc_id;
+    __u32 fb_id;
+    __u32 possible_crtcs;
+    __u32 gamma_size;
+    __u32 count_format_types;
+    __u64 format_type_ptr;
+};
+
+struct drm_mode_get_encoder {
+    __u32 encoder_id;
+    __u32 encoder_type;
+    __u32 crtc_id;
+    __u32 possible_crtcs;
+    __u32 possible_clones;
+};
+
+struct drm_mode_get_connector {
+    __u64 encoders_ptr;
+    __u64 modes_ptr;
+    __u64 props_ptr;
+    __u64 prop_values_ptr;
+    __u32 count_modes;
+    __u32 count_props;
+    __u32 count_encoders;
+    __u32 encoder_id;
+    __u32 connector_id;
+    __u32 connector_type;
+    __u32 connector_type_id;
+    __u32 connection;
+    __u32 mm_width;
+    __u32 mm_height;
+    __u32 subpixel;
+    __u32 pad;
+};
+
+struct drm_mode_get_property {
+    __u64 values_ptr;
+    __u64 enum_blob_ptr;
+    __u32 prop_id;
+    __u32 flags;
+    char name[DRM_PROP_NAME_LEN];
+    __u32 count_values;
+    __u32 count_enum_blobs;
+};
+
+struct drm_mode_obj_get_properties {
+    __u64 props_ptr;
+    __u64 prop_values_ptr;
+    __u32 count_props;
+    __u32 obj_id;
+    __u32 obj_type;
+};
+
+struct drm_mode_fb_cmd2 {
+    __u32 fb_id;
+    __u32 width;
+    __u32 height;
+    __u32 pixel_format;
+    __u32 flags;
+    __u32 handles[4];
+    __u32 pitches[4];
+    __u32 offsets[4];
+    __u64 modifier[4];
+};
+
+struct drm_mode_atomic {
+    __u32 flags;
+    __u32 count_objs;
+    __u64 objs_ptr;
+    __u64 count_props_ptr;
+    __u64 props_ptr;
+    __u64 prop_values_ptr;
+    __u64 reserved;
+    __u64 user_data;
+};
+
+struct drm_mode_create_blob {
+    __u64 data;
+    __u32 length;
+    __u32 blob_id;
+};
+
+struct drm_mode_destroy_blob {
+    __u32 blob_id;
+};
+
+struct drm_event {
+    __u32 type;
+    __u32 length;
+};
+
+struct drm_event_vblank {
+    struct drm_event base;
+    __u64 user_data;
+    __u32 tv_sec;
+    __u32 tv_usec;
+    __u32 sequence;
+    __u32 crtc_id;
+};
+
+#define DRM_IOCTL_GEM_CLOSE             DRM_IOW(0x09, struct drm_gem_close)
+#define DRM_IOCTL_SET_CLIENT_CAP        DRM_IOW(0x0d, struct drm_set_client_cap)
+#define DRM_IOCTL_SET_MASTER            DRM_IO(0x1e)
+#define DRM_IOCTL_PRIME_HANDLE_TO_FD    DRM_IOWR(0x2d, struct drm_prime_handle)
+#define DRM_IOCTL_PRIME_FD_TO_HANDLE    DRM_IOWR(0x2e, struct drm_prime_handle)
+
+#define DRM_IOCTL_MODE_GETRESOURCES     DRM_IOWR(0xA0, struct drm_mode_card_res)
+#define DRM_IOCTL_MODE_GETCRTC          DRM_IOWR(0xA1, struct drm_mode_crtc)
+#define DRM_IOCTL_MODE_GETENCODER       DRM_IOWR(0xA6, struct drm_mode_get_encoder)
+#define DRM_IOCTL_MODE_GETCONNECTOR     DRM_IOWR(0xA7, struct drm_mode_get_connector)
+#define DRM_IOCTL_MODE_GETPROPERTY      DRM_IOWR(0xAA, struct drm_mode_get_property)
+#define DRM_IOCTL_MODE_RMFB             DRM_IOWR(0xAF, unsigned int)
+#define DRM_IOCTL_MODE_CREATE_DUMB      DRM_IOWR(0xB2, struct drm_mode_create_dumb)
+#define DRM_IOCTL_MODE_GETPLANERESOURCES DRM_IOWR(0xB5, struct drm_mode_get_plane_res)
+#define DRM_IOCTL_MODE_GETPLANE         DRM_IOWR(0xB6, struct drm_mode_get_plane)
+#define DRM_IOCTL_MODE_ADDFB2           DRM_IOWR(0xB8, struct drm_mode_fb_cmd2)
+#define DRM_IOCTL_MODE_OBJ_GETPROPERTIES DRM_IOWR(0xB9, struct drm_mode_obj_get_properties)
+#define DRM_IOCTL_MODE_ATOMIC           DRM_IOWR(0xBC, struct drm_mode_atomic)
+#define DRM_IOCTL_MODE_CREATEPROPBLOB   DRM_IOWR(0xBD, struct drm_mode_create_blob)
+#define DRM_IOCTL_MODE_DESTROYPROPBLOB  DRM_IOWR(0xBE, struct drm_mode_destroy_blob)
+
+#endif /* _UAPI_DRM_MALI_H */
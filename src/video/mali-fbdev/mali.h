@@ -42,6 +42,19 @@ enum Rotation
 };
 
 #define MALI_ALIGN(val, align)  (((val) + (align) - 1) & ~((align) - 1))
+
+/*
+ * Pixmap formats are the GPU's own pixel format descriptors: the format in bits
+ * 12-19 and a component swizzle of four 3 bit selectors (R, G, B, A, 0, 1) in the
+ * low bits, e.g. RGBA8 UNORM (0xbb) read as BGRA for ARGB8888.
+ */
 #define MALI_FORMAT_ARGB8888    (0x10bb60a)
+#define MALI_FORMAT_RGB565      (0x1040a88)
+#define MALI_FORMAT_ABGR2101010 (0x1043688)
+
+#ifndef fourcc_code
+#define fourcc_code(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | \
+                ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#endif
 
 #endif /* __MALI_H__ */
\ No newline at end of file
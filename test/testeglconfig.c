@@ -0,0 +1,115 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Benchmark of GL window and context creation, which is mostly choosing the
+ * EGL config on EGL drivers. Without a display, run it on Mesa's software
+ * rasterizer with the offscreen driver:
+ *
+ *   SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 ./testeglconfig [iterations]
+ *
+ * Each round creates a window, a context on it and destroys both, the way
+ * drivers recreate their surfaces on mode changes. Every other round asks
+ * for a depth buffer, so both a repeated and an alternating request are timed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+static double
+to_ms(Uint64 ticks)
+{
+    return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+static int
+run_rounds(int iterations, SDL_bool alternate, double *window_ms, double *context_ms)
+{
+    SDL_Window *window;
+    SDL_GLContext context;
+    Uint64 start, window_ticks = 0, context_ticks = 0;
+    int i;
+
+    for (i = 0; i < iterations; i++) {
+        SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, (alternate && (i & 1)) ? 24 : 0);
+
+        start = SDL_GetPerformanceCounter();
+        window = SDL_CreateWindow("testeglconfig", 0, 0, 64, 64, SDL_WINDOW_OPENGL);
+        window_ticks += SDL_GetPerformanceCounter() - start;
+        if (!window) {
+            SDL_Log("Couldn't create a window: %s\n", SDL_GetError());
+            return -1;
+        }
+
+        start = SDL_GetPerformanceCounter();
+        context = SDL_GL_CreateContext(window);
+        context_ticks += SDL_GetPerformanceCounter() - start;
+        if (!context) {
+            SDL_Log("Couldn't create a context: %s\n", SDL_GetError());
+            SDL_DestroyWindow(window);
+            return -1;
+        }
+
+        SDL_GL_DeleteContext(context);
+        SDL_DestroyWindow(window);
+    }
+
+    *window_ms = to_ms(window_ticks) / iterations;
+    *context_ms = to_ms(context_ticks) / iterations;
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int iterations = (argc > 1) ? SDL_atoi(argv[1]) : 200;
+    double window_ms, context_ms;
+    SDL_Window *window;
+
+    if (iterations <= 0) {
+        SDL_Log("USAGE: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        SDL_Log("Couldn't initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    /* The EGL drivers this matters for run GLES */
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+
+    /* Keeps the GL library loaded between rounds, like a running app */
+    window = SDL_CreateWindow("testeglconfig", 0, 0, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (!window) {
+        SDL_Log("Couldn't create a GL window: %s\n", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    printf("%s video driver, %d rounds\n", SDL_GetCurrentVideoDriver(), iterations);
+
+    if (run_rounds(iterations, SDL_FALSE, &window_ms, &context_ms) == 0) {
+        printf("same attributes:       window %.3f ms, context %.3f ms\n", window_ms, context_ms);
+    }
+    if (run_rounds(iterations, SDL_TRUE, &window_ms, &context_ms) == 0) {
+        printf("alternating depth:     window %.3f ms, context %.3f ms\n", window_ms, context_ms);
+    }
+
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Times creating an OpenGL ES 2.0 renderer and drawing its first frame with
+ * textures of every kind, once linking shader programs as they are needed,
+ * then twice with SDL_HINT_RENDER_GLES2_PRECOMPILE and the programs kept in
+ * SDL_HINT_RENDER_GLES2_PROGRAM_CACHE. The last run loads them all from the
+ * cache. Checks that the frames all come out the same. Without a display,
+ * run it on Mesa's software rasterizer with the offscreen driver. Mesa only
+ * hands out program binaries with its own shader cache on, start it empty:
+ *
+ *   SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 MESA_SHADER_CACHE_DIR=/tmp/empty ./testgles2programcache [directory]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+#define WINDOW_W 320
+#define WINDOW_H 240
+#define TEXTURE_SIZE 64
+
+static const Uint32 formats[] = {
+    SDL_PIXELFORMAT_ARGB8888,
+    SDL_PIXELFORMAT_ABGR8888,
+    SDL_PIXELFORMAT_RGB888,
+    SDL_PIXELFORMAT_BGR888,
+    SDL_PIXELFORMAT_IYUV,
+    SDL_PIXELFORMAT_NV12,
+    SDL_PIXELFORMAT_NV21
+};
+
+/* Draws a fill and a copy from a texture of every format */
+static int
+DrawFrame(SDL_Renderer *renderer)
+{
+    Uint8 pixels[TEXTURE_SIZE * TEXTURE_SIZE * 4];
+    SDL_Rect rect;
+    int i;
+
+    for (i = 0; i < SDL_arraysize(pixels); i++) {
+        pixels[i] = (Uint8) (i * 7 + i / (TEXTURE_SIZE * 4) * 13);
+    }
+
+    SDL_SetRenderDrawColor(renderer, 0x20, 0x40, 0x60, 0xFF);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderDrawColor(renderer, 0xC0, 0x80, 0x40, 0xFF);
+    rect.x = rect.y = 4;
+    rect.w = WINDOW_W - 8;
+    rect.h = 8;
+    SDL_RenderFillRect(renderer, &rect);
+
+    for (i = 0; i < SDL_arraysize(formats); i++) {
+        SDL_Texture *texture = SDL_CreateTexture(renderer, formats[i], SDL_TEXTUREACCESS_STATIC, TEXTURE_SIZE, TEXTURE_SIZE);
+        const int pitch = SDL_ISPIXELFORMAT_FOURCC(formats[i]) ? TEXTURE_SIZE : TEXTURE_SIZE * 4;
+
+        if (!texture) {
+            SDL_Log("Couldn't create a texture: %s\n", SDL_GetError());
+            return -1;
+        }
+        SDL_UpdateTexture(texture, NULL, pixels, pitch);
+
+        rect.x = 4 + (i % 4) * (TEXTURE_SIZE + 8);
+        rect.y = 16 + (i / 4) * (TEXTURE_SIZE + 8);
+        rect.w = rect.h = TEXTURE_SIZE;
+        SDL_RenderCopy(renderer, texture, NULL, &rect);
+        SDL_RenderFlush(renderer);
+        SDL_DestroyTexture(texture);
+    }
+    return 0;
+}
+
+static int
+Run(SDL_Window *window, const char *title, Uint32 *output)
+{
+    SDL_Renderer *renderer;
+    Uint64 start, created;
+    double freq = (double) SDL_GetPerformanceFrequency();
+    int retval = -1;
+
+    start = SDL_GetPerformanceCounter();
+    renderer = SDL_CreateRenderer(window, -1, 0);
+    if (!renderer) {
+        SDL_Log("Couldn't create a renderer: %s\n", SDL_GetError());
+        return -1;
+    }
+    created = SDL_GetPerformanceCounter();
+
+    if (DrawFrame(renderer) == 0 &&
+        SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, output, WINDOW_W * sizeof(Uint32)) == 0) {
+        printf("%-28s created in %7.2f ms, first frame in %7.2f ms\n", title,
+               (created - start) * 1000.0 / freq,
+               (SDL_GetPerformanceCounter() - created) * 1000.0 / freq);
+        retval = 0;
+    }
+
+    SDL_DestroyRenderer(renderer);
+    return retval;
+}
+
+int
+main(int argc, char *argv[])
+{
+    char *directory = (argc > 1) ? SDL_strdup(argv[1]) : SDL_GetPrefPath("libsdl", "testgles2programcache");
+    Uint32 *frames[3] = { NULL, NULL, NULL };
+    SDL_Window *window = NULL;
+    int i, rc = 1;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        SDL_Log("Couldn't initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengles2");
+    SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+
+    for (i = 0; i < SDL_arraysize(frames); i++) {
+        frames[i] = (Uint32 *) SDL_malloc(WINDOW_W * WINDOW_H * sizeof(Uint32));
+        if (!frames[i]) {
+            SDL_Log("Out of memory\n");
+            goto done;
+        }
+    }
+    window = SDL_CreateWindow("testgles2programcache", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_W, WINDOW_H, 0);
+    if (!window || !directory) {
+        SDL_Log("Couldn't create a window: %s\n", SDL_GetError());
+        goto done;
+    }
+
+    printf("programs kept in %s\n", directory);
+
+    if (Run(window, "linked when drawn with:", frames[0]) < 0) {
+        goto done;
+    }
+
+    SDL_SetHint(SDL_HINT_RENDER_GLES2_PRECOMPILE, "1");
+    SDL_SetHint(SDL_HINT_RENDER_GLES2_PROGRAM_CACHE, directory);
+    if (Run(window, "precompiled:", frames[1]) < 0 ||
+        Run(window, "precompiled from the cache:", frames[2]) < 0) {
+        goto done;
+    }
+
+    if (SDL_memcmp(frames[0], frames[1], WINDOW_W * WINDOW_H * sizeof(Uint32)) != 0 ||
+        SDL_memcmp(frames[0], frames[2], WINDOW_W * WINDOW_H * sizeof(Uint32)) != 0) {
+        printf("the frames differ\n");
+        goto done;
+    }
+    printf("the frames are the same\n");
+    rc = 0;
+
+done:
+    for (i = 0; i < SDL_arraysize(frames); i++) {
+        SDL_free(frames[i]);
+    }
+    SDL_free(directory);
+    if (window) {
+        SDL_DestroyWindow(window);
+    }
+    SDL_Quit();
+    return rc;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
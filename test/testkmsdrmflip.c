@@ -0,0 +1,354 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Test for the KMSDRM flip queue.
+ *
+ * The libdrm calls of the flip thread go to a fake display that completes a
+ * flip every 10 ms, which checks the FIFO and mailbox semantics, the flip
+ * timestamps and which buffers come back when. Run with SDL_VIDEODRIVER=kmsdrm,
+ * e.g. on the card of vkms after "modprobe vkms", a window is swapped with the
+ * queue as well and the time SDL_GL_SwapWindow() blocks is measured.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_KMSDRM
+
+#include "SDL.h"
+
+#include "../src/video/kmsdrm/SDL_kmsdrmflip.h"
+#include "../src/video/kmsdrm/SDL_kmsdrmflip.c"
+
+#define FLIP_MS 10
+
+/* What the flip thread calls, the other symbols aren't used by it */
+SDL_DYNKMSDRMFN_drmModeSetCrtc KMSDRM_drmModeSetCrtc;
+SDL_DYNKMSDRMFN_drmModePageFlip KMSDRM_drmModePageFlip;
+SDL_DYNKMSDRMFN_drmHandleEvent KMSDRM_drmHandleEvent;
+
+static struct
+{
+    int pipe[2];                // readable once the flip completed
+    SDL_bool lose_flips;
+    uint32_t crtc_fb;
+    uint32_t flipped[64];
+    int num_flipped;
+    void *user_data;
+    unsigned int sequence;
+} fake;
+
+static char bo_storage[16];
+
+#define BO(i) ((struct gbm_bo *)&bo_storage[i])
+
+static int
+Fake_SetCrtc(int fd, uint32_t crtc_id, uint32_t fb_id, uint32_t x, uint32_t y, uint32_t *connectors, int count,
+             drmModeModeInfoPtr mode)
+{
+    fake.crtc_fb = fb_id;
+    return 0;
+}
+
+static int
+Fake_PageFlip(int fd, uint32_t crtc_id, uint32_t fb_id, uint32_t flags, void *user_data)
+{
+    if (fake.num_flipped < (int)SDL_arraysize(fake.flipped))
+        fake.flipped[fake.num_flipped++] = fb_id;
+    fake.user_data = user_data;
+    if (!fake.lose_flips) {
+        SDL_Delay(FLIP_MS);
+        if (write(fake.pipe[1], "f", 1) != 1)
+            return -1;
+    }
+    return 0;
+}
+
+static int
+Fake_HandleEvent(int fd, drmEventContextPtr ev)
+{
+    char c;
+    Uint64 time;
+
+    if (read(fd, &c, 1) != 1)
+        return -1;
+
+    fake.sequence++;
+    time = 5000000 + (Uint64)fake.sequence * FLIP_MS * 1000;
+    ev->page_flip_handler(fd, fake.sequence, (unsigned int)(time / 1000000), (unsigned int)(time % 1000000),
+                          fake.user_data);
+    return 0;
+}
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); errors++; } } while (0)
+
+static void
+init_fake(void)
+{
+    if (fake.pipe[0] > 0) {
+        close(fake.pipe[0]);
+        close(fake.pipe[1]);
+    }
+    SDL_zero(fake);
+    if (pipe(fake.pipe) < 0)
+        CHECK(0, "no pipe");
+    KMSDRM_drmModeSetCrtc = Fake_SetCrtc;
+    KMSDRM_drmModePageFlip = Fake_PageFlip;
+    KMSDRM_drmHandleEvent = Fake_HandleEvent;
+}
+
+static SDL_bool
+init_queue(KMSDRM_FlipQueue *queue, const char *depth)
+{
+    drmModeModeInfo mode;
+
+    SDL_zero(mode);
+    init_fake();
+    SDL_SetHint(SDL_HINT_KMSDRM_FLIP_QUEUE, depth);
+    if (KMSDRM_FlipQueue_Init(queue, fake.pipe[0], 51, 31, &mode) < 0) {
+        CHECK(0, "init failed: %s", SDL_GetError());
+        return SDL_FALSE;
+    }
+    return SDL_TRUE;
+}
+
+/* Releases what came back, as the render thread does */
+static int
+collect(KMSDRM_FlipQueue *queue, SDL_bool *released, SDL_bool wait)
+{
+    struct gbm_bo *bos[KMSDRM_FLIP_QUEUE_BOS];
+    int i, count = KMSDRM_FlipQueue_Collect(queue, bos, wait);
+
+    for (i = 0; i < count; i++) {
+        CHECK(!released[(char *)bos[i] - bo_storage], "BO %d released twice", (int)((char *)bos[i] - bo_storage));
+        released[(char *)bos[i] - bo_storage] = SDL_TRUE;
+    }
+    return count;
+}
+
+static void
+test_disabled(void)
+{
+    KMSDRM_FlipQueue queue;
+
+    printf("without the hint\n");
+
+    init_queue(&queue, "");
+    CHECK(!queue.thread, "flip thread started without the hint");
+    init_queue(&queue, "0");
+    CHECK(!queue.thread, "flip thread started with a queue of 0 frames");
+    init_queue(&queue, "9");
+    CHECK(queue.thread && queue.depth == KMSDRM_FLIP_QUEUE_MAX, "depth of %d", queue.depth);
+    KMSDRM_FlipQueue_Quit(&queue, NULL);
+}
+
+static void
+test_fifo(void)
+{
+    KMSDRM_FlipQueue queue;
+    SDL_bool released[16] = { SDL_FALSE };
+    struct gbm_bo *bos[KMSDRM_FLIP_QUEUE_BOS];
+    Uint64 start, blocked = 0;
+    int i, count;
+
+    printf("FIFO\n");
+
+    if (!init_queue(&queue, "1"))
+        return;
+
+    /* Eight frames in a row, none is skipped and the producer is held back by the flips */
+    for (i = 0; i < 8; i++) {
+        start = SDL_GetPerformanceCounter();
+        CHECK(KMSDRM_FlipQueue_Push(&queue, BO(i), 100 + i, SDL_FALSE) == 0, "push %d: %s", i, SDL_GetError());
+        blocked += SDL_GetPerformanceCounter() - start;
+        collect(&queue, released, SDL_FALSE);
+    }
+    CHECK(blocked * 1000 / SDL_GetPerformanceFrequency() >= 4 * FLIP_MS, "producer ran ahead of the flips");
+
+    /* Nothing is in flight once the shown BOs stop coming back */
+    while (collect(&queue, released, SDL_TRUE) > 0) {
+    }
+
+    CHECK(fake.crtc_fb == 100, "first frame set on the CRTC as FB %u", fake.crtc_fb);
+    CHECK(fake.num_flipped == 7, "%d flips", fake.num_flipped);
+    for (i = 0; i < fake.num_flipped; i++) {
+        CHECK(fake.flipped[i] == 101 + (uint32_t)i, "flip %d of FB %u", i, fake.flipped[i]);
+    }
+    for (i = 0; i < 7; i++) {
+        CHECK(released[i], "BO %d not released after it left the screen", i);
+    }
+    CHECK(!released[7], "BO on screen released");
+
+    /* The timestamps come from the flip events */
+    CHECK(queue.flips == 7 && queue.flip_sequence == 7, "%u flips, sequence %u", queue.flips, queue.flip_sequence);
+    CHECK(queue.flip_time == 5000000 + 7 * FLIP_MS * 1000, "last flip at %d us", (int)queue.flip_time);
+    CHECK(queue.first_flip_time == 5000000 + FLIP_MS * 1000, "first flip at %d us", (int)queue.first_flip_time);
+
+    count = KMSDRM_FlipQueue_Quit(&queue, bos);
+    CHECK(count == 1 && bos[0] == BO(7), "%d BOs handed back on quit", count);
+    CHECK(!queue.thread, "thread left running");
+}
+
+static void
+test_mailbox(void)
+{
+    KMSDRM_FlipQueue queue;
+    SDL_bool released[16] = { SDL_FALSE };
+    struct gbm_bo *bos[KMSDRM_FLIP_QUEUE_BOS];
+    Uint64 start;
+    int i, count, total = 0;
+
+    printf("mailbox\n");
+
+    if (!init_queue(&queue, "1"))
+        return;
+
+    /* Faster than the display, the producer is never held back and frames get replaced */
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < 12; i++) {
+        CHECK(KMSDRM_FlipQueue_Push(&queue, BO(i), 100 + i, SDL_TRUE) == 0, "push %d: %s", i, SDL_GetError());
+        total += collect(&queue, released, SDL_FALSE);
+    }
+    CHECK((SDL_GetPerformanceCounter() - start) * 1000 / SDL_GetPerformanceFrequency() < 3 * FLIP_MS,
+          "producer held back");
+
+    while ((count = collect(&queue, released, SDL_TRUE)) > 0) {
+        total += count;
+    }
+
+    CHECK(queue.dropped > 0, "no frame replaced");
+    CHECK(fake.num_flipped + 1 + (int)queue.dropped == 12, "%d flips and %u dropped of 12 frames",
+          fake.num_flipped, queue.dropped);
+    CHECK(fake.num_flipped == 0 || fake.flipped[fake.num_flipped - 1] == 111, "newest frame not shown last");
+    CHECK(total == 11, "%d BOs released", total);
+
+    count = KMSDRM_FlipQueue_Quit(&queue, bos);
+    CHECK(count == 1 && bos[0] == BO(11), "%d BOs handed back on quit", count);
+}
+
+static void
+test_lost_flip(void)
+{
+    KMSDRM_FlipQueue queue;
+    SDL_bool released[16] = { SDL_FALSE };
+    struct gbm_bo *bos[KMSDRM_FLIP_QUEUE_BOS];
+    int count;
+
+    printf("lost flip\n");
+
+    if (!init_queue(&queue, "1"))
+        return;
+
+    KMSDRM_FlipQueue_Push(&queue, BO(0), 100, SDL_FALSE);
+    fake.lose_flips = SDL_TRUE;
+    KMSDRM_FlipQueue_Push(&queue, BO(1), 101, SDL_FALSE);
+    KMSDRM_FlipQueue_Push(&queue, BO(2), 102, SDL_FALSE);
+
+    /* The thread gives up after the timeout, producers don't wait anymore */
+    CHECK(KMSDRM_FlipQueue_Push(&queue, BO(3), 103, SDL_FALSE) < 0, "push after a lost flip");
+    CHECK(collect(&queue, released, SDL_TRUE) == 0, "BO of a lost flip came back");
+
+    /* The one that may still be scanned out stays locked */
+    count = KMSDRM_FlipQueue_Quit(&queue, bos);
+    CHECK(count == 2, "%d BOs handed back on quit", count);
+}
+
+/* Swaps on the real display, the time spent in SDL_GL_SwapWindow() shows whether it waits for flips */
+static void
+test_device(const char *depth)
+{
+    SDL_Window *window;
+    SDL_GLContext context;
+    void (*clear_color)(float, float, float, float);
+    void (*clear)(unsigned int);
+    Uint64 start, frame_start, blocked = 0;
+    double elapsed;
+    int i, frames = 120;
+
+    SDL_SetHint(SDL_HINT_KMSDRM_FLIP_QUEUE, depth);
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0) {
+        CHECK(0, "video init: %s", SDL_GetError());
+        return;
+    }
+
+    window = SDL_CreateWindow("testkmsdrmflip", 0, 0, 0, 0, SDL_WINDOW_OPENGL | SDL_WINDOW_FULLSCREEN_DESKTOP);
+    context = window ? SDL_GL_CreateContext(window) : NULL;
+    if (!context) {
+        CHECK(0, "no GL window: %s", SDL_GetError());
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+        return;
+    }
+
+    clear_color = SDL_GL_GetProcAddress("glClearColor");
+    clear = SDL_GL_GetProcAddress("glClear");
+    SDL_GL_SetSwapInterval(1);
+
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < frames; i++) {
+        clear_color((i & 1) ? 1.0f : 0.0f, 0.0f, 0.0f, 1.0f);
+        clear(0x00004000);  /* GL_COLOR_BUFFER_BIT */
+        frame_start = SDL_GetPerformanceCounter();
+        SDL_GL_SwapWindow(window);
+        blocked += SDL_GetPerformanceCounter() - frame_start;
+    }
+    elapsed = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    printf("  queue of %s: %.1f fps, %.2f ms per swap\n", depth, frames / elapsed,
+           blocked * 1000.0 / SDL_GetPerformanceFrequency() / frames);
+
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(window);
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+}
+
+static int
+run_test(void)
+{
+    const char *driver = SDL_getenv("SDL_VIDEODRIVER");
+
+    test_disabled();
+    test_fifo();
+    test_mailbox();
+    test_lost_flip();
+    if (driver && SDL_strcmp(driver, "kmsdrm") == 0) {
+        printf("flips on the display\n");
+        test_device("0");
+        test_device("1");
+    }
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the KMSDRM video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Headless test for importing DMA-BUF frames into the mali-fbdev blitter.
+ *
+ * Decoder buffers are stood in for by memfd buffers and the EGLImage import by
+ * a stub that keeps the attributes it was given, so frame validation, the
+ * EGL_EXT_image_dma_buf_import attributes for multi-plane YUV and the import
+ * cache can be checked on any host.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI && SDL_VIDEO_OPENGL_EGL
+
+#include "../src/video/mali-fbdev/SDL_malidmabuf.h"
+#include "../src/video/mali-fbdev/SDL_malidmabuf.c"
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); errors++; } } while (0)
+
+static struct
+{
+    EGLint attribs[MALI_DMABUF_MAX_ATTRIBS];
+    int imports;
+    int releases;
+    int live;
+    SDL_bool fail;
+} fake;
+
+static EGLint
+find_attrib(const EGLint *attribs, EGLint name)
+{
+    int i;
+
+    for (i = 0; attribs[i] != EGL_NONE; i += 2) {
+        if (attribs[i] == name)
+            return attribs[i + 1];
+    }
+
+    return -1;
+}
+
+static int
+Stub_Import(void *data, const EGLint *attribs, MALI_DMABUFImage *image)
+{
+    int i;
+
+    if (fake.fail)
+        return SDL_SetError("import failed");
+
+    for (i = 0; i < MALI_DMABUF_MAX_ATTRIBS; i++) {
+        fake.attribs[i] = attribs[i];
+        if (attribs[i] == EGL_NONE)
+            break;
+    }
+
+    /* Like an EGLImage, hold on to the buffer so its inode can't be reused */
+    fake.imports++;
+    fake.live++;
+    image->image = (EGLImageKHR)(intptr_t)fake.imports;
+    image->texture = dup(find_attrib(attribs, EGL_DMA_BUF_PLANE0_FD_EXT));
+    return 0;
+}
+
+static void
+Stub_Release(void *data, MALI_DMABUFImage *image)
+{
+    CHECK(image->image != EGL_NO_IMAGE_KHR, "released an image that was never imported");
+    image->image = EGL_NO_IMAGE_KHR;
+    close(image->texture);
+    fake.releases++;
+    fake.live--;
+}
+
+static const MALI_DMABUFImportOps stub_ops = {
+    Stub_Import,
+    Stub_Release
+};
+
+static int
+create_buffer(size_t size)
+{
+    int fd = memfd_create("testmalidmabuf", MFD_CLOEXEC);
+
+    if (fd >= 0 && ftruncate(fd, size) < 0) {
+        close(fd);
+        fd = -1;
+    }
+    CHECK(fd >= 0, "memfd_create failed");
+    return fd;
+}
+
+/* A decoder style NV12 frame, chroma follows the luma plane padded to 16 rows */
+static SDL_DMABUFFrame
+nv12_frame(int fd, int w, int h)
+{
+    SDL_DMABUFFrame frame;
+    int pitch = (w + 63) & ~63;
+
+    SDL_zero(frame);
+    frame.format = SDL_PIXELFORMAT_NV12;
+    frame.w = w;
+    frame.h = h;
+    frame.num_planes = 2;
+    frame.planes[0].fd = fd;
+    frame.planes[0].pitch = pitch;
+    frame.planes[1].fd = fd;
+    frame.planes[1].offset = pitch * ((h + 15) & ~15);
+    frame.planes[1].pitch = pitch;
+    frame.conversion_mode = SDL_YUV_CONVERSION_AUTOMATIC;
+    return frame;
+}
+
+static size_t
+nv12_size(int w, int h)
+{
+    return (size_t)((w + 63) & ~63) * ((h + 15) & ~15) * 3 / 2;
+}
+
+static void
+test_attributes(void)
+{
+    EGLint attribs[MALI_DMABUF_MAX_ATTRIBS];
+    SDL_DMABUFFrame frame;
+    int fd, y, u, v, n;
+
+    printf("import attributes\n");
+
+    fd = create_buffer(nv12_size(1920, 1080));
+    frame = nv12_frame(fd, 1920, 1080);
+    n = MALI_DMABUF_GetAttributes(&frame, attribs, SDL_arraysize(attribs));
+    CHECK(n > 0 && attribs[n] == EGL_NONE, "NV12 attributes not terminated");
+    CHECK(find_attrib(attribs, EGL_LINUX_DRM_FOURCC_EXT) == SDL_FOURCC('N', 'V', '1', '2'), "NV12 fourcc");
+    CHECK(find_attrib(attribs, EGL_WIDTH) == 1920 && find_attrib(attribs, EGL_HEIGHT) == 1080, "NV12 size");
+    CHECK(find_attrib(attribs, EGL_DMA_BUF_PLANE0_FD_EXT) == fd && find_attrib(attribs, EGL_DMA_BUF_PLANE1_FD_EXT) == fd, "NV12 fds");
+    CHECK(find_attrib(attribs, EGL_DMA_BUF_PLANE1_OFFSET_EXT) == 1920 * 1088, "NV12 chroma offset %d",
+          find_attrib(attribs, EGL_DMA_BUF_PLANE1_OFFSET_EXT));
+    CHECK(find_attrib(attribs, EGL_DMA_BUF_PLANE2_FD_EXT) == -1, "NV12 has a third plane");
+    CHECK(find_attrib(attribs, EGL_YUV_COLOR_SPACE_HINT_EXT) == EGL_ITU_REC709_EXT, "HD frame isn't BT.709");
+    CHECK(find_attrib(attribs, EGL_SAMPLE_RANGE_HINT_EXT) == EGL_YUV_NARROW_RANGE_EXT, "video isn't narrow range");
+
+    /* SD content defaults to BT.601, JPEG is full range */
+    frame = nv12_frame(fd, 720, 576);
+    MALI_DMABUF_GetAttributes(&frame, attribs, SDL_arraysize(attribs));
+    CHECK(find_attrib(attribs, EGL_YUV_COLOR_SPACE_HINT_EXT) == EGL_ITU_REC601_EXT, "SD frame isn't BT.601");
+    frame.conversion_mode = SDL_YUV_CONVERSION_JPEG;
+    MALI_DMABUF_GetAttributes(&frame, attribs, SDL_arraysize(attribs));
+    CHECK(find_attrib(attribs, EGL_SAMPLE_RANGE_HINT_EXT) == EGL_YUV_FULL_RANGE_EXT, "JPEG isn't full range");
+    close(fd);
+
+    /* Three planes in three buffers, YV12 keeps V before U */
+    y = create_buffer(640 * 480);
+    u = create_buffer(320 * 240);
+    v = create_buffer(320 * 240);
+    SDL_zero(frame);
+    frame.format = SDL_PIXELFORMAT_YV12;
+    frame.w = 640;
+    frame.h = 480;
+    frame.num_planes = 3;
+    frame.planes[0] = (SDL_DMABUFPlane){ y, 0, 640 };
+    frame.planes[1] = (SDL_DMABUFPlane){ v, 0, 320 };
+    frame.planes[2] = (SDL_DMABUFPlane){ u, 0, 320 };
+    CHECK(MALI_DMABUF_Validate(&frame) == 0, "YV12 frame rejected: %s", SDL_GetError());
+    MALI_DMABUF_GetAttributes(&frame, attribs, SDL_arraysize(attribs));
+    CHECK(find_attrib(attribs, EGL_LINUX_DRM_FOURCC_EXT) == SDL_FOURCC('Y', 'V', '1', '2'), "YV12 fourcc");
+    CHECK(find_attrib(attribs, EGL_DMA_BUF_PLANE1_FD_EXT) == v && find_attrib(attribs, EGL_DMA_BUF_PLANE2_FD_EXT) == u,
+          "YV12 planes out of order");
+    frame.format = SDL_PIXELFORMAT_IYUV;
+    MALI_DMABUF_GetAttributes(&frame, attribs, SDL_arraysize(attribs));
+    CHECK(find_attrib(attribs, EGL_LINUX_DRM_FOURCC_EXT) == SDL_FOURCC('Y', 'U', '1', '2'), "IYUV fourcc");
+    close(y);
+    close(u);
+    close(v);
+
+    /* RGB doesn't need any conversion hints */
+    fd = create_buffer(64 * 64 * 4);
+    SDL_zero(frame);
+    frame.format = SDL_PIXELFORMAT_ARGB8888;
+    frame.w = frame.h = 64;
+    frame.num_planes = 1;
+    frame.planes[0] = (SDL_DMABUFPlane){ fd, 0, 256 };
+    MALI_DMABUF_GetAttributes(&frame, attribs, SDL_arraysize(attribs));
+    CHECK(find_attrib(attribs, EGL_LINUX_DRM_FOURCC_EXT) == SDL_FOURCC('A', 'R', '2', '4'), "ARGB8888 fourcc");
+    CHECK(find_attrib(attribs, EGL_YUV_COLOR_SPACE_HINT_EXT) == -1, "RGB frame has YUV hints");
+    close(fd);
+}
+
+static void
+test_validate(void)
+{
+    SDL_DMABUFFrame frame;
+    int fd;
+
+    printf("frame validation\n");
+
+    fd = create_buffer(nv12_size(1280, 720));
+    frame = nv12_frame(fd, 1280, 720);
+    CHECK(MALI_DMABUF_Validate(&frame) == 0, "NV12 frame rejected: %s", SDL_GetError());
+
+    frame.num_planes = 1;
+    CHECK(MALI_DMABUF_Validate(&frame) < 0, "NV12 with one plane accepted");
+
+    frame = nv12_frame(fd, 1280, 720);
+    frame.planes[1].offset += 64;
+    CHECK(MALI_DMABUF_Validate(&frame) < 0, "chroma past the end of the buffer accepted");
+
+    frame = nv12_frame(fd, 1280, 720);
+    frame.planes[0].pitch = 1024;
+    CHECK(MALI_DMABUF_Validate(&frame) < 0, "pitch narrower than the frame accepted");
+
+    frame = nv12_frame(-1, 1280, 720);
+    CHECK(MALI_DMABUF_Validate(&frame) < 0, "invalid descriptor accepted");
+
+    frame = nv12_frame(fd, 1280, 720);
+    frame.format = SDL_PIXELFORMAT_RGB24;
+    CHECK(MALI_DMABUF_Validate(&frame) < 0, "RGB24 accepted");
+
+    /* The size check mustn't move the descriptor's file offset for good */
+    CHECK(lseek(fd, 0, SEEK_CUR) == 0, "file offset left at %ld", (long)lseek(fd, 0, SEEK_CUR));
+    close(fd);
+}
+
+static void
+test_cache(void)
+{
+    MALI_DMABUFCache cache;
+    MALI_DMABUFImage *image, *again;
+    SDL_DMABUFFrame frame;
+    int pool[MALI_DMABUF_CACHE_SIZE + 1];
+    int fd, dup_fd, i;
+
+    printf("import cache\n");
+
+    SDL_zero(fake);
+    MALI_DMABUFCache_Init(&cache, &stub_ops, NULL);
+
+    /* A decoder cycling through its pool only imports every buffer once */
+    for (i = 0; i < 4; i++) {
+        pool[i] = create_buffer(nv12_size(1920, 1080));
+    }
+    for (i = 0; i < 40; i++) {
+        frame = nv12_frame(pool[i % 4], 1920, 1080);
+        image = MALI_DMABUFCache_Get(&cache, &frame);
+        CHECK(image != NULL, "import failed: %s", SDL_GetError());
+    }
+    CHECK(fake.imports == 4 && cache.hits == 36, "%d imports, %u hits for a pool of 4", fake.imports, cache.hits);
+
+    /* Same buffer through another descriptor is still the same buffer */
+    frame = nv12_frame(pool[1], 1920, 1080);
+    image = MALI_DMABUFCache_Get(&cache, &frame);
+    dup_fd = dup(pool[1]);
+    frame = nv12_frame(dup_fd, 1920, 1080);
+    again = MALI_DMABUFCache_Get(&cache, &frame);
+    CHECK(image == again && fake.imports == 4, "dup'd descriptor imported again");
+    close(dup_fd);
+
+    /* The same buffer split differently is a different image */
+    frame = nv12_frame(pool[1], 1920, 1080);
+    frame.planes[1].offset = 1920 * 1080;
+    CHECK(MALI_DMABUFCache_Get(&cache, &frame) != image && fake.imports == 5, "chroma offset ignored by the cache");
+
+    /* A new stream at another size drops the buffers of the old one */
+    fd = create_buffer(nv12_size(1280, 720));
+    frame = nv12_frame(fd, 1280, 720);
+    CHECK(MALI_DMABUFCache_Get(&cache, &frame) != NULL, "import failed");
+    CHECK(cache.count == 1 && fake.live == 1, "%d images left over from the previous stream", cache.count - 1);
+    close(fd);
+    for (i = 0; i < 4; i++) {
+        close(pool[i]);
+    }
+
+    /* More buffers than fit, the least recently used one goes */
+    for (i = 0; i <= MALI_DMABUF_CACHE_SIZE; i++) {
+        pool[i] = create_buffer(nv12_size(1280, 720));
+        frame = nv12_frame(pool[i], 1280, 720);
+        MALI_DMABUFCache_Get(&cache, &frame);
+        if (i == 0) {
+            /* Keep the first one in use */
+            continue;
+        }
+        frame = nv12_frame(pool[0], 1280, 720);
+        MALI_DMABUFCache_Get(&cache, &frame);
+    }
+    CHECK(cache.count == MALI_DMABUF_CACHE_SIZE && fake.live == MALI_DMABUF_CACHE_SIZE, "%d images cached", cache.count);
+    frame = nv12_frame(pool[0], 1280, 720);
+    i = fake.imports;
+    MALI_DMABUFCache_Get(&cache, &frame);
+    CHECK(fake.imports == i, "buffer in use was evicted");
+    frame = nv12_frame(pool[1], 1280, 720);
+    MALI_DMABUFCache_Get(&cache, &frame);
+    CHECK(fake.imports == i + 1, "least recently used buffer wasn't evicted");
+
+    /* A failed import leaves nothing behind */
+    fake.fail = SDL_TRUE;
+    fd = create_buffer(nv12_size(1280, 720));
+    frame = nv12_frame(fd, 1280, 720);
+    i = cache.count;
+    CHECK(MALI_DMABUFCache_Get(&cache, &frame) == NULL && cache.count <= i, "failed import cached");
+    fake.fail = SDL_FALSE;
+    close(fd);
+
+    MALI_DMABUFCache_Quit(&cache);
+    CHECK(cache.count == 0 && fake.live == 0, "%d images leaked", fake.live);
+    for (i = 0; i <= MALI_DMABUF_CACHE_SIZE; i++) {
+        close(pool[i]);
+    }
+}
+
+static int
+run_test(void)
+{
+    test_attributes();
+    test_validate();
+    test_cache();
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
@@ -0,0 +1,581 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Headless test for the mali-fbdev DRM scanout backend.
+ *
+ * A fake KMS device with a couple of connectors, CRTCs and planes answers the
+ * ioctls, which checks how the display and its primary plane are picked and
+ * what the atomic commits and flip waits look like. With SDL_MALI_DRM_DEVICE
+ * set to a real card, e.g. the one of vkms after "modprobe vkms", dumb buffers
+ * are flipped on it as well.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "../src/video/mali-fbdev/SDL_malidrm.h"
+#include "../src/video/mali-fbdev/SDL_malidrm.c"
+#include "../src/video/mali-fbdev/SDL_maliswapchain.h"
+#include "../src/video/mali-fbdev/SDL_maliswapchain.c"
+#include "../src/video/mali-fbdev/SDL_maliscanout.h"
+#include "../src/video/mali-fbdev/SDL_maliscanout.c"
+
+#define FAKE_FD 7
+#define FOURCC(a, b, c, d) ((Uint32)(a) | ((Uint32)(b) << 8) | ((Uint32)(c) << 16) | ((Uint32)(d) << 24))
+#define XR24 FOURCC('X', 'R', '2', '4')
+#define AR24 FOURCC('A', 'R', '2', '4')
+#define RG16 FOURCC('R', 'G', '1', '6')
+
+/*
+ * Connector 30 is unplugged, 31 is plugged in through encoder 40, which can
+ * drive the second of the CRTCs 50 and 51. Plane 60 is an overlay, 61 and 62
+ * the primary planes of the two CRTCs.
+ */
+enum
+{
+    PROP_TYPE = 100, PROP_FB_ID, PROP_PLANE_CRTC_ID, PROP_SRC_X, PROP_SRC_Y, PROP_SRC_W, PROP_SRC_H,
+    PROP_CRTC_X, PROP_CRTC_Y, PROP_CRTC_W, PROP_CRTC_H, PROP_ACTIVE, PROP_MODE_ID, PROP_CONNECTOR_CRTC_ID,
+    PROP_END
+};
+
+static const char *prop_names[PROP_END - PROP_TYPE] = {
+    "type", "FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+    "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H", "ACTIVE", "MODE_ID", "CRTC_ID"
+};
+
+static struct
+{
+    SDL_bool no_atomic;
+    SDL_bool not_master;
+    SDL_bool unplugged;
+    SDL_bool lit;               // the console has CRTC 51 running at 720p
+    SDL_bool lose_flips;
+    Uint32 num_fbs;
+    struct drm_mode_fb_cmd2 fbs[8];
+    Uint32 blob;
+    Uint64 values[PROP_END];    // what the commits set
+    int commits;
+    Uint32 commit_flags;
+    int commit_objs;
+    SDL_bool flip_pending;
+    Uint64 flip_page;
+    Uint32 sequence;
+    int rmfbs, gem_closes, blobs_destroyed, closes;
+} fake;
+
+static struct drm_mode_modeinfo
+make_mode(int w, int h, Uint32 type)
+{
+    struct drm_mode_modeinfo mode;
+
+    SDL_zero(mode);
+    mode.hdisplay = w;
+    mode.vdisplay = h;
+    mode.vrefresh = 60;
+    mode.type = type;
+    SDL_snprintf(mode.name, sizeof(mode.name), "%dx%d", w, h);
+    return mode;
+}
+
+static int
+Fake_Open(const char *path)
+{
+    return FAKE_FD;
+}
+
+static void
+Fake_Close(int fd)
+{
+    fake.closes++;
+}
+
+static void
+fill_u32(__u64 ptr, __u32 capacity, __u32 *count, const __u32 *ids, __u32 n)
+{
+    __u32 i;
+
+    for (i = 0; i < n && i < capacity; i++) {
+        ((__u32 *)(uintptr_t)ptr)[i] = ids[i];
+    }
+    *count = n;
+}
+
+static int
+fake_properties(struct drm_mode_obj_get_properties *obj)
+{
+    __u32 ids[16], n = 0, i;
+    __u64 values[16];
+
+    if (obj->obj_type == DRM_MODE_OBJECT_PLANE) {
+        ids[n] = PROP_TYPE;
+        values[n++] = obj->obj_id == 60 ? 0 : DRM_PLANE_TYPE_PRIMARY;
+        for (i = PROP_FB_ID; i <= PROP_CRTC_H; i++) {
+            ids[n] = i;
+            values[n++] = 0;
+        }
+    } else if (obj->obj_type == DRM_MODE_OBJECT_CRTC) {
+        ids[n] = PROP_ACTIVE;
+        values[n++] = 0;
+        ids[n] = PROP_MODE_ID;
+        values[n++] = 0;
+    } else if (obj->obj_type == DRM_MODE_OBJECT_CONNECTOR) {
+        ids[n] = PROP_CONNECTOR_CRTC_ID;
+        values[n++] = 0;
+    } else {
+        return -1;
+    }
+
+    for (i = 0; i < n && i < obj->count_props; i++) {
+        ((__u32 *)(uintptr_t)obj->props_ptr)[i] = ids[i];
+        ((__u64 *)(uintptr_t)obj->prop_values_ptr)[i] = values[i];
+    }
+    obj->count_props = n;
+    return 0;
+}
+
+static int
+fake_connector(struct drm_mode_get_connector *conn)
+{
+    struct drm_mode_modeinfo modes[2];
+    __u32 encoder = 40;
+
+    if (conn->connector_id != 30 && conn->connector_id != 31)
+        return -1;
+
+    conn->connection = (conn->connector_id == 31 && !fake.unplugged) ? DRM_MODE_CONNECTED : 2;
+    if (conn->connection != DRM_MODE_CONNECTED) {
+        conn->count_modes = conn->count_encoders = 0;
+        return 0;
+    }
+
+    modes[0] = make_mode(1280, 720, 0);
+    modes[1] = make_mode(1920, 1080, DRM_MODE_TYPE_PREFERRED);
+    conn->encoder_id = fake.lit ? 40 : 0;
+
+    /* All or nothing, like the kernel */
+    if (conn->count_modes >= 2 && conn->modes_ptr)
+        SDL_memcpy((void *)(uintptr_t)conn->modes_ptr, modes, sizeof(modes));
+    if (conn->count_encoders >= 1 && conn->encoders_ptr)
+        *(__u32 *)(uintptr_t)conn->encoders_ptr = encoder;
+    conn->count_modes = 2;
+    conn->count_encoders = 1;
+    return 0;
+}
+
+static int
+fake_plane(struct drm_mode_get_plane *plane)
+{
+    static const __u32 formats[] = { XR24, AR24 };
+
+    if (plane->plane_id < 60 || plane->plane_id > 62)
+        return -1;
+
+    plane->possible_crtcs = plane->plane_id == 60 ? 3 : plane->plane_id == 61 ? 1 : 2;
+    if (plane->count_format_types >= SDL_arraysize(formats) && plane->format_type_ptr)
+        SDL_memcpy((void *)(uintptr_t)plane->format_type_ptr, formats, sizeof(formats));
+    plane->count_format_types = SDL_arraysize(formats);
+    return 0;
+}
+
+static int
+fake_atomic(struct drm_mode_atomic *atomic)
+{
+    const __u32 *objs = (const __u32 *)(uintptr_t)atomic->objs_ptr;
+    const __u32 *counts = (const __u32 *)(uintptr_t)atomic->count_props_ptr;
+    const __u32 *props = (const __u32 *)(uintptr_t)atomic->props_ptr;
+    const __u64 *values = (const __u64 *)(uintptr_t)atomic->prop_values_ptr;
+    __u32 i, j, n = 0;
+
+    /* The kernel turns a commit down while a flip is still in flight */
+    if (fake.flip_pending)
+        return -1;
+
+    for (i = 0; i < atomic->count_objs; i++) {
+        for (j = 0; j < counts[i]; j++, n++) {
+            if (props[n] < PROP_TYPE || props[n] >= PROP_END)
+                return -1;
+            /* Plane properties go to the plane, the CRTC ones to the CRTC */
+            if (objs[i] == 62 && props[n] >= PROP_ACTIVE)
+                return -1;
+            fake.values[props[n]] = values[n];
+        }
+    }
+
+    fake.commits++;
+    fake.commit_flags = atomic->flags;
+    fake.commit_objs = atomic->count_objs;
+    if (atomic->flags & DRM_MODE_PAGE_FLIP_EVENT) {
+        fake.flip_pending = SDL_TRUE;
+        fake.flip_page = atomic->user_data;
+    }
+    return 0;
+}
+
+static int
+Fake_Ioctl(int fd, unsigned long request, void *arg)
+{
+    static const __u32 crtcs[] = { 50, 51 }, connectors[] = { 30, 31 }, planes[] = { 60, 61, 62 };
+
+    if (fd != FAKE_FD)
+        return -1;
+
+    switch (request) {
+    case DRM_IOCTL_SET_CLIENT_CAP:
+        return fake.no_atomic && ((struct drm_set_client_cap *)arg)->capability == DRM_CLIENT_CAP_ATOMIC ? -1 : 0;
+    case DRM_IOCTL_SET_MASTER:
+        return fake.not_master ? -1 : 0;
+    case DRM_IOCTL_MODE_GETRESOURCES: {
+        struct drm_mode_card_res *res = arg;
+        fill_u32(res->crtc_id_ptr, res->count_crtcs, &res->count_crtcs, crtcs, 2);
+        fill_u32(res->connector_id_ptr, res->count_connectors, &res->count_connectors, connectors, 2);
+        return 0;
+    }
+    case DRM_IOCTL_MODE_GETCONNECTOR:
+        return fake_connector(arg);
+    case DRM_IOCTL_MODE_GETENCODER: {
+        struct drm_mode_get_encoder *enc = arg;
+        if (enc->encoder_id != 40)
+            return -1;
+        enc->crtc_id = fake.lit ? 51 : 0;
+        enc->possible_crtcs = 2;
+        return 0;
+    }
+    case DRM_IOCTL_MODE_GETCRTC: {
+        struct drm_mode_crtc *crtc = arg;
+        crtc->mode_valid = fake.lit && crtc->crtc_id == 51;
+        if (crtc->mode_valid)
+            crtc->mode = make_mode(1280, 720, 0);
+        return 0;
+    }
+    case DRM_IOCTL_MODE_GETPLANERESOURCES: {
+        struct drm_mode_get_plane_res *res = arg;
+        fill_u32(res->plane_id_ptr, res->count_planes, &res->count_planes, planes, 3);
+        return 0;
+    }
+    case DRM_IOCTL_MODE_GETPLANE:
+        return fake_plane(arg);
+    case DRM_IOCTL_MODE_OBJ_GETPROPERTIES:
+        return fake_properties(arg);
+    case DRM_IOCTL_MODE_GETPROPERTY: {
+        struct drm_mode_get_property *prop = arg;
+        if (prop->prop_id < PROP_TYPE || prop->prop_id >= PROP_END)
+            return -1;
+        SDL_strlcpy(prop->name, prop_names[prop->prop_id - PROP_TYPE], sizeof(prop->name));
+        return 0;
+    }
+    case DRM_IOCTL_MODE_CREATEPROPBLOB: {
+        struct drm_mode_create_blob *blob = arg;
+        if (blob->length != sizeof(struct drm_mode_modeinfo))
+            return -1;
+        fake.blob = blob->blob_id = 90;
+        return 0;
+    }
+    case DRM_IOCTL_MODE_DESTROYPROPBLOB:
+        fake.blobs_destroyed++;
+        return 0;
+    case DRM_IOCTL_PRIME_FD_TO_HANDLE: {
+        struct drm_prime_handle *prime = arg;
+        prime->handle = 1000 + prime->fd;
+        return 0;
+    }
+    case DRM_IOCTL_MODE_ADDFB2: {
+        struct drm_mode_fb_cmd2 *fb = arg;
+        if (fake.num_fbs == SDL_arraysize(fake.fbs))
+            return -1;
+        fb->fb_id = 200 + fake.num_fbs;
+        fake.fbs[fake.num_fbs++] = *fb;
+        return 0;
+    }
+    case DRM_IOCTL_MODE_ATOMIC:
+        return fake_atomic(arg);
+    case DRM_IOCTL_MODE_RMFB:
+        fake.rmfbs++;
+        return 0;
+    case DRM_IOCTL_GEM_CLOSE:
+        fake.gem_closes++;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+/* A vblank event nobody asked for ahead of the flip, to check they're told apart */
+static int
+Fake_ReadEvents(int fd, void *buffer, int size, int timeout)
+{
+    struct drm_event_vblank events[2];
+
+    if (!fake.flip_pending || fake.lose_flips)
+        return 0;
+
+    SDL_zero(events);
+    events[0].base.type = 0x01;
+    events[0].base.length = sizeof(events[0]);
+    events[1].base.type = DRM_EVENT_FLIP_COMPLETE;
+    events[1].base.length = sizeof(events[1]);
+    events[1].user_data = fake.flip_page;
+    events[1].sequence = ++fake.sequence;
+    events[1].tv_sec = 100 + fake.sequence / 60;
+    events[1].tv_usec = fake.sequence % 60 * 16666;
+    SDL_memcpy(buffer, events, sizeof(events));
+    fake.flip_pending = SDL_FALSE;
+    return sizeof(events);
+}
+
+static const MALI_DRMOps fake_ops = {
+    Fake_Open,
+    Fake_Close,
+    Fake_Ioctl,
+    Fake_ReadEvents
+};
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); errors++; } } while (0)
+
+static void
+test_open(void)
+{
+    MALI_DRM drm;
+
+    printf("display lookup\n");
+
+    /* Dark display, the preferred mode on the CRTC the encoder can drive */
+    SDL_zero(fake);
+    CHECK(MALI_DRM_Open(&drm, &fake_ops, "fake") == 0, "open failed: %s", SDL_GetError());
+    CHECK(drm.connector_id == 31, "connector %u", drm.connector_id);
+    CHECK(drm.crtc_id == 51, "CRTC %u", drm.crtc_id);
+    CHECK(drm.plane_id == 62, "plane %u, not the primary one of the CRTC", drm.plane_id);
+    CHECK(drm.mode.hdisplay == 1920 && drm.mode.vdisplay == 1080, "mode %ux%u", drm.mode.hdisplay, drm.mode.vdisplay);
+    CHECK(drm.plane_props[MALI_DRM_PLANE_FB_ID] == PROP_FB_ID && drm.plane_props[MALI_DRM_PLANE_CRTC_H] == PROP_CRTC_H,
+          "plane properties misread");
+    CHECK(drm.crtc_active == PROP_ACTIVE && drm.crtc_mode_id == PROP_MODE_ID, "CRTC properties misread");
+    CHECK(drm.connector_crtc_id == PROP_CONNECTOR_CRTC_ID, "connector CRTC_ID taken from the plane");
+    CHECK(drm.mode_blob == 90 && drm.modeset, "mode not set up");
+    CHECK(MALI_DRM_HasFormat(&drm, XR24) && MALI_DRM_HasFormat(&drm, AR24), "formats missing");
+    CHECK(!MALI_DRM_HasFormat(&drm, RG16), "RGB565 claimed");
+    MALI_DRM_Close(&drm);
+    CHECK(fake.closes == 1 && fake.blobs_destroyed == 1, "%d closes, %d blobs destroyed", fake.closes, fake.blobs_destroyed);
+    CHECK(drm.fd == -1, "descriptor kept");
+
+    /* The console's mode is kept, the framebuffer was set up for it */
+    SDL_zero(fake);
+    fake.lit = SDL_TRUE;
+    CHECK(MALI_DRM_Open(&drm, &fake_ops, "fake") == 0, "open of a lit display failed: %s", SDL_GetError());
+    CHECK(drm.mode.hdisplay == 1280 && drm.mode.vdisplay == 720, "lit at %ux%u", drm.mode.hdisplay, drm.mode.vdisplay);
+    MALI_DRM_Close(&drm);
+
+    SDL_zero(fake);
+    fake.no_atomic = SDL_TRUE;
+    CHECK(MALI_DRM_Open(&drm, &fake_ops, "fake") < 0, "opened without atomic modesetting");
+    CHECK(fake.closes == 1, "descriptor leaked");
+
+    SDL_zero(fake);
+    fake.not_master = SDL_TRUE;
+    CHECK(MALI_DRM_Open(&drm, &fake_ops, "fake") < 0, "opened a display driven by someone else");
+
+    SDL_zero(fake);
+    fake.unplugged = SDL_TRUE;
+    CHECK(MALI_DRM_Open(&drm, &fake_ops, "fake") < 0, "opened without a display");
+    CHECK(fake.closes == 1 && fake.blobs_destroyed == 0, "cleanup of a failed open");
+}
+
+static void
+test_present(void)
+{
+    MALI_DRM drm;
+    int i;
+
+    printf("atomic flips\n");
+
+    SDL_zero(fake);
+    if (MALI_DRM_Open(&drm, &fake_ops, "fake") < 0) {
+        CHECK(0, "open failed: %s", SDL_GetError());
+        return;
+    }
+
+    for (i = 0; i < 3; i++) {
+        CHECK(MALI_DRM_AddPage(&drm, i, 20 + i, 1920, 1080, 7680, 0, XR24) == 0, "page %d: %s", i, SDL_GetError());
+    }
+    CHECK(fake.num_fbs == 3, "%u framebuffers", fake.num_fbs);
+    CHECK(fake.fbs[1].handles[0] == 1021 && fake.fbs[1].pitches[0] == 7680 && fake.fbs[1].pixel_format == XR24,
+          "framebuffer of page 1 is off");
+    CHECK(drm.fb_ids[2] == 202, "page 2 as framebuffer %u", drm.fb_ids[2]);
+
+    /* The first flip sets the mode as well */
+    CHECK(MALI_DRM_Present(&drm, 0, SDL_TRUE) == 0, "first flip failed: %s", SDL_GetError());
+    CHECK(fake.commit_flags == (DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_ATOMIC_ALLOW_MODESET),
+          "first commit flags 0x%x", fake.commit_flags);
+    CHECK(fake.commit_objs == 3, "first commit on %d objects", fake.commit_objs);
+    CHECK(fake.values[PROP_ACTIVE] == 1 && fake.values[PROP_MODE_ID] == 90 && fake.values[PROP_CONNECTOR_CRTC_ID] == 51,
+          "mode not set");
+    CHECK(fake.values[PROP_FB_ID] == 200 && fake.values[PROP_PLANE_CRTC_ID] == 51, "plane not put on the CRTC");
+    CHECK(fake.values[PROP_SRC_W] == (1920ull << 16) && fake.values[PROP_SRC_H] == (1080ull << 16),
+          "source not in 16.16");
+    CHECK(fake.values[PROP_CRTC_W] == 1920 && fake.values[PROP_CRTC_H] == 1080, "plane doesn't cover the mode");
+    CHECK(!drm.flip_pending && drm.flip_sequence == 1, "flip not waited for with vsync");
+    CHECK(drm.flip_time == 100 * 1000000ull + 16666, "flip at %d us", (int)drm.flip_time);
+
+    /* Without vsync the flip is left in flight, the next one waits for it */
+    CHECK(MALI_DRM_Present(&drm, 1, SDL_FALSE) == 0, "flip without vsync failed: %s", SDL_GetError());
+    CHECK(fake.commit_flags == (DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK), "flip flags 0x%x", fake.commit_flags);
+    CHECK(fake.commit_objs == 1, "flip touches %d objects", fake.commit_objs);
+    CHECK(drm.flip_pending, "flip without vsync waited for");
+    CHECK(MALI_DRM_Present(&drm, 2, SDL_FALSE) == 0, "flip over one in flight failed: %s", SDL_GetError());
+    CHECK(fake.values[PROP_FB_ID] == 202 && drm.flip_sequence == 2, "second flip lost");
+    CHECK(MALI_DRM_WaitFlip(&drm, 0) == 0 && drm.flip_sequence == 3, "flip in flight not waited for");
+
+    /* A display that stops flipping gives an error, then gets another chance */
+    fake.lose_flips = SDL_TRUE;
+    CHECK(MALI_DRM_Present(&drm, 0, SDL_TRUE) < 0, "lost flip went unnoticed");
+    CHECK(!drm.flip_pending, "lost flip still pending");
+    fake.lose_flips = SDL_FALSE;
+    fake.flip_pending = SDL_FALSE;
+    CHECK(MALI_DRM_Present(&drm, 1, SDL_TRUE) == 0, "no flips after a lost one: %s", SDL_GetError());
+
+    MALI_DRM_Close(&drm);
+    CHECK(fake.rmfbs == 3 && fake.gem_closes == 3, "%d framebuffers and %d handles released", fake.rmfbs, fake.gem_closes);
+
+    /* Pages of one buffer share its handle, which is closed once */
+    SDL_zero(fake);
+    MALI_DRM_Open(&drm, &fake_ops, "fake");
+    MALI_DRM_AddPage(&drm, 0, 20, 1920, 1080, 7680, 0, XR24);
+    MALI_DRM_AddPage(&drm, 1, 20, 1920, 1080, 7680, 7680 * 1080, XR24);
+    CHECK(fake.fbs[1].offsets[0] == 7680 * 1080, "offset of the second slice %u", fake.fbs[1].offsets[0]);
+    MALI_DRM_Close(&drm);
+    CHECK(fake.rmfbs == 2 && fake.gem_closes == 1, "%d framebuffers and %d handles released", fake.rmfbs, fake.gem_closes);
+}
+
+static void
+test_scanout(void)
+{
+    MALI_Scanout scanout;
+
+    printf("scanout backend\n");
+
+    SDL_zero(fake);
+    CHECK(MALI_Scanout_InitDRM(&scanout, &fake_ops, "fake", XR24, 1280, 720, 0, 3) < 0, "window smaller than the mode accepted");
+    CHECK(fake.closes == 1, "device left open");
+    CHECK(MALI_Scanout_InitDRM(&scanout, &fake_ops, "fake", XR24, 1920, 1080, 1, 3) < 0, "rotated window accepted");
+    CHECK(MALI_Scanout_InitDRM(&scanout, &fake_ops, "fake", RG16, 1920, 1080, 0, 3) < 0, "RGB565 pages accepted");
+
+    SDL_zero(fake);
+    if (MALI_Scanout_InitDRM(&scanout, &fake_ops, "fake", XR24, 1920, 1080, 0, 2) < 0) {
+        CHECK(0, "init failed: %s", SDL_GetError());
+        return;
+    }
+    CHECK(MALI_Scanout_AddPage(&scanout, 0, 20, 1920, 1080, 7680, XR24) == 0, "page 0: %s", SDL_GetError());
+    CHECK(MALI_Scanout_AddPage(&scanout, 1, 21, 1920, 1080, 7680, XR24) == 0, "page 1: %s", SDL_GetError());
+    CHECK(MALI_Scanout_Present(&scanout, 1, SDL_TRUE) == 0, "present failed: %s", SDL_GetError());
+    CHECK(fake.values[PROP_FB_ID] == 201, "presented framebuffer %d", (int)fake.values[PROP_FB_ID]);
+    MALI_Scanout_Quit(&scanout);
+    CHECK(fake.closes == 1 && fake.rmfbs == 2, "scanout quit left the device set up");
+}
+
+/* Dumb buffers flipped on a real card, vkms flips at 60 Hz with nothing attached */
+static void
+test_device(const char *path)
+{
+    struct drm_mode_create_dumb dumb;
+    struct drm_prime_handle prime;
+    MALI_DRM drm;
+    int fds[2] = { -1, -1 };
+    Uint64 first = 0, interval;
+    int i;
+
+    printf("flips on %s\n", path);
+
+    if (MALI_DRM_Open(&drm, &MALI_DRM_DeviceOps, path) < 0) {
+        CHECK(0, "open failed: %s", SDL_GetError());
+        return;
+    }
+
+    for (i = 0; i < 2; i++) {
+        SDL_zero(dumb);
+        dumb.width = drm.mode.hdisplay;
+        dumb.height = drm.mode.vdisplay;
+        dumb.bpp = 32;
+        SDL_zero(prime);
+        if (ioctl(drm.fd, DRM_IOCTL_MODE_CREATE_DUMB, &dumb) < 0) {
+            CHECK(0, "dumb buffer %d not created", i);
+            break;
+        }
+        prime.handle = dumb.handle;
+        prime.flags = O_CLOEXEC;
+        if (ioctl(drm.fd, DRM_IOCTL_PRIME_HANDLE_TO_FD, &prime) < 0) {
+            CHECK(0, "dumb buffer %d not exported", i);
+            break;
+        }
+        fds[i] = prime.fd;
+        CHECK(MALI_DRM_AddPage(&drm, i, fds[i], dumb.width, dumb.height, dumb.pitch, 0, XR24) == 0,
+              "page %d: %s", i, SDL_GetError());
+    }
+
+    for (i = 0; i < 61 && fds[1] >= 0; i++) {
+        if (MALI_DRM_Present(&drm, i % 2, SDL_TRUE) < 0) {
+            CHECK(0, "flip %d failed: %s", i, SDL_GetError());
+            break;
+        }
+        if (i == 0)
+            first = drm.flip_time;
+    }
+
+    if (i == 61) {
+        interval = (drm.flip_time - first) / 60;
+        printf("  %d x %d, a flip every %d us\n", drm.mode.hdisplay, drm.mode.vdisplay, (int)interval);
+        CHECK(interval > 1000000 / 250 && interval < 1000000 / 20, "flips %d us apart", (int)interval);
+    }
+
+    MALI_DRM_Close(&drm);
+    for (i = 0; i < 2; i++) {
+        if (fds[i] >= 0)
+            close(fds[i]);
+    }
+}
+
+static int
+run_test(void)
+{
+    const char *device = SDL_getenv("SDL_MALI_DRM_DEVICE");
+
+    test_open();
+    test_present();
+    test_scanout();
+    if (device && *device)
+        test_device(device);
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
@@ -0,0 +1,298 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Headless test for the mali-fbdev window surface mapped onto the swap chain.
+ *
+ * /dev/ion is stood in for by memfd buffers and DMA_BUF_IOCTL_SYNC by a stub
+ * that tracks which pages the CPU may touch, so the page mapping, the cache
+ * maintenance brackets and keeping the surface contents intact across
+ * presents can be checked on any host.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "../src/video/mali-fbdev/SDL_maliswapchain.h"
+#include "../src/video/mali-fbdev/SDL_maliswapchain.c"
+#include "../src/video/mali-fbdev/SDL_maliionpool.h"
+#include "../src/video/mali-fbdev/SDL_maliionpool.c"
+#include "../src/video/mali-fbdev/SDL_malifb.h"
+#include "../src/video/mali-fbdev/SDL_malifb.c"
+
+#define WIDTH   320
+#define HEIGHT  240
+#define PITCH   1280
+#define FRAMES  2000
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); errors++; } } while (0)
+
+/* Open START/END brackets per descriptor, and whether they allow writing */
+static struct
+{
+    int open[256];
+    SDL_bool write[256];
+    int syncs;
+} fake;
+
+static int next_handle = 1;
+
+static int
+Memfd_Alloc(int ion_fd, size_t size, ion_user_handle_t *handle, int *fd)
+{
+    int memfd = memfd_create("testmalifb", MFD_CLOEXEC);
+
+    if (memfd < 0 || memfd >= (int)SDL_arraysize(fake.open) || ftruncate(memfd, size) < 0) {
+        if (memfd >= 0)
+            close(memfd);
+        return SDL_SetError("memfd_create failed");
+    }
+
+    *handle = next_handle++;
+    *fd = memfd;
+    return 0;
+}
+
+static void
+Memfd_Free(int ion_fd, ion_user_handle_t handle)
+{
+}
+
+static const MALI_IONOps memfd_ops = {
+    Memfd_Alloc,
+    Memfd_Free
+};
+
+static int
+Stub_Sync(int fd, Uint64 flags)
+{
+    fake.syncs++;
+    if (flags & DMA_BUF_SYNC_END) {
+        CHECK(fake.open[fd] > 0, "sync end on fd %d without a start", fd);
+        fake.open[fd]--;
+        fake.write[fd] = SDL_FALSE;
+    } else {
+        CHECK(fake.open[fd] == 0, "nested sync start on fd %d", fd);
+        fake.open[fd]++;
+        fake.write[fd] = (flags & DMA_BUF_SYNC_WRITE) ? SDL_TRUE : SDL_FALSE;
+    }
+    return 0;
+}
+
+static const MALI_FramebufferOps stub_ops = {
+    Stub_Sync
+};
+
+static void
+test_pool(void)
+{
+    MALI_IONPool pool;
+    ion_user_handle_t handle;
+    int fds[3], fd, i;
+
+    printf("memfd backed pool\n");
+
+    MALI_IONPool_Init(&pool, &memfd_ops, -1);
+    for (i = 0; i < 3; i++) {
+        CHECK(MALI_IONPool_Acquire(&pool, PITCH * HEIGHT, &handle, &fds[i]) == 0, "allocation failed: %s", SDL_GetError());
+    }
+    CHECK(pool.allocations == 3, "%u allocations", pool.allocations);
+
+    /* A page of the same size comes straight back */
+    MALI_IONPool_Release(&pool, fds[1]);
+    CHECK(MALI_IONPool_Acquire(&pool, PITCH * HEIGHT, &handle, &fd) == 0 && fd == fds[1], "released page not reused");
+    CHECK(pool.reuses == 1, "%u reuses", pool.reuses);
+    MALI_IONPool_Quit(&pool);
+}
+
+static void
+fill_rect(MALI_Framebuffer *fb, Uint8 *canvas, const SDL_Rect *rect, Uint32 value)
+{
+    Uint8 *pixels = fb->pages[fb->current].pixels;
+    int x, y;
+
+    CHECK(fake.open[fb->pages[fb->current].fd] && fake.write[fb->pages[fb->current].fd],
+          "CPU writes to page %d outside of a write bracket", fb->current);
+
+    for (y = rect->y; y < rect->y + rect->h; y++) {
+        for (x = rect->x; x < rect->x + rect->w; x++) {
+            SDL_memcpy(pixels + y * PITCH + x * 4, &value, 4);
+            SDL_memcpy(canvas + y * PITCH + x * 4, &value, 4);
+        }
+    }
+}
+
+/*
+ * The application draws random rectangles and presents them as damage, while
+ * the blitter side picks up pages in a scrambled order. Whatever page the
+ * application ends up with must always look exactly like the surface it left.
+ */
+static void
+test_present(int depth, MALI_PresentMode mode)
+{
+    MALI_IONPool pool;
+    MALI_SwapChain chain;
+    MALI_Framebuffer fb;
+    ion_user_handle_t handle;
+    int fds[MALI_SWAPCHAIN_MAX_DEPTH];
+    Uint32 offsets[MALI_SWAPCHAIN_MAX_DEPTH] = { 0 };
+    Uint8 *canvas, *pixels;
+    Uint32 seed = 0xC0FFEE + depth;
+    SDL_Rect rect;
+    int frame, page, i, mismatches = 0;
+
+    printf("present %s depth %d\n", mode == MALI_PRESENT_FIFO ? "fifo" : "mailbox", depth);
+
+    SDL_zero(fake);
+    MALI_IONPool_Init(&pool, &memfd_ops, -1);
+    for (i = 0; i < depth; i++) {
+        if (MALI_IONPool_Acquire(&pool, PITCH * HEIGHT, &handle, &fds[i]) < 0) {
+            CHECK(0, "allocation failed: %s", SDL_GetError());
+            return;
+        }
+    }
+
+    if (MALI_Framebuffer_Map(&fb, &stub_ops, depth, fds, offsets, WIDTH, HEIGHT, PITCH, 4) < 0) {
+        CHECK(0, "map failed: %s", SDL_GetError());
+        return;
+    }
+
+    canvas = (Uint8 *)SDL_calloc(1, PITCH * HEIGHT);
+    MALI_SwapChain_Init(&chain, depth, mode);
+    pixels = MALI_Framebuffer_Acquire(&fb, MALI_SwapChain_AcquireRender(&chain));
+    CHECK(pixels != NULL, "first page not mapped");
+
+    for (frame = 0; frame < FRAMES; frame++) {
+        seed = seed * 1103515245 + 12345;
+        rect.x = (seed >> 8) % WIDTH;
+        rect.y = (seed >> 16) % HEIGHT;
+        rect.w = 1 + (seed >> 4) % (WIDTH - rect.x);
+        rect.h = 1 + (seed >> 12) % (HEIGHT - rect.y);
+        if ((frame % 50) == 0) {
+            rect.x = rect.y = 0;
+            rect.w = WIDTH;
+            rect.h = HEIGHT;
+        }
+        fill_rect(&fb, canvas, &rect, seed | 1);
+
+        MALI_Framebuffer_Present(&fb, (frame % 50) == 0 ? NULL : &rect, 1);
+        CHECK(fake.open[fb.pages[fb.latest].fd] == 0, "presented page %d still open for the CPU", fb.latest);
+
+        /* Let the blitter take frames now and then, so pages come back in all sorts of orders */
+        MALI_SwapChain_Queue(&chain);
+        if ((seed >> 20) % 3 != 0 && MALI_SwapChain_HasQueued(&chain)) {
+            page = MALI_SwapChain_AcquirePresent(&chain);
+            CHECK(fake.open[fb.pages[page].fd] == 0, "blitter got page %d while the CPU has it", page);
+        }
+        while ((page = MALI_SwapChain_AcquireRender(&chain)) < 0) {
+            MALI_SwapChain_AcquirePresent(&chain);
+        }
+
+        pixels = MALI_Framebuffer_Acquire(&fb, page);
+        if (SDL_memcmp(pixels, canvas, PITCH * HEIGHT) != 0)
+            mismatches++;
+    }
+
+    CHECK(mismatches == 0, "%d frames started from a stale surface", mismatches);
+    printf("  %d frames, %.1f KiB copied per frame on average\n",
+           FRAMES, fb.bytes_copied / 1024.0 / FRAMES);
+
+    MALI_Framebuffer_Unmap(&fb);
+    for (i = 0; i < depth; i++) {
+        CHECK(fake.open[fds[i]] == 0, "page %d left open for the CPU", i);
+    }
+
+    SDL_free(canvas);
+    MALI_IONPool_Quit(&pool);
+}
+
+static void
+test_scanout_offsets(void)
+{
+    MALI_IONPool pool;
+    MALI_Framebuffer fb;
+    ion_user_handle_t handle;
+    int fd, fds[3];
+    Uint32 offsets[3];
+    int i;
+
+    printf("pages at unaligned offsets of one buffer\n");
+
+    /* Direct scanout hands out slices of the framebuffer, 240 rows of 1280 bytes aren't page aligned */
+    SDL_zero(fake);
+    MALI_IONPool_Init(&pool, &memfd_ops, -1);
+    CHECK(MALI_IONPool_Acquire(&pool, PITCH * (HEIGHT + 1) * 3, &handle, &fd) == 0, "allocation failed");
+    for (i = 0; i < 3; i++) {
+        /* Separate descriptors only so the stub can tell the pages' brackets apart */
+        fds[i] = i ? dup(fd) : fd;
+        offsets[i] = PITCH * (HEIGHT + 1) * i;
+    }
+
+    CHECK(MALI_Framebuffer_Map(&fb, &stub_ops, 3, fds, offsets, WIDTH, HEIGHT, PITCH, 4) == 0, "map failed: %s", SDL_GetError());
+    for (i = 0; i < 3; i++) {
+        Uint8 *pixels = MALI_Framebuffer_Acquire(&fb, i);
+        SDL_memset(pixels, 0x10 + i, PITCH * HEIGHT);
+        MALI_Framebuffer_Present(&fb, NULL, 0);
+    }
+    for (i = 0; i < 3; i++) {
+        Uint8 *a = (Uint8 *)fb.pages[i].pixels;
+        CHECK(a[0] == 0x10 + i && a[PITCH * HEIGHT - 1] == 0x10 + i, "page %d overlaps another one", i);
+    }
+    MALI_Framebuffer_Unmap(&fb);
+    close(fds[1]);
+    close(fds[2]);
+    MALI_IONPool_Quit(&pool);
+}
+
+static int
+run_test(void)
+{
+    int depth;
+    MALI_PresentMode mode;
+
+    test_pool();
+    test_scanout_offsets();
+    for (mode = MALI_PRESENT_MAILBOX; mode <= MALI_PRESENT_FIFO; mode++) {
+        for (depth = MALI_SWAPCHAIN_MIN_DEPTH; depth <= 4; depth++) {
+            test_present(depth, mode);
+        }
+    }
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Headless test for the mali-fbdev performance overlay.
+ *
+ * Covers everything short of the GL calls: /proc/stat parsing, the projection
+ * against the rotation the blitter applies to the pages, the statistics and
+ * the geometry fed to the second VBO.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+
+#include "../src/video/mali-fbdev/SDL_malihud.h"
+#include "../src/video/mali-fbdev/SDL_malihud.c"
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); errors++; } } while (0)
+
+static void
+test_parse(void)
+{
+    Uint64 busy = 0, total = 0;
+
+    CHECK(MALI_HUD_ParseCPUStat("cpu  100 5 50 800 20 3 2 0 0 0\ncpu0 50 2 25 400 10 1 1 0 0 0\n", &busy, &total),
+          "full cpu line rejected");
+    CHECK(busy == 160 && total == 980, "busy %u total %u, expected 160 and 980", (unsigned)busy, (unsigned)total);
+
+    /* Old kernels stop after iowait */
+    CHECK(MALI_HUD_ParseCPUStat("cpu 10 0 10 80 0\n", &busy, &total) && busy == 20 && total == 100,
+          "short cpu line: busy %u total %u", (unsigned)busy, (unsigned)total);
+
+    CHECK(!MALI_HUD_ParseCPUStat("cpu0 1 2 3 4 5\n", &busy, &total), "per-core line accepted");
+    CHECK(!MALI_HUD_ParseCPUStat("cpu  1 2 3\n", &busy, &total), "truncated line accepted");
+    CHECK(!MALI_HUD_ParseCPUStat("", &busy, &total), "empty file accepted");
+}
+
+static void
+project(float m[4][4], float x, float y, float *cx, float *cy)
+{
+    *cx = m[0][0] * x + m[1][0] * y + m[3][0];
+    *cy = m[0][1] * x + m[1][1] * y + m[3][1];
+}
+
+/* Where MALI_Blitter_DamageToViewport puts a display point, in clip coordinates */
+static void
+blitter_rotate(int rotation, int vw, int vh, float x, float y, float *cx, float *cy)
+{
+    float dw = (rotation & 1) ? vh : vw, dh = (rotation & 1) ? vw : vh;
+    float tx = x, ty = dh - y, ax, ay;
+
+    switch (rotation) {
+        case 1: ax = dh - ty; ay = tx; break;
+        case 2: ax = dw - tx; ay = dh - ty; break;
+        case 3: ax = ty; ay = dw - tx; break;
+        default: ax = tx; ay = ty; break;
+    }
+    *cx = 2.0f * ax / vw - 1.0f;
+    *cy = 2.0f * ay / vh - 1.0f;
+}
+
+static void
+test_projection(void)
+{
+    static const float corners[4][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+    float m[4][4], cx, cy, ex, ey, x, y, dw, dh;
+    int rotation, i;
+
+    for (rotation = 0; rotation < 4; rotation++) {
+        dw = (rotation & 1) ? 480 : 800;
+        dh = (rotation & 1) ? 800 : 480;
+        MALI_HUD_GetProjection(rotation, dw, dh, m);
+
+        for (i = 0; i < 5; i++) {
+            x = i < 4 ? corners[i][0] * dw : 123;
+            y = i < 4 ? corners[i][1] * dh : 45;
+            project(m, x, y, &cx, &cy);
+            blitter_rotate(rotation, 800, 480, x, y, &ex, &ey);
+            CHECK(SDL_fabs(cx - ex) < 1e-4 && SDL_fabs(cy - ey) < 1e-4,
+                  "rotation %d: (%g, %g) lands on (%g, %g), the pages put it at (%g, %g)",
+                  rotation, x, y, cx, cy, ex, ey);
+        }
+    }
+
+    /* The top left corner of the display, where the overlay goes */
+    MALI_HUD_GetProjection(0, 800, 480, m);
+    project(m, 0, 0, &cx, &cy);
+    CHECK(cx == -1.0f && cy == 1.0f, "unrotated top left at (%g, %g)", cx, cy);
+}
+
+static void
+test_disabled(void)
+{
+    MALI_HUD hud;
+    SDL_GLFrameTiming timing;
+
+    SDL_SetHint(SDL_HINT_MALI_HUD, "0");
+    MALI_HUD_Init(&hud, 0, 1280, 720, 60);
+    CHECK(!hud.enabled && hud.vertices == NULL, "overlay set up without the hint");
+
+    SDL_zero(timing);
+    timing.swap_returned = 1000;
+    MALI_HUD_Record(&hud, &timing);
+    CHECK(hud.num_vertices == 0 && hud.history_count == 0, "disabled overlay recorded a frame");
+    MALI_HUD_Quit(&hud);
+}
+
+static void
+test_text(void)
+{
+    MALI_HUD hud;
+
+    SDL_zero(hud);
+    hud.scale = 2;
+    hud.vertices = SDL_malloc(MALI_HUD_MAX_VERTICES * sizeof(*hud.vertices));
+
+    /* One rectangle per run of pixels in a row: seven for '1', eleven for '8' */
+    MALI_HUD_AddText(&hud, "1 8?", 10, 20);
+    CHECK(hud.num_vertices == 18 * 6, "\"1 8?\" took %d vertices, expected %d", hud.num_vertices, 18 * 6);
+
+    /* The top row of '1' is its single middle pixel */
+    CHECK(hud.vertices[0][0] == 14 && hud.vertices[0][1] == 20 && hud.vertices[4][0] == 16 && hud.vertices[4][1] == 22,
+          "top of '1' spans (%g, %g) to (%g, %g)",
+          hud.vertices[0][0], hud.vertices[0][1], hud.vertices[4][0], hud.vertices[4][1]);
+
+    SDL_free(hud.vertices);
+}
+
+static void
+test_record(void)
+{
+    MALI_HUD hud;
+    SDL_GLFrameTiming timing;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 period = frequency / 60, start = frequency;
+    float x0, y0, x1, y1;
+    int i;
+
+    SDL_SetHint(SDL_HINT_MALI_HUD, "1");
+    MALI_HUD_Init(&hud, 1, 720, 1280, 60);
+    CHECK(hud.enabled && hud.vertices != NULL, "overlay not set up with the hint");
+    if (!hud.enabled)
+        return;
+    CHECK(hud.scale == 2, "scale %d on a 720 pixel high display", hud.scale);
+    CHECK(hud.count[MALI_HUD_BACKGROUND] == 6 && hud.count[MALI_HUD_BUDGET] == 6 && hud.count[MALI_HUD_GRAPH] == 0,
+          "fresh overlay has %d background, %d budget and %d graph vertices",
+          hud.count[MALI_HUD_BACKGROUND], hud.count[MALI_HUD_BUDGET], hud.count[MALI_HUD_GRAPH]);
+
+    for (i = 0; i < 2 * MALI_HUD_HISTORY; i++) {
+        SDL_zero(timing);
+        timing.swap_returned = start + i * period;
+        timing.blit_done = timing.swap_returned - frequency / 500;
+        timing.blit_gpu_done = timing.swap_returned - frequency / 2000;
+        MALI_HUD_Record(&hud, &timing);
+    }
+
+    CHECK(hud.history_count == MALI_HUD_HISTORY, "%d frames in the graph", hud.history_count);
+    CHECK(hud.count[MALI_HUD_GRAPH] == 6 * MALI_HUD_HISTORY, "%d graph vertices", hud.count[MALI_HUD_GRAPH]);
+    CHECK(SDL_strcmp(hud.lines[0], "FPS  60.0") == 0, "frame rate reads \"%s\"", hud.lines[0]);
+    CHECK(SDL_strcmp(hud.lines[1], "MS   16.7") == 0, "frame time reads \"%s\"", hud.lines[1]);
+    CHECK(SDL_strcmp(hud.lines[3], "GPU  1.50") == 0, "blit time reads \"%s\"", hud.lines[3]);
+
+    /* Frames right at the refresh period reach up to the budget line */
+    y0 = hud.vertices[hud.first[MALI_HUD_GRAPH]][1];
+    y1 = hud.vertices[hud.first[MALI_HUD_BUDGET]][1];
+    CHECK(SDL_fabs(y0 - y1) < 0.5f, "bar top at %g, budget line at %g", y0, y1);
+
+    /* All of it inside the rotated 720x1280 display */
+    x0 = y0 = 1e9f;
+    x1 = y1 = -1e9f;
+    for (i = 0; i < hud.num_vertices; i++) {
+        x0 = SDL_min(x0, hud.vertices[i][0]);
+        y0 = SDL_min(y0, hud.vertices[i][1]);
+        x1 = SDL_max(x1, hud.vertices[i][0]);
+        y1 = SDL_max(y1, hud.vertices[i][1]);
+    }
+    CHECK(x0 >= 0 && y0 >= 0 && x1 <= 1280 && y1 <= 720, "overlay spans (%g, %g) to (%g, %g)", x0, y0, x1, y1);
+
+    /* A stall tops out the bar instead of running off the graph */
+    SDL_zero(timing);
+    timing.swap_returned = start + 2 * MALI_HUD_HISTORY * period + frequency;
+    MALI_HUD_Record(&hud, &timing);
+    i = hud.first[MALI_HUD_GRAPH] + hud.count[MALI_HUD_GRAPH] - 6;
+    CHECK(hud.vertices[i + 2][1] - hud.vertices[i][1] <= MALI_HUD_GRAPH_HEIGHT * hud.scale + 0.5f,
+          "a one second frame is %g high", hud.vertices[i + 2][1] - hud.vertices[i][1]);
+
+    MALI_HUD_Quit(&hud);
+}
+
+static int
+run_test(void)
+{
+    test_parse();
+    test_projection();
+    test_disabled();
+    test_text();
+    test_record();
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
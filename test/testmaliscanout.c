@@ -0,0 +1,289 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Headless test for the mali-fbdev direct scanout path.
+ *
+ * The framebuffer is a stub backend that records pans and vsync waits instead
+ * of issuing ioctls, which lets the layout checks, page placement and the swap
+ * chain hand-off be verified on any host.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "../src/video/mali-fbdev/SDL_maliswapchain.h"
+#include "../src/video/mali-fbdev/SDL_maliswapchain.c"
+#include "../src/video/mali-fbdev/SDL_malidrm.h"
+#include "../src/video/mali-fbdev/SDL_malidrm.c"
+#include "../src/video/mali-fbdev/SDL_maliscanout.h"
+#include "../src/video/mali-fbdev/SDL_maliscanout.c"
+
+#define STEPS 5000
+
+/* One global fake framebuffer, the ops only get the fd */
+static struct
+{
+    struct fb_fix_screeninfo finfo;
+    struct fb_var_screeninfo vinfo;
+    SDL_bool fail_export;
+    SDL_bool fail_put_var;
+    int pans;
+    int vsyncs;
+} fake;
+
+static int
+Stub_GetFix(int fd, struct fb_fix_screeninfo *finfo)
+{
+    *finfo = fake.finfo;
+    return 0;
+}
+
+static int
+Stub_PutVar(int fd, struct fb_var_screeninfo *vinfo)
+{
+    if (fake.fail_put_var)
+        return -1;
+    fake.vinfo = *vinfo;
+    return 0;
+}
+
+static int
+Stub_Pan(int fd, struct fb_var_screeninfo *vinfo)
+{
+    if (vinfo->yoffset + vinfo->yres > fake.vinfo.yres_virtual)
+        return -1;
+    fake.vinfo.yoffset = vinfo->yoffset;
+    fake.pans++;
+    return 0;
+}
+
+static int
+Stub_WaitVSync(int fd)
+{
+    fake.vsyncs++;
+    return 0;
+}
+
+static int
+Stub_ExportDMABuf(int fd)
+{
+    /* Needs to be a real descriptor, MALI_Scanout_Quit closes it */
+    return fake.fail_export ? -1 : open("/dev/null", O_RDONLY);
+}
+
+static const MALI_ScanoutOps stub_ops = {
+    Stub_GetFix,
+    Stub_PutVar,
+    Stub_Pan,
+    Stub_WaitVSync,
+    Stub_ExportDMABuf
+};
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); errors++; } } while (0)
+
+static void
+reset_fake(int xres, int yres, Uint32 line_length, int pages)
+{
+    SDL_zero(fake);
+    fake.vinfo.xres = fake.vinfo.xres_virtual = xres;
+    fake.vinfo.yres = fake.vinfo.yres_virtual = yres;
+    fake.vinfo.bits_per_pixel = 32;
+    fake.vinfo.red.offset = 16;
+    fake.vinfo.green.offset = 8;
+    fake.vinfo.blue.offset = 0;
+    fake.finfo.line_length = line_length;
+    fake.finfo.smem_len = line_length * yres * pages;
+}
+
+static void
+test_can_use(void)
+{
+    struct fb_var_screeninfo vinfo;
+
+    printf("layout checks\n");
+
+    reset_fake(640, 480, 2560, 3);
+    CHECK(MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 640, 480, 0, 3), "matching layout rejected");
+    CHECK(!MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 640, 480, 1, 3), "rotated window accepted");
+    CHECK(!MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 320, 240, 0, 3), "scaled window accepted");
+    CHECK(!MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 640, 480, 0, 4), "depth beyond video memory accepted");
+
+    vinfo = fake.vinfo;
+    vinfo.bits_per_pixel = 16;
+    CHECK(!MALI_Scanout_CanUse(&vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 640, 480, 0, 3), "16bpp framebuffer accepted");
+
+    /* RGB565 pages go straight to a 16bpp framebuffer, with half the pitch */
+    reset_fake(640, 480, 1280, 3);
+    fake.vinfo.bits_per_pixel = 16;
+    fake.vinfo.red.offset = 11;
+    fake.vinfo.green.offset = 5;
+    fake.vinfo.blue.offset = 0;
+    CHECK(MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB565, 640, 480, 0, 3), "RGB565 framebuffer rejected");
+    CHECK(!MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 640, 480, 0, 3), "XRGB8888 pages on a 16bpp framebuffer accepted");
+    fake.vinfo.red.offset = 0;
+    fake.vinfo.blue.offset = 11;
+    CHECK(!MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB565, 640, 480, 0, 3), "BGR565 framebuffer accepted");
+    CHECK(!MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_UNKNOWN, 640, 480, 0, 3), "format without a layout accepted");
+
+    vinfo = fake.vinfo;
+    vinfo.red.offset = 0;
+    vinfo.blue.offset = 16;
+    CHECK(!MALI_Scanout_CanUse(&vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 640, 480, 0, 3), "ABGR framebuffer accepted");
+
+    reset_fake(600, 480, 2400, 3);
+    CHECK(!MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 600, 480, 0, 3), "unaligned pitch accepted");
+
+    /* Padded rows are fine as long as they stay aligned */
+    reset_fake(600, 480, 2432, 3);
+    CHECK(MALI_Scanout_CanUse(&fake.vinfo, &fake.finfo, SDL_PIXELFORMAT_RGB888, 600, 480, 0, 3), "padded pitch rejected");
+}
+
+static void
+test_init(void)
+{
+    MALI_Scanout scanout;
+    int i;
+
+    printf("initialization\n");
+
+    reset_fake(640, 480, 2560, 4);
+    CHECK(MALI_Scanout_Init(&scanout, &stub_ops, 0, &fake.vinfo, SDL_PIXELFORMAT_RGB888, 640, 480, 0, 4) == 0, "init failed: %s", SDL_GetError());
+    CHECK(scanout.dmabuf_fd >= 0, "no DMA_BUF exported");
+    CHECK(fake.vinfo.yres_virtual == 480 * 4, "yres_virtual is %u", fake.vinfo.yres_virtual);
+    CHECK(scanout.stride == 2560, "stride is %u", scanout.stride);
+    for (i = 0; i < 4; i++) {
+        CHECK(MALI_Scanout_GetPageOffset(&scanout, i) == (Uint32)(2560 * 480 * i), "page %d at offset %u", i, MALI_Scanout_GetPageOffset(&scanout, i));
+    }
+    MALI_Scanout_Quit(&scanout);
+    CHECK(scanout.dmabuf_fd == -1, "DMA_BUF left open");
+
+    reset_fake(640, 480, 2560, 3);
+    fake.fail_export = SDL_TRUE;
+    CHECK(MALI_Scanout_Init(&scanout, &stub_ops, 0, &fake.vinfo, SDL_PIXELFORMAT_RGB888, 640, 480, 0, 3) < 0, "init succeeded without a DMA_BUF");
+
+    reset_fake(640, 480, 2560, 3);
+    fake.fail_put_var = SDL_TRUE;
+    CHECK(MALI_Scanout_Init(&scanout, &stub_ops, 0, &fake.vinfo, SDL_PIXELFORMAT_RGB888, 640, 480, 0, 3) < 0, "init succeeded without room for the pages");
+    CHECK(scanout.dmabuf_fd == -1, "DMA_BUF leaked on failure");
+}
+
+/*
+ * Runs the application and the presenting thread against each other in a
+ * scrambled order, the page the stub framebuffer is scanning out must never be
+ * handed to the application.
+ */
+static void
+test_present(int depth, MALI_PresentMode mode)
+{
+    MALI_SwapChain chain;
+    MALI_Scanout scanout;
+    Uint32 seed = 0x1234567 + depth;
+    int step, page, shown = -1, presented = 0, pending = -1;
+
+    printf("present %s depth %d\n", mode == MALI_PRESENT_FIFO ? "fifo" : "mailbox", depth);
+
+    reset_fake(320, 240, 1280, depth);
+    if (MALI_Scanout_Init(&scanout, &stub_ops, 0, &fake.vinfo, SDL_PIXELFORMAT_RGB888, 320, 240, 0, depth) < 0) {
+        CHECK(0, "init failed: %s", SDL_GetError());
+        return;
+    }
+
+    MALI_SwapChain_Init(&chain, depth, mode);
+    MALI_SwapChain_DeferRelease(&chain);
+
+    for (step = 0; step < STEPS; step++) {
+        seed = seed * 1103515245 + 12345;
+
+        switch ((seed >> 16) % 3) {
+        case 0:
+            /* Application swaps and grabs the next page, if there is one */
+            if (chain.rendering >= 0)
+                MALI_SwapChain_Queue(&chain);
+            MALI_SwapChain_AcquireRender(&chain);
+            break;
+        case 1:
+            /* Thread picks up a frame, the pan happens later */
+            if (pending < 0 && MALI_SwapChain_HasQueued(&chain))
+                pending = MALI_SwapChain_AcquirePresent(&chain);
+            break;
+        default:
+            /* Flip lands, only now may the old page be reused */
+            if (pending >= 0) {
+                CHECK(MALI_Scanout_Present(&scanout, pending, SDL_TRUE) == 0, "pan to page %d failed", pending);
+                MALI_SwapChain_ReleasePrevious(&chain);
+                pending = -1;
+                presented++;
+            }
+            break;
+        }
+
+        if (fake.pans > 0) {
+            shown = fake.vinfo.yoffset / fake.vinfo.yres;
+            CHECK(chain.state[shown] == MALI_PAGE_PRESENTING, "page %d on screen in state %d at step %d", shown, chain.state[shown], step);
+            CHECK(chain.rendering != shown, "application rendering into the scanned out page %d at step %d", shown, step);
+        }
+
+        for (page = 0; page < depth; page++) {
+            if (chain.state[page] == MALI_PAGE_RENDERING)
+                CHECK(page == chain.rendering, "stray rendering page %d at step %d", page, step);
+        }
+    }
+
+    CHECK(presented > STEPS / 20, "only %d frames presented", presented);
+    CHECK(fake.vsyncs == fake.pans, "%d vsync waits for %d pans", fake.vsyncs, fake.pans);
+    printf("  %d frames presented, %d dropped\n", presented, (int)chain.frames_dropped);
+
+    MALI_Scanout_Quit(&scanout);
+}
+
+static int
+run_test(void)
+{
+    int depth;
+    MALI_PresentMode mode;
+
+    test_can_use();
+    test_init();
+    for (mode = MALI_PRESENT_MAILBOX; mode <= MALI_PRESENT_FIFO; mode++) {
+        for (depth = MALI_SWAPCHAIN_MIN_DEPTH; depth <= 4; depth++) {
+            test_present(depth, mode);
+        }
+    }
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Headless harness for the mali-fbdev pixmap swap chain.
+ *
+ * The ION pages are plain memory stamped with the frame number, the EGL fences
+ * are timestamps at which the fake GPU "finishes" a frame, and the blitter
+ * thread and display are simulated on a fixed timeline, so the result is fully
+ * deterministic and runs on any host.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "../src/video/mali-fbdev/SDL_maliswapchain.h"
+#include "../src/video/mali-fbdev/SDL_maliswapchain.c"
+
+#define TICK_US         50
+#define REFRESH_US      16650
+#define GPU_LAG_US      3000
+#define BLIT_US         1500
+#define RUN_US          (10 * 1000 * 1000)
+
+typedef struct
+{
+    const char *name;
+    int (*frame_time)(int frame);
+} Workload;
+
+typedef struct
+{
+    /* fake ION backing store and EGL fence for every page */
+    Uint32 contents[MALI_SWAPCHAIN_MAX_DEPTH];
+    int fence_at[MALI_SWAPCHAIN_MAX_DEPTH];
+
+    int produced;
+    int presented;
+    int dropped;
+    int duplicated;
+    int stalled_us;
+    Sint64 latency_us;
+    int errors;
+} Result;
+
+static int
+steady_frame(int frame)
+{
+    return 16000;
+}
+
+static int
+fast_frame(int frame)
+{
+    return 8000;
+}
+
+static int
+uneven_frame(int frame)
+{
+    /* Emulators alternating between cheap and expensive frames */
+    return (frame & 1) ? 24000 : 9000;
+}
+
+static int
+jitter_frame(int frame)
+{
+    Uint32 x = (Uint32)frame * 1103515245u + 12345u;
+    return 10000 + (int)((x >> 8) % 13000);
+}
+
+static const Workload workloads[] = {
+    { "steady 16ms", steady_frame },
+    { "fast 8ms", fast_frame },
+    { "uneven 9/24ms", uneven_frame },
+    { "jitter 10-23ms", jitter_frame },
+};
+
+static void
+simulate(const Workload *workload, int depth, MALI_PresentMode mode, Result *res)
+{
+    MALI_SwapChain chain;
+    int i, t, queued;
+    int frame = 0, render_page = 0, render_end;
+    int blit_page = -1, blit_frame = 0, blit_done = 0, blit_visible = -1;
+    int blit_queued = 0, visible_queued = 0;
+    int queued_at[MALI_SWAPCHAIN_MAX_DEPTH];
+    int on_screen = -1, last_vsync_frame = -1;
+
+    SDL_zerop(res);
+    MALI_SwapChain_Init(&chain, depth, mode);
+    render_end = workload->frame_time(frame);
+
+    for (t = 0; t < RUN_US; t += TICK_US) {
+        /* Application thread */
+        if (render_page < 0) {
+            render_page = MALI_SwapChain_AcquireRender(&chain);
+            if (render_page < 0) {
+                res->stalled_us += TICK_US;
+            } else {
+                render_end = t + workload->frame_time(frame);
+            }
+        } else if (t >= render_end) {
+            if (chain.state[render_page] != MALI_PAGE_RENDERING || chain.presenting == render_page) {
+                SDL_Log("  page %d written while not owned by the application", render_page);
+                res->errors++;
+            }
+            res->contents[render_page] = (Uint32)frame;
+            res->fence_at[render_page] = t + GPU_LAG_US;
+            queued_at[render_page] = t;
+            res->produced++;
+            frame++;
+
+            MALI_SwapChain_Queue(&chain);
+            render_page = MALI_SwapChain_AcquireRender(&chain);
+            if (render_page >= 0) {
+                render_end = t + workload->frame_time(frame);
+            }
+        }
+
+        /* Blitter thread: pick a page, wait on its fence, blit, then block on vsync */
+        if (blit_page < 0 && blit_visible < 0 && MALI_SwapChain_HasQueued(&chain)) {
+            blit_page = MALI_SwapChain_AcquirePresent(&chain);
+            blit_frame = (int)res->contents[blit_page];
+            blit_done = SDL_max(t, res->fence_at[blit_page]) + BLIT_US;
+            blit_queued = queued_at[blit_page];
+        }
+        if (blit_page >= 0 && t >= blit_done) {
+            if ((int)res->contents[blit_page] != blit_frame) {
+                SDL_Log("  page %d was overwritten while being presented", blit_page);
+                res->errors++;
+            }
+            blit_visible = blit_frame;
+            visible_queued = blit_queued;
+            blit_page = -1;
+        }
+
+        /* Display */
+        if ((t % REFRESH_US) < TICK_US) {
+            if (blit_visible >= 0) {
+                if (blit_visible <= on_screen) {
+                    SDL_Log("  frame %d presented after frame %d", blit_visible, on_screen);
+                    res->errors++;
+                }
+                if (mode == MALI_PRESENT_FIFO && blit_visible != on_screen + 1) {
+                    SDL_Log("  FIFO skipped from frame %d to frame %d", on_screen, blit_visible);
+                    res->errors++;
+                }
+                on_screen = blit_visible;
+                blit_visible = -1;
+                res->presented++;
+                res->latency_us += t - visible_queued;
+            } else if (on_screen >= 0 && on_screen == last_vsync_frame) {
+                res->duplicated++;
+                MALI_SwapChain_AddRepeats(&chain, 1);
+            }
+            last_vsync_frame = on_screen;
+        }
+    }
+
+    /* Every produced frame must be accounted for by the chain's own counters */
+    res->dropped = (int)chain.frames_dropped;
+    for (i = 0, queued = 0; i < chain.depth; i++) {
+        queued += (chain.state[i] == MALI_PAGE_QUEUED);
+    }
+    if (chain.frames_presented + chain.frames_dropped + queued != (Uint64)res->produced ||
+        chain.frames_repeated != (Uint64)res->duplicated) {
+        SDL_Log("  chain counters disagree: presented %d, dropped %d, queued %d, repeated %d",
+                (int)chain.frames_presented, (int)chain.frames_dropped, queued, (int)chain.frames_repeated);
+        res->errors++;
+    }
+    if (mode == MALI_PRESENT_FIFO && chain.frames_dropped != 0) {
+        SDL_Log("  FIFO dropped %d frames", (int)chain.frames_dropped);
+        res->errors++;
+    }
+}
+
+static int
+run_test(void)
+{
+    int success = 1;
+    size_t i;
+    int depth;
+    MALI_PresentMode mode;
+
+    printf("%-16s %-7s %5s %8s %8s %8s %8s %10s %10s\n",
+           "workload", "mode", "depth", "produced", "shown", "dropped", "dupes", "stall ms", "latency ms");
+
+    for (i = 0; i < SDL_arraysize(workloads); i++) {
+        for (mode = MALI_PRESENT_MAILBOX; mode <= MALI_PRESENT_FIFO; mode++) {
+        for (depth = MALI_SWAPCHAIN_MIN_DEPTH; depth <= 5; depth++) {
+            Result res;
+
+            simulate(&workloads[i], depth, mode, &res);
+            printf("%-16s %-7s %5d %8d %8d %8d %8d %10d %10.2f\n",
+                   workloads[i].name, mode == MALI_PRESENT_FIFO ? "fifo" : "mailbox", depth,
+                   res.produced, res.presented,
+                   res.dropped, res.duplicated, res.stalled_us / 1000,
+                   res.presented ? (double)res.latency_us / res.presented / 1000.0 : 0.0);
+
+            if (res.errors) {
+                printf("  FAIL: %d ownership or ordering violations\n", res.errors);
+                success = 0;
+            }
+        }
+        }
+    }
+
+    return success;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
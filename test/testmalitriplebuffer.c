@@ -0,0 +1,380 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Stress test for the mali-fbdev swap chain hand-off between threads.
+ *
+ * An application thread and a blitter thread run flat out against each other,
+ * using the same waiting scheme as the driver: the lock-free mailbox chain
+ * wakes the blitter through a semaphore posted only while it sleeps, every
+ * other chain goes through the mutex and condition variable. The EGL pixmaps are stood in for by plain
+ * memory pages stamped with the frame number and a fake fence, so any page
+ * handed to both threads at once, torn frame or lost wakeup shows up.
+ *
+ * The startup hand-off goes through the driver's own MALI_TripleBuffer calls:
+ * the blitter of every first window, including one created after the last
+ * was destroyed, has to wait until that window's pages are allocated.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "../src/video/mali-fbdev/SDL_maliswapchain.h"
+#include "../src/video/mali-fbdev/SDL_maliswapchain.c"
+#include "../src/video/mali-fbdev/SDL_malitriplebuf.c"
+
+#define FRAMES      200000
+#define PAGE_WORDS  64
+
+/* Who is touching a page right now, claimed with a CAS so any overlap is caught */
+enum { OWNER_NONE = 0, OWNER_APP, OWNER_BLITTER };
+
+typedef struct Page
+{
+    SDL_atomic_t owner;
+    SDL_atomic_t fence;     /* frame number once the fake GPU is done with the page */
+    Uint32 words[PAGE_WORDS];
+} Page;
+
+typedef struct Context
+{
+    MALI_SwapChain chain;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    SDL_sem *sem;
+    SDL_atomic_t sleeping;
+    int stop;
+
+    Page pages[MALI_SWAPCHAIN_MAX_DEPTH];
+    Uint32 produced;
+    Uint32 presented;
+    Uint32 last_shown;
+    SDL_atomic_t errors;
+} Context;
+
+static void
+report(Context *ctx, const char *what, int page, Uint32 frame)
+{
+    if (SDL_AtomicAdd(&ctx->errors, 1) < 10)
+        printf("  FAIL: %s, page %d frame %u\n", what, page, frame);
+}
+
+static void
+claim(Context *ctx, int page, int owner, Uint32 frame)
+{
+    if (!SDL_AtomicCAS(&ctx->pages[page].owner, OWNER_NONE, owner))
+        report(ctx, owner == OWNER_APP ? "application got a page the blitter is using" :
+                                         "blitter got a page the application is using", page, frame);
+}
+
+static void
+unclaim(Context *ctx, int page)
+{
+    SDL_AtomicSet(&ctx->pages[page].owner, OWNER_NONE);
+}
+
+/* Same as MALI_WakeBlitter, posts left over would keep the blitter spinning once idle */
+static void
+wake_blitter(Context *ctx)
+{
+    if (SDL_AtomicCAS(&ctx->sleeping, 1, 0))
+        SDL_SemPost(ctx->sem);
+    if (SDL_SemValue(ctx->sem) > 1)
+        report(ctx, "blitter woken more than once", -1, SDL_SemValue(ctx->sem));
+}
+
+static int SDLCALL
+blitter_thread(void *data)
+{
+    Context *ctx = (Context *)data;
+    int i, page;
+    Uint32 frame;
+
+    SDL_LockMutex(ctx->mutex);
+    for (;;) {
+        /* Same wait as MALI_WaitForWork, the condition variable is only for the application */
+        while (!ctx->stop && !MALI_SwapChain_HasQueued(&ctx->chain)) {
+            SDL_AtomicCAS(&ctx->sleeping, 0, 1);
+            if (MALI_SwapChain_HasQueued(&ctx->chain) && SDL_AtomicCAS(&ctx->sleeping, 1, 0))
+                break;
+            SDL_UnlockMutex(ctx->mutex);
+            SDL_SemWait(ctx->sem);
+            SDL_LockMutex(ctx->mutex);
+        }
+        if (ctx->stop && !MALI_SwapChain_HasQueued(&ctx->chain))
+            break;
+
+        page = MALI_SwapChain_AcquirePresent(&ctx->chain);
+        SDL_CondBroadcast(ctx->cond);
+        SDL_UnlockMutex(ctx->mutex);
+
+        if (page < 0 || page >= ctx->chain.depth) {
+            report(ctx, "blitter got an invalid page", page, 0);
+            SDL_LockMutex(ctx->mutex);
+            continue;
+        }
+
+        /* "Blit" the page, reading it twice around a yield to catch writes from the application */
+        claim(ctx, page, OWNER_BLITTER, 0);
+        frame = ctx->pages[page].words[0];
+        if ((Uint32)SDL_AtomicGet(&ctx->pages[page].fence) != frame)
+            report(ctx, "fence doesn't belong to the frame in the page", page, frame);
+        if (ctx->presented > 0 && (Sint32)(frame - ctx->last_shown) <= 0)
+            report(ctx, "frame shown out of order", page, frame);
+        if (ctx->chain.mode == MALI_PRESENT_FIFO && ctx->presented > 0 && frame != ctx->last_shown + 1)
+            report(ctx, "FIFO skipped a frame", page, frame);
+        for (i = 0; i < PAGE_WORDS; i++) {
+            if (ctx->pages[page].words[i] != frame) {
+                report(ctx, "torn frame", page, frame);
+                break;
+            }
+        }
+        if ((ctx->presented & 7) == 0)
+            SDL_Delay(0);
+        if (ctx->pages[page].words[PAGE_WORDS - 1] != frame)
+            report(ctx, "page overwritten while being shown", page, frame);
+        unclaim(ctx, page);
+
+        ctx->last_shown = frame;
+        ctx->presented++;
+        SDL_LockMutex(ctx->mutex);
+    }
+    SDL_UnlockMutex(ctx->mutex);
+
+    return 0;
+}
+
+static void
+render(Context *ctx, int page, Uint32 frame)
+{
+    int i;
+
+    claim(ctx, page, OWNER_APP, frame);
+    for (i = 0; i < PAGE_WORDS; i++) {
+        ctx->pages[page].words[i] = frame;
+    }
+    SDL_AtomicSet(&ctx->pages[page].fence, (int)frame);
+    unclaim(ctx, page);
+}
+
+static int
+stress(int depth, MALI_PresentMode mode)
+{
+    Context *ctx;
+    SDL_Thread *thread;
+    Uint64 start;
+    Uint32 queued, frame;
+    int page;
+    int errors;
+    SDL_bool wake;
+
+    ctx = (Context *)SDL_calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        printf("  FAIL: out of memory\n");
+        return 1;
+    }
+
+    MALI_SwapChain_Init(&ctx->chain, depth, mode);
+    ctx->mutex = SDL_CreateMutex();
+    ctx->cond = SDL_CreateCond();
+    ctx->sem = SDL_CreateSemaphore(0);
+
+    start = SDL_GetPerformanceCounter();
+    thread = SDL_CreateThread(blitter_thread, "blitter", ctx);
+
+    /* The application thread, mirrors MALI_GLES_SwapWindowWithDamage */
+    page = MALI_SwapChain_AcquireRender(&ctx->chain);
+    for (frame = 1; frame <= FRAMES; frame++) {
+        render(ctx, page, frame);
+        ctx->produced++;
+
+        if (ctx->chain.lockfree) {
+            if (MALI_SwapChain_Queue(&ctx->chain))
+                wake_blitter(ctx);
+            page = MALI_SwapChain_AcquireRender(&ctx->chain);
+        } else {
+            SDL_LockMutex(ctx->mutex);
+            wake = !MALI_SwapChain_HasQueued(&ctx->chain);
+            MALI_SwapChain_Queue(&ctx->chain);
+            if (wake)
+                wake_blitter(ctx);
+            while ((page = MALI_SwapChain_AcquireRender(&ctx->chain)) < 0)
+                SDL_CondWait(ctx->cond, ctx->mutex);
+            SDL_UnlockMutex(ctx->mutex);
+        }
+
+        if (page < 0 || page >= depth) {
+            report(ctx, "application got an invalid page", page, frame);
+            break;
+        }
+    }
+
+    SDL_LockMutex(ctx->mutex);
+    ctx->stop = 1;
+    SDL_CondBroadcast(ctx->cond);
+    wake_blitter(ctx);
+    SDL_UnlockMutex(ctx->mutex);
+    SDL_WaitThread(thread, NULL);
+
+    /* The blitter drains what's queued before stopping, so every frame is shown or dropped */
+    queued = MALI_SwapChain_HasQueued(&ctx->chain) ? 1 : 0;
+    if (ctx->chain.frames_presented != ctx->presented ||
+        ctx->chain.frames_presented + ctx->chain.frames_dropped + queued != ctx->produced) {
+        printf("  FAIL: produced %u, presented %u (chain %u), dropped %u, queued %u\n",
+               ctx->produced, ctx->presented, (Uint32)ctx->chain.frames_presented,
+               (Uint32)ctx->chain.frames_dropped, queued);
+        SDL_AtomicAdd(&ctx->errors, 1);
+    }
+    if (ctx->last_shown != ctx->produced)
+        report(ctx, "last frame never shown", -1, ctx->last_shown);
+
+    printf("%-7s depth %d %-9s %8u frames %8u shown %8u dropped %6.0f ms\n",
+           mode == MALI_PRESENT_FIFO ? "fifo" : "mailbox", depth, ctx->chain.lockfree ? "lock-free" : "locked",
+           ctx->produced, ctx->presented, (Uint32)ctx->chain.frames_dropped,
+           (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+
+    if (SDL_SemValue(ctx->sem) > 0)
+        report(ctx, "wakeups left over", -1, SDL_SemValue(ctx->sem));
+
+    errors = SDL_AtomicGet(&ctx->errors);
+    SDL_DestroySemaphore(ctx->sem);
+    SDL_DestroyCond(ctx->cond);
+    SDL_DestroyMutex(ctx->mutex);
+    SDL_free(ctx);
+    return errors;
+}
+
+/* What the blitter thread saw of the pages, stands in for MALI_TripleBufferingThread */
+typedef struct Startup
+{
+    SDL_DisplayData displaydata;
+    SDL_atomic_t waited;
+    SDL_bool pages_ready;
+} Startup;
+
+static int SDLCALL
+startup_thread(void *data)
+{
+    Startup *startup = (Startup *)data;
+
+    startup->pages_ready = MALI_TripleBufferWaitForPages(&startup->displaydata);
+    SDL_AtomicSet(&startup->waited, 1);
+    return 0;
+}
+
+/* One window's life on the display, the pages are allocated unless the window fails early */
+static int
+startup_window(Startup *startup, int window, SDL_bool allocate)
+{
+    SDL_DisplayData *displaydata = &startup->displaydata;
+    int errors = 0;
+
+    MALI_TripleBufferInit(displaydata);
+    SDL_AtomicSet(&startup->waited, 0);
+    startup->pages_ready = SDL_FALSE;
+    displaydata->triplebuf_thread = SDL_CreateThread(startup_thread, "blitter", startup);
+
+    /* MALI_CreateWindow is still allocating the pages */
+    SDL_Delay(20);
+    if (SDL_AtomicGet(&startup->waited)) {
+        printf("  FAIL: window %d, blitter went on before the pages were ready\n", window);
+        errors++;
+    }
+
+    if (allocate) {
+        MALI_TripleBufferPagesReady(displaydata);
+        SDL_WaitThread(displaydata->triplebuf_thread, NULL);
+        displaydata->triplebuf_thread = NULL;
+        if (!startup->pages_ready) {
+            printf("  FAIL: window %d, blitter didn't get the pages\n", window);
+            errors++;
+        }
+    }
+
+    /* Destroying the window stops a blitter still waiting without the pages */
+    MALI_TripleBufferQuit(displaydata);
+    if (!SDL_AtomicGet(&startup->waited)) {
+        printf("  FAIL: window %d, blitter didn't stop\n", window);
+        errors++;
+    } else if (!allocate && startup->pages_ready) {
+        printf("  FAIL: window %d, blitter got pages that were never allocated\n", window);
+        errors++;
+    }
+    return errors;
+}
+
+static int
+startup(void)
+{
+    Startup *startup;
+    int errors = 0;
+
+    startup = (Startup *)SDL_calloc(1, sizeof(*startup));
+    if (!startup) {
+        printf("  FAIL: out of memory\n");
+        return 1;
+    }
+
+    /* Create, destroy and create again, then a window that fails before its pages */
+    errors += startup_window(startup, 1, SDL_TRUE);
+    errors += startup_window(startup, 2, SDL_TRUE);
+    errors += startup_window(startup, 3, SDL_FALSE);
+    errors += startup_window(startup, 4, SDL_TRUE);
+
+    printf("startup 4 windows %s\n", errors ? "failed" : "waited for their pages");
+    SDL_free(startup);
+    return errors;
+}
+
+static int
+run_test(void)
+{
+    int depth, errors = 0;
+    MALI_PresentMode mode;
+
+    errors += startup();
+
+    for (mode = MALI_PRESENT_MAILBOX; mode <= MALI_PRESENT_FIFO; mode++) {
+        for (depth = MALI_SWAPCHAIN_MIN_DEPTH; depth <= 4; depth++) {
+            errors += stress(depth, mode);
+        }
+    }
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
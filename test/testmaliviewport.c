@@ -0,0 +1,350 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Headless test for the mali-fbdev viewport policies.
+ *
+ * Lays windows of common sizes out on common panels in all four rotations and
+ * checks the quads: they stay on the viewport, centered, with the requested
+ * size and aspect ratio, and sample the window the right way up once the
+ * vertex shader turns the texture coordinates.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "SDL_hints.h"
+
+#include "../src/video/mali-fbdev/SDL_maliviewport.h"
+#include "../src/video/mali-fbdev/SDL_maliviewport.c"
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); errors++; } } while (0)
+
+static const int panels[][2] = {
+    { 640, 480 }, { 800, 480 }, { 854, 480 }, { 1280, 720 }, { 1920, 1080 }, { 480, 854 }
+};
+
+static const int planes[][2] = {
+    { 256, 224 }, { 320, 240 }, { 160, 144 }, { 640, 480 }, { 1280, 720 }, { 2048, 1536 }
+};
+
+static void
+test_parse(void)
+{
+    MALI_ViewportScaling scaling;
+    float ratio;
+    int crop[4];
+
+    CHECK(MALI_Viewport_ParseScaling(NULL, &scaling) && scaling == MALI_VIEWPORT_FIT, "unset scaling isn't fit");
+    CHECK(MALI_Viewport_ParseScaling("Integer", &scaling) && scaling == MALI_VIEWPORT_INTEGER, "integer not parsed");
+    CHECK(MALI_Viewport_ParseScaling("stretch", &scaling) && scaling == MALI_VIEWPORT_STRETCH, "stretch not parsed");
+    CHECK(!MALI_Viewport_ParseScaling("zoom", &scaling), "unknown scaling accepted");
+
+    CHECK(MALI_Viewport_ParseRatio("8:7", &ratio) && SDL_fabs(ratio - 8.0f / 7.0f) < 1e-6, "8:7 parsed as %g", ratio);
+    CHECK(MALI_Viewport_ParseRatio("4/3", &ratio) && SDL_fabs(ratio - 4.0f / 3.0f) < 1e-6, "4/3 parsed as %g", ratio);
+    CHECK(MALI_Viewport_ParseRatio("1.25", &ratio) && ratio == 1.25f, "1.25 parsed as %g", ratio);
+    CHECK(!MALI_Viewport_ParseRatio("8:", &ratio), "8: accepted");
+    CHECK(!MALI_Viewport_ParseRatio("0:1", &ratio), "0:1 accepted");
+    CHECK(!MALI_Viewport_ParseRatio("4:3x", &ratio), "4:3x accepted");
+
+    CHECK(MALI_Viewport_ParseCrop("8", crop) && crop[0] == 8 && crop[1] == 8 && crop[2] == 8 && crop[3] == 8,
+          "single crop value not applied to every edge");
+    CHECK(MALI_Viewport_ParseCrop("4,8", crop) && crop[0] == 4 && crop[1] == 8 && crop[2] == 4 && crop[3] == 8,
+          "horizontal,vertical crop parsed as %d,%d,%d,%d", crop[0], crop[1], crop[2], crop[3]);
+    CHECK(MALI_Viewport_ParseCrop("1,2,3,4", crop) && crop[0] == 1 && crop[1] == 2 && crop[2] == 3 && crop[3] == 4,
+          "left,top,right,bottom crop parsed as %d,%d,%d,%d", crop[0], crop[1], crop[2], crop[3]);
+    CHECK(!MALI_Viewport_ParseCrop("1,2,3", crop), "three crop values accepted");
+    CHECK(!MALI_Viewport_ParseCrop("-1", crop), "negative crop accepted");
+    CHECK(!MALI_Viewport_ParseCrop("1,2,3,4,5", crop), "five crop values accepted");
+}
+
+static void
+test_hints(void)
+{
+    MALI_ViewportPolicy policy;
+
+    SDL_SetHint(SDL_HINT_MALI_VIEWPORT, "integer");
+    SDL_SetHint(SDL_HINT_MALI_PIXEL_ASPECT, "8:7");
+    SDL_SetHint(SDL_HINT_MALI_DISPLAY_ASPECT, "bogus");
+    SDL_SetHint(SDL_HINT_MALI_OVERSCAN, "0,8");
+    MALI_Viewport_GetPolicy(&policy);
+    CHECK(policy.scaling == MALI_VIEWPORT_INTEGER, "scaling hint ignored");
+    CHECK(SDL_fabs(policy.pixel_aspect - 8.0f / 7.0f) < 1e-6, "pixel aspect hint ignored");
+    CHECK(policy.display_aspect == 0.0f, "invalid display aspect used");
+    CHECK(policy.crop[1] == 8 && policy.crop[3] == 8 && policy.crop[0] == 0, "overscan hint ignored");
+
+    SDL_SetHint(SDL_HINT_MALI_VIEWPORT, "");
+    SDL_SetHint(SDL_HINT_MALI_PIXEL_ASPECT, "");
+    SDL_SetHint(SDL_HINT_MALI_DISPLAY_ASPECT, "");
+    SDL_SetHint(SDL_HINT_MALI_OVERSCAN, "");
+    MALI_Viewport_GetPolicy(&policy);
+    CHECK(policy.scaling == MALI_VIEWPORT_FIT && policy.pixel_aspect == 1.0f && policy.display_aspect == 0.0f &&
+          policy.crop[0] == 0 && policy.crop[1] == 0 && policy.crop[2] == 0 && policy.crop[3] == 0,
+          "defaults aren't a plain fit");
+
+    /* Hint callbacks apply one hint at a time, before SDL_GetHint returns the new value */
+    policy.scaling = MALI_VIEWPORT_STRETCH;
+    MALI_Viewport_ApplyHint(&policy, SDL_HINT_MALI_PIXEL_ASPECT, "4:3");
+    CHECK(policy.scaling == MALI_VIEWPORT_STRETCH && SDL_fabs(policy.pixel_aspect - 4.0f / 3.0f) < 1e-6,
+          "applying the pixel aspect hint changed more than the pixel aspect");
+    MALI_Viewport_ApplyHint(&policy, SDL_HINT_MALI_PIXEL_ASPECT, "bogus");
+    CHECK(policy.pixel_aspect == 1.0f, "invalid pixel aspect didn't go back to square pixels");
+    MALI_Viewport_ApplyHint(&policy, SDL_HINT_MALI_OVERSCAN, "2");
+    MALI_Viewport_ApplyHint(&policy, SDL_HINT_MALI_OVERSCAN, NULL);
+    CHECK(policy.crop[0] == 0 && policy.crop[3] == 0, "cleared overscan hint kept cropping");
+}
+
+/* Texture coordinates as the vertex shader turns them, wrapped onto the texture */
+static void
+shade(int rotation, int plane_w, int plane_h, float u, float v, float *tx, float *ty)
+{
+    switch (rotation) {
+        case 1: *tx = v; *ty = -u; break;
+        case 2: *tx = -u; *ty = -v; break;
+        case 3: *tx = -v; *ty = u; break;
+        default: *tx = u; *ty = v; break;
+    }
+    *tx = SDL_fmodf(*tx + 4.0f * plane_w, (float)plane_w);
+    *ty = SDL_fmodf(*ty + 4.0f * plane_h, (float)plane_h);
+}
+
+/* The inverse of the display to viewport mapping of MALI_Blitter_DamageToViewport */
+static void
+to_display(int rotation, int viewport_w, int viewport_h, float ax, float ay, float *x, float *y)
+{
+    float dw = (rotation & 1) ? viewport_h : viewport_w, dh = (rotation & 1) ? viewport_w : viewport_h;
+    float tx, ty;
+
+    switch (rotation) {
+        case 1: tx = ay; ty = dh - ax; break;
+        case 2: tx = dw - ax; ty = dh - ay; break;
+        case 3: tx = dw - ay; ty = ax; break;
+        default: tx = ax; ty = ay; break;
+    }
+    *x = tx;
+    *y = dh - ty;
+}
+
+static SDL_bool
+same_texel(float a, float b, int size)
+{
+    float d = SDL_fabsf(a - b);
+    return d < 0.01f || SDL_fabsf(d - size) < 0.01f;
+}
+
+/*
+ * The corner of the quad at the top left of the display has to sample the top left of
+ * the cropped window, the bottom right one its bottom right. GL textures start at the bottom.
+ */
+static void
+check_orientation(const char *what, const MALI_ViewportPolicy *policy, int rotation, int vw, int vh, int pw, int ph,
+                  float vert[4][4])
+{
+    float x, y, tx, ty, best_tl = 1e9f, best_br = -1e9f;
+    int i, tl = 0, br = 0;
+
+    for (i = 0; i < 4; i++) {
+        to_display(rotation, vw, vh, vert[i][0], vert[i][1], &x, &y);
+        if (x + y < best_tl) {
+            best_tl = x + y;
+            tl = i;
+        }
+        if (x + y > best_br) {
+            best_br = x + y;
+            br = i;
+        }
+    }
+
+    shade(rotation, pw, ph, vert[tl][2], vert[tl][3], &tx, &ty);
+    CHECK(same_texel(tx, (float)policy->crop[0], pw) && same_texel(ty, (float)(ph - policy->crop[1]), ph),
+          "%s rotation %d %dx%d on %dx%d: top left samples (%g, %g)", what, rotation, pw, ph, vw, vh, tx, ty);
+    shade(rotation, pw, ph, vert[br][2], vert[br][3], &tx, &ty);
+    CHECK(same_texel(tx, (float)(pw - policy->crop[2]), pw) && same_texel(ty, (float)policy->crop[3], ph),
+          "%s rotation %d %dx%d on %dx%d: bottom right samples (%g, %g)", what, rotation, pw, ph, vw, vh, tx, ty);
+}
+
+/* The quad's size in the window's orientation */
+static void
+get_picture_size(int rotation, float vert[4][4], float *w, float *h)
+{
+    float qw = vert[3][0] - vert[0][0], qh = vert[3][1] - vert[0][1];
+    *w = (rotation & 1) ? qh : qw;
+    *h = (rotation & 1) ? qw : qh;
+}
+
+static void
+check_quad(const char *what, int rotation, int vw, int vh, float vert[4][4], float scale[2])
+{
+    float left = vert[0][0], bottom = vert[0][1], right = vw - vert[3][0], top = vh - vert[3][1];
+
+    CHECK(left >= 0 && bottom >= 0 && right >= 0 && top >= 0,
+          "%s rotation %d on %dx%d: quad off the viewport", what, rotation, vw, vh);
+    CHECK(SDL_fabs(left - right) <= 1 && SDL_fabs(top - bottom) <= 1,
+          "%s rotation %d on %dx%d: quad not centered", what, rotation, vw, vh);
+    CHECK(vert[0][0] == vert[1][0] && vert[2][0] == vert[3][0] && vert[0][1] == vert[2][1] && vert[1][1] == vert[3][1],
+          "%s rotation %d on %dx%d: quad isn't a strip of a rectangle", what, rotation, vw, vh);
+    CHECK(scale[0] > 0 && scale[1] > 0, "%s rotation %d on %dx%d: scale %g x %g", what, rotation, vw, vh,
+          scale[0], scale[1]);
+}
+
+static void
+test_layouts(void)
+{
+    MALI_ViewportPolicy policy;
+    float vert[4][4], scale[2], w, h, fit_w, fit_h, aspect, factor;
+    int p, q, rotation, vw, vh, pw, ph, dw, dh;
+
+    for (p = 0; p < (int)SDL_arraysize(panels); p++) {
+        for (q = 0; q < (int)SDL_arraysize(planes); q++) {
+            for (rotation = 0; rotation < 4; rotation++) {
+                vw = panels[p][0];
+                vh = panels[p][1];
+                pw = planes[q][0];
+                ph = planes[q][1];
+                dw = (rotation & 1) ? vh : vw;
+                dh = (rotation & 1) ? vw : vh;
+
+                /* Fit touches two edges and keeps the aspect ratio */
+                SDL_zero(policy);
+                policy.pixel_aspect = 1.0f;
+                MALI_Viewport_GetQuad(&policy, rotation, vw, vh, pw, ph, vert, scale);
+                check_quad("fit", rotation, vw, vh, vert, scale);
+                check_orientation("fit", &policy, rotation, vw, vh, pw, ph, vert);
+                get_picture_size(rotation, vert, &fit_w, &fit_h);
+                CHECK(fit_w == dw || fit_h == dh, "fit %dx%d on %dx%d rotation %d is %gx%g",
+                      pw, ph, vw, vh, rotation, fit_w, fit_h);
+                CHECK(SDL_fabs(fit_w / fit_h - (float)pw / ph) < 2.0f / SDL_min(fit_w, fit_h),
+                      "fit %dx%d on %dx%d rotation %d is %gx%g", pw, ph, vw, vh, rotation, fit_w, fit_h);
+
+                /* Integer is a whole multiple, or fit when the window is too big for that */
+                policy.scaling = MALI_VIEWPORT_INTEGER;
+                MALI_Viewport_GetQuad(&policy, rotation, vw, vh, pw, ph, vert, scale);
+                check_quad("integer", rotation, vw, vh, vert, scale);
+                check_orientation("integer", &policy, rotation, vw, vh, pw, ph, vert);
+                get_picture_size(rotation, vert, &w, &h);
+                factor = SDL_floorf(SDL_min((float)dw / pw, (float)dh / ph));
+                if (factor >= 1.0f) {
+                    CHECK(w == pw * factor && h == ph * factor && scale[0] == factor && scale[1] == factor,
+                          "integer %dx%d on %dx%d rotation %d is %gx%g", pw, ph, vw, vh, rotation, w, h);
+                } else {
+                    CHECK(w == fit_w && h == fit_h, "integer %dx%d on %dx%d rotation %d doesn't fall back to fit",
+                          pw, ph, vw, vh, rotation);
+                }
+
+                /* Stretch covers it all */
+                policy.scaling = MALI_VIEWPORT_STRETCH;
+                MALI_Viewport_GetQuad(&policy, rotation, vw, vh, pw, ph, vert, scale);
+                check_quad("stretch", rotation, vw, vh, vert, scale);
+                check_orientation("stretch", &policy, rotation, vw, vh, pw, ph, vert);
+                CHECK(vert[0][0] == 0 && vert[0][1] == 0 && vert[3][0] == vw && vert[3][1] == vh,
+                      "stretch %dx%d on %dx%d rotation %d leaves a border", pw, ph, vw, vh, rotation);
+
+                /* Overscan cropping with SNES pixels, the picture is what's left, 8:7 wider */
+                SDL_zero(policy);
+                policy.pixel_aspect = 8.0f / 7.0f;
+                policy.crop[0] = 2;
+                policy.crop[1] = 8;
+                policy.crop[2] = 6;
+                policy.crop[3] = 4;
+                MALI_Viewport_GetQuad(&policy, rotation, vw, vh, pw, ph, vert, scale);
+                check_quad("cropped", rotation, vw, vh, vert, scale);
+                check_orientation("cropped", &policy, rotation, vw, vh, pw, ph, vert);
+                get_picture_size(rotation, vert, &w, &h);
+                aspect = (pw - 8) * (8.0f / 7.0f) / (ph - 12);
+                CHECK(SDL_fabs(w / h - aspect) < 2.0f / SDL_min(w, h), "cropped %dx%d on %dx%d rotation %d is %gx%g",
+                      pw, ph, vw, vh, rotation, w, h);
+            }
+        }
+    }
+}
+
+static void
+test_retro(void)
+{
+    MALI_ViewportPolicy policy;
+    float vert[4][4], scale[2], w, h;
+    int rotation;
+
+    /* SNES on 720p: 8:7 pixels, three times the lines when integer scaled */
+    SDL_zero(policy);
+    policy.pixel_aspect = 8.0f / 7.0f;
+    MALI_Viewport_GetQuad(&policy, 0, 1280, 720, 256, 224, vert, scale);
+    get_picture_size(0, vert, &w, &h);
+    CHECK(w == 940 && h == 720, "SNES fit on 720p is %gx%g", w, h);
+
+    policy.scaling = MALI_VIEWPORT_INTEGER;
+    for (rotation = 0; rotation < 4; rotation++) {
+        MALI_Viewport_GetQuad(&policy, rotation, (rotation & 1) ? 720 : 1280, (rotation & 1) ? 1280 : 720,
+                              256, 224, vert, scale);
+        get_picture_size(rotation, vert, &w, &h);
+        CHECK(w == 878 && h == 672, "SNES integer on 720p rotation %d is %gx%g", rotation, w, h);
+    }
+
+    /* A 4:3 picture whatever the window size */
+    SDL_zero(policy);
+    policy.pixel_aspect = 1.0f;
+    policy.display_aspect = 4.0f / 3.0f;
+    MALI_Viewport_GetQuad(&policy, 0, 1920, 1080, 256, 224, vert, scale);
+    get_picture_size(0, vert, &w, &h);
+    CHECK(w == 1440 && h == 1080, "4:3 on 1080p is %gx%g", w, h);
+
+    /* NES overscan, 8 lines off the top and bottom, on a 640x480 panel */
+    SDL_zero(policy);
+    policy.pixel_aspect = 1.0f;
+    policy.scaling = MALI_VIEWPORT_INTEGER;
+    policy.crop[1] = policy.crop[3] = 8;
+    MALI_Viewport_GetQuad(&policy, 0, 640, 480, 256, 240, vert, scale);
+    get_picture_size(0, vert, &w, &h);
+    CHECK(w == 512 && h == 448 && vert[0][3] == 8 && vert[1][3] == 232, "cropped NES is %gx%g showing lines %g to %g",
+          w, h, vert[0][3], vert[1][3]);
+
+    /* Cropping away the whole window is ignored */
+    policy.crop[1] = policy.crop[3] = 200;
+    MALI_Viewport_GetQuad(&policy, 0, 640, 480, 256, 240, vert, scale);
+    CHECK(vert[0][3] == 0 && vert[1][3] == 240, "window cropped away");
+}
+
+static int
+run_test(void)
+{
+    test_parse();
+    test_hints();
+    test_layouts();
+    test_retro();
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
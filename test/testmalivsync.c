@@ -0,0 +1,231 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Headless test for the mali-fbdev refresh rate detection and vsync clock.
+ *
+ * The rate is derived from CEA-861 mode timings and from timed refreshes, the
+ * clock is fed swap timestamps of a simulated 59.94 Hz panel with wake-up
+ * jitter and dropped frames and has to predict its refreshes.
+ */
+
+#include "../src/SDL_internal.h"
+
+#include <stdio.h>
+
+static int run_test(void);
+
+#if SDL_VIDEO_DRIVER_MALI
+
+#include "../src/video/mali-fbdev/SDL_malivsync.h"
+#include "../src/video/mali-fbdev/SDL_malivsync.c"
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); errors++; } } while (0)
+
+static struct fb_var_screeninfo
+make_mode(Uint32 pixclock, Uint32 hfront, Uint32 vfront, Uint32 vmode)
+{
+    struct fb_var_screeninfo vinfo;
+
+    /* 1920x1080 with 148 + 44 and 36 + 5 back porch and sync, the front porch sets the rate */
+    SDL_zero(vinfo);
+    vinfo.xres = 1920;
+    vinfo.yres = 1080;
+    vinfo.pixclock = pixclock;
+    vinfo.left_margin = 148;
+    vinfo.right_margin = hfront;
+    vinfo.hsync_len = 44;
+    vinfo.upper_margin = 36;
+    vinfo.lower_margin = vfront;
+    vinfo.vsync_len = 5;
+    vinfo.vmode = vmode;
+    return vinfo;
+}
+
+static void
+test_mode_rate(void)
+{
+    struct fb_var_screeninfo vinfo;
+    Uint32 rate;
+
+    vinfo = make_mode(6734, 88, 4, FB_VMODE_NONINTERLACED);
+    rate = MALI_Vsync_GetModeRate(&vinfo);
+    CHECK(rate == 60000, "1080p60 at %u mHz", rate);
+
+    /* 148.35 MHz, the NTSC flavour */
+    vinfo = make_mode(6741, 88, 4, FB_VMODE_NONINTERLACED);
+    rate = MALI_Vsync_GetModeRate(&vinfo);
+    CHECK(rate >= 59930 && rate <= 59945, "1080p59.94 at %u mHz", rate);
+
+    vinfo = make_mode(6734, 528, 4, FB_VMODE_NONINTERLACED);
+    rate = MALI_Vsync_GetModeRate(&vinfo);
+    CHECK(rate == 50000, "1080p50 at %u mHz", rate);
+
+    /* Interlaced modes refresh once per field */
+    vinfo = make_mode(13468, 88, 4, FB_VMODE_INTERLACED);
+    rate = MALI_Vsync_GetModeRate(&vinfo);
+    CHECK(rate == 60000, "1080i60 at %u mHz", rate);
+
+    vinfo = make_mode(0, 88, 4, FB_VMODE_NONINTERLACED);
+    CHECK(MALI_Vsync_GetModeRate(&vinfo) == 0, "mode without a pixel clock has a rate");
+
+    vinfo = make_mode(1, 88, 4, FB_VMODE_NONINTERLACED);
+    CHECK(MALI_Vsync_GetModeRate(&vinfo) == 0, "a 400 kHz refresh was taken at face value");
+}
+
+static void
+test_measured_rate(void)
+{
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 timestamps[MALI_VSYNC_MEASURE_FRAMES + 1];
+    Uint32 rate;
+    int i;
+
+    for (i = 0; i < (int)SDL_arraysize(timestamps); i++) {
+        timestamps[i] = frequency + i * frequency / 50;
+    }
+
+    /* One late wake-up, which also shortens the next interval */
+    timestamps[4] += frequency / 200;
+    rate = MALI_Vsync_GetMeasuredRate(timestamps, SDL_arraysize(timestamps));
+    CHECK(rate >= 49999 && rate <= 50001, "50 Hz measured at %u mHz", rate);
+
+    timestamps[4] = timestamps[3];
+    CHECK(MALI_Vsync_GetMeasuredRate(timestamps, SDL_arraysize(timestamps)) == 0, "stalled clock measured");
+    CHECK(MALI_Vsync_GetMeasuredRate(timestamps, 1) == 0, "a single refresh measured");
+}
+
+static int
+wait_fails(int fd)
+{
+    return -1;
+}
+
+static int
+wait_returns(int fd)
+{
+    return 0;
+}
+
+static void
+test_measure(void)
+{
+    MALI_ScanoutOps ops;
+
+    SDL_zero(ops);
+    ops.wait_vsync = wait_fails;
+    CHECK(MALI_Vsync_Measure(&ops, -1) == 0, "measured without FBIO_WAITFORVSYNC");
+
+    /* Some drivers take the ioctl and return right away */
+    ops.wait_vsync = wait_returns;
+    CHECK(MALI_Vsync_Measure(&ops, -1) == 0, "measured a driver that doesn't wait");
+}
+
+/* Swap timestamps of a panel refreshing every true_period, up to half a millisecond late */
+static void
+simulate(MALI_VsyncClock *clock, Uint64 start, Uint64 true_period, int refreshes, Uint64 *last)
+{
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint32 seed = 12345;
+    int i;
+
+    for (i = 0; i < refreshes; i++) {
+        seed = seed * 1103515245 + 12345;
+
+        /* Every so often a frame takes two refreshes */
+        if (i % 37 == 36)
+            continue;
+
+        *last = start + i * true_period;
+        MALI_Vsync_Record(clock, *last + (seed >> 16) % 500 * frequency / 1000000);
+    }
+}
+
+static void
+test_clock(void)
+{
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 true_period, last = 0, start = frequency, predicted, expected, tolerance = frequency / 1000;
+    MALI_VsyncClock clock;
+    Sint64 error;
+
+    /* Assumed 60 Hz, actually 59.94 */
+    MALI_Vsync_Init(&clock, 60000);
+    CHECK(MALI_Vsync_Predict(&clock, 1000) == 1000 + clock.period, "prediction without a phase");
+
+    true_period = frequency * 1000 / 59940;
+    simulate(&clock, start, true_period, 600, &last);
+    error = (Sint64)(clock.period - true_period);
+    CHECK(error < (Sint64)true_period / 2000 && error > -(Sint64)true_period / 2000,
+          "period off by %d ticks after 10 seconds", (int)error);
+
+    /* Halfway to the next refresh, the prediction is the one after the last swap */
+    expected = last + true_period;
+    predicted = MALI_Vsync_Predict(&clock, last + true_period / 2);
+    CHECK(predicted + tolerance > expected && predicted < expected + tolerance,
+          "predicted %d ticks from the refresh", (int)(predicted - expected));
+
+    /* Several refreshes without swaps are extrapolated */
+    expected = last + 5 * true_period;
+    predicted = MALI_Vsync_Predict(&clock, last + 4 * true_period + true_period / 2);
+    CHECK(predicted + tolerance > expected && predicted < expected + tolerance,
+          "extrapolated %d ticks from the refresh", (int)(predicted - expected));
+
+    CHECK(MALI_Vsync_CountRefreshes(&clock, last, last + 3 * true_period + tolerance) == 3, "three refreshes miscounted");
+    CHECK(MALI_Vsync_CountRefreshes(&clock, last, last) == 0, "refreshes counted without time passing");
+
+    /* A stall loses track, the clock picks up at the next swap */
+    last += frequency + true_period / 3;
+    MALI_Vsync_Record(&clock, last);
+    CHECK(clock.phase == last, "stall not picked up");
+    error = (Sint64)(clock.period - true_period);
+    CHECK(error < (Sint64)true_period / 2000 && error > -(Sint64)true_period / 2000, "stall changed the period");
+
+    /* Reported as 50 Hz, actually 60, the clock still gets there */
+    MALI_Vsync_Init(&clock, 50000);
+    true_period = frequency / 60;
+    simulate(&clock, start, true_period, 600, &last);
+    error = (Sint64)(clock.period - true_period);
+    CHECK(error < (Sint64)true_period / 1000 && error > -(Sint64)true_period / 1000,
+          "wrong nominal rate, period off by %d ticks", (int)error);
+}
+
+static int
+run_test(void)
+{
+    test_mode_rate();
+    test_measured_rate();
+    test_measure();
+    test_clock();
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors == 0;
+}
+
+#else
+
+static int
+run_test(void)
+{
+    printf("SDL compiled without the mali-fbdev video driver.\n");
+    return 1;
+}
+
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    return run_test() ? 0 : 1;
+}
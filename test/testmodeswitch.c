@@ -0,0 +1,155 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Benchmark for resolution changes of an OpenGL window.
+ *
+ * Cycles the window through the sizes emulators typically switch between and
+ * measures how long it takes from SDL_SetWindowSize() until the first frame at
+ * the new size has been swapped, which is the hitch a user would notice.
+ */
+
+#include "SDL.h"
+#include "SDL_opengl.h"
+
+static const struct { int w, h; } sizes[] = {
+    { 320, 240 },
+    { 256, 224 },
+    { 320, 224 },
+    { 640, 480 },
+    { 384, 224 },
+    { 512, 448 },
+};
+
+static void (APIENTRY *pglClearColor)(GLclampf, GLclampf, GLclampf, GLclampf);
+static void (APIENTRY *pglClear)(GLbitfield);
+
+static int
+compare_ticks(const void *a, const void *b)
+{
+    Uint64 x = *(const Uint64 *)a, y = *(const Uint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static void
+draw_frame(SDL_Window *window, int frame)
+{
+    pglClearColor((frame & 1) ? 1.0f : 0.0f, 0.0f, (frame & 1) ? 0.0f : 1.0f, 1.0f);
+    pglClear(GL_COLOR_BUFFER_BIT);
+    SDL_GL_SwapWindow(window);
+}
+
+int
+main(int argc, char *argv[])
+{
+    SDL_Window *window;
+    SDL_GLContext context;
+    SDL_Event event;
+    Uint64 *samples, total = 0, freq;
+    int i, iterations = 20, count, frame = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = SDL_atoi(argv[++i]);
+        } else {
+            SDL_Log("Usage: %s [--iterations N]", argv[0]);
+            return 1;
+        }
+    }
+
+    if (iterations <= 0) {
+        iterations = 1;
+    }
+
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO);
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
+        return 1;
+    }
+
+    window = SDL_CreateWindow("testmodeswitch", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                              sizes[0].w, sizes[0].h, SDL_WINDOW_OPENGL);
+    if (!window) {
+        SDL_Log("Couldn't create window: %s", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    context = SDL_GL_CreateContext(window);
+    if (!context) {
+        SDL_Log("Couldn't create GL context: %s", SDL_GetError());
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+
+    pglClearColor = SDL_GL_GetProcAddress("glClearColor");
+    pglClear = SDL_GL_GetProcAddress("glClear");
+    if (!pglClearColor || !pglClear) {
+        SDL_Log("Couldn't load GL functions: %s", SDL_GetError());
+        SDL_GL_DeleteContext(context);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+
+    SDL_GL_SetSwapInterval(1);
+
+    count = iterations * (int)SDL_arraysize(sizes);
+    samples = (Uint64 *)SDL_malloc(count * sizeof(*samples));
+    if (!samples) {
+        SDL_Log("Out of memory");
+        return 1;
+    }
+
+    /* Warm up, the first frames pay for one-time initialization */
+    for (i = 0; i < 10; i++) {
+        draw_frame(window, frame++);
+    }
+
+    for (i = 0; i < count; i++) {
+        int s = (i + 1) % SDL_arraysize(sizes);
+        Uint64 start = SDL_GetPerformanceCounter();
+
+        SDL_SetWindowSize(window, sizes[s].w, sizes[s].h);
+        draw_frame(window, frame++);
+        samples[i] = SDL_GetPerformanceCounter() - start;
+        total += samples[i];
+
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                count = i + 1;
+                break;
+            }
+        }
+
+        /* A few frames at the new size, so the driver is back in its steady state */
+        draw_frame(window, frame++);
+        draw_frame(window, frame++);
+    }
+
+    freq = SDL_GetPerformanceFrequency();
+    SDL_qsort(samples, count, sizeof(*samples), compare_ticks);
+    SDL_Log("%s: %d mode switches, min %.2f ms, avg %.2f ms, p95 %.2f ms, max %.2f ms",
+            SDL_GetCurrentVideoDriver(), count,
+            samples[0] * 1000.0 / freq,
+            total * 1000.0 / freq / count,
+            samples[(count * 95) / 100] * 1000.0 / freq,
+            samples[count - 1] * 1000.0 / freq);
+
+    SDL_free(samples);
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
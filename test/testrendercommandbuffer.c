@@ -0,0 +1,239 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Draws the same sprites once with SDL_RenderCopyF() on the main thread and
+ * once recorded into command buffers by several threads, then checks both
+ * frames came out the same, and that a buffer recorded before the scale
+ * changed isn't submitted. Without a display, run it on Mesa's software
+ * rasterizer with the offscreen driver:
+ *
+ *   SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 ./testrendercommandbuffer [sprites] [threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+#define WINDOW_W 640
+#define WINDOW_H 480
+#define NUM_TEXTURES 8
+#define SPRITE_SIZE 32
+#define MAX_THREADS 16
+
+typedef struct Recording
+{
+    SDL_RenderCommandBuffer *buffer;
+    SDL_Texture **textures;
+    int first, count;       /* the sprites this thread records */
+    int retval;
+} Recording;
+
+static SDL_Texture *
+CreateSprite(SDL_Renderer *renderer, int index)
+{
+    Uint32 pixels[SPRITE_SIZE * SPRITE_SIZE];
+    const Uint32 color = 0x80000000 | ((index * 0x3F1D57) & 0xFFFFFF);
+    SDL_Texture *texture;
+    int i;
+
+    for (i = 0; i < SPRITE_SIZE * SPRITE_SIZE; i++) {
+        pixels[i] = ((i / SPRITE_SIZE + i) & 4) ? color : 0;
+    }
+
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, SPRITE_SIZE, SPRITE_SIZE);
+    if (texture) {
+        SDL_UpdateTexture(texture, NULL, pixels, sizeof(Uint32) * SPRITE_SIZE);
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+    return texture;
+}
+
+static void
+GetSprite(int i, SDL_Rect *srcrect, SDL_FRect *dstrect)
+{
+    srcrect->x = (i % 4) * 2;
+    srcrect->y = (i % 5) * 2;
+    srcrect->w = SPRITE_SIZE - srcrect->x;
+    srcrect->h = SPRITE_SIZE - srcrect->y;
+    dstrect->x = (float) ((i * 37) % (WINDOW_W - SPRITE_SIZE));
+    dstrect->y = (float) ((i * 91) % (WINDOW_H - SPRITE_SIZE));
+    dstrect->w = (float) srcrect->w;
+    dstrect->h = (float) srcrect->h;
+}
+
+static int SDLCALL
+RecordSprites(void *data)
+{
+    Recording *recording = (Recording *) data;
+    int i;
+
+    for (i = recording->first; i < recording->first + recording->count; i++) {
+        SDL_Rect srcrect;
+        SDL_FRect dstrect;
+
+        GetSprite(i, &srcrect, &dstrect);
+        if (SDL_RecordRenderCopyF(recording->buffer, recording->textures[i % NUM_TEXTURES], &srcrect, &dstrect) < 0) {
+            recording->retval = -1;
+            break;
+        }
+    }
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const int num_sprites = (argc > 1) ? SDL_atoi(argv[1]) : 10000;
+    const int num_threads = (argc > 2) ? SDL_atoi(argv[2]) : 4;
+    SDL_Texture *textures[NUM_TEXTURES];
+    Recording recordings[MAX_THREADS];
+    SDL_Thread *threads[MAX_THREADS];
+    Uint32 *direct, *recorded;
+    SDL_Window *window;
+    SDL_Renderer *renderer = NULL;
+    SDL_RendererInfo info;
+    Uint64 start;
+    double direct_ms, recorded_ms;
+    int i, rc = 1;
+
+    if (num_sprites <= 0 || num_threads <= 0 || num_threads > MAX_THREADS) {
+        SDL_Log("USAGE: %s [sprites] [threads, up to %d]\n", argv[0], MAX_THREADS);
+        return 1;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        SDL_Log("Couldn't initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    SDL_zeroa(textures);
+    SDL_zeroa(recordings);
+    direct = (Uint32 *) SDL_malloc(WINDOW_W * WINDOW_H * sizeof(Uint32));
+    recorded = (Uint32 *) SDL_malloc(WINDOW_W * WINDOW_H * sizeof(Uint32));
+    window = SDL_CreateWindow("testrendercommandbuffer", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_W, WINDOW_H, 0);
+    if (!direct || !recorded || !window) {
+        SDL_Log("Couldn't create a window: %s\n", SDL_GetError());
+        goto done;
+    }
+
+    renderer = SDL_CreateRenderer(window, -1, 0);
+    if (!renderer || SDL_GetRendererInfo(renderer, &info) < 0) {
+        SDL_Log("Couldn't create a renderer: %s\n", SDL_GetError());
+        goto done;
+    }
+
+    for (i = 0; i < NUM_TEXTURES; i++) {
+        textures[i] = CreateSprite(renderer, i);
+        if (!textures[i]) {
+            SDL_Log("Couldn't create a texture: %s\n", SDL_GetError());
+            goto done;
+        }
+    }
+
+    printf("%s renderer, %d sprites, %d threads\n", info.name, num_sprites, num_threads);
+
+    /* Drawn the usual way */
+    start = SDL_GetPerformanceCounter();
+    SDL_SetRenderDrawColor(renderer, 0x20, 0x20, 0x40, 0xFF);
+    SDL_RenderClear(renderer);
+    for (i = 0; i < num_sprites; i++) {
+        SDL_Rect srcrect;
+        SDL_FRect dstrect;
+
+        GetSprite(i, &srcrect, &dstrect);
+        SDL_RenderCopyF(renderer, textures[i % NUM_TEXTURES], &srcrect, &dstrect);
+    }
+    SDL_RenderFlush(renderer);
+    direct_ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, direct, WINDOW_W * sizeof(Uint32)) < 0) {
+        SDL_Log("Couldn't read the frame back: %s\n", SDL_GetError());
+        goto done;
+    }
+
+    /* Recorded by the threads, each taking a slice of the sprites */
+    for (i = 0; i < num_threads; i++) {
+        recordings[i].buffer = SDL_CreateRenderCommandBuffer(renderer);
+        if (!recordings[i].buffer) {
+            SDL_Log("Couldn't create a command buffer: %s\n", SDL_GetError());
+            goto done;
+        }
+        recordings[i].textures = textures;
+        recordings[i].first = num_sprites * i / num_threads;
+        recordings[i].count = num_sprites * (i + 1) / num_threads - recordings[i].first;
+    }
+
+    start = SDL_GetPerformanceCounter();
+    SDL_SetRenderDrawColor(renderer, 0x20, 0x20, 0x40, 0xFF);
+    SDL_RenderClear(renderer);
+    for (i = 0; i < num_threads; i++) {
+        threads[i] = SDL_CreateThread(RecordSprites, "RecordSprites", &recordings[i]);
+    }
+    for (i = 0; i < num_threads; i++) {
+        if (threads[i]) {
+            SDL_WaitThread(threads[i], NULL);
+        } else {
+            RecordSprites(&recordings[i]);
+        }
+    }
+    for (i = 0; i < num_threads; i++) {
+        if (recordings[i].retval < 0 || SDL_RenderSubmitCommandBuffer(recordings[i].buffer) < 0) {
+            SDL_Log("Couldn't record the sprites: %s\n", SDL_GetError());
+            goto done;
+        }
+    }
+    SDL_RenderFlush(renderer);
+    recorded_ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, recorded, WINDOW_W * sizeof(Uint32)) < 0) {
+        SDL_Log("Couldn't read the frame back: %s\n", SDL_GetError());
+        goto done;
+    }
+
+    printf("main thread: %.3f ms, recorded: %.3f ms\n", direct_ms, recorded_ms);
+    if (SDL_memcmp(direct, recorded, WINDOW_W * WINDOW_H * sizeof(Uint32)) != 0) {
+        printf("the frames differ\n");
+        goto done;
+    }
+    printf("the frames are the same\n");
+
+    /* The recorded vertices are already scaled */
+    recordings[0].count = 1;
+    RecordSprites(&recordings[0]);
+    SDL_RenderSetScale(renderer, 2.0f, 2.0f);
+    if (recordings[0].retval < 0 || SDL_RenderSubmitCommandBuffer(recordings[0].buffer) == 0) {
+        printf("a buffer recorded at the old scale was submitted\n");
+        goto done;
+    }
+    rc = 0;
+
+done:
+    for (i = 0; i < num_threads && i < MAX_THREADS; i++) {
+        if (recordings[i].buffer) {
+            SDL_DestroyRenderCommandBuffer(recordings[i].buffer);
+        }
+    }
+    for (i = 0; i < NUM_TEXTURES; i++) {
+        if (textures[i]) {
+            SDL_DestroyTexture(textures[i]);
+        }
+    }
+    if (renderer) {
+        SDL_DestroyRenderer(renderer);
+    }
+    SDL_free(direct);
+    SDL_free(recorded);
+    SDL_Quit();
+    return rc;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,210 @@
+/*
+  Copyright (C) 1997-2022 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/*
+ * Benchmark of many sprites copied from many small textures, drawn once
+ * without and once with SDL_HINT_RENDER_ATLAS. Reports the frame time and the
+ * draws the renderer made, and how far apart the last frames of both runs are.
+ * Without a display, run it on Mesa's software rasterizer with the offscreen
+ * driver:
+ *
+ *   SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 ./testspritebatch [sprites] [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+#define WINDOW_W 640
+#define WINDOW_H 480
+#define NUM_TEXTURES 64
+#define SPRITE_SIZE 32
+
+typedef struct Result
+{
+    double frame_ms;
+    SDL_RenderStats stats;
+} Result;
+
+/* A disc in a color of its own on a transparent background, so blending and
+   the filtering at the edges of the textures show in the output */
+static SDL_Texture *
+CreateSprite(SDL_Renderer *renderer, int index)
+{
+    Uint32 pixels[SPRITE_SIZE * SPRITE_SIZE];
+    const Uint32 color = 0xFF000000 | ((index * 0x3F1D57) & 0xFFFFFF);
+    SDL_Texture *texture;
+    int x, y;
+
+    for (y = 0; y < SPRITE_SIZE; y++) {
+        for (x = 0; x < SPRITE_SIZE; x++) {
+            const int dx = 2 * x + 1 - SPRITE_SIZE;
+            const int dy = 2 * y + 1 - SPRITE_SIZE;
+            const SDL_bool inside = (dx * dx + dy * dy <= SPRITE_SIZE * SPRITE_SIZE);
+
+            pixels[y * SPRITE_SIZE + x] = (inside || x == 0 || y == 0) ? color : 0;
+        }
+    }
+
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, SPRITE_SIZE, SPRITE_SIZE);
+    if (texture) {
+        SDL_UpdateTexture(texture, NULL, pixels, sizeof(Uint32) * SPRITE_SIZE);
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+    return texture;
+}
+
+static int
+Run(SDL_Window *window, SDL_bool atlas, int num_sprites, int frames, Uint32 *output, Result *result)
+{
+    SDL_Texture *textures[NUM_TEXTURES];
+    SDL_Renderer *renderer;
+    Uint64 start;
+    int i, frame, retval = -1;
+
+    SDL_SetHint(SDL_HINT_RENDER_ATLAS, atlas ? "1" : "0");
+
+    renderer = SDL_CreateRenderer(window, -1, 0);
+    if (!renderer) {
+        SDL_Log("Couldn't create a renderer: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    SDL_zeroa(textures);
+    for (i = 0; i < NUM_TEXTURES; i++) {
+        textures[i] = CreateSprite(renderer, i);
+        if (!textures[i]) {
+            SDL_Log("Couldn't create a texture: %s\n", SDL_GetError());
+            goto done;
+        }
+    }
+
+    start = SDL_GetPerformanceCounter();
+    for (frame = 0; frame < frames; frame++) {
+        SDL_SetRenderDrawColor(renderer, 0x20, 0x20, 0x40, 0xFF);
+        SDL_RenderClear(renderer);
+
+        /* Every third sprite is scaled up, filtering it */
+        for (i = 0; i < num_sprites; i++) {
+            SDL_FRect rect;
+
+            rect.w = rect.h = (i % 3) ? SPRITE_SIZE : SPRITE_SIZE * 1.5f;
+            rect.x = (float) ((i * 37 + frame * 3) % (WINDOW_W - SPRITE_SIZE * 2));
+            rect.y = (float) ((i * 91 + frame * 2) % (WINDOW_H - SPRITE_SIZE * 2));
+            SDL_RenderCopyF(renderer, textures[i % NUM_TEXTURES], NULL, &rect);
+        }
+
+        /* The last frame is read back instead of presented */
+        if (frame == frames - 1) {
+            SDL_RenderFlush(renderer);
+            break;
+        }
+        SDL_RenderPresent(renderer);
+    }
+
+    if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, output, WINDOW_W * sizeof(Uint32)) < 0) {
+        SDL_Log("Couldn't read the frame back: %s\n", SDL_GetError());
+        goto done;
+    }
+    result->frame_ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency() / frames;
+
+    SDL_RenderGetStats(renderer, &result->stats);
+    retval = 0;
+
+done:
+    for (i = 0; i < NUM_TEXTURES; i++) {
+        if (textures[i]) {
+            SDL_DestroyTexture(textures[i]);
+        }
+    }
+    SDL_DestroyRenderer(renderer);
+    return retval;
+}
+
+static int
+MaxDifference(const Uint32 *a, const Uint32 *b)
+{
+    int i, shift, diff, max = 0;
+
+    for (i = 0; i < WINDOW_W * WINDOW_H; i++) {
+        for (shift = 0; shift < 32; shift += 8) {
+            diff = SDL_abs((int) ((a[i] >> shift) & 0xFF) - (int) ((b[i] >> shift) & 0xFF));
+            max = SDL_max(max, diff);
+        }
+    }
+    return max;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const int num_sprites = (argc > 1) ? SDL_atoi(argv[1]) : 2000;
+    const int frames = (argc > 2) ? SDL_atoi(argv[2]) : 200;
+    Uint32 *without, *with;
+    SDL_Window *window;
+    SDL_RendererInfo info;
+    SDL_Renderer *renderer;
+    Result results[2];
+    int rc = 1;
+
+    if (num_sprites <= 0 || frames <= 1) {
+        SDL_Log("USAGE: %s [sprites] [frames]\n", argv[0]);
+        return 1;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        SDL_Log("Couldn't initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+    SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+
+    without = (Uint32 *) SDL_malloc(WINDOW_W * WINDOW_H * sizeof(Uint32));
+    with = (Uint32 *) SDL_malloc(WINDOW_W * WINDOW_H * sizeof(Uint32));
+    window = SDL_CreateWindow("testspritebatch", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_W, WINDOW_H, 0);
+    if (!without || !with || !window) {
+        SDL_Log("Couldn't create a window: %s\n", SDL_GetError());
+        goto done;
+    }
+
+    renderer = SDL_CreateRenderer(window, -1, 0);
+    if (!renderer || SDL_GetRendererInfo(renderer, &info) < 0) {
+        SDL_Log("Couldn't create a renderer: %s\n", SDL_GetError());
+        goto done;
+    }
+    SDL_DestroyRenderer(renderer);
+
+    printf("%s renderer, %d sprites from %d textures, %d frames\n", info.name, num_sprites, NUM_TEXTURES, frames);
+
+    if (Run(window, SDL_FALSE, num_sprites, frames, without, &results[0]) < 0 ||
+        Run(window, SDL_TRUE, num_sprites, frames, with, &results[1]) < 0) {
+        goto done;
+    }
+
+    printf("without atlas: %.3f ms/frame, %u draw calls, %u commands queued, %u run\n", results[0].frame_ms,
+           results[0].stats.draw_calls, results[0].stats.commands_queued, results[0].stats.commands_run);
+    printf("with atlas:    %.3f ms/frame, %u draw calls, %u commands queued, %u run, %d textures in %d pages\n", results[1].frame_ms,
+           results[1].stats.draw_calls, results[1].stats.commands_queued, results[1].stats.commands_run,
+           results[1].stats.atlas_textures, results[1].stats.atlas_pages);
+    printf("frames differ by at most %d per channel\n", MaxDifference(without, with));
+    rc = 0;
+
+done:
+    SDL_free(without);
+    SDL_free(with);
+    SDL_Quit();
+    return rc;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */